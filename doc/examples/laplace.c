@@ -4,10 +4,10 @@
 
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_vector.h>
-#include <gsl/gsl_matrix.h>
-#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_errno.h>
 
 #include <gslsp/gsl_spmatrix.h>
+#include <gslsp/gsl_splinalg.h>
 
 /* exact solution */
 double u_exact(const double x) { return sin(M_PI * x); }
@@ -24,58 +24,64 @@ main()
   gsl_vector *u = gsl_vector_alloc(n);        /* solution vector */
   size_t i;
 
-  /* construct the sparse matrix for the finite difference equation */
+  /*
+   * construct the sparse matrix for the finite difference equation,
+   * multiplied by -1 so that the matrix is positive definite
+   */
 
   /* loop over interior grid points */
   for (i = 0; i < n; ++i)
     {
       /* u_{i+1} term, ignore at the boundary */
       if (i + 1 < n)
-        gsl_spmatrix_set(T, i, i + 1, 1.0);
+        gsl_spmatrix_set(T, i, i + 1, -1.0);
 
-      gsl_spmatrix_set(T, i, i, -2.0);
+      gsl_spmatrix_set(T, i, i, 2.0);
 
       /* u_{i-1} term, ignore at the boundary */
       if (i > 0)
-        gsl_spmatrix_set(T, i, i - 1, 1.0);
+        gsl_spmatrix_set(T, i, i - 1, -1.0);
     }
 
   /* scale by h^2 */
   gsl_spmatrix_scale(T, 1.0 / (h * h));
 
-  /* construct right hand side vector */
+  /* construct right hand side vector -f */
   for (i = 0; i < n; ++i)
     {
       double xi = (i + 1) * h;
       double fi = -M_PI * M_PI * sin(M_PI * xi);
-      gsl_vector_set(f, i, fi);
+      gsl_vector_set(f, i, -fi);
     }
 
   /* convert to compressed column format */
   C = gsl_spmatrix_compress(T);
 
-  /*
-   * At this point, C->i, C->p, C->data contain the
-   * row indices, column pointers, and matrix elements
-   * of the compressed column storage format. These 3
-   * arrays can be passed to external linear solvers.
-   *
-   * For illustration purposes, we will convert the
-   * sparse matrix to a dense gsl_matrix and complete
-   * the solution using a dense LU solver.
-   */
-
+  /* now solve the system with the conjugate gradient iterative solver */
   {
-    gsl_matrix *A = gsl_matrix_alloc(n, n);
-    gsl_permutation *p = gsl_permutation_alloc(n);
-    int s;
+    const double tol = 1.0e-10;                 /* solution relative tolerance */
+    const size_t max_iter = 10;                 /* maximum iterations */
+    gsl_splinalg_itersolve *work =
+      gsl_splinalg_itersolve_alloc(gsl_splinalg_itersolve_cg, n, 0);
+    size_t iter = 0;
+    int status;
+
+    /* initial guess u = 0 */
+    gsl_vector_set_zero(u);
+
+    /* solve the system A u = -f */
+    do
+      {
+        status = gsl_splinalg_itersolve_iterate(C, f, tol, u, work);
 
-    /* convert sparse to dense */
-    gsl_spmatrix_sp2d(A, T);
+        /* print out residual norm ||A*u + f|| */
+        fprintf(stderr, "iter %zu residual = %.12e\n",
+                iter, gsl_splinalg_itersolve_normr(work));
 
-    /* solve linear system A u = f */
-    gsl_linalg_LU_decomp(A, p, &s);
-    gsl_linalg_LU_solve(A, p, f, u);
+        if (status == GSL_SUCCESS)
+          fprintf(stderr, "Converged\n");
+      }
+    while (status == GSL_CONTINUE && ++iter < max_iter);
 
     /* output solution */
     for (i = 0; i < n; ++i)
@@ -87,8 +93,7 @@ main()
         printf("%f %.12e %.12e\n", xi, u_gsl, u_analytic);
       }
 
-    gsl_matrix_free(A);
-    gsl_permutation_free(p);
+    gsl_splinalg_itersolve_free(work);
   }
 
   gsl_spmatrix_free(T);
@@ -0,0 +1,169 @@
+/* gsl_splinalg.h
+ *
+ * Copyright (C) 2012-2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GSL_SPLINALG_H__
+#define __GSL_SPLINALG_H__
+
+#include <stdlib.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_vector.h>
+
+#include "gsl_spmatrix.h"
+
+#undef __BEGIN_DECLS
+#undef __END_DECLS
+#ifdef __cplusplus
+# define __BEGIN_DECLS extern "C" {
+# define __END_DECLS }
+#else
+# define __BEGIN_DECLS /* empty */
+# define __END_DECLS /* empty */
+#endif
+
+__BEGIN_DECLS
+
+/*
+ * preconditioner: solve(r, z, params) computes z = M^{-1} r for
+ * a preconditioning matrix M approximating A; r and z have the
+ * length of the linear system and never refer to the same vector
+ */
+typedef struct
+{
+  int (*solve) (const gsl_vector *r, gsl_vector *z, void *params);
+  void *params;
+} gsl_splinalg_precond;
+
+/* iterative linear solvers for A x = b */
+typedef struct
+{
+  const char *name;
+  void * (*alloc) (const size_t n, const size_t m);
+  int (*iterate) (const gsl_spmatrix *A, const gsl_vector *b,
+                  const double tol, const gsl_splinalg_precond *P,
+                  gsl_vector *x, size_t *niter, void *state);
+  double (*normr) (const void *state);
+  void (*free) (void *state);
+} gsl_splinalg_itersolve_type;
+
+typedef struct
+{
+  const gsl_splinalg_itersolve_type *type;
+  const gsl_splinalg_precond *precond; /* preconditioner or NULL */
+  double normr;                        /* current residual norm || b - A x || */
+  size_t niter;                        /* total number of iterations */
+  void *state;
+} gsl_splinalg_itersolve;
+
+/* incomplete LU factorization with zero fill-in */
+typedef struct
+{
+  size_t n;         /* size of matrix */
+  gsl_spmatrix *LU; /* factors L (strictly lower, unit diagonal) and U, CCS */
+  size_t *diag;     /* diag[j] = index of U_jj in LU->data, size n */
+  size_t *map;      /* row -> index marker for current column, size n */
+} gsl_splinalg_ilu0_workspace;
+
+/* incomplete Cholesky factorization with zero fill-in */
+typedef struct
+{
+  size_t n;         /* size of matrix */
+  size_t nz;        /* number of non-zero elements of A */
+  gsl_spmatrix *L;  /* lower triangular factor, CCS */
+  size_t *adiag;    /* adiag[j] = index of A_jj in A->data, size n */
+  size_t *map;      /* row -> index marker for current column, size n */
+} gsl_splinalg_ic0_workspace;
+
+/* supernodal sparse Cholesky factorization */
+typedef struct
+{
+  size_t n;          /* size of matrix */
+  size_t nnz;        /* number of non-zero elements in L */
+  size_t *parent;    /* elimination tree, size n */
+  size_t *colcount;  /* number of non-zero elements in each column of L, size n */
+  size_t nsuper;     /* number of supernodes */
+  size_t *super;     /* first column of each supernode, size nsuper + 1 */
+  size_t *col2super; /* supernode containing each column, size n */
+  size_t *rowptr;    /* row index pointers of supernodes, size nsuper + 1 */
+  size_t *rowind;    /* row indices of supernodes, size rowptr[nsuper] */
+  size_t *blkptr;    /* value pointers of supernodes, size nsuper + 1 */
+  double *blk;       /* dense column-major blocks of L, size blkptr[nsuper] */
+  size_t *map;       /* row -> block row marker for current supernode, size n */
+  size_t *head;      /* supernodes updating each supernode, size nsuper */
+  size_t *next;      /* linked lists of updating supernodes, size nsuper */
+  size_t *pos;       /* next unused row of each supernode, size nsuper */
+  double *work;      /* dense update block, size worksize */
+  size_t worksize;
+} gsl_splinalg_cholesky_workspace;
+
+/* available solvers */
+GSL_VAR const gsl_splinalg_itersolve_type * gsl_splinalg_itersolve_cg;
+GSL_VAR const gsl_splinalg_itersolve_type * gsl_splinalg_itersolve_gmres;
+GSL_VAR const gsl_splinalg_itersolve_type * gsl_splinalg_itersolve_bicgstab;
+
+/*
+ * Prototypes
+ */
+
+/* spitersolve.c */
+gsl_splinalg_itersolve *
+gsl_splinalg_itersolve_alloc(const gsl_splinalg_itersolve_type *T,
+                             const size_t n, const size_t m);
+void gsl_splinalg_itersolve_free(gsl_splinalg_itersolve *w);
+const char *gsl_splinalg_itersolve_name(const gsl_splinalg_itersolve *w);
+int gsl_splinalg_itersolve_set_precond(gsl_splinalg_itersolve *w,
+                                       const gsl_splinalg_precond *P);
+int gsl_splinalg_itersolve_iterate(const gsl_spmatrix *A,
+                                   const gsl_vector *b, const double tol,
+                                   gsl_vector *x, gsl_splinalg_itersolve *w);
+double gsl_splinalg_itersolve_normr(const gsl_splinalg_itersolve *w);
+size_t gsl_splinalg_itersolve_niter(const gsl_splinalg_itersolve *w);
+
+/* spilu0.c */
+gsl_splinalg_ilu0_workspace *gsl_splinalg_ilu0_alloc(const gsl_spmatrix *A);
+void gsl_splinalg_ilu0_free(gsl_splinalg_ilu0_workspace *w);
+int gsl_splinalg_ilu0_decomp(const gsl_spmatrix *A,
+                             gsl_splinalg_ilu0_workspace *w);
+int gsl_splinalg_ilu0_solve(const gsl_splinalg_ilu0_workspace *w,
+                            const gsl_vector *b, gsl_vector *x);
+int gsl_splinalg_ilu0_precond(const gsl_vector *r, gsl_vector *z,
+                              void *params);
+
+/* spic0.c */
+gsl_splinalg_ic0_workspace *gsl_splinalg_ic0_alloc(const gsl_spmatrix *A);
+void gsl_splinalg_ic0_free(gsl_splinalg_ic0_workspace *w);
+int gsl_splinalg_ic0_decomp(const gsl_spmatrix *A,
+                            gsl_splinalg_ic0_workspace *w);
+int gsl_splinalg_ic0_solve(const gsl_splinalg_ic0_workspace *w,
+                           const gsl_vector *b, gsl_vector *x);
+int gsl_splinalg_ic0_precond(const gsl_vector *r, gsl_vector *z,
+                             void *params);
+
+/* spcholesky.c */
+gsl_splinalg_cholesky_workspace *
+gsl_splinalg_cholesky_alloc(const gsl_spmatrix *A);
+void gsl_splinalg_cholesky_free(gsl_splinalg_cholesky_workspace *w);
+int gsl_splinalg_cholesky_decomp(const gsl_spmatrix *A,
+                                 gsl_splinalg_cholesky_workspace *w);
+int gsl_splinalg_cholesky_solve(const gsl_splinalg_cholesky_workspace *w,
+                                const gsl_vector *b, gsl_vector *x);
+
+__END_DECLS
+
+#endif /* __GSL_SPLINALG_H__ */
@@ -20,11 +20,15 @@
 #ifndef __GSL_SPMATRIX_H__
 #define __GSL_SPMATRIX_H__
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_matrix.h>
+#include <gsl/gsl_permutation.h>
+#include <gsl/gsl_blas.h>
 
 #undef __BEGIN_DECLS
 #undef __END_DECLS
@@ -52,6 +56,14 @@ __BEGIN_DECLS
  *   A->p[j] <= n < A->p[j+1]
  * so that column j is stored in
  * [ data[p[j]], data[p[j] + 1], ..., data[p[j+1] - 1] ]
+ *
+ * Compressed row format:
+ *
+ * If data[n] = A_{ij}, then:
+ *   j = A->i[n]
+ *   A->p[i] <= n < A->p[i+1]
+ * so that row i is stored in
+ * [ data[p[i]], data[p[i] + 1], ..., data[p[i+1] - 1] ]
  */
 
 typedef struct
@@ -59,7 +71,7 @@ typedef struct
   size_t size1; /* number of rows */
   size_t size2; /* number of columns */
 
-  size_t *i;    /* row indices of size nzmax */
+  size_t *i;    /* row indices (column indices for comp. row) of size nzmax */
   double *data; /* matrix elements of size nzmax */
 
   /*
@@ -76,14 +88,222 @@ typedef struct
 
   size_t *work; /* workspace of size MAX(size1,size2) used in various routines */
 
+  /*
+   * hash table for triplet format, mapping (i,j) -> n + 1 where
+   * data[n] = A_{ij}, or 0 for an empty slot; open addressing with
+   * linear probing, hashsize is a power of 2 and at least 2*nzmax;
+   * NULL unless enabled with gsl_spmatrix_hash_init()
+   */
+  size_t *hash;
+  size_t hashsize;
+
   size_t flags;
+
+  /*
+   * file mapping from gsl_spmatrix_mmap() containing the arrays i, p
+   * and data of a read-only matrix, or NULL
+   */
+  void *map;
+  size_t mapsize;
 } gsl_spmatrix;
 
 #define GSL_SPMATRIX_TRIPLET      (1 << 0)
 #define GSL_SPMATRIX_CCS          (1 << 1)
+#define GSL_SPMATRIX_CRS          (1 << 2)
 
+#define GSL_SPMATRIX_TYPEMASK     (GSL_SPMATRIX_TRIPLET | GSL_SPMATRIX_CCS | \
+                                   GSL_SPMATRIX_CRS)
+
+/*
+ * properties of compressed matrices, stored in flags alongside the
+ * storage format:
+ *
+ * SORTED: inner indices are in increasing order within each column (CCS)
+ *         or row (CRS)
+ * NODUPS: no (i,j) entry is stored more than once
+ * READONLY: the arrays i, p and data are not owned by the matrix and
+ *           must not be modified or freed
+ * SYMMETRIC: the matrix is symmetric and only its lower triangle and
+ *            diagonal (i >= j) are stored, in CCS format
+ */
+#define GSL_SPMATRIX_SORTED       (1 << 8)
+#define GSL_SPMATRIX_NODUPS       (1 << 9)
+#define GSL_SPMATRIX_READONLY     (1 << 10)
+#define GSL_SPMATRIX_SYMMETRIC    (1 << 11)
+
+/* flags for gsl_spmatrix_fwrite_mm() */
+#define GSL_SPMATRIX_MM_PATTERN   (1 << 0)
+#define GSL_SPMATRIX_MM_SYMMETRIC (1 << 1)
+
+#define GSLSP_TYPE(m)             ((m)->flags & GSL_SPMATRIX_TYPEMASK)
 #define GSLSP_ISTRIPLET(m)        ((m)->flags & GSL_SPMATRIX_TRIPLET)
 #define GSLSP_ISCCS(m)            ((m)->flags & GSL_SPMATRIX_CCS)
+#define GSLSP_ISCRS(m)            ((m)->flags & GSL_SPMATRIX_CRS)
+#define GSLSP_ISSORTED(m)         ((m)->flags & GSL_SPMATRIX_SORTED)
+#define GSLSP_ISREADONLY(m)       ((m)->flags & GSL_SPMATRIX_READONLY)
+#define GSLSP_ISSYMMETRIC(m)      ((m)->flags & GSL_SPMATRIX_SYMMETRIC)
+
+/*
+ * compressed matrix with 32 bit inner indices: the same layout as a
+ * CCS or CRS gsl_spmatrix, except that i is stored as uint32_t, so
+ * each non-zero element needs 12 bytes instead of 16 on 64 bit
+ * systems. Both dimensions must be at most 2^32; the pointers p
+ * remain size_t so that nz is not limited.
+ */
+typedef struct
+{
+  size_t size1;   /* number of rows */
+  size_t size2;   /* number of columns */
+  uint32_t *i;    /* row indices (column indices for CRS) of size nzmax */
+  double *data;   /* matrix elements of size nzmax */
+  size_t *p;      /* column (row) pointers of size size2 + 1 (size1 + 1) */
+  size_t nzmax;   /* maximum number of matrix elements */
+  size_t nz;      /* number of non-zero values in matrix */
+  size_t *work;   /* workspace of size MAX(size1,size2) */
+  size_t flags;   /* GSL_SPMATRIX_CCS or _CRS, with SORTED/NODUPS */
+} gsl_spmatrix_i32;
+
+/*
+ * compressed matrix with single precision values: the same layout as
+ * a CCS or CRS gsl_spmatrix, except that data is stored as float,
+ * halving the storage of the values
+ */
+typedef struct
+{
+  size_t size1;   /* number of rows */
+  size_t size2;   /* number of columns */
+  size_t *i;      /* row indices (column indices for CRS) of size nzmax */
+  float *data;    /* matrix elements of size nzmax */
+  size_t *p;      /* column (row) pointers of size size2 + 1 (size1 + 1) */
+  size_t nzmax;   /* maximum number of matrix elements */
+  size_t nz;      /* number of non-zero values in matrix */
+  size_t flags;   /* GSL_SPMATRIX_CCS or _CRS, with SORTED/NODUPS */
+} gsl_spmatrix_float;
+
+/*
+ * SELL-C-sigma (sliced ELLPACK) format: the rows are sorted by
+ * decreasing length within windows of sigma rows and grouped into
+ * chunks of C rows. Chunk c is stored column by column, padded to the
+ * length of its longest row, so that the k-th elements of its C rows
+ * are contiguous: element k of row r (0 <= r < C) of chunk c is
+ * val[cptr[c] + k*C + r], in column col[cptr[c] + k*C + r], and
+ * belongs to row perm[c*C + r] of the original matrix (or to no row
+ * if perm[c*C + r] >= size1). Only the first len[c*C + r] elements of
+ * a stored row are part of the matrix; the rest are padding
+ */
+typedef struct
+{
+  size_t size1;    /* number of rows */
+  size_t size2;    /* number of columns */
+  size_t C;        /* chunk height */
+  size_t sigma;    /* sorting window */
+  size_t nchunks;  /* number of chunks */
+  size_t nz;       /* number of non-zero elements, excluding padding */
+  size_t *cptr;    /* chunk offsets, size nchunks + 1 */
+  size_t *perm;    /* original row of each stored row, size nchunks*C */
+  int32_t *len;    /* length of each stored row, size nchunks*C */
+  int32_t *col;    /* column indices, size cptr[nchunks] */
+  double *val;     /* values, size cptr[nchunks] */
+} gsl_spmatrix_sell;
+
+/* SIMD instruction sets for gsl_spblas_sell_dgemv() */
+#define GSL_SPBLAS_SIMD_SCALAR    0
+#define GSL_SPBLAS_SIMD_AVX2      1
+#define GSL_SPBLAS_SIMD_AVX512    2
+
+/*
+ * block sparse row (BSR) format: the matrix is divided into b-by-b
+ * blocks, and every block containing a non-zero element is stored in
+ * full. Block row I consists of the blocks p[I] <= n < p[I+1], in
+ * block columns j[n] (sorted), and element (r,c) of block n is
+ * data[n*b*b + r*b + c]
+ */
+typedef struct
+{
+  size_t size1;    /* number of rows, a multiple of b */
+  size_t size2;    /* number of columns, a multiple of b */
+  size_t b;        /* block size */
+  size_t mb;       /* number of block rows, size1 / b */
+  size_t nb;       /* number of block columns, size2 / b */
+  size_t nzb;      /* number of stored blocks */
+  size_t *p;       /* block row pointers, size mb + 1 */
+  size_t *j;       /* block column indices, size nzb */
+  double *data;    /* blocks stored by rows, size nzb*b*b */
+} gsl_spmatrix_bsr;
+
+/* largest supported BSR block size */
+#define GSL_SPMATRIX_BSR_MAXB     8
+
+/*
+ * diagonal (DIA) format: each diagonal containing a non-zero element
+ * is stored in full. Diagonal k has offset[k] = j - i (offsets sorted
+ * in increasing order), and element (i, i + offset[k]) is
+ * data[k*size1 + i]; positions outside the matrix are zero
+ */
+typedef struct
+{
+  size_t size1;    /* number of rows */
+  size_t size2;    /* number of columns */
+  size_t ndiag;    /* number of stored diagonals */
+  long *offset;    /* diagonal offsets, size ndiag */
+  double *data;    /* diagonals, size ndiag*size1 */
+} gsl_spmatrix_dia;
+
+/*
+ * compress plan: records where each triplet of a triplet matrix is
+ * stored in its sorted compressed form, so that the values of the
+ * compressed matrix can be recomputed when only the triplet values
+ * change
+ *
+ * map[n] = index in C->data to which triplet n is added
+ */
+typedef struct
+{
+  size_t nz;    /* number of triplets */
+  size_t *map;  /* triplet -> compressed index map of size nz */
+  size_t size1; /* dimensions of compressed matrix */
+  size_t size2;
+  size_t cnz;   /* number of non-zero values in compressed matrix */
+  size_t type;  /* storage format of compressed matrix */
+} gsl_spmatrix_plan;
+
+/*
+ * workspace for the _w variants of the dgemm, add, transpose and
+ * compress routines. Those routines use only this workspace instead
+ * of allocating their own or using the work array of a matrix, so a
+ * workspace of size n serves any matrices with dimensions up to n,
+ * and threads with separate workspaces can call them concurrently on
+ * the same input matrices
+ */
+typedef struct
+{
+  size_t n;       /* maximum matrix dimension */
+  size_t *iwork;  /* integer workspace, size n */
+  double *dwork;  /* floating point workspace, size n */
+} gsl_spmatrix_workspace;
+
+/*
+ * analysis of a sparse triangular matrix op(A) for
+ * gsl_spblas_dtrsv_levels(): the off-diagonal elements of row i of
+ * op(A) are A->data[pos[p]] in column col[p], for ptr[i] <= p < ptr[i+1],
+ * and the rows of level l are level_rows[level_ptr[l..l+1]-1]
+ */
+typedef struct
+{
+  size_t n;                /* size of matrix */
+  size_t nz;               /* number of off-diagonal elements in triangle */
+  size_t nzA;              /* number of elements of A, including both triangles */
+  CBLAS_UPLO_t Uplo;
+  CBLAS_TRANSPOSE_t TransA;
+  size_t type;             /* storage format of A */
+  size_t *ptr;             /* row pointers of op(A), size n + 1 */
+  size_t *col;             /* column indices, size nz */
+  size_t *pos;             /* positions in A->data, size nz */
+  size_t *diag;            /* position of diagonal element of row i, size n */
+  size_t nlevels;          /* number of levels */
+  size_t *level_ptr;       /* level pointers, size n + 1 */
+  size_t *level_rows;      /* rows sorted by level, size n */
+} gsl_spblas_trsv_workspace;
 
 /*
  * Prototypes
@@ -96,6 +316,18 @@ void gsl_spmatrix_free(gsl_spmatrix *m);
 int gsl_spmatrix_realloc(const size_t nzmax, gsl_spmatrix *m);
 int gsl_spmatrix_set_zero(gsl_spmatrix *m);
 size_t gsl_spmatrix_nnz(const gsl_spmatrix *m);
+gsl_spmatrix_workspace *gsl_spmatrix_workspace_alloc(const size_t n);
+void gsl_spmatrix_workspace_free(gsl_spmatrix_workspace *work);
+
+/* spio.c */
+int gsl_spmatrix_fprintf(FILE *stream, const gsl_spmatrix *m,
+                         const char *format);
+int gsl_spmatrix_fwrite_mm(FILE *stream, const gsl_spmatrix *m,
+                           const size_t flags);
+gsl_spmatrix *gsl_spmatrix_fread_mm(FILE *stream);
+int gsl_spmatrix_fwrite(FILE *stream, const gsl_spmatrix *m);
+gsl_spmatrix *gsl_spmatrix_fread(FILE *stream);
+gsl_spmatrix *gsl_spmatrix_mmap(const char *filename);
 
 /* spcopy.c */
 gsl_spmatrix *gsl_spmatrix_memcpy(const gsl_spmatrix *src);
@@ -105,16 +337,38 @@ double gsl_spmatrix_get(const gsl_spmatrix *m, const size_t i,
                         const size_t j);
 int gsl_spmatrix_set(gsl_spmatrix *m, const size_t i, const size_t j,
                      const double x);
+int gsl_spmatrix_accumulate(gsl_spmatrix *m, const size_t i, const size_t j,
+                            const double x);
+int gsl_spmatrix_hash_init(gsl_spmatrix *m);
+int gsl_spmatrix_hash_rebuild(gsl_spmatrix *m);
+void gsl_spmatrix_hash_free(gsl_spmatrix *m);
 
 /* spcompress.c */
 gsl_spmatrix *gsl_spmatrix_compress(const gsl_spmatrix *T);
+gsl_spmatrix *gsl_spmatrix_crs(const gsl_spmatrix *T);
+gsl_spmatrix *gsl_spmatrix_compress_sorted(const gsl_spmatrix *T,
+                                           const size_t type);
+gsl_spmatrix *gsl_spmatrix_symmetric(const gsl_spmatrix *A);
+gsl_spmatrix *gsl_spmatrix_compress_w(const gsl_spmatrix *T,
+                                      const size_t type,
+                                      gsl_spmatrix_workspace *work);
 void gsl_spmatrix_cumsum(const size_t n, size_t *c);
+gsl_spmatrix_plan *gsl_spmatrix_plan_alloc(const size_t nz);
+void gsl_spmatrix_plan_free(gsl_spmatrix_plan *plan);
+gsl_spmatrix *gsl_spmatrix_compress_plan(const gsl_spmatrix *T,
+                                         const size_t type,
+                                         gsl_spmatrix_plan *plan);
+int gsl_spmatrix_compress_update(const double *data,
+                                 const gsl_spmatrix_plan *plan,
+                                 gsl_spmatrix *C);
 
 /* spoper.c */
 int gsl_spmatrix_scale(gsl_spmatrix *m, const double x);
 int gsl_spmatrix_minmax(const gsl_spmatrix *m, double *min_out,
                         double *max_out);
 gsl_spmatrix *gsl_spmatrix_add(const gsl_spmatrix *a, const gsl_spmatrix *b);
+gsl_spmatrix *gsl_spmatrix_add_w(const gsl_spmatrix *a, const gsl_spmatrix *b,
+                                 gsl_spmatrix_workspace *work);
 int gsl_spmatrix_d2sp(gsl_spmatrix *S, const gsl_matrix *A);
 int gsl_spmatrix_sp2d(gsl_matrix *A, const gsl_spmatrix *S);
 
@@ -123,16 +377,135 @@ int gsl_spmatrix_equal(const gsl_spmatrix *a, const gsl_spmatrix *b);
 
 /* spswap.c */
 gsl_spmatrix *gsl_spmatrix_transpose_memcpy(const gsl_spmatrix *src);
+int gsl_spmatrix_transpose_memcpy_w(gsl_spmatrix *dest,
+                                    const gsl_spmatrix *src,
+                                    gsl_spmatrix_workspace *work);
+int gsl_spmatrix_transpose(gsl_spmatrix *m);
+gsl_spmatrix *gsl_spmatrix_permute(const gsl_spmatrix *A,
+                                   const gsl_permutation *p,
+                                   const gsl_permutation *q);
+
+/* sporder.c */
+int gsl_spmatrix_rcm(const gsl_spmatrix *A, gsl_permutation *p);
+int gsl_spmatrix_amd(const gsl_spmatrix *A, gsl_permutation *p);
 
 /* spblas */
-int gsl_spblas_dgemv(const double alpha, const gsl_spmatrix *A,
-                     const gsl_vector *x, const double beta, gsl_vector *y);
+int gsl_spblas_dgemv(const CBLAS_TRANSPOSE_t TransA, const double alpha,
+                     const gsl_spmatrix *A, const gsl_vector *x,
+                     const double beta, gsl_vector *y);
 gsl_spmatrix *gsl_spblas_dgemm(const double alpha, const gsl_spmatrix *A,
                                const gsl_spmatrix *B);
+gsl_spmatrix *gsl_spblas_dgemm_symbolic(const gsl_spmatrix *A,
+                                        const gsl_spmatrix *B);
+int gsl_spblas_dgemm_numeric(const double alpha, const gsl_spmatrix *A,
+                             const gsl_spmatrix *B, gsl_spmatrix *C);
+gsl_spmatrix *gsl_spblas_dgemm_w(const double alpha, const gsl_spmatrix *A,
+                                 const gsl_spmatrix *B,
+                                 gsl_spmatrix_workspace *work);
+gsl_spmatrix *gsl_spblas_dgemm_symbolic_w(const gsl_spmatrix *A,
+                                          const gsl_spmatrix *B,
+                                          gsl_spmatrix_workspace *work);
+int gsl_spblas_dgemm_numeric_w(const double alpha, const gsl_spmatrix *A,
+                               const gsl_spmatrix *B, gsl_spmatrix *C,
+                               gsl_spmatrix_workspace *work);
+int gsl_spblas_dgemm_dense(const double alpha, const gsl_spmatrix *A,
+                           const gsl_matrix *X, const double beta,
+                           gsl_matrix *Y);
+int gsl_spblas_dsymv(const double alpha, const gsl_spmatrix *A,
+                     const gsl_vector *x, const double beta, gsl_vector *y);
+int gsl_spblas_dtrsv(const CBLAS_UPLO_t Uplo, const CBLAS_TRANSPOSE_t TransA,
+                     const CBLAS_DIAG_t Diag, const gsl_spmatrix *A,
+                     gsl_vector *x);
+gsl_spblas_trsv_workspace *
+gsl_spblas_trsv_alloc(const CBLAS_UPLO_t Uplo, const CBLAS_TRANSPOSE_t TransA,
+                      const gsl_spmatrix *A);
+void gsl_spblas_trsv_free(gsl_spblas_trsv_workspace *w);
+int gsl_spblas_dtrsv_levels(const CBLAS_DIAG_t Diag, const gsl_spmatrix *A,
+                            const gsl_spblas_trsv_workspace *w,
+                            gsl_vector *x);
 size_t gsl_spblas_scatter(const gsl_spmatrix *A, const size_t j, const double alpha,
                           size_t *w, double *x, const size_t mark, gsl_spmatrix *C,
                           size_t nz);
 
+/* spi32.c */
+gsl_spmatrix_i32 *gsl_spmatrix_i32_alloc_nzmax(const size_t n1,
+                                               const size_t n2,
+                                               const size_t nzmax,
+                                               const size_t flags);
+void gsl_spmatrix_i32_free(gsl_spmatrix_i32 *m);
+gsl_spmatrix_i32 *gsl_spmatrix_i32_compress(const gsl_spmatrix *A,
+                                            const size_t type);
+double gsl_spmatrix_i32_get(const gsl_spmatrix_i32 *m, const size_t i,
+                            const size_t j);
+gsl_spmatrix_i32 *gsl_spmatrix_i32_transpose_memcpy(const gsl_spmatrix_i32 *src);
+int gsl_spmatrix_i32_transpose(gsl_spmatrix_i32 *m);
+int gsl_spblas_i32_dgemv(const CBLAS_TRANSPOSE_t TransA, const double alpha,
+                         const gsl_spmatrix_i32 *A, const gsl_vector *x,
+                         const double beta, gsl_vector *y);
+gsl_spmatrix_i32 *gsl_spblas_i32_dgemm(const double alpha,
+                                       const gsl_spmatrix_i32 *A,
+                                       const gsl_spmatrix_i32 *B);
+gsl_spmatrix_i32 *gsl_spblas_i32_dgemm_symbolic(const gsl_spmatrix_i32 *A,
+                                                const gsl_spmatrix_i32 *B);
+int gsl_spblas_i32_dgemm_numeric(const double alpha, const gsl_spmatrix_i32 *A,
+                                 const gsl_spmatrix_i32 *B,
+                                 gsl_spmatrix_i32 *C);
+
+/* spfloat.c */
+gsl_spmatrix_float *gsl_spmatrix_float_alloc_nzmax(const size_t n1,
+                                                   const size_t n2,
+                                                   const size_t nzmax,
+                                                   const size_t flags);
+void gsl_spmatrix_float_free(gsl_spmatrix_float *m);
+gsl_spmatrix_float *gsl_spmatrix_float_compress(const gsl_spmatrix *A,
+                                                const size_t type);
+float gsl_spmatrix_float_get(const gsl_spmatrix_float *m, const size_t i,
+                             const size_t j);
+int gsl_spblas_dsgemv(const CBLAS_TRANSPOSE_t TransA, const double alpha,
+                      const gsl_spmatrix_float *A, const gsl_vector *x,
+                      const double beta, gsl_vector *y);
+
+/* spbsr.c */
+gsl_spmatrix_bsr *gsl_spmatrix_bsr_alloc(const gsl_spmatrix *A,
+                                         const size_t b);
+void gsl_spmatrix_bsr_free(gsl_spmatrix_bsr *m);
+size_t gsl_spmatrix_bsr_blocksize(const gsl_spmatrix *A,
+                                  const double maxfill);
+double gsl_spmatrix_bsr_get(const gsl_spmatrix_bsr *m, const size_t i,
+                            const size_t j);
+int gsl_spblas_bsr_dgemv(const double alpha, const gsl_spmatrix_bsr *A,
+                         const gsl_vector *x, const double beta,
+                         gsl_vector *y);
+int gsl_spblas_bsr_dgemm_dense(const double alpha,
+                               const gsl_spmatrix_bsr *A,
+                               const gsl_matrix *X, const double beta,
+                               gsl_matrix *Y);
+
+/* spdia.c */
+size_t gsl_spmatrix_dia_ndiag(const gsl_spmatrix *A);
+gsl_spmatrix_dia *gsl_spmatrix_dia_alloc(const gsl_spmatrix *A);
+void gsl_spmatrix_dia_free(gsl_spmatrix_dia *m);
+double gsl_spmatrix_dia_get(const gsl_spmatrix_dia *m, const size_t i,
+                            const size_t j);
+int gsl_spblas_dia_dgemv(const double alpha, const gsl_spmatrix_dia *A,
+                         const gsl_vector *x, const double beta,
+                         gsl_vector *y);
+
+/* spsell.c */
+gsl_spmatrix_sell *gsl_spmatrix_sell_alloc(const gsl_spmatrix *A,
+                                           const size_t C,
+                                           const size_t sigma);
+void gsl_spmatrix_sell_free(gsl_spmatrix_sell *m);
+int gsl_spblas_sell_dgemv(const double alpha, const gsl_spmatrix_sell *A,
+                          const gsl_vector *x, const double beta,
+                          gsl_vector *y);
+int gsl_spblas_sell_set_simd(const size_t simd);
+size_t gsl_spblas_sell_get_simd(void);
+
+/* spthread.c */
+int gsl_spblas_set_num_threads(const size_t nthreads);
+size_t gsl_spblas_get_num_threads(void);
+
 __END_DECLS
 
 #endif /* __GSL_SPMATRIX_H__ */
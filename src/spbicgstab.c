@@ -0,0 +1,331 @@
+/* spbicgstab.c
+ *
+ * Copyright (C) 2012-2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "gsl_splinalg.h"
+
+/*
+ * The code in this module performs the BiCGStab method with right
+ * preconditioning, for general square matrices A
+ *
+ * References:
+ *
+ * [1] van der Vorst, H. A., Bi-CGSTAB: A fast and smoothly converging
+ *     variant of Bi-CG for the solution of nonsymmetric linear systems,
+ *     SIAM J. Sci. Stat. Comput., 13, 1992
+ *
+ * [2] Saad, Y., Iterative Methods for Sparse Linear Systems, 2nd ed,
+ *     SIAM, 2003, Algorithm 7.7
+ */
+
+typedef struct
+{
+  size_t n;          /* size of linear system */
+  size_t maxiter;    /* maximum iterations per call to bicgstab_iterate() */
+
+  gsl_vector *r;     /* residual vector, size n */
+  gsl_vector *rhat;  /* shadow residual, size n */
+  gsl_vector *p;     /* search direction, size n */
+  gsl_vector *v;     /* v = A M^{-1} p, size n */
+  gsl_vector *s;     /* intermediate residual, size n */
+  gsl_vector *t;     /* t = A M^{-1} s, size n */
+  gsl_vector *phat;  /* M^{-1} p, size n */
+  gsl_vector *shat;  /* M^{-1} s, size n */
+
+  double normr;      /* residual norm || b - A x || */
+} bicgstab_state_t;
+
+static void *bicgstab_alloc(const size_t n, const size_t m);
+static int bicgstab_iterate(const gsl_spmatrix *A, const gsl_vector *b,
+                            const double tol, const gsl_splinalg_precond *P,
+                            gsl_vector *x, size_t *niter, void *vstate);
+static double bicgstab_normr(const void *vstate);
+static void bicgstab_free(void *vstate);
+
+/*
+bicgstab_alloc()
+  Allocate BiCGStab workspace
+
+Inputs: n - size of linear system
+        m - maximum number of iterations per call to bicgstab_iterate();
+            if 0, n is used
+
+Return: pointer to workspace
+*/
+
+static void *
+bicgstab_alloc(const size_t n, const size_t m)
+{
+  bicgstab_state_t *state;
+
+  state = calloc(1, sizeof(bicgstab_state_t));
+  if (!state)
+    {
+      GSL_ERROR_NULL("failed to allocate bicgstab state", GSL_ENOMEM);
+    }
+
+  state->n = n;
+  state->maxiter = (m > 0) ? m : n;
+
+  state->r = gsl_vector_alloc(n);
+  state->rhat = gsl_vector_alloc(n);
+  state->p = gsl_vector_alloc(n);
+  state->v = gsl_vector_alloc(n);
+  state->s = gsl_vector_alloc(n);
+  state->t = gsl_vector_alloc(n);
+  state->phat = gsl_vector_alloc(n);
+  state->shat = gsl_vector_alloc(n);
+  if (!state->r || !state->rhat || !state->p || !state->v ||
+      !state->s || !state->t || !state->phat || !state->shat)
+    {
+      bicgstab_free(state);
+      GSL_ERROR_NULL("failed to allocate bicgstab vectors", GSL_ENOMEM);
+    }
+
+  state->normr = 0.0;
+
+  return state;
+} /* bicgstab_alloc() */
+
+/*
+bicgstab_iterate()
+  Perform up to state->maxiter BiCGStab iterations
+
+Inputs: A      - square sparse matrix
+        b      - right hand side vector
+        tol    - relative tolerance
+        P      - preconditioner or NULL
+        x      - (input/output) on input, initial guess; on output,
+                 updated solution
+        niter  - (output) number of iterations performed
+        vstate - workspace
+
+Return: GSL_SUCCESS if || b - A x || <= tol * || b ||, GSL_CONTINUE if
+maxiter iterations were performed without converging, or an error code
+
+Notes:
+1) Each call restarts the method from the residual b - A x, with the
+shadow residual rhat = r
+
+2) Each iteration requires two matrix-vector products. The vector
+updates are fused: p is updated in one pass, s and its norm in one
+pass, and x, r and the norm of r in one pass
+*/
+
+static int
+bicgstab_iterate(const gsl_spmatrix *A, const gsl_vector *b,
+                 const double tol, const gsl_splinalg_precond *P,
+                 gsl_vector *x, size_t *niter, void *vstate)
+{
+  bicgstab_state_t *state = (bicgstab_state_t *) vstate;
+  const size_t n = state->n;
+  gsl_vector *phat = P ? state->phat : state->p;
+  gsl_vector *shat = P ? state->shat : state->s;
+  double *X = x->data;
+  const size_t incX = x->stride;
+  double *R = state->r->data;
+  double *Pd = state->p->data;
+  double *V = state->v->data;
+  double *S = state->s->data;
+  double *T = state->t->data;
+  double *Ph = phat->data;
+  double *Sh = shat->data;
+  const double normb = gsl_blas_dnrm2(b);
+  double rho = 1.0, alpha = 1.0, omega = 1.0;
+  size_t i, k;
+  int status;
+
+  *niter = 0;
+
+  if (n != state->r->size)
+    {
+      GSL_ERROR("matrix does not match workspace", GSL_EBADLEN);
+    }
+
+  if (normb == 0.0)
+    {
+      gsl_vector_set_zero(x);
+      state->normr = 0.0;
+      return GSL_SUCCESS;
+    }
+
+  /* r = b - A x, rhat = r */
+  gsl_vector_memcpy(state->r, b);
+  gsl_spblas_dgemv(CblasNoTrans, -1.0, A, x, 1.0, state->r);
+
+  state->normr = gsl_blas_dnrm2(state->r);
+  if (state->normr <= tol * normb)
+    return GSL_SUCCESS;
+
+  gsl_vector_memcpy(state->rhat, state->r);
+  gsl_vector_set_zero(state->p);
+  gsl_vector_set_zero(state->v);
+
+  for (k = 0; k < state->maxiter; ++k)
+    {
+      double rho_new, beta, rv, tt, ts, ss = 0.0, rr = 0.0;
+
+      gsl_blas_ddot(state->rhat, state->r, &rho_new);
+      if (rho_new == 0.0)
+        {
+          GSL_ERROR("BiCGStab breakdown: rho = 0", GSL_EZERODIV);
+        }
+
+      beta = (rho_new / rho) * (alpha / omega);
+      rho = rho_new;
+
+      /* p = r + beta (p - omega v) */
+      for (i = 0; i < n; ++i)
+        Pd[i] = R[i] + beta * (Pd[i] - omega * V[i]);
+
+      /* v = A M^{-1} p */
+      if (P)
+        {
+          status = P->solve(state->p, phat, P->params);
+          if (status)
+            return status;
+        }
+
+      gsl_spblas_dgemv(CblasNoTrans, 1.0, A, phat, 0.0, state->v);
+
+      gsl_blas_ddot(state->rhat, state->v, &rv);
+      if (rv == 0.0)
+        {
+          GSL_ERROR("BiCGStab breakdown: (rhat,v) = 0", GSL_EZERODIV);
+        }
+
+      alpha = rho / rv;
+
+      /* s = r - alpha v, ss = s.s */
+      for (i = 0; i < n; ++i)
+        {
+          S[i] = R[i] - alpha * V[i];
+          ss += S[i] * S[i];
+        }
+
+      ++(*niter);
+
+      if (sqrt(ss) <= tol * normb)
+        {
+          /* x = x + alpha M^{-1} p */
+          for (i = 0; i < n; ++i)
+            X[i * incX] += alpha * Ph[i];
+
+          state->normr = sqrt(ss);
+          return GSL_SUCCESS;
+        }
+
+      /* t = A M^{-1} s */
+      if (P)
+        {
+          status = P->solve(state->s, shat, P->params);
+          if (status)
+            return status;
+        }
+
+      gsl_spblas_dgemv(CblasNoTrans, 1.0, A, shat, 0.0, state->t);
+
+      gsl_blas_ddot(state->t, state->t, &tt);
+      gsl_blas_ddot(state->t, state->s, &ts);
+      if (tt == 0.0)
+        {
+          GSL_ERROR("BiCGStab breakdown: t = 0", GSL_EZERODIV);
+        }
+
+      omega = ts / tt;
+
+      /* x = x + alpha M^{-1} p + omega M^{-1} s, r = s - omega t, rr = r.r */
+      for (i = 0; i < n; ++i)
+        {
+          X[i * incX] += alpha * Ph[i] + omega * Sh[i];
+          R[i] = S[i] - omega * T[i];
+          rr += R[i] * R[i];
+        }
+
+      state->normr = sqrt(rr);
+      if (state->normr <= tol * normb)
+        return GSL_SUCCESS;
+
+      if (omega == 0.0)
+        {
+          GSL_ERROR("BiCGStab breakdown: omega = 0", GSL_EZERODIV);
+        }
+    }
+
+  return GSL_CONTINUE;
+} /* bicgstab_iterate() */
+
+static double
+bicgstab_normr(const void *vstate)
+{
+  const bicgstab_state_t *state = (const bicgstab_state_t *) vstate;
+  return state->normr;
+} /* bicgstab_normr() */
+
+static void
+bicgstab_free(void *vstate)
+{
+  bicgstab_state_t *state = (bicgstab_state_t *) vstate;
+
+  if (state->r)
+    gsl_vector_free(state->r);
+
+  if (state->rhat)
+    gsl_vector_free(state->rhat);
+
+  if (state->p)
+    gsl_vector_free(state->p);
+
+  if (state->v)
+    gsl_vector_free(state->v);
+
+  if (state->s)
+    gsl_vector_free(state->s);
+
+  if (state->t)
+    gsl_vector_free(state->t);
+
+  if (state->phat)
+    gsl_vector_free(state->phat);
+
+  if (state->shat)
+    gsl_vector_free(state->shat);
+
+  free(state);
+} /* bicgstab_free() */
+
+static const gsl_splinalg_itersolve_type bicgstab_type =
+{
+  "bicgstab",
+  &bicgstab_alloc,
+  &bicgstab_iterate,
+  &bicgstab_normr,
+  &bicgstab_free
+};
+
+const gsl_splinalg_itersolve_type * gsl_splinalg_itersolve_bicgstab = &bicgstab_type;
@@ -0,0 +1,739 @@
+/* spbsr.c
+ *
+ * Copyright (C) 2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "spthread.h"
+
+static gsl_spmatrix *bsr_ccs(const gsl_spmatrix *A);
+static size_t bsr_count(const gsl_spmatrix *A, const size_t b,
+                        size_t *mark, size_t *cnt);
+static void bsr_mv(const double alpha, const gsl_spmatrix_bsr *A,
+                   const size_t I0, const size_t I1, const double *X,
+                   const size_t incX, const double beta, double *Y,
+                   const size_t incY);
+static void bsr_mm(const double alpha, const gsl_spmatrix_bsr *A,
+                   const size_t I0, const size_t I1, const gsl_matrix *X,
+                   const double beta, gsl_matrix *Y);
+
+/*
+gsl_spmatrix_bsr_alloc()
+  Create a block sparse row matrix from a sparse matrix
+
+Inputs: A - sparse matrix in triplet, CCS or CRS format, without
+            symmetric storage
+        b - block size, 1 <= b <= GSL_SPMATRIX_BSR_MAXB; size1 and
+            size2 of A must be multiples of b
+
+Return: pointer to new matrix, or NULL on error
+
+Notes:
+1) Every b-by-b block containing at least one element of A is stored
+in full, with explicit zeros for the missing elements. Duplicate
+triplets are summed
+
+2) The blocks are built from the CCS arrays of A, scanning the block
+columns in order, so the blocks of each block row are sorted by block
+column. A CCS matrix is used directly, a CRS matrix is transposed with
+gsl_spmatrix_transpose_memcpy(), whose arrays are the CCS arrays of A,
+and a triplet matrix is compressed with gsl_spmatrix_compress()
+*/
+
+gsl_spmatrix_bsr *
+gsl_spmatrix_bsr_alloc(const gsl_spmatrix *A, const size_t b)
+{
+  if (b == 0 || b > GSL_SPMATRIX_BSR_MAXB)
+    {
+      GSL_ERROR_NULL("block size must be between 1 and GSL_SPMATRIX_BSR_MAXB",
+                     GSL_EINVAL);
+    }
+  else if (A->size1 % b != 0 || A->size2 % b != 0)
+    {
+      GSL_ERROR_NULL("matrix dimensions must be multiples of block size",
+                     GSL_EBADLEN);
+    }
+  else if (GSLSP_ISSYMMETRIC(A))
+    {
+      GSL_ERROR_NULL("symmetric storage is not supported", GSL_EINVAL);
+    }
+  else
+    {
+      const size_t bb = b * b;
+      const size_t mb = A->size1 / b;
+      gsl_spmatrix *B = bsr_ccs(A);
+      const gsl_spmatrix *S = B ? B : A;
+      gsl_spmatrix_bsr *m;
+      size_t *mark, *cur;
+      size_t I, J, j, p;
+
+      /* conversion to CCS failed */
+      if (!GSLSP_ISCCS(S))
+        return NULL;
+
+      m = calloc(1, sizeof(gsl_spmatrix_bsr));
+      mark = malloc(2 * (mb + 1) * sizeof(size_t));
+      if (!m || !mark)
+        {
+          free(m);
+          free(mark);
+          if (B)
+            gsl_spmatrix_free(B);
+          GSL_ERROR_NULL("failed to allocate space for BSR matrix",
+                         GSL_ENOMEM);
+        }
+
+      cur = mark + mb + 1;
+
+      m->size1 = A->size1;
+      m->size2 = A->size2;
+      m->b = b;
+      m->mb = mb;
+      m->nb = A->size2 / b;
+
+      m->p = malloc((mb + 1) * sizeof(size_t));
+      if (!m->p)
+        {
+          free(mark);
+          if (B)
+            gsl_spmatrix_free(B);
+          gsl_spmatrix_bsr_free(m);
+          GSL_ERROR_NULL("failed to allocate space for BSR matrix",
+                         GSL_ENOMEM);
+        }
+
+      /* count the blocks of each block row and form the row pointers */
+      m->nzb = bsr_count(S, b, mark, m->p + 1);
+
+      m->p[0] = 0;
+      for (I = 0; I < mb; ++I)
+        m->p[I + 1] += m->p[I];
+
+      m->j = malloc(GSL_MAX(m->nzb, 1) * sizeof(size_t));
+      m->data = calloc(GSL_MAX(m->nzb * bb, 1), sizeof(double));
+      if (!m->j || !m->data)
+        {
+          free(mark);
+          if (B)
+            gsl_spmatrix_free(B);
+          gsl_spmatrix_bsr_free(m);
+          GSL_ERROR_NULL("failed to allocate space for BSR matrix",
+                         GSL_ENOMEM);
+        }
+
+      /*
+       * mark[I] = J + 1 once the block (I,J) has been created, and
+       * cur[I] is the next free block of block row I
+       */
+      memset(mark, 0, mb * sizeof(size_t));
+      memcpy(cur, m->p, mb * sizeof(size_t));
+
+      for (J = 0; J < m->nb; ++J)
+        {
+          for (j = J * b; j < (J + 1) * b; ++j)
+            {
+              for (p = S->p[j]; p < S->p[j + 1]; ++p)
+                {
+                  const size_t i = S->i[p];
+                  const size_t k = i / b;
+
+                  if (mark[k] != J + 1)
+                    {
+                      mark[k] = J + 1;
+                      m->j[cur[k]++] = J;
+                    }
+
+                  m->data[(cur[k] - 1) * bb + (i % b) * b + j % b] +=
+                    S->data[p];
+                }
+            }
+        }
+
+      free(mark);
+      if (B)
+        gsl_spmatrix_free(B);
+
+      return m;
+    }
+} /* gsl_spmatrix_bsr_alloc() */
+
+/*
+gsl_spmatrix_bsr_free()
+  Free a block sparse row matrix
+*/
+
+void
+gsl_spmatrix_bsr_free(gsl_spmatrix_bsr *m)
+{
+  if (m->p)
+    free(m->p);
+
+  if (m->j)
+    free(m->j);
+
+  if (m->data)
+    free(m->data);
+
+  free(m);
+} /* gsl_spmatrix_bsr_free() */
+
+/*
+gsl_spmatrix_bsr_blocksize()
+  Detect the block structure of a sparse matrix
+
+Inputs: A       - sparse matrix in triplet, CCS or CRS format, without
+                  symmetric storage
+        maxfill - maximum fill ratio, >= 1
+
+Return: the largest block size b <= GSL_SPMATRIX_BSR_MAXB, dividing
+both dimensions of A, for which the BSR matrix stores at most
+maxfill*nz elements (including explicit zeros); 0 on error
+
+Notes:
+1) With maxfill = 1 only block sizes for which every block is
+completely filled are accepted. b = 1 always qualifies
+
+2) The number of blocks is counted in O(nz) time for each candidate
+block size, without forming the BSR matrix
+*/
+
+size_t
+gsl_spmatrix_bsr_blocksize(const gsl_spmatrix *A, const double maxfill)
+{
+  if (maxfill < 1.0)
+    {
+      GSL_ERROR_VAL("maxfill must be at least 1", GSL_EINVAL, 0);
+    }
+  else if (GSLSP_ISSYMMETRIC(A))
+    {
+      GSL_ERROR_VAL("symmetric storage is not supported", GSL_EINVAL, 0);
+    }
+  else
+    {
+      gsl_spmatrix *B = bsr_ccs(A);
+      const gsl_spmatrix *S = B ? B : A;
+      size_t *mark;
+      size_t b;
+
+      if (!GSLSP_ISCCS(S))
+        return 0;
+
+      mark = malloc((A->size1 + 1) * sizeof(size_t));
+      if (!mark)
+        {
+          if (B)
+            gsl_spmatrix_free(B);
+          GSL_ERROR_VAL("failed to allocate space for mark", GSL_ENOMEM, 0);
+        }
+
+      for (b = GSL_SPMATRIX_BSR_MAXB; b > 1; --b)
+        {
+          size_t nzb;
+
+          if (A->size1 % b != 0 || A->size2 % b != 0)
+            continue;
+
+          nzb = bsr_count(S, b, mark, NULL);
+          if ((double) (nzb * b * b) <= maxfill * (double) S->nz)
+            break;
+        }
+
+      free(mark);
+      if (B)
+        gsl_spmatrix_free(B);
+
+      return b;
+    }
+} /* gsl_spmatrix_bsr_blocksize() */
+
+/*
+gsl_spmatrix_bsr_get()
+  Return element (i,j) of a block sparse row matrix
+*/
+
+double
+gsl_spmatrix_bsr_get(const gsl_spmatrix_bsr *m, const size_t i,
+                     const size_t j)
+{
+  if (i >= m->size1)
+    {
+      GSL_ERROR_VAL("first index out of range", GSL_EINVAL, 0.0);
+    }
+  else if (j >= m->size2)
+    {
+      GSL_ERROR_VAL("second index out of range", GSL_EINVAL, 0.0);
+    }
+  else
+    {
+      const size_t b = m->b;
+      const size_t I = i / b;
+      const size_t J = j / b;
+      size_t p;
+
+      for (p = m->p[I]; p < m->p[I + 1]; ++p)
+        {
+          if (m->j[p] == J)
+            return m->data[p * b * b + (i % b) * b + j % b];
+        }
+
+      return 0.0;
+    }
+} /* gsl_spmatrix_bsr_get() */
+
+/*
+gsl_spblas_bsr_dgemv()
+  Multiply a block sparse row matrix and a vector
+
+Inputs: alpha - scalar factor
+        A     - BSR matrix
+        x     - dense vector
+        beta  - scalar factor
+        y     - (input/output) dense vector
+
+Return: y = alpha*A*x + beta*y
+
+Notes:
+1) Block sizes 2, 3 and 4 have kernels with fully unrolled block
+products, which keep the b sums of a block row and the b elements of
+x in registers
+
+2) With more than one thread, the block rows are split into ranges
+with approximately equal numbers of blocks. Each element of y is
+computed by one thread in the same order as the serial code, so the
+result does not depend on the number of threads
+*/
+
+int
+gsl_spblas_bsr_dgemv(const double alpha, const gsl_spmatrix_bsr *A,
+                     const gsl_vector *x, const double beta, gsl_vector *y)
+{
+  if (A->size2 != x->size)
+    {
+      GSL_ERROR("invalid length of x vector", GSL_EBADLEN);
+    }
+  else if (A->size1 != y->size)
+    {
+      GSL_ERROR("invalid length of y vector", GSL_EBADLEN);
+    }
+  else
+    {
+      const size_t nthreads = gsl_spblas_get_num_threads();
+      double *Y = y->data;
+      const size_t incY = y->stride;
+
+      if (alpha == 0.0)
+        {
+          size_t i;
+
+          for (i = 0; i < A->size1; ++i)
+            Y[i * incY] = (beta == 0.0) ? 0.0 : beta * Y[i * incY];
+        }
+      else if (nthreads == 1)
+        {
+          bsr_mv(alpha, A, 0, A->mb, x->data, x->stride, beta, Y, incY);
+        }
+      else
+        {
+          size_t *part = malloc((nthreads + 1) * sizeof(size_t));
+          long t;
+
+          if (!part)
+            {
+              GSL_ERROR("failed to allocate space for partition",
+                        GSL_ENOMEM);
+            }
+
+          spthread_partition(A->p, A->mb, nthreads, part);
+
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+          for (t = 0; t < (long) nthreads; ++t)
+            {
+              bsr_mv(alpha, A, part[t], part[t + 1], x->data, x->stride,
+                     beta, Y, incY);
+            }
+
+          free(part);
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_spblas_bsr_dgemv() */
+
+/*
+gsl_spblas_bsr_dgemm_dense()
+  Multiply a block sparse row matrix and a dense matrix
+
+Inputs: alpha - scalar factor
+        A     - BSR matrix, M-by-N
+        X     - dense matrix, N-by-K
+        beta  - scalar factor
+        Y     - (input/output) dense matrix, M-by-K
+
+Return: Y = alpha*A*X + beta*Y
+
+Notes:
+1) Each row of a block is applied to the b rows of X it references
+in a single sweep over the row of Y; block sizes 2, 3 and 4 have
+unrolled sweeps. The inner loops run over contiguous rows of X and Y
+and can be vectorized by the compiler
+
+2) The block rows are split between threads as in
+gsl_spblas_bsr_dgemv(), and the result does not depend on the number
+of threads
+*/
+
+int
+gsl_spblas_bsr_dgemm_dense(const double alpha, const gsl_spmatrix_bsr *A,
+                           const gsl_matrix *X, const double beta,
+                           gsl_matrix *Y)
+{
+  if (A->size2 != X->size1)
+    {
+      GSL_ERROR("X matrix must have size2(A) rows", GSL_EBADLEN);
+    }
+  else if (A->size1 != Y->size1 || X->size2 != Y->size2)
+    {
+      GSL_ERROR("Y matrix must be size1(A)-by-size2(X)", GSL_EBADLEN);
+    }
+  else
+    {
+      const size_t nthreads = gsl_spblas_get_num_threads();
+
+      if (nthreads == 1)
+        {
+          bsr_mm(alpha, A, 0, A->mb, X, beta, Y);
+        }
+      else
+        {
+          size_t *part = malloc((nthreads + 1) * sizeof(size_t));
+          long t;
+
+          if (!part)
+            {
+              GSL_ERROR("failed to allocate space for partition",
+                        GSL_ENOMEM);
+            }
+
+          spthread_partition(A->p, A->mb, nthreads, part);
+
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+          for (t = 0; t < (long) nthreads; ++t)
+            bsr_mm(alpha, A, part[t], part[t + 1], X, beta, Y);
+
+          free(part);
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_spblas_bsr_dgemm_dense() */
+
+/*
+bsr_ccs()
+  Return the CCS form of A if it must be created, or NULL if A is
+already in CCS format (or on error)
+*/
+
+static gsl_spmatrix *
+bsr_ccs(const gsl_spmatrix *A)
+{
+  if (GSLSP_ISCCS(A))
+    return NULL;
+  else if (GSLSP_ISCRS(A))
+    {
+      gsl_spmatrix *B = gsl_spmatrix_transpose_memcpy(A);
+
+      /* the arrays of A^T in CRS format are those of A in CCS format */
+      if (B)
+        {
+          B->size1 = A->size1;
+          B->size2 = A->size2;
+          B->flags = (B->flags & ~GSL_SPMATRIX_CRS) | GSL_SPMATRIX_CCS;
+        }
+
+      return B;
+    }
+  else
+    return gsl_spmatrix_compress(A);
+} /* bsr_ccs() */
+
+/*
+bsr_count()
+  Count the b-by-b blocks of a CCS matrix
+
+Inputs: A    - CCS matrix
+        b    - block size
+        mark - workspace of size size1/b
+        cnt  - (output) number of blocks in each block row, or NULL
+
+Return: total number of blocks
+*/
+
+static size_t
+bsr_count(const gsl_spmatrix *A, const size_t b, size_t *mark, size_t *cnt)
+{
+  const size_t mb = A->size1 / b;
+  size_t nzb = 0;
+  size_t J, j, p;
+
+  memset(mark, 0, mb * sizeof(size_t));
+  if (cnt)
+    memset(cnt, 0, mb * sizeof(size_t));
+
+  for (J = 0; J < A->size2 / b; ++J)
+    {
+      for (j = J * b; j < (J + 1) * b; ++j)
+        {
+          for (p = A->p[j]; p < A->p[j + 1]; ++p)
+            {
+              const size_t I = A->i[p] / b;
+
+              if (mark[I] != J + 1)
+                {
+                  mark[I] = J + 1;
+                  ++nzb;
+                  if (cnt)
+                    ++cnt[I];
+                }
+            }
+        }
+    }
+
+  return nzb;
+} /* bsr_count() */
+
+/*
+bsr_mv()
+  y(I0*b:I1*b-1) := alpha*A(I0*b:I1*b-1,:)*x + beta*y(I0*b:I1*b-1)
+*/
+
+static void
+bsr_mv(const double alpha, const gsl_spmatrix_bsr *A, const size_t I0,
+       const size_t I1, const double *X, const size_t incX,
+       const double beta, double *Y, const size_t incY)
+{
+  const size_t b = A->b;
+  const size_t *Ap = A->p;
+  const size_t *Aj = A->j;
+  const double *Ad = A->data;
+  double t[GSL_SPMATRIX_BSR_MAXB];
+  size_t I, p, r, c;
+
+  for (I = I0; I < I1; ++I)
+    {
+      double *y = Y + I * b * incY;
+
+      switch (b)
+        {
+          case 2:
+            {
+              double t0 = 0.0, t1 = 0.0;
+
+              for (p = Ap[I]; p < Ap[I + 1]; ++p)
+                {
+                  const double *a = Ad + 4 * p;
+                  const double *x = X + 2 * Aj[p] * incX;
+                  const double x0 = x[0], x1 = x[incX];
+
+                  t0 += a[0] * x0 + a[1] * x1;
+                  t1 += a[2] * x0 + a[3] * x1;
+                }
+
+              t[0] = t0;
+              t[1] = t1;
+              break;
+            }
+
+          case 3:
+            {
+              double t0 = 0.0, t1 = 0.0, t2 = 0.0;
+
+              for (p = Ap[I]; p < Ap[I + 1]; ++p)
+                {
+                  const double *a = Ad + 9 * p;
+                  const double *x = X + 3 * Aj[p] * incX;
+                  const double x0 = x[0], x1 = x[incX], x2 = x[2 * incX];
+
+                  t0 += a[0] * x0 + a[1] * x1 + a[2] * x2;
+                  t1 += a[3] * x0 + a[4] * x1 + a[5] * x2;
+                  t2 += a[6] * x0 + a[7] * x1 + a[8] * x2;
+                }
+
+              t[0] = t0;
+              t[1] = t1;
+              t[2] = t2;
+              break;
+            }
+
+          case 4:
+            {
+              double t0 = 0.0, t1 = 0.0, t2 = 0.0, t3 = 0.0;
+
+              for (p = Ap[I]; p < Ap[I + 1]; ++p)
+                {
+                  const double *a = Ad + 16 * p;
+                  const double *x = X + 4 * Aj[p] * incX;
+                  const double x0 = x[0], x1 = x[incX];
+                  const double x2 = x[2 * incX], x3 = x[3 * incX];
+
+                  t0 += a[0] * x0 + a[1] * x1 + a[2] * x2 + a[3] * x3;
+                  t1 += a[4] * x0 + a[5] * x1 + a[6] * x2 + a[7] * x3;
+                  t2 += a[8] * x0 + a[9] * x1 + a[10] * x2 + a[11] * x3;
+                  t3 += a[12] * x0 + a[13] * x1 + a[14] * x2 + a[15] * x3;
+                }
+
+              t[0] = t0;
+              t[1] = t1;
+              t[2] = t2;
+              t[3] = t3;
+              break;
+            }
+
+          default:
+            for (r = 0; r < b; ++r)
+              t[r] = 0.0;
+
+            for (p = Ap[I]; p < Ap[I + 1]; ++p)
+              {
+                const double *a = Ad + b * b * p;
+                const double *x = X + b * Aj[p] * incX;
+
+                for (r = 0; r < b; ++r)
+                  {
+                    for (c = 0; c < b; ++c)
+                      t[r] += a[r * b + c] * x[c * incX];
+                  }
+              }
+            break;
+        }
+
+      for (r = 0; r < b; ++r)
+        {
+          if (beta == 0.0)
+            y[r * incY] = alpha * t[r];
+          else
+            y[r * incY] = alpha * t[r] + beta * y[r * incY];
+        }
+    }
+} /* bsr_mv() */
+
+/*
+bsr_mm()
+  Y(I0*b:I1*b-1,:) := alpha*A(I0*b:I1*b-1,:)*X + beta*Y(I0*b:I1*b-1,:)
+*/
+
+static void
+bsr_mm(const double alpha, const gsl_spmatrix_bsr *A, const size_t I0,
+       const size_t I1, const gsl_matrix *X, const double beta,
+       gsl_matrix *Y)
+{
+  const size_t b = A->b;
+  const size_t K = X->size2;
+  const size_t tdx = X->tda;
+  const size_t tdy = Y->tda;
+  size_t I, p, r, c, k;
+
+  for (I = I0; I < I1; ++I)
+    {
+      for (r = 0; r < b; ++r)
+        {
+          double *y = Y->data + (I * b + r) * tdy;
+
+          if (beta == 0.0)
+            {
+              for (k = 0; k < K; ++k)
+                y[k] = 0.0;
+            }
+          else if (beta != 1.0)
+            {
+              for (k = 0; k < K; ++k)
+                y[k] *= beta;
+            }
+        }
+
+      if (alpha == 0.0)
+        continue;
+
+      for (p = A->p[I]; p < A->p[I + 1]; ++p)
+        {
+          const double *blk = A->data + b * b * p;
+          const double *x0 = X->data + b * A->j[p] * tdx;
+
+          for (r = 0; r < b; ++r)
+            {
+              const double *a = blk + r * b;
+              double *y = Y->data + (I * b + r) * tdy;
+
+              switch (b)
+                {
+                  case 2:
+                    {
+                      const double a0 = alpha * a[0], a1 = alpha * a[1];
+                      const double *x1 = x0 + tdx;
+
+                      for (k = 0; k < K; ++k)
+                        y[k] += a0 * x0[k] + a1 * x1[k];
+                      break;
+                    }
+
+                  case 3:
+                    {
+                      const double a0 = alpha * a[0], a1 = alpha * a[1];
+                      const double a2 = alpha * a[2];
+                      const double *x1 = x0 + tdx, *x2 = x1 + tdx;
+
+                      for (k = 0; k < K; ++k)
+                        y[k] += a0 * x0[k] + a1 * x1[k] + a2 * x2[k];
+                      break;
+                    }
+
+                  case 4:
+                    {
+                      const double a0 = alpha * a[0], a1 = alpha * a[1];
+                      const double a2 = alpha * a[2], a3 = alpha * a[3];
+                      const double *x1 = x0 + tdx, *x2 = x1 + tdx;
+                      const double *x3 = x2 + tdx;
+
+                      for (k = 0; k < K; ++k)
+                        y[k] += a0 * x0[k] + a1 * x1[k] + a2 * x2[k] +
+                                a3 * x3[k];
+                      break;
+                    }
+
+                  default:
+                    for (c = 0; c < b; ++c)
+                      {
+                        const double ac = alpha * a[c];
+                        const double *x = x0 + c * tdx;
+
+                        for (k = 0; k < K; ++k)
+                          y[k] += ac * x[k];
+                      }
+                    break;
+                }
+            }
+        }
+    }
+} /* bsr_mm() */
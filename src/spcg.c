@@ -0,0 +1,282 @@
+/* spcg.c
+ *
+ * Copyright (C) 2012-2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "gsl_splinalg.h"
+
+/*
+ * The code in this module performs the (preconditioned) conjugate
+ * gradient method for symmetric positive definite matrices A
+ *
+ * References:
+ *
+ * [1] Saad, Y., Iterative Methods for Sparse Linear Systems, 2nd ed,
+ *     SIAM, 2003, Algorithm 9.1
+ */
+
+typedef struct
+{
+  size_t n;        /* size of linear system */
+  size_t maxiter;  /* maximum iterations per call to cg_iterate() */
+
+  gsl_vector *r;   /* residual vector r = b - A x, size n */
+  gsl_vector *z;   /* preconditioned residual z = M^{-1} r, size n */
+  gsl_vector *p;   /* search direction, size n */
+  gsl_vector *q;   /* q = A p, size n */
+
+  double normr;    /* residual norm || r || */
+} cg_state_t;
+
+static void *cg_alloc(const size_t n, const size_t m);
+static int cg_iterate(const gsl_spmatrix *A, const gsl_vector *b,
+                      const double tol, const gsl_splinalg_precond *P,
+                      gsl_vector *x, size_t *niter, void *vstate);
+static double cg_normr(const void *vstate);
+static void cg_free(void *vstate);
+
+/*
+cg_alloc()
+  Allocate CG workspace
+
+Inputs: n - size of linear system
+        m - maximum number of iterations per call to cg_iterate();
+            if 0, n is used
+
+Return: pointer to workspace
+*/
+
+static void *
+cg_alloc(const size_t n, const size_t m)
+{
+  cg_state_t *state;
+
+  state = calloc(1, sizeof(cg_state_t));
+  if (!state)
+    {
+      GSL_ERROR_NULL("failed to allocate cg state", GSL_ENOMEM);
+    }
+
+  state->n = n;
+  state->maxiter = (m > 0) ? m : n;
+
+  state->r = gsl_vector_alloc(n);
+  state->z = gsl_vector_alloc(n);
+  state->p = gsl_vector_alloc(n);
+  state->q = gsl_vector_alloc(n);
+  if (!state->r || !state->z || !state->p || !state->q)
+    {
+      cg_free(state);
+      GSL_ERROR_NULL("failed to allocate cg vectors", GSL_ENOMEM);
+    }
+
+  state->normr = 0.0;
+
+  return state;
+} /* cg_alloc() */
+
+/*
+cg_iterate()
+  Perform up to state->maxiter CG iterations
+
+Inputs: A      - symmetric positive definite sparse matrix
+        b      - right hand side vector
+        tol    - relative tolerance
+        P      - preconditioner (symmetric positive definite) or NULL
+        x      - (input/output) on input, initial guess; on output,
+                 updated solution
+        niter  - (output) number of iterations performed
+        vstate - workspace
+
+Return: GSL_SUCCESS if || b - A x || <= tol * || b ||, GSL_CONTINUE if
+maxiter iterations were performed without converging, or an error code
+
+Notes:
+1) The residual is computed explicitly as b - A x on entry, and then
+updated recursively. Each iteration requires one matrix-vector product,
+two dot products and two vector loops: the updates of x and r and the
+norm of r are computed in a single pass, and the new search direction
+in a second pass
+
+2) Without a preconditioner, z = r is not stored separately
+*/
+
+static int
+cg_iterate(const gsl_spmatrix *A, const gsl_vector *b, const double tol,
+           const gsl_splinalg_precond *P, gsl_vector *x, size_t *niter,
+           void *vstate)
+{
+  cg_state_t *state = (cg_state_t *) vstate;
+  const size_t n = state->n;
+  gsl_vector *r = state->r;
+  gsl_vector *z = P ? state->z : state->r;
+  gsl_vector *p = state->p;
+  gsl_vector *q = state->q;
+  double *X = x->data;
+  const size_t incX = x->stride;
+  double *R = r->data;
+  double *Z = z->data;
+  double *Pd = p->data;
+  double *Q = q->data;
+  const double normb = gsl_blas_dnrm2(b);
+  double rho, pq;
+  size_t i, k;
+  int status;
+
+  *niter = 0;
+
+  if (n != r->size)
+    {
+      GSL_ERROR("matrix does not match workspace", GSL_EBADLEN);
+    }
+
+  if (normb == 0.0)
+    {
+      /* A x = 0 has the solution x = 0 */
+      for (i = 0; i < n; ++i)
+        X[i * incX] = 0.0;
+
+      state->normr = 0.0;
+      return GSL_SUCCESS;
+    }
+
+  /* r = b - A x */
+  gsl_vector_memcpy(r, b);
+  gsl_spblas_dgemv(CblasNoTrans, -1.0, A, x, 1.0, r);
+
+  state->normr = gsl_blas_dnrm2(r);
+  if (state->normr <= tol * normb)
+    return GSL_SUCCESS;
+
+  /* z = M^{-1} r, rho = r.z, p = z */
+  if (P)
+    {
+      status = P->solve(r, z, P->params);
+      if (status)
+        return status;
+
+      gsl_blas_ddot(r, z, &rho);
+    }
+  else
+    {
+      rho = state->normr * state->normr;
+    }
+
+  gsl_vector_memcpy(p, z);
+
+  for (k = 0; k < state->maxiter; ++k)
+    {
+      double alpha, beta, rho_new;
+      double rr = 0.0;
+
+      /* q = A p */
+      gsl_spblas_dgemv(CblasNoTrans, 1.0, A, p, 0.0, q);
+
+      gsl_blas_ddot(p, q, &pq);
+      if (pq <= 0.0 || rho <= 0.0)
+        {
+          GSL_ERROR("matrix or preconditioner is not positive definite",
+                    GSL_EDOM);
+        }
+
+      alpha = rho / pq;
+
+      /* x = x + alpha p, r = r - alpha q, rr = r.r */
+      for (i = 0; i < n; ++i)
+        {
+          X[i * incX] += alpha * Pd[i];
+          R[i] -= alpha * Q[i];
+          rr += R[i] * R[i];
+        }
+
+      ++(*niter);
+
+      state->normr = sqrt(rr);
+      if (state->normr <= tol * normb)
+        return GSL_SUCCESS;
+
+      if (P)
+        {
+          status = P->solve(r, z, P->params);
+          if (status)
+            return status;
+
+          gsl_blas_ddot(r, z, &rho_new);
+        }
+      else
+        {
+          rho_new = rr;
+        }
+
+      beta = rho_new / rho;
+      rho = rho_new;
+
+      /* p = z + beta p */
+      for (i = 0; i < n; ++i)
+        Pd[i] = Z[i] + beta * Pd[i];
+    }
+
+  return GSL_CONTINUE;
+} /* cg_iterate() */
+
+static double
+cg_normr(const void *vstate)
+{
+  const cg_state_t *state = (const cg_state_t *) vstate;
+  return state->normr;
+} /* cg_normr() */
+
+static void
+cg_free(void *vstate)
+{
+  cg_state_t *state = (cg_state_t *) vstate;
+
+  if (state->r)
+    gsl_vector_free(state->r);
+
+  if (state->z)
+    gsl_vector_free(state->z);
+
+  if (state->p)
+    gsl_vector_free(state->p);
+
+  if (state->q)
+    gsl_vector_free(state->q);
+
+  free(state);
+} /* cg_free() */
+
+static const gsl_splinalg_itersolve_type cg_type =
+{
+  "cg",
+  &cg_alloc,
+  &cg_iterate,
+  &cg_normr,
+  &cg_free
+};
+
+const gsl_splinalg_itersolve_type * gsl_splinalg_itersolve_cg = &cg_type;
@@ -0,0 +1,687 @@
+/* spcholesky.c
+ *
+ * Copyright (C) 2012-2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "gsl_splinalg.h"
+
+/*
+ * The code in this module computes the sparse Cholesky factorization
+ * A = L L^T of a symmetric positive definite matrix A in compressed
+ * column format, using the lower triangle of A.
+ *
+ * The symbolic phase (gsl_splinalg_cholesky_alloc) computes the
+ * elimination tree of A, the number of non-zero elements in each column
+ * of L, and the partition of the columns of L into fundamental
+ * supernodes: sets of consecutive columns sharing the same sparsity
+ * pattern below the diagonal. Each supernode is stored as a dense
+ * column-major block, so that the numeric phase
+ * (gsl_splinalg_cholesky_decomp) is a left-looking sequence of dense
+ * matrix products, dense Cholesky factorizations and triangular solves.
+ *
+ * References:
+ *
+ * [1] Davis, T. A., Direct Methods for Sparse Linear Systems, SIAM, 2006
+ *
+ * [2] Ng, E. G. and Peyton, B. W., Block sparse Cholesky algorithms on
+ *     advanced uniprocessor computers, SIAM J. Sci. Comput., 14, 1993
+ */
+
+/* marker for the root of the elimination tree and end of lists */
+#define CHOL_NONE     ((size_t) -1)
+
+static int chol_lower(const gsl_spmatrix *A, size_t *rp, size_t **ri);
+static void chol_etree(const size_t n, const size_t *rp, const size_t *ri,
+                       size_t *parent, size_t *ancestor);
+static int chol_block_factor(const size_t s,
+                             gsl_splinalg_cholesky_workspace *w);
+
+/*
+gsl_splinalg_cholesky_alloc()
+  Perform the symbolic analysis of the Cholesky factorization of A
+and allocate the storage for L
+
+Inputs: A - symmetric square matrix in compressed column format. Only
+            the lower triangle (including the diagonal) is used
+
+Return: pointer to workspace
+
+Notes:
+1) Row k of L has the pattern of the set of nodes reachable in the
+elimination tree from the columns j < k of row k of A, stopping at k.
+These sets are traversed twice: first to count the elements of each
+column of L, and once the supernodes are known, to store the row
+indices of the first column of each supernode. The total cost is
+proportional to the number of non-zero elements of L
+
+2) Column j + 1 is added to the supernode of column j when it is the
+only child of j in the elimination tree and has one less element than
+column j, so that both columns have the same pattern below the diagonal
+*/
+
+gsl_splinalg_cholesky_workspace *
+gsl_splinalg_cholesky_alloc(const gsl_spmatrix *A)
+{
+  gsl_splinalg_cholesky_workspace *w;
+  size_t *rp, *ri = NULL, *flag, *nchild;
+  size_t n, i, j, k, p, s, maxrows = 0, maxcols = 0;
+
+  if (A->size1 != A->size2)
+    {
+      GSL_ERROR_NULL("matrix must be square", GSL_ENOTSQR);
+    }
+  else if (!GSLSP_ISCCS(A))
+    {
+      GSL_ERROR_NULL("matrix must be in compressed column format",
+                     GSL_EINVAL);
+    }
+
+  n = A->size1;
+
+  w = calloc(1, sizeof(gsl_splinalg_cholesky_workspace));
+  if (!w)
+    {
+      GSL_ERROR_NULL("failed to allocate space for cholesky struct",
+                     GSL_ENOMEM);
+    }
+
+  w->n = n;
+
+  w->parent = malloc(GSL_MAX(n, 1) * sizeof(size_t));
+  w->colcount = malloc(GSL_MAX(n, 1) * sizeof(size_t));
+  w->col2super = malloc(GSL_MAX(n, 1) * sizeof(size_t));
+  w->super = malloc((n + 1) * sizeof(size_t));
+  w->map = malloc(GSL_MAX(n, 1) * sizeof(size_t));
+  rp = malloc((n + 1) * sizeof(size_t));
+  flag = malloc(GSL_MAX(n, 1) * sizeof(size_t));
+  nchild = calloc(GSL_MAX(n, 1), sizeof(size_t));
+  if (!w->parent || !w->colcount || !w->col2super || !w->super ||
+      !w->map || !rp || !flag || !nchild || chol_lower(A, rp, &ri))
+    {
+      free(rp);
+      free(ri);
+      free(flag);
+      free(nchild);
+      gsl_splinalg_cholesky_free(w);
+      GSL_ERROR_NULL("failed to allocate space for cholesky workspace",
+                     GSL_ENOMEM);
+    }
+
+  chol_etree(n, rp, ri, w->parent, flag);
+
+  /* count the elements of each column of L from the row patterns */
+  for (k = 0; k < n; ++k)
+    {
+      w->colcount[k] = 1;
+      flag[k] = k;
+
+      for (p = rp[k]; p < rp[k + 1]; ++p)
+        {
+          for (i = ri[p]; flag[i] != k; i = w->parent[i])
+            {
+              w->colcount[i]++;
+              flag[i] = k;
+            }
+        }
+
+      if (w->parent[k] != CHOL_NONE)
+        nchild[w->parent[k]]++;
+    }
+
+  /* fundamental supernodes */
+  w->nsuper = 0;
+  for (j = 0; j < n; ++j)
+    {
+      if (j == 0 || w->parent[j - 1] != j || nchild[j] != 1 ||
+          w->colcount[j - 1] != w->colcount[j] + 1)
+        w->super[w->nsuper++] = j;
+
+      w->col2super[j] = w->nsuper - 1;
+    }
+
+  w->super[w->nsuper] = n;
+
+  w->rowptr = malloc((w->nsuper + 1) * sizeof(size_t));
+  w->blkptr = malloc((w->nsuper + 1) * sizeof(size_t));
+  w->head = malloc(GSL_MAX(w->nsuper, 1) * sizeof(size_t));
+  w->next = malloc(GSL_MAX(w->nsuper, 1) * sizeof(size_t));
+  w->pos = malloc(GSL_MAX(w->nsuper, 1) * sizeof(size_t));
+  if (!w->rowptr || !w->blkptr || !w->head || !w->next || !w->pos)
+    {
+      free(rp);
+      free(ri);
+      free(flag);
+      free(nchild);
+      gsl_splinalg_cholesky_free(w);
+      GSL_ERROR_NULL("failed to allocate space for supernodes", GSL_ENOMEM);
+    }
+
+  w->nnz = 0;
+  w->rowptr[0] = 0;
+  w->blkptr[0] = 0;
+  for (s = 0; s < w->nsuper; ++s)
+    {
+      const size_t ncols = w->super[s + 1] - w->super[s];
+      const size_t nrows = w->colcount[w->super[s]];
+
+      for (j = w->super[s]; j < w->super[s + 1]; ++j)
+        w->nnz += w->colcount[j];
+
+      w->rowptr[s + 1] = w->rowptr[s] + nrows;
+      w->blkptr[s + 1] = w->blkptr[s] + nrows * ncols;
+
+      maxrows = GSL_MAX(maxrows, nrows);
+      maxcols = GSL_MAX(maxcols, ncols);
+
+      w->head[s] = CHOL_NONE;
+    }
+
+  w->rowind = malloc(GSL_MAX(w->rowptr[w->nsuper], 1) * sizeof(size_t));
+  w->blk = malloc(GSL_MAX(w->blkptr[w->nsuper], 1) * sizeof(double));
+  w->worksize = maxrows * maxcols;
+  w->work = malloc(GSL_MAX(w->worksize, 1) * sizeof(double));
+  if (!w->rowind || !w->blk || !w->work)
+    {
+      free(rp);
+      free(ri);
+      free(flag);
+      free(nchild);
+      gsl_splinalg_cholesky_free(w);
+      GSL_ERROR_NULL("failed to allocate space for cholesky factor",
+                     GSL_ENOMEM);
+    }
+
+  /*
+   * store the pattern of the first column of each supernode; rows
+   * are visited in increasing order, so the row indices are sorted
+   * with the columns of the supernode first. nchild[] is reused as
+   * the insertion pointer of each supernode
+   */
+  for (s = 0; s < w->nsuper; ++s)
+    nchild[s] = w->rowptr[s];
+
+  for (k = 0; k < n; ++k)
+    {
+      flag[k] = CHOL_NONE;
+      w->map[k] = CHOL_NONE;
+    }
+
+  for (k = 0; k < n; ++k)
+    {
+      flag[k] = k;
+
+      if (w->super[w->col2super[k]] == k)
+        w->rowind[nchild[w->col2super[k]]++] = k;
+
+      for (p = rp[k]; p < rp[k + 1]; ++p)
+        {
+          for (i = ri[p]; flag[i] != k; i = w->parent[i])
+            {
+              if (w->super[w->col2super[i]] == i)
+                w->rowind[nchild[w->col2super[i]]++] = k;
+
+              flag[i] = k;
+            }
+        }
+    }
+
+  free(rp);
+  free(ri);
+  free(flag);
+  free(nchild);
+
+  return w;
+} /* gsl_splinalg_cholesky_alloc() */
+
+void
+gsl_splinalg_cholesky_free(gsl_splinalg_cholesky_workspace *w)
+{
+  if (w->parent)
+    free(w->parent);
+
+  if (w->colcount)
+    free(w->colcount);
+
+  if (w->super)
+    free(w->super);
+
+  if (w->col2super)
+    free(w->col2super);
+
+  if (w->rowptr)
+    free(w->rowptr);
+
+  if (w->rowind)
+    free(w->rowind);
+
+  if (w->blkptr)
+    free(w->blkptr);
+
+  if (w->blk)
+    free(w->blk);
+
+  if (w->map)
+    free(w->map);
+
+  if (w->head)
+    free(w->head);
+
+  if (w->next)
+    free(w->next);
+
+  if (w->pos)
+    free(w->pos);
+
+  if (w->work)
+    free(w->work);
+
+  free(w);
+} /* gsl_splinalg_cholesky_free() */
+
+/*
+gsl_splinalg_cholesky_decomp()
+  Compute the Cholesky factorization A = L L^T
+
+Inputs: A - symmetric positive definite matrix with the same sparsity
+            pattern as the matrix given to gsl_splinalg_cholesky_alloc()
+        w - workspace
+
+Return: success or error
+
+Notes:
+1) The supernodes are factored in order (left-looking). Supernode s is
+first updated by every previous supernode d having elements in the rows
+of the columns of s: the block of rows of d from the first row in s
+downward is multiplied by the transpose of its rows within s, using
+gsl_blas_dgemm(), and the result is subtracted from s. The diagonal
+block of s is then factored with gsl_linalg_cholesky_decomp() and the
+rows below it are computed with gsl_blas_dtrsm()
+
+2) The supernodes which update s are found from linked lists: once d is
+factored, it is linked into the list of the supernode containing its
+next row which has not yet been used, so that no search is required
+
+3) No memory is allocated, so this function may be called any number of
+times for matrices with the same pattern
+*/
+
+int
+gsl_splinalg_cholesky_decomp(const gsl_spmatrix *A,
+                             gsl_splinalg_cholesky_workspace *w)
+{
+  if (A->size1 != w->n || A->size2 != w->n || !GSLSP_ISCCS(A))
+    {
+      GSL_ERROR("matrix does not match workspace", GSL_EBADLEN);
+    }
+  else
+    {
+      size_t s;
+
+      for (s = 0; s < w->nsuper; ++s)
+        w->head[s] = CHOL_NONE;
+
+      for (s = 0; s < w->nsuper; ++s)
+        {
+          const size_t f = w->super[s];
+          const size_t l = w->super[s + 1];
+          const size_t nrows = w->rowptr[s + 1] - w->rowptr[s];
+          const size_t *rows = w->rowind + w->rowptr[s];
+          double *Ls = w->blk + w->blkptr[s];
+          size_t d, j, p, r;
+          int status = GSL_SUCCESS;
+
+          for (r = 0; r < nrows; ++r)
+            w->map[rows[r]] = r;
+
+          /* assemble columns f..l-1 of the lower triangle of A */
+          for (p = 0; p < nrows * (l - f); ++p)
+            Ls[p] = 0.0;
+
+          for (j = f; j < l && !status; ++j)
+            {
+              double *Lj = Ls + (j - f) * nrows;
+
+              for (p = A->p[j]; p < A->p[j + 1]; ++p)
+                {
+                  if (A->i[p] < j)
+                    continue;
+
+                  if (w->map[A->i[p]] == CHOL_NONE)
+                    status = GSL_EINVAL;
+                  else
+                    Lj[w->map[A->i[p]]] += A->data[p];
+                }
+            }
+
+          /* updates from the supernodes d with elements in rows f..l-1 */
+          for (d = w->head[s]; d != CHOL_NONE && !status; )
+            {
+              const size_t dnext = w->next[d];
+              const size_t nd = w->rowptr[d + 1] - w->rowptr[d];
+              const size_t kd = w->super[d + 1] - w->super[d];
+              const size_t *drows = w->rowind + w->rowptr[d];
+              double *Ld = w->blk + w->blkptr[d];
+              const size_t p1 = w->pos[d];
+              size_t p2 = p1, a, b;
+
+              while (p2 < nd && drows[p2] < l)
+                ++p2;
+
+              {
+                /* rows of the column-major block of d are columns here */
+                const size_t m1 = nd - p1;
+                const size_t m2 = p2 - p1;
+                gsl_matrix_view B1 =
+                  gsl_matrix_view_array_with_tda(Ld + p1, kd, m1, nd);
+                gsl_matrix_view B2 =
+                  gsl_matrix_view_array_with_tda(Ld + p1, kd, m2, nd);
+                gsl_matrix_view C = gsl_matrix_view_array(w->work, m2, m1);
+
+                /* C = L_d(p1:p2,:) L_d(p1:nd,:)^T */
+                gsl_blas_dgemm(CblasTrans, CblasNoTrans, 1.0, &B2.matrix,
+                               &B1.matrix, 0.0, &C.matrix);
+
+                for (a = 0; a < m2; ++a)
+                  {
+                    double *Lj = Ls + (drows[p1 + a] - f) * nrows;
+                    const double *Ca = w->work + a * m1;
+
+                    for (b = a; b < m1; ++b)
+                      Lj[w->map[drows[p1 + b]]] -= Ca[b];
+                  }
+              }
+
+              /* link d to the supernode containing its next row */
+              w->pos[d] = p2;
+              if (p2 < nd)
+                {
+                  const size_t t = w->col2super[drows[p2]];
+                  w->next[d] = w->head[t];
+                  w->head[t] = d;
+                }
+
+              d = dnext;
+            }
+
+          for (r = 0; r < nrows; ++r)
+            w->map[rows[r]] = CHOL_NONE;
+
+          if (status)
+            {
+              GSL_ERROR("matrix does not match workspace pattern",
+                        GSL_EINVAL);
+            }
+
+          status = chol_block_factor(s, w);
+          if (status)
+            {
+              GSL_ERROR("matrix is not positive definite", GSL_EDOM);
+            }
+
+          /* link s to the supernode containing its first off-diagonal row */
+          w->pos[s] = l - f;
+          if (l - f < nrows)
+            {
+              const size_t t = w->col2super[rows[l - f]];
+              w->next[s] = w->head[t];
+              w->head[t] = s;
+            }
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_splinalg_cholesky_decomp() */
+
+/*
+gsl_splinalg_cholesky_solve()
+  Solve L L^T x = b using the Cholesky factor
+
+Inputs: w - workspace containing factor
+        b - right hand side
+        x - (output) solution; may be the same vector as b
+
+Return: success or error
+*/
+
+int
+gsl_splinalg_cholesky_solve(const gsl_splinalg_cholesky_workspace *w,
+                            const gsl_vector *b, gsl_vector *x)
+{
+  const size_t n = w->n;
+
+  if (b->size != n || x->size != n)
+    {
+      GSL_ERROR("vector length does not match workspace", GSL_EBADLEN);
+    }
+  else
+    {
+      double *X = x->data;
+      const size_t incX = x->stride;
+      size_t s, c, r;
+
+      if (x != b)
+        gsl_vector_memcpy(x, b);
+
+      /* forward substitution L y = b */
+      for (s = 0; s < w->nsuper; ++s)
+        {
+          const size_t f = w->super[s];
+          const size_t nrows = w->rowptr[s + 1] - w->rowptr[s];
+          const size_t *rows = w->rowind + w->rowptr[s];
+
+          for (c = 0; c < w->super[s + 1] - f; ++c)
+            {
+              const double *Lc = w->blk + w->blkptr[s] + c * nrows;
+              const double xj = X[(f + c) * incX] / Lc[c];
+
+              X[(f + c) * incX] = xj;
+
+              for (r = c + 1; r < nrows; ++r)
+                X[rows[r] * incX] -= Lc[r] * xj;
+            }
+        }
+
+      /* back substitution L^T x = y */
+      for (s = w->nsuper; s-- > 0; )
+        {
+          const size_t f = w->super[s];
+          const size_t nrows = w->rowptr[s + 1] - w->rowptr[s];
+          const size_t *rows = w->rowind + w->rowptr[s];
+
+          for (c = w->super[s + 1] - f; c-- > 0; )
+            {
+              const double *Lc = w->blk + w->blkptr[s] + c * nrows;
+              double sum = X[(f + c) * incX];
+
+              for (r = c + 1; r < nrows; ++r)
+                sum -= Lc[r] * X[rows[r] * incX];
+
+              X[(f + c) * incX] = sum / Lc[c];
+            }
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_splinalg_cholesky_solve() */
+
+/*
+chol_lower()
+  Build the strictly lower triangle of A in compressed row format: row
+k lists the columns j < k with A(k,j) stored
+
+Inputs: A  - CCS matrix
+        rp - (output) row pointers, size n + 1
+        ri - (output) column indices, allocated here
+
+Return: success or error
+*/
+
+static int
+chol_lower(const gsl_spmatrix *A, size_t *rp, size_t **ri)
+{
+  const size_t n = A->size1;
+  size_t *next;
+  size_t j, p;
+
+  for (j = 0; j < n; ++j)
+    rp[j] = 0;
+
+  for (j = 0; j < n; ++j)
+    {
+      for (p = A->p[j]; p < A->p[j + 1]; ++p)
+        {
+          if (A->i[p] > j)
+            rp[A->i[p]]++;
+        }
+    }
+
+  gsl_spmatrix_cumsum(n, rp);
+
+  *ri = malloc(GSL_MAX(rp[n], 1) * sizeof(size_t));
+  next = malloc(GSL_MAX(n, 1) * sizeof(size_t));
+  if (!*ri || !next)
+    {
+      free(*ri);
+      free(next);
+      *ri = NULL;
+      return GSL_ENOMEM;
+    }
+
+  for (j = 0; j < n; ++j)
+    next[j] = rp[j];
+
+  for (j = 0; j < n; ++j)
+    {
+      for (p = A->p[j]; p < A->p[j + 1]; ++p)
+        {
+          if (A->i[p] > j)
+            (*ri)[next[A->i[p]]++] = j;
+        }
+    }
+
+  free(next);
+
+  return GSL_SUCCESS;
+} /* chol_lower() */
+
+/*
+chol_etree()
+  Compute the elimination tree of A
+
+Inputs: n        - size of matrix
+        rp       - row pointers of strictly lower triangle of A
+        ri       - column indices of strictly lower triangle of A
+        parent   - (output) parent of each node, CHOL_NONE for roots
+        ancestor - workspace, size n
+
+Notes:
+1) For each row k, the path from each j < k with A(k,j) != 0 is followed
+up to its current root, which becomes a child of k. Path compression
+through ancestor[] makes the cost almost linear in nnz(A) [1, Sec. 4.1]
+*/
+
+static void
+chol_etree(const size_t n, const size_t *rp, const size_t *ri,
+           size_t *parent, size_t *ancestor)
+{
+  size_t k, p, i, inext;
+
+  for (k = 0; k < n; ++k)
+    {
+      parent[k] = CHOL_NONE;
+      ancestor[k] = CHOL_NONE;
+
+      for (p = rp[k]; p < rp[k + 1]; ++p)
+        {
+          for (i = ri[p]; i != CHOL_NONE && i < k; i = inext)
+            {
+              inext = ancestor[i];
+              ancestor[i] = k;
+
+              if (inext == CHOL_NONE)
+                parent[i] = k;
+            }
+        }
+    }
+} /* chol_etree() */
+
+/*
+chol_block_factor()
+  Factor the diagonal block of supernode s and compute the rows below
+it, once all updates have been applied
+
+Return: success, or GSL_EDOM if the diagonal block is not positive
+definite
+
+Notes:
+1) The column-major block of s, seen as a row-major gsl_matrix, is its
+transpose. The diagonal block is therefore mirrored so that its lower
+triangle (as a gsl_matrix) holds the lower triangle of A, factored in
+place, and the factor is mirrored back. The rows below the diagonal
+block then satisfy L21 L11^T = A21, i.e. L11 L21^T = A21^T, where
+L21^T is the remaining part of the row-major view
+*/
+
+static int
+chol_block_factor(const size_t s, gsl_splinalg_cholesky_workspace *w)
+{
+  const size_t ncols = w->super[s + 1] - w->super[s];
+  const size_t nrows = w->rowptr[s + 1] - w->rowptr[s];
+  double *Ls = w->blk + w->blkptr[s];
+  gsl_matrix_view D = gsl_matrix_view_array_with_tda(Ls, ncols, ncols, nrows);
+  size_t r, c;
+  int status;
+
+  for (c = 0; c < ncols; ++c)
+    {
+      for (r = c + 1; r < ncols; ++r)
+        Ls[r * nrows + c] = Ls[c * nrows + r];
+    }
+
+  status = gsl_linalg_cholesky_decomp(&D.matrix);
+  if (status)
+    return status;
+
+  for (c = 0; c < ncols; ++c)
+    {
+      for (r = c + 1; r < ncols; ++r)
+        Ls[c * nrows + r] = Ls[r * nrows + c];
+    }
+
+  if (nrows > ncols)
+    {
+      gsl_matrix_view V = gsl_matrix_view_array_with_tda(Ls + ncols, ncols,
+                                                         nrows - ncols, nrows);
+
+      gsl_blas_dtrsm(CblasLeft, CblasLower, CblasNoTrans, CblasNonUnit, 1.0,
+                     &D.matrix, &V.matrix);
+    }
+
+  return GSL_SUCCESS;
+} /* chol_block_factor() */
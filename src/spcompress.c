@@ -25,6 +25,20 @@
 #include <gsl/gsl_errno.h>
 
 #include "gsl_spmatrix.h"
+#include "spthread.h"
+
+/* minimum array length for which gsl_spmatrix_cumsum() uses threads */
+#define CUMSUM_PARALLEL_MIN    16384
+
+static gsl_spmatrix *compress(const gsl_spmatrix *T, const size_t flags,
+                              size_t *map, size_t *work);
+static gsl_spmatrix *compress_sorted(const gsl_spmatrix *T, const size_t type,
+                                     size_t *map);
+static int compress_parallel(const size_t *Tj, const size_t *Ti,
+                             const double *Td, const size_t nz,
+                             const size_t nouter, const size_t nthreads,
+                             size_t *map, gsl_spmatrix *m);
+static int cumsum_parallel(const size_t n, size_t *c, const size_t nthreads);
 
 /*
 gsl_spmatrix_compress()
@@ -38,22 +52,524 @@ Return: pointer to new matrix (should be freed when finished with it)
 gsl_spmatrix *
 gsl_spmatrix_compress(const gsl_spmatrix *T)
 {
-  const size_t *Tj; /* column indices of triplet matrix */
-  size_t *Cp;       /* column pointers of compressed column matrix */
+  return compress(T, GSL_SPMATRIX_CCS, NULL, NULL);
+} /* gsl_spmatrix_compress() */
+
+/*
+gsl_spmatrix_crs()
+  Create a sparse matrix in compressed row format
+
+Inputs: T - sparse matrix in triplet format
+
+Return: pointer to new matrix (should be freed when finished with it)
+*/
+
+gsl_spmatrix *
+gsl_spmatrix_crs(const gsl_spmatrix *T)
+{
+  return compress(T, GSL_SPMATRIX_CRS, NULL, NULL);
+} /* gsl_spmatrix_crs() */
+
+/*
+gsl_spmatrix_compress_sorted()
+  Create a sparse matrix in compressed column or compressed row
+format, with sorted indices and duplicate entries summed
+
+Inputs: T    - sparse matrix in triplet format
+        type - GSL_SPMATRIX_CCS or GSL_SPMATRIX_CRS
+
+Return: pointer to new matrix (should be freed when finished with it)
+
+Notes:
+1) The triplets are first compressed into the opposite format, and
+then transposed into the requested format. Since the transpose scans
+the intermediate matrix in order, the inner indices of the result are
+sorted, and duplicate (i,j) entries arrive consecutively so they are
+summed as they are stored (double transpose method)
+
+2) The output matrix has the GSL_SPMATRIX_SORTED and GSL_SPMATRIX_NODUPS
+flags set, which enables binary search in gsl_spmatrix_get()
+*/
+
+gsl_spmatrix *
+gsl_spmatrix_compress_sorted(const gsl_spmatrix *T, const size_t type)
+{
+  return compress_sorted(T, type, NULL);
+} /* gsl_spmatrix_compress_sorted() */
+
+/*
+gsl_spmatrix_compress_w()
+  Create a sparse matrix in compressed column or compressed row
+format using a caller-supplied workspace
+
+Inputs: T    - sparse matrix in triplet format
+        type - GSL_SPMATRIX_CCS or GSL_SPMATRIX_CRS
+        work - workspace of size at least the number of columns (CCS)
+               or rows (CRS) of T
+
+Return: pointer to new matrix (should be freed when finished with it)
+
+Notes:
+1) The result is identical to gsl_spmatrix_compress() or
+gsl_spmatrix_crs(). The conversion is done by the calling thread, and
+the only memory allocated is the result
+*/
+
+gsl_spmatrix *
+gsl_spmatrix_compress_w(const gsl_spmatrix *T, const size_t type,
+                        gsl_spmatrix_workspace *work)
+{
+  if (type != GSL_SPMATRIX_CCS && type != GSL_SPMATRIX_CRS)
+    {
+      GSL_ERROR_NULL("type must be GSL_SPMATRIX_CCS or GSL_SPMATRIX_CRS",
+                     GSL_EINVAL);
+    }
+  else if (work->n < (type == GSL_SPMATRIX_CCS ? T->size2 : T->size1))
+    {
+      GSL_ERROR_NULL("workspace is too small", GSL_EBADLEN);
+    }
+  else
+    {
+      return compress(T, type, NULL, work->iwork);
+    }
+} /* gsl_spmatrix_compress_w() */
+
+/*
+gsl_spmatrix_symmetric()
+  Create the symmetric storage of a symmetric matrix: the lower
+triangle and diagonal in compressed column format
+
+Inputs: A - square sparse matrix (triplet, CCS or CRS) storing both
+            triangles of a symmetric matrix
+
+Return: pointer to new matrix (should be freed when finished with it)
+
+Notes:
+1) The elements with i >= j are filtered directly into a triplet
+array, which is then compressed as in gsl_spmatrix_compress_sorted(),
+so the result is sorted and duplicates are summed. The elements with
+i < j are ignored, so the symmetry of A is not checked
+
+2) The result has the GSL_SPMATRIX_SYMMETRIC flag set
+*/
+
+gsl_spmatrix *
+gsl_spmatrix_symmetric(const gsl_spmatrix *A)
+{
+  if (A->size1 != A->size2)
+    {
+      GSL_ERROR_NULL("matrix must be square", GSL_ENOTSQR);
+    }
+  else if (!GSLSP_ISTRIPLET(A) && !GSLSP_ISCCS(A) && !GSLSP_ISCRS(A))
+    {
+      GSL_ERROR_NULL("unsupported matrix type", GSL_EINVAL);
+    }
+  else
+    {
+      const size_t nouter = GSLSP_ISTRIPLET(A) ? 1 : A->size1;
+      gsl_spmatrix *T, *m;
+      size_t k, p, nz = 0;
+
+      T = gsl_spmatrix_alloc_nzmax(A->size1, A->size2, GSL_MAX(A->nz, 1),
+                                   GSL_SPMATRIX_TRIPLET);
+      if (!T)
+        return NULL;
+
+      for (k = 0; k < nouter; ++k)
+        {
+          const size_t p0 = GSLSP_ISTRIPLET(A) ? 0 : A->p[k];
+          const size_t p1 = GSLSP_ISTRIPLET(A) ? A->nz : A->p[k + 1];
+
+          for (p = p0; p < p1; ++p)
+            {
+              const size_t i = GSLSP_ISTRIPLET(A) ? A->i[p] :
+                               GSLSP_ISCCS(A) ? A->i[p] : k;
+              const size_t j = GSLSP_ISTRIPLET(A) ? A->p[p] :
+                               GSLSP_ISCCS(A) ? k : A->i[p];
+
+              if (i >= j)
+                {
+                  T->i[nz] = i;
+                  T->p[nz] = j;
+                  T->data[nz] = A->data[p];
+                  ++nz;
+                }
+            }
+        }
+
+      T->nz = nz;
+
+      m = compress_sorted(T, GSL_SPMATRIX_CCS, NULL);
+      gsl_spmatrix_free(T);
+
+      if (m)
+        m->flags |= GSL_SPMATRIX_SYMMETRIC;
+
+      return m;
+    }
+} /* gsl_spmatrix_symmetric() */
+
+/*
+gsl_spmatrix_plan_alloc()
+  Allocate a compress plan for a triplet matrix with nz elements
+
+Inputs: nz - number of triplets
+
+Return: pointer to new plan (should be freed with gsl_spmatrix_plan_free)
+*/
+
+gsl_spmatrix_plan *
+gsl_spmatrix_plan_alloc(const size_t nz)
+{
+  gsl_spmatrix_plan *plan;
+
+  plan = calloc(1, sizeof(gsl_spmatrix_plan));
+  if (!plan)
+    {
+      GSL_ERROR_NULL("failed to allocate space for plan struct",
+                     GSL_ENOMEM);
+    }
+
+  plan->map = malloc(GSL_MAX(nz, 1) * sizeof(size_t));
+  if (!plan->map)
+    {
+      gsl_spmatrix_plan_free(plan);
+      GSL_ERROR_NULL("failed to allocate space for plan map", GSL_ENOMEM);
+    }
+
+  plan->nz = nz;
+
+  return plan;
+} /* gsl_spmatrix_plan_alloc() */
+
+void
+gsl_spmatrix_plan_free(gsl_spmatrix_plan *plan)
+{
+  if (plan->map)
+    free(plan->map);
+
+  free(plan);
+} /* gsl_spmatrix_plan_free() */
+
+/*
+gsl_spmatrix_compress_plan()
+  Create a sparse matrix in sorted compressed column or compressed row
+format, as in gsl_spmatrix_compress_sorted(), and record where each
+triplet is stored
+
+Inputs: T    - sparse matrix in triplet format
+        type - GSL_SPMATRIX_CCS or GSL_SPMATRIX_CRS
+        plan - (output) plan with plan->nz = T->nz; on output,
+               plan->map[n] is the index in C->data to which triplet n
+               is added
+
+Return: pointer to new matrix C (should be freed when finished with it)
+*/
+
+gsl_spmatrix *
+gsl_spmatrix_compress_plan(const gsl_spmatrix *T, const size_t type,
+                           gsl_spmatrix_plan *plan)
+{
+  if (!GSLSP_ISTRIPLET(T))
+    {
+      GSL_ERROR_NULL("matrix must be in triplet format", GSL_EINVAL);
+    }
+  else if (plan->nz != T->nz)
+    {
+      GSL_ERROR_NULL("plan does not match number of triplets", GSL_EBADLEN);
+    }
+  else
+    {
+      gsl_spmatrix *C = compress_sorted(T, type, plan->map);
+
+      if (C)
+        {
+          plan->size1 = T->size1;
+          plan->size2 = T->size2;
+          plan->cnz = C->nz;
+          plan->type = type;
+        }
+
+      return C;
+    }
+} /* gsl_spmatrix_compress_plan() */
+
+/*
+gsl_spmatrix_compress_update()
+  Recompute the values of a compressed matrix from new triplet values,
+keeping its sparsity pattern
+
+Inputs: data - triplet values, of length plan->nz, stored in the same
+               order as the triplets given to gsl_spmatrix_compress_plan()
+        plan - compress plan
+        C    - (output) matrix returned by gsl_spmatrix_compress_plan()
+
+Return: success or error
+
+Notes:
+1) No memory is allocated. Duplicate triplets are summed in the same
+order as in gsl_spmatrix_compress_plan(), so the result is identical to
+compressing a new triplet matrix with gsl_spmatrix_compress_sorted()
+*/
+
+int
+gsl_spmatrix_compress_update(const double *data,
+                             const gsl_spmatrix_plan *plan, gsl_spmatrix *C)
+{
+  if (GSLSP_ISTRIPLET(C))
+    {
+      GSL_ERROR("C must be in compressed format", GSL_EINVAL);
+    }
+  else if (GSLSP_ISREADONLY(C))
+    {
+      GSL_ERROR("C is read-only", GSL_EINVAL);
+    }
+  else if (GSLSP_TYPE(C) != plan->type)
+    {
+      GSL_ERROR("C does not have the storage format of the plan",
+                GSL_EINVAL);
+    }
+  else if (C->size1 != plan->size1 || C->size2 != plan->size2 ||
+           C->nz != plan->cnz)
+    {
+      GSL_ERROR("C does not match plan", GSL_EBADLEN);
+    }
+  else
+    {
+      const size_t *map = plan->map;
+      double *Cd = C->data;
+      size_t n;
+
+      for (n = 0; n < C->nz; ++n)
+        Cd[n] = 0.0;
+
+      for (n = 0; n < plan->nz; ++n)
+        Cd[map[n]] += data[n];
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_spmatrix_compress_update() */
+
+/*
+compress_sorted()
+  Create a sorted compressed matrix with duplicates summed; see
+gsl_spmatrix_compress_sorted()
+
+Inputs: T    - sparse matrix in triplet format
+        type - GSL_SPMATRIX_CCS or GSL_SPMATRIX_CRS
+        map  - (output) if not NULL, array of length T->nz; on output
+               map[n] is the index in the returned matrix of triplet n
+
+Return: pointer to new matrix (should be freed when finished with it)
+*/
+
+static gsl_spmatrix *
+compress_sorted(const gsl_spmatrix *T, const size_t type, size_t *map)
+{
+  if (type != GSL_SPMATRIX_CCS && type != GSL_SPMATRIX_CRS)
+    {
+      GSL_ERROR_NULL("type must be GSL_SPMATRIX_CCS or GSL_SPMATRIX_CRS",
+                     GSL_EINVAL);
+    }
+  else
+    {
+      const size_t other = (type == GSL_SPMATRIX_CCS) ?
+                           GSL_SPMATRIX_CRS : GSL_SPMATRIX_CCS;
+      const size_t ninner = (type == GSL_SPMATRIX_CCS) ?
+                            T->size1 : T->size2;
+      const size_t nouter = (type == GSL_SPMATRIX_CCS) ?
+                            T->size2 : T->size1;
+      gsl_spmatrix *A; /* intermediate matrix in the other format */
+      gsl_spmatrix *m;
+      size_t *Ap, *Ai, *Cp, *Ci, *w;
+      size_t *dest = NULL; /* dest[p] = index in m of element p of A */
+      double *Ad, *Cd;
+      size_t j, p, nz;
+
+      A = compress(T, other, map, NULL);
+      if (!A)
+        return NULL;
+
+      m = gsl_spmatrix_alloc_nzmax(T->size1, T->size2, A->nz, type);
+      if (!m)
+        {
+          gsl_spmatrix_free(A);
+          return NULL;
+        }
+
+      if (map)
+        {
+          dest = malloc(GSL_MAX(A->nz, 1) * sizeof(size_t));
+          if (!dest)
+            {
+              gsl_spmatrix_free(A);
+              gsl_spmatrix_free(m);
+              GSL_ERROR_NULL("failed to allocate space for dest",
+                             GSL_ENOMEM);
+            }
+        }
+
+      Ap = A->p;
+      Ai = A->i;
+      Ad = A->data;
+      Cp = m->p;
+      Ci = m->i;
+      Cd = m->data;
+      w = m->work;
+
+      /* count entries of each output column, including duplicates */
+      for (j = 0; j < nouter + 1; ++j)
+        Cp[j] = 0;
+
+      for (p = 0; p < A->nz; ++p)
+        Cp[Ai[p]]++;
+
+      gsl_spmatrix_cumsum(nouter, Cp);
+
+      for (j = 0; j < nouter; ++j)
+        w[j] = Cp[j];
+
+      /*
+       * transpose A into m; w[k] points one past the last element
+       * stored in output column k, so a duplicate is detected by
+       * comparing with the previous element of that column
+       */
+      for (j = 0; j < ninner; ++j)
+        {
+          for (p = Ap[j]; p < Ap[j + 1]; ++p)
+            {
+              size_t k = Ai[p];
+
+              if (w[k] > Cp[k] && Ci[w[k] - 1] == j)
+                {
+                  Cd[w[k] - 1] += Ad[p];
+                }
+              else
+                {
+                  Ci[w[k]] = j;
+                  Cd[w[k]] = Ad[p];
+                  ++w[k];
+                }
+
+              if (dest)
+                dest[p] = w[k] - 1;
+            }
+        }
+
+      /* remove the gaps left by summed duplicates */
+      nz = 0;
+      for (j = 0; j < nouter; ++j)
+        {
+          size_t start = Cp[j];
+
+          Cp[j] = nz;
+
+          for (p = start; p < w[j]; ++p)
+            {
+              Ci[nz] = Ci[p];
+              Cd[nz] = Cd[p];
+              ++nz;
+            }
+
+          /* w[j] = distance column j was moved by the compaction */
+          w[j] = start - Cp[j];
+        }
+
+      Cp[nouter] = nz;
+      m->nz = nz;
+      m->flags |= GSL_SPMATRIX_SORTED | GSL_SPMATRIX_NODUPS;
+
+      if (map)
+        {
+          /* compose triplet -> A -> m */
+          for (p = 0; p < T->nz; ++p)
+            {
+              size_t q = map[p];
+              map[p] = dest[q] - w[Ai[q]];
+            }
+
+          free(dest);
+        }
+
+      gsl_spmatrix_free(A);
+
+      return m;
+    }
+} /* compress_sorted() */
+
+/*
+compress()
+  Convert a triplet matrix to compressed column or compressed
+row format. The two formats differ only in which triplet index
+array is used to compute the pointers (outer index) and which is
+copied into m->i (inner index)
+
+Inputs: T     - sparse matrix in triplet format
+        flags - GSL_SPMATRIX_CCS or GSL_SPMATRIX_CRS
+        map   - (output) if not NULL, array of length T->nz; on output
+                map[n] is the index in the returned matrix of triplet n
+        work  - if not NULL, workspace of size nouter used instead of
+                m->work; the conversion is then done by a single thread
+
+Return: pointer to new matrix (should be freed when finished with it)
+
+Notes:
+1) With more than one thread, compress_parallel() is used, which
+produces exactly the same matrix
+*/
+
+static gsl_spmatrix *
+compress(const gsl_spmatrix *T, const size_t flags, size_t *map,
+         size_t *work)
+{
+  const size_t *Tj; /* outer indices of triplet matrix (columns for CCS) */
+  const size_t *Ti; /* inner indices of triplet matrix (rows for CCS) */
+  const size_t nthreads = gsl_spblas_get_num_threads();
+  size_t *Cp;       /* column (or row) pointers of compressed matrix */
   size_t *w;        /* copy of column pointers */
   gsl_spmatrix *m;
+  size_t nouter;    /* number of columns (CCS) or rows (CRS) */
   size_t n;
 
-  m = gsl_spmatrix_alloc_nzmax(T->size1, T->size2, T->nz,
-                               GSL_SPMATRIX_CCS);
+  if (!GSLSP_ISTRIPLET(T))
+    {
+      GSL_ERROR_NULL("matrix must be in triplet format", GSL_EINVAL);
+    }
+
+  m = gsl_spmatrix_alloc_nzmax(T->size1, T->size2, T->nz, flags);
   if (!m)
     return NULL;
 
-  Tj = T->p;
+  if (flags == GSL_SPMATRIX_CCS)
+    {
+      Tj = T->p;
+      Ti = T->i;
+      nouter = m->size2;
+    }
+  else
+    {
+      Tj = T->i;
+      Ti = T->p;
+      nouter = m->size1;
+    }
+
+  m->nz = T->nz;
+
+  if (nthreads > 1 && !work)
+    {
+      if (compress_parallel(Tj, Ti, T->data, T->nz, nouter, nthreads, map, m))
+        {
+          gsl_spmatrix_free(m);
+          return NULL;
+        }
+
+      return m;
+    }
+
   Cp = m->p;
 
   /* initialize column pointers to 0 */
-  for (n = 0; n < m->size2 + 1; ++n)
+  for (n = 0; n < nouter + 1; ++n)
     Cp[n] = 0;
 
   /*
@@ -64,25 +580,26 @@ gsl_spmatrix_compress(const gsl_spmatrix *T)
     Cp[Tj[n]]++;
 
   /* compute column pointers: p[j] = p[j-1] + nnz[j-1] */
-  gsl_spmatrix_cumsum(m->size2, Cp);
+  spthread_cumsum(nouter, Cp, work ? 1 : nthreads);
 
   /* make a copy of the column pointers */
-  w = m->work;
-  for (n = 0; n < m->size2; ++n)
+  w = work ? work : m->work;
+  for (n = 0; n < nouter; ++n)
     w[n] = Cp[n];
 
   /* transfer data from triplet format to compressed column */
   for (n = 0; n < T->nz; ++n)
     {
       size_t k = w[Tj[n]]++;
-      m->i[k] = T->i[n];
+      m->i[k] = Ti[n];
       m->data[k] = T->data[n];
-    }
 
-  m->nz = T->nz;
+      if (map)
+        map[n] = k;
+    }
 
   return m;
-} /* gsl_spmatrix_compress() */
+} /* compress() */
 
 /*
 gsl_spmatrix_cumsum()
@@ -102,15 +619,34 @@ Inputs: n - length of input array
             on input, contains the n values c[k]
             on output, contains the n + 1 values p[j]
 
-Return: success or error
+Notes:
+1) For large n, the sum is computed with multiple threads if
+more than one has been requested with gsl_spblas_set_num_threads()
 */
 
 void
 gsl_spmatrix_cumsum(const size_t n, size_t *c)
+{
+  spthread_cumsum(n, c, gsl_spblas_get_num_threads());
+} /* gsl_spmatrix_cumsum() */
+
+/*
+spthread_cumsum()
+  gsl_spmatrix_cumsum() with an explicit number of threads; the
+_w routines pass nthreads = 1 so that they neither allocate nor
+start threads
+*/
+
+void
+spthread_cumsum(const size_t n, size_t *c, const size_t nthreads)
 {
   size_t sum = 0;
   size_t k;
 
+  if (nthreads > 1 && n >= CUMSUM_PARALLEL_MIN &&
+      cumsum_parallel(n, c, nthreads) == GSL_SUCCESS)
+    return;
+
   for (k = 0; k < n; ++k)
     {
       size_t ck = c[k];
@@ -119,4 +655,196 @@ gsl_spmatrix_cumsum(const size_t n, size_t *c)
     }
 
   c[n] = sum;
-} /* gsl_spmatrix_cumsum() */
+} /* spthread_cumsum() */
+
+/*
+compress_parallel()
+  Multithreaded version of the counting sort in compress()
+
+Inputs: Tj       - outer indices of triplets (columns for CCS)
+        Ti       - inner indices of triplets (rows for CCS)
+        Td       - triplet values
+        nz       - number of triplets
+        nouter   - number of columns (CCS) or rows (CRS)
+        nthreads - number of threads
+        map      - (output) if not NULL, map[n] = index in m of triplet n
+        m        - (output) compressed matrix with nzmax >= nz
+
+Return: success or error
+
+Notes:
+1) The triplets are split into nthreads contiguous chunks. Each thread
+computes a histogram of the columns in its chunk; for each column, the
+histograms are then converted into the offset of each chunk within the
+column, so that entries of chunk t are stored after those of chunks
+0..t-1. Each thread then scatters its chunk into disjoint locations.
+Since every chunk is processed in order, the result is identical to the
+serial counting sort.
+
+2) Requires O(nthreads * nouter) additional workspace
+*/
+
+static int
+compress_parallel(const size_t *Tj, const size_t *Ti, const double *Td,
+                  const size_t nz, const size_t nouter, const size_t nthreads,
+                  size_t *map, gsl_spmatrix *m)
+{
+  size_t *Cp = m->p;
+  size_t *Ci = m->i;
+  double *Cd = m->data;
+  size_t *H;
+  long t;
+
+  /* H[t*nouter + j] = histogram of thread t for column j */
+  H = malloc(nthreads * nouter * sizeof(size_t));
+  if (!H)
+    {
+      GSL_ERROR("failed to allocate space for histograms", GSL_ENOMEM);
+    }
+
+#pragma omp parallel num_threads(nthreads)
+  {
+    long j;
+
+#pragma omp for schedule(static, 1)
+    for (t = 0; t < (long) nthreads; ++t)
+      {
+        const size_t n0 = spthread_block(nz, nthreads, t);
+        const size_t n1 = spthread_block(nz, nthreads, t + 1);
+        size_t *h = H + t * nouter;
+        size_t n;
+
+        for (n = 0; n < nouter; ++n)
+          h[n] = 0;
+
+        for (n = n0; n < n1; ++n)
+          h[Tj[n]]++;
+      }
+
+    /* offsets of each chunk within each column, and column counts */
+#pragma omp for schedule(static)
+    for (j = 0; j < (long) nouter; ++j)
+      {
+        size_t sum = 0;
+        size_t k;
+
+        for (k = 0; k < nthreads; ++k)
+          {
+            size_t hk = H[k * nouter + j];
+            H[k * nouter + j] = sum;
+            sum += hk;
+          }
+
+        Cp[j] = sum;
+      }
+  }
+
+  /* compute column pointers: p[j] = p[j-1] + nnz[j-1] */
+  gsl_spmatrix_cumsum(nouter, Cp);
+
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+  for (t = 0; t < (long) nthreads; ++t)
+    {
+      const size_t n0 = spthread_block(nz, nthreads, t);
+      const size_t n1 = spthread_block(nz, nthreads, t + 1);
+      size_t *h = H + t * nouter;
+      size_t n;
+
+      for (n = n0; n < n1; ++n)
+        {
+          size_t j = Tj[n];
+          size_t k = Cp[j] + h[j]++;
+
+          Ci[k] = Ti[n];
+          Cd[k] = Td[n];
+
+          if (map)
+            map[n] = k;
+        }
+    }
+
+  free(H);
+
+  return GSL_SUCCESS;
+} /* compress_parallel() */
+
+/*
+cumsum_parallel()
+  Multithreaded version of gsl_spmatrix_cumsum()
+
+Inputs: n        - length of input array
+        c        - (input/output) array of size n + 1
+        nthreads - number of threads
+
+Return: success or error
+
+Notes:
+1) The array is split into nthreads blocks. Each thread sums its block,
+the block sums are scanned serially to give the starting value of each
+block, and each thread then computes the prefix sums of its block.
+Integer addition is exact, so the result is identical to the serial one.
+*/
+
+static int
+cumsum_parallel(const size_t n, size_t *c, const size_t nthreads)
+{
+  size_t *bsum = malloc((nthreads + 1) * sizeof(size_t));
+  long t;
+
+  if (!bsum)
+    return GSL_ENOMEM;
+
+#pragma omp parallel num_threads(nthreads)
+  {
+#pragma omp for schedule(static, 1)
+    for (t = 0; t < (long) nthreads; ++t)
+      {
+        const size_t k0 = spthread_block(n, nthreads, t);
+        const size_t k1 = spthread_block(n, nthreads, t + 1);
+        size_t sum = 0;
+        size_t k;
+
+        for (k = k0; k < k1; ++k)
+          sum += c[k];
+
+        bsum[t] = sum;
+      }
+
+#pragma omp single
+    {
+      size_t sum = 0;
+      size_t k;
+
+      for (k = 0; k < nthreads; ++k)
+        {
+          size_t bk = bsum[k];
+          bsum[k] = sum;
+          sum += bk;
+        }
+
+      bsum[nthreads] = sum;
+    }
+
+#pragma omp for schedule(static, 1)
+    for (t = 0; t < (long) nthreads; ++t)
+      {
+        const size_t k0 = spthread_block(n, nthreads, t);
+        const size_t k1 = spthread_block(n, nthreads, t + 1);
+        size_t sum = bsum[t];
+        size_t k;
+
+        for (k = k0; k < k1; ++k)
+          {
+            size_t ck = c[k];
+            c[k] = sum;
+            sum += ck;
+          }
+      }
+  }
+
+  c[n] = bsum[nthreads];
+
+  free(bsum);
+
+  return GSL_SUCCESS;
+} /* cumsum_parallel() */
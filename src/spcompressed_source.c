@@ -0,0 +1,165 @@
+/* spcompressed_source.c
+ *
+ * Copyright (C) 2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Conversion from gsl_spmatrix and element access for the compressed
+ * matrix variants, included by spi32.c (SPBASE_I32) and spfloat.c
+ * (SPBASE_FLOAT) between sptemplates_on.h and sptemplates_off.h.
+ */
+
+/*
+gsl_spmatrix_xxx_compress()
+  Create a compressed matrix variant from a gsl_spmatrix
+
+Inputs: A    - sparse matrix in triplet format, or in the compressed
+               format type without symmetric storage
+        type - GSL_SPMATRIX_CCS or GSL_SPMATRIX_CRS
+
+Return: pointer to new matrix, or NULL on error
+
+Notes:
+1) A triplet matrix is first compressed with
+gsl_spmatrix_compress_sorted(), so the result is sorted and has no
+duplicate entries, and duplicates are summed in double precision
+before the values are converted to ATOMIC; a compressed matrix keeps
+its own properties
+
+2) The indices are converted to INDEX; the dimensions were checked by
+gsl_spmatrix_xxx_alloc_nzmax()
+*/
+
+TYPE(gsl_spmatrix) *
+FUNCTION(gsl_spmatrix, compress)(const gsl_spmatrix *A, const size_t type)
+{
+  if (type != GSL_SPMATRIX_CCS && type != GSL_SPMATRIX_CRS)
+    {
+      GSL_ERROR_NULL("type must be GSL_SPMATRIX_CCS or GSL_SPMATRIX_CRS",
+                     GSL_EINVAL);
+    }
+  else if (!GSLSP_ISTRIPLET(A) && GSLSP_TYPE(A) != type)
+    {
+      GSL_ERROR_NULL("A must be in triplet format or in the requested format",
+                     GSL_EINVAL);
+    }
+  else if (GSLSP_ISSYMMETRIC(A))
+    {
+      GSL_ERROR_NULL("symmetric storage is not supported", GSL_EINVAL);
+    }
+  else
+    {
+      gsl_spmatrix *C = NULL;
+      const gsl_spmatrix *S = A;
+      TYPE(gsl_spmatrix) *m;
+      size_t n, np;
+
+      if (GSLSP_ISTRIPLET(A))
+        {
+          C = gsl_spmatrix_compress_sorted(A, type);
+          if (!C)
+            return NULL;
+
+          S = C;
+        }
+
+      m = FUNCTION(gsl_spmatrix, alloc_nzmax)(S->size1, S->size2, S->nz,
+                                              type);
+      if (!m)
+        {
+          if (C)
+            gsl_spmatrix_free(C);
+
+          return NULL;
+        }
+
+      np = (type == GSL_SPMATRIX_CCS) ? S->size2 + 1 : S->size1 + 1;
+
+      for (n = 0; n < np; ++n)
+        m->p[n] = S->p[n];
+
+      for (n = 0; n < S->nz; ++n)
+        {
+          m->i[n] = (INDEX) S->i[n];
+          m->data[n] = (ATOMIC) S->data[n];
+        }
+
+      m->nz = S->nz;
+      m->flags = type | (S->flags & (GSL_SPMATRIX_SORTED | GSL_SPMATRIX_NODUPS));
+
+      if (C)
+        gsl_spmatrix_free(C);
+
+      return m;
+    }
+} /* gsl_spmatrix_xxx_compress() */
+
+/*
+gsl_spmatrix_xxx_get()
+  Return m_{ij}, using a binary search if the inner indices are sorted
+*/
+
+ATOMIC
+FUNCTION(gsl_spmatrix, get)(const TYPE(gsl_spmatrix) *m, const size_t i,
+                            const size_t j)
+{
+  if (i >= m->size1)
+    {
+      GSL_ERROR_VAL("first index out of range", GSL_EINVAL, (ATOMIC) 0);
+    }
+  else if (j >= m->size2)
+    {
+      GSL_ERROR_VAL("second index out of range", GSL_EINVAL, (ATOMIC) 0);
+    }
+  else
+    {
+      const INDEX *mi = m->i;
+      const size_t *mp = m->p;
+      const size_t outer = GSLSP_ISCCS(m) ? j : i;
+      const INDEX inner = (INDEX) (GSLSP_ISCCS(m) ? i : j);
+      size_t lo = mp[outer];
+      size_t hi = mp[outer + 1];
+
+      if (GSLSP_ISSORTED(m))
+        {
+          while (lo < hi)
+            {
+              size_t mid = lo + (hi - lo) / 2;
+
+              if (mi[mid] < inner)
+                lo = mid + 1;
+              else
+                hi = mid;
+            }
+
+          if (lo < mp[outer + 1] && mi[lo] == inner)
+            return m->data[lo];
+        }
+      else
+        {
+          size_t p;
+
+          for (p = lo; p < hi; ++p)
+            {
+              if (mi[p] == inner)
+                return m->data[p];
+            }
+        }
+
+      return (ATOMIC) 0;
+    }
+} /* gsl_spmatrix_xxx_get() */
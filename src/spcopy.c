@@ -42,16 +42,27 @@ gsl_spmatrix_memcpy(const gsl_spmatrix *src)
           dest->p[n] = src->p[n];
           dest->data[n] = src->data[n];
         }
+
+      dest->nz = src->nz;
+
+      if (src->hash && gsl_spmatrix_hash_init(dest))
+        {
+          gsl_spmatrix_free(dest);
+          return NULL;
+        }
     }
-  else if (GSLSP_ISCCS(src))
+  else if (GSLSP_ISCCS(src) || GSLSP_ISCRS(src))
     {
+      /* number of column pointers (CCS) or row pointers (CRS) */
+      const size_t np = GSLSP_ISCCS(src) ? src->size2 + 1 : src->size1 + 1;
+
       for (n = 0; n < src->nz; ++n)
         {
           dest->i[n] = src->i[n];
           dest->data[n] = src->data[n];
         }
 
-      for (n = 0; n < src->size2 + 1; ++n)
+      for (n = 0; n < np; ++n)
         {
           dest->p[n] = src->p[n];
         }
@@ -62,6 +73,7 @@ gsl_spmatrix_memcpy(const gsl_spmatrix *src)
     }
 
   dest->nz = src->nz;
+  dest->flags = src->flags & ~GSL_SPMATRIX_READONLY;
 
   return dest;
 } /* gsl_spmatrix_memcpy() */
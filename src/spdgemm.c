@@ -21,8 +21,33 @@
 #include <stdlib.h>
 #include <math.h>
 
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_errno.h>
+
 #include "gsl_spmatrix.h"
+#include "spthread.h"
+
+#define SPBASE_DOUBLE
+#include "sptemplates_on.h"
+#include "spdgemm_source.c"
+#include "sptemplates_off.h"
+#undef SPBASE_DOUBLE
 
+static int dgemm_operands(const gsl_spmatrix *A, const gsl_spmatrix *B,
+                          const gsl_spmatrix **L, const gsl_spmatrix **R,
+                          size_t *M, size_t *N);
+static int dgemm_numeric_operands(const gsl_spmatrix *A,
+                                  const gsl_spmatrix *B,
+                                  const gsl_spmatrix *C,
+                                  const gsl_spmatrix **L,
+                                  const gsl_spmatrix **R, size_t *M,
+                                  size_t *N);
+static gsl_spmatrix *dgemm_symbolic(const gsl_spmatrix *A,
+                                    const gsl_spmatrix *B,
+                                    const gsl_spmatrix *L,
+                                    const gsl_spmatrix *R, const size_t M,
+                                    const size_t N, size_t *w,
+                                    const size_t nthreads);
 /*
 gsl_spblas_dgemm()
   Multiply two sparse matrices
@@ -34,84 +59,452 @@ Inputs: alpha - scalar factor
 Return: sparse matrix C = alpha*A*B
 
 Notes:
-1) based on CSparse routine cs_multiply
+1) The sparsity pattern of C is computed first by
+gsl_spblas_dgemm_symbolic(), so that C is allocated with exactly
+the number of non-zero elements it needs, and the values are then
+computed by gsl_spblas_dgemm_numeric()
 */
 
 gsl_spmatrix *
 gsl_spblas_dgemm(const double alpha, const gsl_spmatrix *A, const gsl_spmatrix *B)
 {
-  if (A->size2 != B->size1)
+  gsl_spmatrix *C;
+  int s;
+
+  C = gsl_spblas_dgemm_symbolic(A, B);
+  if (!C)
+    return NULL;
+
+  s = gsl_spblas_dgemm_numeric(alpha, A, B, C);
+  if (s)
     {
-      GSL_ERROR_NULL("matrices dimensions do not match", GSL_EBADLEN);
+      gsl_spmatrix_free(C);
+      return NULL;
     }
+
+  return C;
+} /* gsl_spblas_dgemm() */
+
+/*
+gsl_spblas_dgemm_symbolic()
+  Compute the sparsity pattern of the product of two sparse matrices
+
+Inputs: A - sparse matrix
+        B - sparse matrix
+
+Return: sparse matrix C with the sparsity pattern of A*B; C->i and C->p
+        are filled in but C->data is not initialized
+
+Notes:
+1) A first pass counts the number of non-zeros in each column of C,
+so C is allocated exactly once with nzmax = nnz(A*B). A second pass
+then stores the row indices.
+
+2) Within each column of C, row indices are stored in the order they
+are first encountered and are not necessarily sorted
+
+3) With more than one thread, each thread processes a contiguous block
+of columns of C using its own workspace. The pattern is identical to
+the one computed by a single thread.
+*/
+
+gsl_spmatrix *
+gsl_spblas_dgemm_symbolic(const gsl_spmatrix *A, const gsl_spmatrix *B)
+{
+  const gsl_spmatrix *L, *R;
+  size_t M, N;
+  int s;
+
+  s = dgemm_operands(A, B, &L, &R, &M, &N);
+  if (s)
+    return NULL;
   else
     {
-      const size_t M = A->size1;
-      const size_t N = B->size2;
-      size_t *Bi = B->i;
-      size_t *Bp = B->p;
-      double *Bd = B->data;
-      size_t *w = A->work;
-      double *x;
+      const size_t nthreads = gsl_spblas_get_num_threads();
+      size_t *w;
       gsl_spmatrix *C;
-      size_t *Cp, *Ci;
-      double *Cd;
-      size_t j, p;
-      size_t nz = 0;
 
-      x = malloc(M * sizeof(double)); /* allocate workspace */
-
-      C = gsl_spmatrix_alloc_nzmax(M, N, A->nz + B->nz, A->flags);
-      if (!C)
+      w = malloc(nthreads * M * sizeof(size_t));
+      if (!w)
         {
-          GSL_ERROR_NULL("error allocating matrix C", GSL_ENOMEM);
+          GSL_ERROR_NULL("failed to allocate space for workspace", GSL_ENOMEM);
         }
 
-      /* initialize workspace to 0 */
-      for (j = 0; j < M; ++j)
-        w[j] = 0;
+      C = dgemm_symbolic(A, B, L, R, M, N, w, nthreads);
+
+      free(w);
+
+      return C;
+    }
+} /* gsl_spblas_dgemm_symbolic() */
+
+/*
+gsl_spblas_dgemm_numeric()
+  Compute the values of the product of two sparse matrices, whose
+sparsity pattern has been previously computed
+
+Inputs: alpha - scalar factor
+        A     - sparse matrix
+        B     - sparse matrix
+        C     - (input/output) on input, sparsity pattern of A*B
+                from gsl_spblas_dgemm_symbolic(); on output,
+                C = alpha*A*B
 
-      Cp = C->p;
-      Ci = C->i;
-      Cd = C->data;
+Return: success or error
+
+Notes:
+1) The values of A and B may change between calls as long as their
+sparsity patterns do not, so that products with a fixed pattern only
+need to compute the symbolic phase once
+
+2) With more than one thread, each thread computes a contiguous block
+of columns of C with its own dense accumulator. Each column is computed
+in the same order as by a single thread, so the result does not depend
+on the number of threads.
+*/
+
+int
+gsl_spblas_dgemm_numeric(const double alpha, const gsl_spmatrix *A,
+                         const gsl_spmatrix *B, gsl_spmatrix *C)
+{
+  const gsl_spmatrix *L, *R;
+  size_t M, N;
+  int s;
+
+  s = dgemm_numeric_operands(A, B, C, &L, &R, &M, &N);
+  if (s)
+    return s;
+  else
+    {
+      const size_t nthreads = gsl_spblas_get_num_threads();
+      double *x;
+      long t;
 
-      for (j = 0; j < N; ++j)
+      x = malloc(nthreads * M * sizeof(double));
+      if (!x)
         {
-          if (nz + M > C->nzmax)
-            {
-              int s = gsl_spmatrix_realloc(2 * C->nzmax + M, C);
-              if (s)
-                {
-                  GSL_ERROR_NULL("unable to realloc matrix C", GSL_ENOMEM);
-                }
-
-              /* these pointers could have changed due to reallocation */
-              Ci = C->i;
-              Cd = C->data;
-            }
+          GSL_ERROR("failed to allocate space for workspace", GSL_ENOMEM);
+        }
 
-          Cp[j] = nz; /* column j of C starts here */
+      if (nthreads == 1)
+        {
+          spblas_dgemm_values(alpha, L, R, 0, N, x, C);
+        }
+      else
+        {
+          size_t *part = spblas_dgemm_partition(L, R, N, nthreads);
 
-          for (p = Bp[j]; p < Bp[j + 1]; ++p)
+          if (!part)
             {
-              nz = gsl_spblas_scatter(A, Bi[p], Bd[p], w, x, j + 1, C, nz);
+              free(x);
+              GSL_ERROR("failed to allocate space for partition", GSL_ENOMEM);
             }
 
-          for (p = Cp[j]; p < nz; ++p)
-            Cd[p] = x[Ci[p]];
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+          for (t = 0; t < (long) nthreads; ++t)
+            spblas_dgemm_values(alpha, L, R, part[t], part[t + 1], x + t * M,
+                                C);
+
+          free(part);
         }
 
-      Cp[N] = nz;
-      C->nz = nz;
+      free(x);
 
-      /* scale by alpha */
-      gsl_spmatrix_scale(C, alpha);
+      return GSL_SUCCESS;
+    }
+} /* gsl_spblas_dgemm_numeric() */
 
-      free(x);
+/*
+gsl_spblas_dgemm_w()
+  Multiply two sparse matrices using a caller-supplied workspace
 
-      return C;
+Inputs: alpha - scalar factor
+        A     - sparse matrix
+        B     - sparse matrix
+        work  - workspace of size at least the number of rows of A
+                (CCS) or the number of columns of B (CRS)
+
+Return: sparse matrix C = alpha*A*B
+
+Notes:
+1) The _w variants of the dgemm routines compute the same result as
+gsl_spblas_dgemm(), gsl_spblas_dgemm_symbolic() and
+gsl_spblas_dgemm_numeric(), but run on the calling thread and take
+their scratch space from work. A and B are only read, so several
+threads may multiply the same matrices concurrently, each with its own
+workspace
+
+2) The only memory allocated is C itself; gsl_spblas_dgemm_numeric_w()
+allocates nothing
+*/
+
+gsl_spmatrix *
+gsl_spblas_dgemm_w(const double alpha, const gsl_spmatrix *A,
+                   const gsl_spmatrix *B, gsl_spmatrix_workspace *work)
+{
+  gsl_spmatrix *C;
+  int s;
+
+  C = gsl_spblas_dgemm_symbolic_w(A, B, work);
+  if (!C)
+    return NULL;
+
+  s = gsl_spblas_dgemm_numeric_w(alpha, A, B, C, work);
+  if (s)
+    {
+      gsl_spmatrix_free(C);
+      return NULL;
     }
-} /* gsl_spblas_dgemm() */
+
+  return C;
+} /* gsl_spblas_dgemm_w() */
+
+/*
+gsl_spblas_dgemm_symbolic_w()
+  Compute the sparsity pattern of A*B using a caller-supplied
+workspace; see gsl_spblas_dgemm_symbolic() and gsl_spblas_dgemm_w()
+*/
+
+gsl_spmatrix *
+gsl_spblas_dgemm_symbolic_w(const gsl_spmatrix *A, const gsl_spmatrix *B,
+                            gsl_spmatrix_workspace *work)
+{
+  const gsl_spmatrix *L, *R;
+  size_t M, N;
+  int s;
+
+  s = dgemm_operands(A, B, &L, &R, &M, &N);
+  if (s)
+    return NULL;
+  else if (work->n < M)
+    {
+      GSL_ERROR_NULL("workspace is too small", GSL_EBADLEN);
+    }
+  else
+    {
+      return dgemm_symbolic(A, B, L, R, M, N, work->iwork, 1);
+    }
+} /* gsl_spblas_dgemm_symbolic_w() */
+
+/*
+gsl_spblas_dgemm_numeric_w()
+  Compute the values of A*B with a previously computed sparsity
+pattern, using a caller-supplied workspace; see
+gsl_spblas_dgemm_numeric() and gsl_spblas_dgemm_w()
+*/
+
+int
+gsl_spblas_dgemm_numeric_w(const double alpha, const gsl_spmatrix *A,
+                           const gsl_spmatrix *B, gsl_spmatrix *C,
+                           gsl_spmatrix_workspace *work)
+{
+  const gsl_spmatrix *L, *R;
+  size_t M, N;
+  int s;
+
+  s = dgemm_numeric_operands(A, B, C, &L, &R, &M, &N);
+  if (s)
+    return s;
+  else if (work->n < M)
+    {
+      GSL_ERROR("workspace is too small", GSL_EBADLEN);
+    }
+  else
+    {
+      spblas_dgemm_values(alpha, L, R, 0, N, work->dwork, C);
+      return GSL_SUCCESS;
+    }
+} /* gsl_spblas_dgemm_numeric_w() */
+
+/*
+dgemm_symbolic()
+  Compute the sparsity pattern of C = L*R; see
+gsl_spblas_dgemm_symbolic()
+
+Inputs: A        - sparse matrix
+        B        - sparse matrix
+        L        - left operand
+        R        - right operand
+        M        - number of rows of L
+        N        - number of columns of R
+        w        - workspace of size nthreads*M
+        nthreads - number of threads
+
+Return: sparse matrix C with the sparsity pattern of A*B, or NULL
+        on error
+*/
+
+static gsl_spmatrix *
+dgemm_symbolic(const gsl_spmatrix *A, const gsl_spmatrix *B,
+               const gsl_spmatrix *L, const gsl_spmatrix *R,
+               const size_t M, const size_t N, size_t *w,
+               const size_t nthreads)
+{
+  size_t *part = NULL;
+  gsl_spmatrix *C;
+  long t;
+  int s;
+
+  /* allocate C without storage for elements until nnz(C) is known */
+  C = gsl_spmatrix_alloc_nzmax(A->size1, B->size2, 1, A->flags);
+  if (!C)
+    {
+      GSL_ERROR_NULL("error allocating matrix C", GSL_ENOMEM);
+    }
+
+  if (nthreads > 1)
+    {
+      part = spblas_dgemm_partition(L, R, N, nthreads);
+      if (!part)
+        {
+          gsl_spmatrix_free(C);
+          GSL_ERROR_NULL("failed to allocate space for partition",
+                         GSL_ENOMEM);
+        }
+    }
+
+  /* pass 1: count the number of non-zeros in each column of C */
+  if (nthreads == 1)
+    {
+      spblas_dgemm_count(L, R, M, 0, N, w, C->p);
+    }
+  else
+    {
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+      for (t = 0; t < (long) nthreads; ++t)
+        spblas_dgemm_count(L, R, M, part[t], part[t + 1], w + t * M, C->p);
+    }
+
+  spthread_cumsum(N, C->p, nthreads);
+
+  s = gsl_spmatrix_realloc(GSL_MAX(C->p[N], 1), C);
+  if (s)
+    {
+      free(part);
+      gsl_spmatrix_free(C);
+      GSL_ERROR_NULL("unable to allocate matrix C", GSL_ENOMEM);
+    }
+
+  /*
+   * pass 2: store row indices of each column of C; each block starts
+   * at its column pointer so the blocks can be filled independently
+   */
+  if (nthreads == 1)
+    {
+      spblas_dgemm_pattern(L, R, M, 0, N, w, C);
+    }
+  else
+    {
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+      for (t = 0; t < (long) nthreads; ++t)
+        spblas_dgemm_pattern(L, R, M, part[t], part[t + 1], w + t * M, C);
+    }
+
+  C->nz = C->p[N];
+
+  free(part);
+
+  return C;
+} /* dgemm_symbolic() */
+
+/*
+dgemm_operands()
+  Check the inputs to the dgemm routines and determine the operands
+of the compressed column product
+
+Inputs: A - sparse matrix
+        B - sparse matrix
+        L - (output) left operand
+        R - (output) right operand
+        M - (output) number of rows of L
+        N - (output) number of columns of R
+
+Return: success or error
+
+Notes:
+1) For CCS inputs, L = A and R = B. The arrays of a CRS matrix are the
+CCS arrays of its transpose, so for CRS inputs C^T = B^T A^T is computed
+with L = B and R = A, which yields exactly the CRS arrays of C
+
+2) Matrices with symmetric storage (GSL_SPMATRIX_SYMMETRIC) hold only
+their lower triangle and are rejected
+*/
+
+static int
+dgemm_operands(const gsl_spmatrix *A, const gsl_spmatrix *B,
+               const gsl_spmatrix **L, const gsl_spmatrix **R,
+               size_t *M, size_t *N)
+{
+  if (A->size2 != B->size1)
+    {
+      GSL_ERROR("matrices dimensions do not match", GSL_EBADLEN);
+    }
+  else if (GSLSP_TYPE(A) != GSLSP_TYPE(B))
+    {
+      GSL_ERROR("matrices must have same sparse storage format", GSL_EINVAL);
+    }
+  else if (GSLSP_ISSYMMETRIC(A) || GSLSP_ISSYMMETRIC(B))
+    {
+      GSL_ERROR("symmetric storage is not supported", GSL_EINVAL);
+    }
+  else if (GSLSP_ISCCS(A))
+    {
+      *L = A;
+      *R = B;
+      *M = A->size1;
+      *N = B->size2;
+    }
+  else if (GSLSP_ISCRS(A))
+    {
+      *L = B;
+      *R = A;
+      *M = B->size2;
+      *N = A->size1;
+    }
+  else
+    {
+      GSL_ERROR("matrices must be in compressed format", GSL_EINVAL);
+    }
+
+  return GSL_SUCCESS;
+} /* dgemm_operands() */
+
+/*
+dgemm_numeric_operands()
+  Check the inputs to the numeric dgemm routines; as dgemm_operands(),
+with the additional checks on the output matrix C
+*/
+
+static int
+dgemm_numeric_operands(const gsl_spmatrix *A, const gsl_spmatrix *B,
+                       const gsl_spmatrix *C, const gsl_spmatrix **L,
+                       const gsl_spmatrix **R, size_t *M, size_t *N)
+{
+  int s;
+
+  s = dgemm_operands(A, B, L, R, M, N);
+  if (s)
+    return s;
+  else if (C->size1 != A->size1 || C->size2 != B->size2)
+    {
+      GSL_ERROR("matrix C has wrong dimensions", GSL_EBADLEN);
+    }
+  else if (GSLSP_TYPE(C) != GSLSP_TYPE(A))
+    {
+      GSL_ERROR("matrix C must have same sparse storage format as A and B",
+                GSL_EINVAL);
+    }
+  else if (GSLSP_ISREADONLY(C))
+    {
+      GSL_ERROR("matrix C is read-only", GSL_EINVAL);
+    }
+  else if (GSLSP_ISSYMMETRIC(C))
+    {
+      GSL_ERROR("symmetric storage is not supported", GSL_EINVAL);
+    }
+
+  return GSL_SUCCESS;
+} /* dgemm_numeric_operands() */
 
 /*
 gsl_spblas_scatter()
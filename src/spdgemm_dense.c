@@ -0,0 +1,247 @@
+/* spdgemm_dense.c
+ *
+ * Copyright (C) 2012-2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "spthread.h"
+
+static void dense_scale(const double beta, gsl_matrix *Y,
+                        const size_t i0, const size_t i1,
+                        const size_t k0, const size_t k1);
+static void dense_update(const double alpha, const gsl_spmatrix *A,
+                         const size_t n0, const size_t n1,
+                         const gsl_matrix *X, gsl_matrix *Y,
+                         const size_t k0, const size_t k1);
+
+/*
+gsl_spblas_dgemm_dense()
+  Multiply a sparse matrix and a dense matrix
+
+Inputs: alpha - scalar factor
+        A     - sparse matrix, M-by-N
+        X     - dense matrix, N-by-K
+        beta  - scalar factor
+        Y     - (input/output) dense matrix, M-by-K
+
+Return: Y = alpha*A*X + beta*Y
+
+Notes:
+1) Each non-zero element A_{ij} is loaded once and used to update the
+whole row i of Y with row j of X. Since gsl_matrix is stored by rows,
+the inner loop runs over contiguous memory and can be vectorized by
+the compiler.
+
+2) With more than one thread, CRS matrices are split into blocks of
+rows with approximately equal numbers of non-zeros, while for CCS and
+triplet matrices the columns of X and Y are split between threads. In
+both cases every element of Y is computed by a single thread in the
+same order as the serial code, so the result does not depend on the
+number of threads.
+
+3) A matrix with symmetric storage (GSL_SPMATRIX_SYMMETRIC) is rejected
+*/
+
+int
+gsl_spblas_dgemm_dense(const double alpha, const gsl_spmatrix *A,
+                       const gsl_matrix *X, const double beta, gsl_matrix *Y)
+{
+  const size_t M = A->size1;
+  const size_t N = A->size2;
+  const size_t K = X->size2;
+
+  if (N != X->size1)
+    {
+      GSL_ERROR("X matrix must have size2(A) rows", GSL_EBADLEN);
+    }
+  else if (M != Y->size1 || K != Y->size2)
+    {
+      GSL_ERROR("Y matrix must be size1(A)-by-size2(X)", GSL_EBADLEN);
+    }
+  else if (!GSLSP_ISTRIPLET(A) && !GSLSP_ISCCS(A) && !GSLSP_ISCRS(A))
+    {
+      GSL_ERROR("unsupported matrix type", GSL_EINVAL);
+    }
+  else if (GSLSP_ISSYMMETRIC(A))
+    {
+      GSL_ERROR("symmetric storage is not supported", GSL_EINVAL);
+    }
+  else
+    {
+      const size_t nthreads = gsl_spblas_get_num_threads();
+      const size_t nouter = GSLSP_ISTRIPLET(A) ? A->nz :
+                            GSLSP_ISCCS(A) ? N : M;
+      long t;
+
+      if (nthreads == 1)
+        {
+          /* Y := beta*Y */
+          dense_scale(beta, Y, 0, M, 0, K);
+
+          /* Y := alpha*A*X + Y */
+          if (alpha != 0.0)
+            dense_update(alpha, A, 0, nouter, X, Y, 0, K);
+        }
+      else if (GSLSP_ISCRS(A))
+        {
+          size_t *part = malloc((nthreads + 1) * sizeof(size_t));
+
+          if (!part)
+            {
+              GSL_ERROR("failed to allocate space for partition",
+                        GSL_ENOMEM);
+            }
+
+          spthread_partition(A->p, M, nthreads, part);
+
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+          for (t = 0; t < (long) nthreads; ++t)
+            {
+              dense_scale(beta, Y, part[t], part[t + 1], 0, K);
+
+              if (alpha != 0.0)
+                dense_update(alpha, A, part[t], part[t + 1], X, Y, 0, K);
+            }
+
+          free(part);
+        }
+      else
+        {
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+          for (t = 0; t < (long) nthreads; ++t)
+            {
+              const size_t k0 = spthread_block(K, nthreads, t);
+              const size_t k1 = spthread_block(K, nthreads, t + 1);
+
+              if (k0 == k1)
+                continue;
+
+              dense_scale(beta, Y, 0, M, k0, k1);
+
+              if (alpha != 0.0)
+                dense_update(alpha, A, 0, nouter, X, Y, k0, k1);
+            }
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_spblas_dgemm_dense() */
+
+/*
+dense_scale()
+  Y(i0:i1-1,k0:k1-1) := beta*Y(i0:i1-1,k0:k1-1)
+*/
+
+static void
+dense_scale(const double beta, gsl_matrix *Y, const size_t i0,
+            const size_t i1, const size_t k0, const size_t k1)
+{
+  size_t i, k;
+
+  if (beta == 1.0)
+    return;
+
+  for (i = i0; i < i1; ++i)
+    {
+      double *y = Y->data + i * Y->tda;
+
+      if (beta == 0.0)
+        {
+          for (k = k0; k < k1; ++k)
+            y[k] = 0.0;
+        }
+      else
+        {
+          for (k = k0; k < k1; ++k)
+            y[k] *= beta;
+        }
+    }
+} /* dense_scale() */
+
+/*
+dense_update()
+  Y(:,k0:k1-1) += alpha*A*X(:,k0:k1-1), using only the rows n0:n1-1
+of A (CRS), the columns n0:n1-1 of A (CCS), or the triplets n0:n1-1
+(triplet format)
+*/
+
+static void
+dense_update(const double alpha, const gsl_spmatrix *A,
+             const size_t n0, const size_t n1,
+             const gsl_matrix *X, gsl_matrix *Y,
+             const size_t k0, const size_t k1)
+{
+  const size_t *Ap = A->p;
+  const size_t *Ai = A->i;
+  const double *Ad = A->data;
+  const size_t tdx = X->tda;
+  const size_t tdy = Y->tda;
+  size_t n, p, k;
+
+  if (GSLSP_ISCRS(A))
+    {
+      for (n = n0; n < n1; ++n)
+        {
+          double *y = Y->data + n * tdy;
+
+          for (p = Ap[n]; p < Ap[n + 1]; ++p)
+            {
+              const double a = alpha * Ad[p];
+              const double *x = X->data + Ai[p] * tdx;
+
+              for (k = k0; k < k1; ++k)
+                y[k] += a * x[k];
+            }
+        }
+    }
+  else if (GSLSP_ISCCS(A))
+    {
+      for (n = n0; n < n1; ++n)
+        {
+          const double *x = X->data + n * tdx;
+
+          for (p = Ap[n]; p < Ap[n + 1]; ++p)
+            {
+              const double a = alpha * Ad[p];
+              double *y = Y->data + Ai[p] * tdy;
+
+              for (k = k0; k < k1; ++k)
+                y[k] += a * x[k];
+            }
+        }
+    }
+  else
+    {
+      for (p = n0; p < n1; ++p)
+        {
+          const double a = alpha * Ad[p];
+          const double *x = X->data + Ap[p] * tdx;
+          double *y = Y->data + Ai[p] * tdy;
+
+          for (k = k0; k < k1; ++k)
+            y[k] += a * x[k];
+        }
+    }
+} /* dense_update() */
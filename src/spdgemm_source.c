@@ -0,0 +1,241 @@
+/* spdgemm_source.c
+ *
+ * Copyright (C) 2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Column block kernels of the sparse matrix-matrix product C = L*R in
+ * compressed column form, included by spdgemm.c and spi32.c between
+ * sptemplates_on.h and sptemplates_off.h. The callers allocate C and
+ * divide its columns between the threads with spblas_dgemm_partition();
+ * the kernels only touch the columns j0 <= j < j1 of C.
+ */
+
+/*
+spblas_dgemm_partition()
+  Split the columns of C = L*R into nthreads contiguous blocks of
+approximately equal work, measured as the number of multiply-adds
+needed for each column,
+
+  work(j) = Sum_{k in R(:,j)} nnz(L(:,k))
+
+Inputs: L        - left operand
+        R        - right operand
+        N        - number of columns of R
+        nthreads - number of blocks
+
+Return: array of size nthreads + 1 containing block boundaries
+        (must be freed by caller), or NULL on allocation failure
+*/
+
+static size_t *
+FUNCTION(spblas, dgemm_partition)(const TYPE(gsl_spmatrix) *L,
+                                  const TYPE(gsl_spmatrix) *R,
+                                  const size_t N, const size_t nthreads)
+{
+  const size_t *Lp = L->p;
+  const INDEX *Ri = R->i;
+  const size_t *Rp = R->p;
+  size_t *work = malloc((N + 1) * sizeof(size_t));
+  size_t *part = malloc((nthreads + 1) * sizeof(size_t));
+  long j;
+
+  if (!work || !part)
+    {
+      free(work);
+      free(part);
+      return NULL;
+    }
+
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+  for (j = 0; j < (long) N; ++j)
+    {
+      size_t p, cnt = 0;
+
+      for (p = Rp[j]; p < Rp[j + 1]; ++p)
+        cnt += Lp[Ri[p] + 1] - Lp[Ri[p]];
+
+      work[j] = cnt;
+    }
+
+  gsl_spmatrix_cumsum(N, work);
+  spthread_partition(work, N, nthreads, part);
+
+  free(work);
+
+  return part;
+} /* spblas_dgemm_partition() */
+
+/*
+spblas_dgemm_count()
+  Count the number of non-zeros in columns j0 <= j < j1 of C = L*R
+
+Inputs: L  - left operand
+        R  - right operand
+        M  - number of rows of L
+        j0 - first column
+        j1 - one past last column
+        w  - workspace of size M
+        Cp - (output) Cp[j] = nnz(C(:,j)) for j0 <= j < j1
+*/
+
+static void
+FUNCTION(spblas, dgemm_count)(const TYPE(gsl_spmatrix) *L,
+                              const TYPE(gsl_spmatrix) *R, const size_t M,
+                              const size_t j0, const size_t j1, size_t *w,
+                              size_t *Cp)
+{
+  const INDEX *Li = L->i;
+  const size_t *Lp = L->p;
+  const INDEX *Ri = R->i;
+  const size_t *Rp = R->p;
+  size_t i, j, p, q;
+
+  for (i = 0; i < M; ++i)
+    w[i] = 0;
+
+  for (j = j0; j < j1; ++j)
+    {
+      size_t cnt = 0;
+
+      for (p = Rp[j]; p < Rp[j + 1]; ++p)
+        {
+          size_t k = Ri[p];
+
+          for (q = Lp[k]; q < Lp[k + 1]; ++q)
+            {
+              i = Li[q];
+
+              if (w[i] < j + 1)
+                {
+                  w[i] = j + 1;
+                  ++cnt;
+                }
+            }
+        }
+
+      Cp[j] = cnt;
+    }
+} /* spblas_dgemm_count() */
+
+/*
+spblas_dgemm_pattern()
+  Store the row indices of columns j0 <= j < j1 of C = L*R
+
+Inputs: L  - left operand
+        R  - right operand
+        M  - number of rows of L
+        j0 - first column
+        j1 - one past last column
+        w  - workspace of size M
+        C  - (input/output) on input, C->p contains the final column
+             pointers; on output, C->i is filled in for columns j0:j1-1
+*/
+
+static void
+FUNCTION(spblas, dgemm_pattern)(const TYPE(gsl_spmatrix) *L,
+                                const TYPE(gsl_spmatrix) *R, const size_t M,
+                                const size_t j0, const size_t j1, size_t *w,
+                                TYPE(gsl_spmatrix) *C)
+{
+  const INDEX *Li = L->i;
+  const size_t *Lp = L->p;
+  const INDEX *Ri = R->i;
+  const size_t *Rp = R->p;
+  INDEX *Ci = C->i;
+  size_t nz = C->p[j0];
+  size_t i, j, p, q;
+
+  for (i = 0; i < M; ++i)
+    w[i] = 0;
+
+  for (j = j0; j < j1; ++j)
+    {
+      for (p = Rp[j]; p < Rp[j + 1]; ++p)
+        {
+          size_t k = Ri[p];
+
+          for (q = Lp[k]; q < Lp[k + 1]; ++q)
+            {
+              i = Li[q];
+
+              if (w[i] < j + 1)
+                {
+                  w[i] = j + 1;
+                  Ci[nz++] = (INDEX) i;
+                }
+            }
+        }
+    }
+} /* spblas_dgemm_pattern() */
+
+/*
+spblas_dgemm_values()
+  Compute the values of columns j0 <= j < j1 of C = alpha*L*R
+
+Inputs: alpha - scalar factor
+        L     - left operand
+        R     - right operand
+        j0    - first column
+        j1    - one past last column
+        x     - dense accumulator of size M (rows of L)
+        C     - (input/output) on input, sparsity pattern of L*R;
+                on output, C->data is filled in for columns j0:j1-1
+
+Notes:
+1) The products are accumulated in double precision for every ATOMIC
+type
+*/
+
+static void
+FUNCTION(spblas, dgemm_values)(const double alpha, const TYPE(gsl_spmatrix) *L,
+                               const TYPE(gsl_spmatrix) *R, const size_t j0,
+                               const size_t j1, double *x,
+                               TYPE(gsl_spmatrix) *C)
+{
+  const INDEX *Li = L->i;
+  const size_t *Lp = L->p;
+  const ATOMIC *Ld = L->data;
+  const INDEX *Ri = R->i;
+  const size_t *Rp = R->p;
+  const ATOMIC *Rd = R->data;
+  const INDEX *Ci = C->i;
+  const size_t *Cp = C->p;
+  ATOMIC *Cd = C->data;
+  size_t j, p, q;
+
+  for (j = j0; j < j1; ++j)
+    {
+      /* clear the dense accumulator on the pattern of C(:,j) */
+      for (p = Cp[j]; p < Cp[j + 1]; ++p)
+        x[Ci[p]] = 0.0;
+
+      /* x = sum_k L(:,k) R(k,j) */
+      for (p = Rp[j]; p < Rp[j + 1]; ++p)
+        {
+          size_t k = Ri[p];
+          double rkj = (double) Rd[p];
+
+          for (q = Lp[k]; q < Lp[k + 1]; ++q)
+            x[Li[q]] += (double) Ld[q] * rkj;
+        }
+
+      /* gather C(:,j) = alpha * x */
+      for (p = Cp[j]; p < Cp[j + 1]; ++p)
+        Cd[p] = (ATOMIC) (alpha * x[Ci[p]]);
+    }
+} /* spblas_dgemm_values() */
@@ -23,105 +23,69 @@
 
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_vector.h>
+#include <gsl/gsl_blas.h>
 #include <gsl/gsl_errno.h>
 
 #include "gsl_spmatrix.h"
+#include "spthread.h"
+
+#define SPBASE_DOUBLE
+#include "sptemplates_on.h"
+#include "spgemv_source.c"
+#include "sptemplates_off.h"
+#undef SPBASE_DOUBLE
 
 /*
 gsl_spblas_dgemv()
   Multiply a sparse matrix and a vector
 
-Inputs: alpha - scalar factor
-        A     - sparse matrix
-        x     - dense vector
-        beta  - scalar factor
-        y     - (input/output) dense vector
+Inputs: TransA - CblasNoTrans or CblasTrans
+        alpha  - scalar factor
+        A      - sparse matrix
+        x      - dense vector
+        beta   - scalar factor
+        y      - (input/output) dense vector
+
+Return: y = alpha*op(A)*x + beta*y, where op(A) = A or A^T
 
-Return: y = alpha*A*x + beta*y
+Notes:
+1) The product is computed by the kernels of spgemv_source.c, which
+are shared with gsl_spblas_i32_dgemv() and gsl_spblas_dsgemv(). As for
+compressed matrices, op(A) = A^T for a triplet matrix is described by
+a shallow copy of A, with its index arrays exchanged
+
+2) A matrix with symmetric storage (GSL_SPMATRIX_SYMMETRIC) holds only
+its lower triangle; it equals its transpose and is passed to
+gsl_spblas_dsymv() for either value of TransA
 */
 
 int
-gsl_spblas_dgemv(const double alpha, const gsl_spmatrix *A,
-                 const gsl_vector *x, const double beta, gsl_vector *y)
+gsl_spblas_dgemv(const CBLAS_TRANSPOSE_t TransA, const double alpha,
+                 const gsl_spmatrix *A, const gsl_vector *x,
+                 const double beta, gsl_vector *y)
 {
-  const size_t M = A->size1;
-  const size_t N = A->size2;
-
-  if (N != x->size)
+  if (TransA != CblasNoTrans && TransA != CblasTrans &&
+      TransA != CblasConjTrans)
     {
-      GSL_ERROR("invalid length of x vector", GSL_EBADLEN);
+      GSL_ERROR("invalid TransA", GSL_EINVAL);
     }
-  else if (M != y->size)
+  else if (GSLSP_ISSYMMETRIC(A))
     {
-      GSL_ERROR("invalid length of y vector", GSL_EBADLEN);
+      return gsl_spblas_dsymv(alpha, A, x, beta, y);
     }
-  else
+  else if (GSLSP_ISTRIPLET(A) && TransA != CblasNoTrans)
     {
-      size_t j, p;
-      size_t incX, incY;
-      double *X, *Y;
-      double *Ad;
-      size_t *Ap, *Ai, *Aj;
-
-      /* form y := beta*y */
-
-      Y = y->data;
-      incY = y->stride;
+      gsl_spmatrix AT = *A;
 
-      if (beta == 0.0)
-        {
-          size_t jy = 0;
-          for (j = 0; j < M; ++j)
-            {
-              Y[jy] = 0.0;
-              jy += incY;
-            }
-        }
-      else if (beta != 1.0)
-        {
-          size_t jy = 0;
-          for (j = 0; j < M; ++j)
-            {
-              Y[jy] *= beta;
-              jy += incY;
-            }
-        }
+      AT.size1 = A->size2;
+      AT.size2 = A->size1;
+      AT.i = A->p;
+      AT.p = A->i;
 
-      if (alpha == 0.0)
-        return GSL_SUCCESS;
-
-      /* form y := alpha*A*x + y */
-      Ap = A->p;
-      Ad = A->data;
-      X = x->data;
-      incX = x->stride;
-
-      if (GSLSP_ISCCS(A))
-        {
-          Ai = A->i;
-          for (j = 0; j < N; ++j)
-            {
-              for (p = Ap[j]; p < Ap[j + 1]; ++p)
-                {
-                  Y[Ai[p] * incY] += alpha * Ad[p] * X[j * incX];
-                }
-            }
-        }
-      else if (A->flags & GSL_SPMATRIX_TRIPLET)
-        {
-          Ai = A->i;
-          Aj = A->p;
-
-          for (p = 0; p < A->nz; ++p)
-            {
-              Y[Ai[p] * incY] += alpha * Ad[p] * X[Aj[p] * incX];
-            }
-        }
-      else
-        {
-          GSL_ERROR("unsupported matrix type", GSL_EINVAL);
-        }
-
-      return GSL_SUCCESS;
+      return spblas_gemv(alpha, &AT, x, beta, y);
+    }
+  else
+    {
+      return spblas_gemv_op(TransA, alpha, A, x, beta, y);
     }
 } /* gsl_spblas_dgemv() */
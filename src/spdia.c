@@ -0,0 +1,387 @@
+/* spdia.c
+ *
+ * Copyright (C) 2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "spthread.h"
+
+/* rows per strip in gsl_spblas_dia_dgemv() */
+#define DIA_STRIP           1024
+
+static void dia_scan(const gsl_spmatrix *A, size_t *map, double *data);
+static void dia_mv(const double alpha, const gsl_spmatrix_dia *A,
+                   const size_t i0, const size_t i1, const double *X,
+                   const size_t incX, const double beta, double *Y,
+                   const size_t incY);
+
+/*
+gsl_spmatrix_dia_ndiag()
+  Count the diagonals of a sparse matrix containing non-zero elements
+
+Inputs: A - sparse matrix in triplet, CCS or CRS format, without
+            symmetric storage
+
+Return: number of occupied diagonals, or 0 on error
+
+Notes:
+1) A DIA matrix stores ndiag*size1 elements, so the ratio
+nz / (ndiag*size1) measures how well A suits the DIA format
+*/
+
+size_t
+gsl_spmatrix_dia_ndiag(const gsl_spmatrix *A)
+{
+  const size_t nd = A->size1 + A->size2 - 1;
+  size_t *map = calloc(nd, sizeof(size_t));
+  size_t ndiag = 0;
+  size_t d;
+
+  if (GSLSP_ISSYMMETRIC(A))
+    {
+      free(map);
+      GSL_ERROR_VAL("symmetric storage is not supported", GSL_EINVAL, 0);
+    }
+  else if (!map)
+    {
+      GSL_ERROR_VAL("failed to allocate space for map", GSL_ENOMEM, 0);
+    }
+
+  dia_scan(A, map, NULL);
+
+  for (d = 0; d < nd; ++d)
+    ndiag += (map[d] != 0);
+
+  free(map);
+
+  return ndiag;
+} /* gsl_spmatrix_dia_ndiag() */
+
+/*
+gsl_spmatrix_dia_alloc()
+  Create a diagonal format matrix from a sparse matrix
+
+Inputs: A - sparse matrix in triplet, CCS or CRS format, without
+            symmetric storage
+
+Return: pointer to new matrix, or NULL on error
+
+Notes:
+1) Every diagonal containing at least one element of A is stored in
+full, with explicit zeros for the missing elements. Duplicate
+triplets are summed
+
+2) The elements of A are visited in storage order in two passes:
+the first marks the occupied diagonals, the second stores each
+element in its diagonal, so no index arrays are kept
+*/
+
+gsl_spmatrix_dia *
+gsl_spmatrix_dia_alloc(const gsl_spmatrix *A)
+{
+  const size_t M = A->size1;
+  const size_t N = A->size2;
+  const size_t nd = M + N - 1;
+  gsl_spmatrix_dia *m;
+  size_t *map;
+  size_t d;
+
+  if (!GSLSP_ISTRIPLET(A) && !GSLSP_ISCCS(A) && !GSLSP_ISCRS(A))
+    {
+      GSL_ERROR_NULL("unsupported matrix type", GSL_EINVAL);
+    }
+  else if (GSLSP_ISSYMMETRIC(A))
+    {
+      GSL_ERROR_NULL("symmetric storage is not supported", GSL_EINVAL);
+    }
+
+  m = calloc(1, sizeof(gsl_spmatrix_dia));
+  map = calloc(nd, sizeof(size_t));
+  if (!m || !map)
+    {
+      free(m);
+      free(map);
+      GSL_ERROR_NULL("failed to allocate space for DIA matrix", GSL_ENOMEM);
+    }
+
+  m->size1 = M;
+  m->size2 = N;
+
+  /* map[d] != 0 for occupied diagonals, d = j - i + M - 1 */
+  dia_scan(A, map, NULL);
+
+  for (d = 0; d < nd; ++d)
+    m->ndiag += (map[d] != 0);
+
+  m->offset = malloc(GSL_MAX(m->ndiag, 1) * sizeof(long));
+  m->data = calloc(GSL_MAX(m->ndiag * M, 1), sizeof(double));
+  if (!m->offset || !m->data)
+    {
+      free(map);
+      gsl_spmatrix_dia_free(m);
+      GSL_ERROR_NULL("failed to allocate space for DIA matrix", GSL_ENOMEM);
+    }
+
+  /* number the diagonals in increasing order of offset; map[d] = k + 1 */
+  m->ndiag = 0;
+  for (d = 0; d < nd; ++d)
+    {
+      if (map[d])
+        {
+          m->offset[m->ndiag] = (long) d - (long) (M - 1);
+          map[d] = ++m->ndiag;
+        }
+    }
+
+  dia_scan(A, map, m->data);
+
+  free(map);
+
+  return m;
+} /* gsl_spmatrix_dia_alloc() */
+
+/*
+gsl_spmatrix_dia_free()
+  Free a diagonal format matrix
+*/
+
+void
+gsl_spmatrix_dia_free(gsl_spmatrix_dia *m)
+{
+  if (m->offset)
+    free(m->offset);
+
+  if (m->data)
+    free(m->data);
+
+  free(m);
+} /* gsl_spmatrix_dia_free() */
+
+/*
+gsl_spmatrix_dia_get()
+  Return element (i,j) of a diagonal format matrix
+*/
+
+double
+gsl_spmatrix_dia_get(const gsl_spmatrix_dia *m, const size_t i,
+                     const size_t j)
+{
+  if (i >= m->size1)
+    {
+      GSL_ERROR_VAL("first index out of range", GSL_EINVAL, 0.0);
+    }
+  else if (j >= m->size2)
+    {
+      GSL_ERROR_VAL("second index out of range", GSL_EINVAL, 0.0);
+    }
+  else
+    {
+      const long off = (long) j - (long) i;
+      size_t lo = 0, hi = m->ndiag;
+
+      /* binary search for the diagonal */
+      while (lo < hi)
+        {
+          size_t mid = lo + (hi - lo) / 2;
+
+          if (m->offset[mid] < off)
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+
+      if (lo < m->ndiag && m->offset[lo] == off)
+        return m->data[lo * m->size1 + i];
+
+      return 0.0;
+    }
+} /* gsl_spmatrix_dia_get() */
+
+/*
+gsl_spblas_dia_dgemv()
+  Multiply a diagonal format matrix and a vector
+
+Inputs: alpha - scalar factor
+        A     - DIA matrix
+        x     - dense vector
+        beta  - scalar factor
+        y     - (input/output) dense vector
+
+Return: y = alpha*A*x + beta*y
+
+Notes:
+1) Each diagonal is applied as an axpy-style sweep
+y(i) += alpha * d(i) * x(i + offset) over contiguous ranges of the
+diagonal, x and y, with no index arrays. The rows are processed in
+strips of DIA_STRIP rows so that the strip of y stays in cache while
+all diagonals are applied to it
+
+2) With more than one thread, the rows are divided evenly between
+threads. Each y(i) accumulates the diagonals in the same order in
+every case, so the result does not depend on the number of threads
+*/
+
+int
+gsl_spblas_dia_dgemv(const double alpha, const gsl_spmatrix_dia *A,
+                     const gsl_vector *x, const double beta, gsl_vector *y)
+{
+  if (A->size2 != x->size)
+    {
+      GSL_ERROR("invalid length of x vector", GSL_EBADLEN);
+    }
+  else if (A->size1 != y->size)
+    {
+      GSL_ERROR("invalid length of y vector", GSL_EBADLEN);
+    }
+  else
+    {
+      const size_t M = A->size1;
+      const size_t nthreads = gsl_spblas_get_num_threads();
+      long t;
+
+      if (nthreads == 1)
+        {
+          dia_mv(alpha, A, 0, M, x->data, x->stride, beta, y->data,
+                 y->stride);
+        }
+      else
+        {
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+          for (t = 0; t < (long) nthreads; ++t)
+            {
+              dia_mv(alpha, A, spthread_block(M, nthreads, t),
+                     spthread_block(M, nthreads, t + 1), x->data, x->stride,
+                     beta, y->data, y->stride);
+            }
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_spblas_dia_dgemv() */
+
+/*
+dia_scan()
+  Visit the elements of a sparse matrix
+
+Inputs: A    - sparse matrix in triplet, CCS or CRS format
+        map  - array of size size1 + size2 - 1, indexed by
+               d = j - i + size1 - 1
+        data - if NULL, map[d] is set to 1 for each occupied diagonal;
+               otherwise each element (i,j) is added to
+               data[(map[d] - 1)*size1 + i]
+*/
+
+static void
+dia_scan(const gsl_spmatrix *A, size_t *map, double *data)
+{
+  const size_t M = A->size1;
+  size_t n, k, p;
+
+  if (GSLSP_ISTRIPLET(A))
+    {
+      for (n = 0; n < A->nz; ++n)
+        {
+          const size_t i = A->i[n];
+          const size_t d = A->p[n] + M - 1 - i;
+
+          if (data)
+            data[(map[d] - 1) * M + i] += A->data[n];
+          else
+            map[d] = 1;
+        }
+    }
+  else
+    {
+      const size_t nouter = GSLSP_ISCCS(A) ? A->size2 : M;
+
+      for (k = 0; k < nouter; ++k)
+        {
+          for (p = A->p[k]; p < A->p[k + 1]; ++p)
+            {
+              const size_t i = GSLSP_ISCCS(A) ? A->i[p] : k;
+              const size_t j = GSLSP_ISCCS(A) ? k : A->i[p];
+              const size_t d = j + M - 1 - i;
+
+              if (data)
+                data[(map[d] - 1) * M + i] += A->data[p];
+              else
+                map[d] = 1;
+            }
+        }
+    }
+} /* dia_scan() */
+
+/*
+dia_mv()
+  y(i0:i1-1) := alpha*A(i0:i1-1,:)*x + beta*y(i0:i1-1)
+*/
+
+static void
+dia_mv(const double alpha, const gsl_spmatrix_dia *A, const size_t i0,
+       const size_t i1, const double *X, const size_t incX,
+       const double beta, double *Y, const size_t incY)
+{
+  const size_t M = A->size1;
+  const long N = (long) A->size2;
+  size_t s, i, k;
+
+  for (s = i0; s < i1; s += DIA_STRIP)
+    {
+      const size_t s1 = GSL_MIN(s + DIA_STRIP, i1);
+
+      /* y := beta*y */
+      for (i = s; i < s1; ++i)
+        Y[i * incY] = (beta == 0.0) ? 0.0 : beta * Y[i * incY];
+
+      if (alpha == 0.0)
+        continue;
+
+      for (k = 0; k < A->ndiag; ++k)
+        {
+          const long off = A->offset[k];
+          const double *d = A->data + k * M;
+
+          /* rows of the strip with 0 <= i + off < N */
+          const size_t lo = (size_t) GSL_MAX((long) s, -off);
+          const size_t hi = (size_t) GSL_MAX(GSL_MIN((long) s1, N - off),
+                                             (long) lo);
+          const size_t jlo = (size_t) ((long) lo + off);
+
+          if (incX == 1 && incY == 1)
+            {
+              const double *dd = d + lo;
+              const double *x = X + jlo;
+              double *y = Y + lo;
+
+              for (i = 0; i < hi - lo; ++i)
+                y[i] += alpha * dd[i] * x[i];
+            }
+          else
+            {
+              for (i = 0; i < hi - lo; ++i)
+                Y[(lo + i) * incY] += alpha * d[lo + i] * X[(jlo + i) * incX];
+            }
+        }
+    }
+} /* dia_mv() */
@@ -0,0 +1,241 @@
+/* spdsymv.c
+ *
+ * Copyright (C) 2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "spthread.h"
+
+static int dsymv_parallel(const double alpha, const gsl_spmatrix *A,
+                          const gsl_vector *x, const double beta,
+                          gsl_vector *y, const size_t nthreads);
+
+/*
+gsl_spblas_dsymv()
+  Multiply a symmetric sparse matrix and a vector
+
+Inputs: alpha - scalar factor
+        A     - symmetric sparse matrix, storing its lower triangle
+                in CCS format (see gsl_spmatrix_symmetric())
+        x     - dense vector
+        beta  - scalar factor
+        y     - (input/output) dense vector
+
+Return: y = alpha*A*x + beta*y
+
+Notes:
+1) Each stored element a_ij with i > j is applied twice in a single
+pass over A: it is scattered into y_i as a_ij x_j, and its transpose
+is gathered into the dot product of column j with x, which gives the
+contribution to y_j. The diagonal elements are applied once
+
+2) With more than one thread, the columns are split into blocks with
+approximately equal numbers of non-zeros (spthread_partition). The
+scattered updates of different threads conflict, so each thread
+accumulates its contribution in a private vector, which is summed
+afterwards. Since a thread owning columns j0 <= j < j1 of the lower
+triangle only writes to rows i >= j0, its private vector needs only
+size1 - j0 elements. The private vectors are allocated on every call,
+so the number of threads is limited by spthread_nprivate(), as in
+gsl_spblas_dgemv()
+*/
+
+int
+gsl_spblas_dsymv(const double alpha, const gsl_spmatrix *A,
+                 const gsl_vector *x, const double beta, gsl_vector *y)
+{
+  const size_t N = A->size2;
+
+  if (!GSLSP_ISSYMMETRIC(A) || !GSLSP_ISCCS(A))
+    {
+      GSL_ERROR("matrix must have symmetric CCS storage", GSL_EINVAL);
+    }
+  else if (N != x->size)
+    {
+      GSL_ERROR("invalid length of x vector", GSL_EBADLEN);
+    }
+  else if (N != y->size)
+    {
+      GSL_ERROR("invalid length of y vector", GSL_EBADLEN);
+    }
+  else
+    {
+      const size_t nthreads =
+        spthread_nprivate(gsl_spblas_get_num_threads(), A->nz, N);
+      const size_t *Ap = A->p;
+      const size_t *Ai = A->i;
+      const double *Ad = A->data;
+      const double *X = x->data;
+      const size_t incX = x->stride;
+      double *Y = y->data;
+      const size_t incY = y->stride;
+      size_t j, p;
+
+      if (nthreads > 1 && alpha != 0.0)
+        return dsymv_parallel(alpha, A, x, beta, y, nthreads);
+
+      /* y := beta*y */
+      for (j = 0; j < N; ++j)
+        {
+          if (beta == 0.0)
+            Y[j * incY] = 0.0;
+          else if (beta != 1.0)
+            Y[j * incY] *= beta;
+        }
+
+      if (alpha == 0.0)
+        return GSL_SUCCESS;
+
+      /* y := alpha*A*x + y */
+      for (j = 0; j < N; ++j)
+        {
+          const double xj = X[j * incX];
+          double temp = 0.0;
+
+          for (p = Ap[j]; p < Ap[j + 1]; ++p)
+            {
+              const size_t i = Ai[p];
+
+              Y[i * incY] += alpha * Ad[p] * xj;
+
+              if (i != j)
+                temp += Ad[p] * X[i * incX];
+            }
+
+          Y[j * incY] += alpha * temp;
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_spblas_dsymv() */
+
+/*
+dsymv_parallel()
+  Multithreaded version of gsl_spblas_dsymv(); see the notes above
+
+Inputs: alpha    - scalar factor, != 0
+        A        - symmetric sparse matrix
+        x        - dense vector
+        beta     - scalar factor
+        y        - (input/output) dense vector
+        nthreads - number of threads
+
+Return: y = alpha*A*x + beta*y
+*/
+
+static int
+dsymv_parallel(const double alpha, const gsl_spmatrix *A,
+               const gsl_vector *x, const double beta, gsl_vector *y,
+               const size_t nthreads)
+{
+  const size_t N = A->size2;
+  const size_t *Ap = A->p;
+  const size_t *Ai = A->i;
+  const double *Ad = A->data;
+  const double *X = x->data;
+  const size_t incX = x->stride;
+  double *Y = y->data;
+  const size_t incY = y->stride;
+  size_t *part, *off;
+  double *work;
+  size_t k;
+  long t;
+
+  part = malloc(2 * (nthreads + 1) * sizeof(size_t));
+  if (!part)
+    {
+      GSL_ERROR("failed to allocate space for partition", GSL_ENOMEM);
+    }
+
+  spthread_partition(Ap, N, nthreads, part);
+
+  /* private vector of thread k is work[off[k] .. off[k+1]-1] */
+  off = part + nthreads + 1;
+  off[0] = 0;
+  for (k = 0; k < nthreads; ++k)
+    off[k + 1] = off[k] + (N - part[k]);
+
+  work = malloc(GSL_MAX(off[nthreads], 1) * sizeof(double));
+  if (!work)
+    {
+      free(part);
+      GSL_ERROR("failed to allocate space for thread workspace", GSL_ENOMEM);
+    }
+
+#pragma omp parallel num_threads(nthreads)
+  {
+    long i;
+
+    /* w_t(r - j0) = row r of the partial product of thread t */
+#pragma omp for schedule(static, 1)
+    for (t = 0; t < (long) nthreads; ++t)
+      {
+        const size_t j0 = part[t];
+        double *w = work + off[t];
+        size_t j, p;
+
+        for (j = 0; j < N - j0; ++j)
+          w[j] = 0.0;
+
+        for (j = j0; j < part[t + 1]; ++j)
+          {
+            const double xj = X[j * incX];
+            double temp = 0.0;
+
+            for (p = Ap[j]; p < Ap[j + 1]; ++p)
+              {
+                const size_t r = Ai[p];
+
+                w[r - j0] += Ad[p] * xj;
+
+                if (r != j)
+                  temp += Ad[p] * X[r * incX];
+              }
+
+            w[j - j0] += temp;
+          }
+      }
+
+    /* y := beta*y + alpha*sum_t w_t */
+#pragma omp for schedule(static)
+    for (i = 0; i < (long) N; ++i)
+      {
+        double sum = 0.0;
+        size_t s;
+
+        for (s = 0; s < nthreads && part[s] <= (size_t) i; ++s)
+          sum += work[off[s] + (size_t) i - part[s]];
+
+        if (beta == 0.0)
+          Y[i * incY] = alpha * sum;
+        else
+          Y[i * incY] = beta * Y[i * incY] + alpha * sum;
+      }
+  }
+
+  free(work);
+  free(part);
+
+  return GSL_SUCCESS;
+} /* dsymv_parallel() */
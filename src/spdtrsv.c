@@ -0,0 +1,570 @@
+/* spdtrsv.c
+ *
+ * Copyright (C) 2012-2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+
+/* marker for a diagonal element which is not stored */
+#define TRSV_NONE     ((size_t) -1)
+
+static void trsv_row(const int nonunit, const double *Ad,
+                     const gsl_spblas_trsv_workspace *w, const size_t r,
+                     gsl_vector *x);
+static int trsv_op(const CBLAS_UPLO_t Uplo, const CBLAS_TRANSPOSE_t TransA,
+                   const gsl_spmatrix *A, gsl_spmatrix *B, int *lower);
+static int trsv_pattern(const gsl_spmatrix *A,
+                        const gsl_spblas_trsv_workspace *w);
+
+/*
+gsl_spblas_dtrsv()
+  Solve a sparse triangular system op(A) x = b
+
+Inputs: Uplo   - CblasLower or CblasUpper; only this triangle of A
+                 (and its diagonal) is used
+        TransA - CblasNoTrans or CblasTrans
+        Diag   - CblasUnit or CblasNonUnit; for CblasUnit, the
+                 diagonal of A is assumed to be 1 and is not used
+        A      - square sparse matrix in CCS or CRS format
+        x      - (input/output) on input, right hand side b; on output,
+                 solution x
+
+Return: success or error
+
+Notes:
+1) As in gsl_spblas_dgemv(), op(A) = A^T is handled by viewing the CCS
+arrays of A as the CRS arrays of A^T, so that only two kernels are
+needed: a column oriented one (CCS), which scatters x_j into the
+remaining right hand side, and a row oriented one (CRS), which gathers
+the known x_j into a dot product
+
+2) Elements of A outside the triangle Uplo are ignored. For a matrix
+with symmetric storage, the upper triangle is the transpose of the
+stored lower triangle
+*/
+
+int
+gsl_spblas_dtrsv(const CBLAS_UPLO_t Uplo, const CBLAS_TRANSPOSE_t TransA,
+                 const CBLAS_DIAG_t Diag, const gsl_spmatrix *A,
+                 gsl_vector *x)
+{
+  const size_t N = A->size1;
+  gsl_spmatrix B;
+  int lower;
+
+  if (N != A->size2)
+    {
+      GSL_ERROR("matrix must be square", GSL_ENOTSQR);
+    }
+  else if (N != x->size)
+    {
+      GSL_ERROR("invalid length", GSL_EBADLEN);
+    }
+  else if (trsv_op(Uplo, TransA, A, &B, &lower))
+    {
+      GSL_ERROR("matrix must be in compressed format and Uplo/TransA valid",
+                GSL_EINVAL);
+    }
+  else
+    {
+      const int nonunit = (Diag == CblasNonUnit);
+      const size_t *Bp = B.p;
+      const size_t *Bi = B.i;
+      const double *Bd = B.data;
+      double *X = x->data;
+      const size_t incX = x->stride;
+      size_t k, p;
+
+      if (GSLSP_ISCCS(&B))
+        {
+          /* column oriented: once x_j is known, remove it from b */
+          for (k = 0; k < N; ++k)
+            {
+              const size_t j = lower ? k : N - 1 - k;
+              double xj = X[j * incX];
+
+              if (nonunit)
+                {
+                  double ajj = 0.0;
+
+                  for (p = Bp[j]; p < Bp[j + 1]; ++p)
+                    {
+                      if (Bi[p] == j)
+                        ajj += Bd[p];
+                    }
+
+                  if (ajj == 0.0)
+                    {
+                      GSL_ERROR("matrix is singular", GSL_ESING);
+                    }
+
+                  xj /= ajj;
+                  X[j * incX] = xj;
+                }
+
+              for (p = Bp[j]; p < Bp[j + 1]; ++p)
+                {
+                  const size_t i = Bi[p];
+
+                  if ((lower && i > j) || (!lower && i < j))
+                    X[i * incX] -= Bd[p] * xj;
+                }
+            }
+        }
+      else
+        {
+          /* row oriented: x_i = (b_i - sum_j a_ij x_j) / a_ii */
+          for (k = 0; k < N; ++k)
+            {
+              const size_t i = lower ? k : N - 1 - k;
+              double sum = X[i * incX];
+              double aii = 0.0;
+
+              for (p = Bp[i]; p < Bp[i + 1]; ++p)
+                {
+                  const size_t j = Bi[p];
+
+                  if (j == i)
+                    aii += Bd[p];
+                  else if ((lower && j < i) || (!lower && j > i))
+                    sum -= Bd[p] * X[j * incX];
+                }
+
+              if (nonunit)
+                {
+                  if (aii == 0.0)
+                    {
+                      GSL_ERROR("matrix is singular", GSL_ESING);
+                    }
+
+                  sum /= aii;
+                }
+
+              X[i * incX] = sum;
+            }
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_spblas_dtrsv() */
+
+/*
+gsl_spblas_trsv_alloc()
+  Analyze the sparsity pattern of a triangular matrix for
+gsl_spblas_dtrsv_levels()
+
+Inputs: Uplo   - CblasLower or CblasUpper
+        TransA - CblasNoTrans or CblasTrans
+        A      - square sparse matrix in CCS or CRS format
+
+Return: pointer to workspace
+
+Notes:
+1) The rows of op(A) are stored in the workspace as lists of
+(column, position in A->data) pairs, so that the solve can always be
+performed row by row, reading the values of A at solve time. The values
+of A may therefore change between solves, provided the pattern does not
+
+2) Row i belongs to level 0 if it depends on no other row, and otherwise
+to level 1 + max(level of the rows it depends on). All rows of a level
+can be solved concurrently once the previous levels are known; the
+rows are stored sorted by level
+*/
+
+gsl_spblas_trsv_workspace *
+gsl_spblas_trsv_alloc(const CBLAS_UPLO_t Uplo, const CBLAS_TRANSPOSE_t TransA,
+                      const gsl_spmatrix *A)
+{
+  const size_t N = A->size1;
+  gsl_spblas_trsv_workspace *w;
+  gsl_spmatrix B;
+  size_t *level;
+  size_t i, k, p, nz = 0;
+  int lower;
+
+  if (N != A->size2)
+    {
+      GSL_ERROR_NULL("matrix must be square", GSL_ENOTSQR);
+    }
+  else if (trsv_op(Uplo, TransA, A, &B, &lower))
+    {
+      GSL_ERROR_NULL("matrix must be in compressed format and Uplo/TransA valid",
+                     GSL_EINVAL);
+    }
+
+  w = calloc(1, sizeof(gsl_spblas_trsv_workspace));
+  if (!w)
+    {
+      GSL_ERROR_NULL("failed to allocate space for trsv struct", GSL_ENOMEM);
+    }
+
+  w->n = N;
+  w->Uplo = Uplo;
+  w->TransA = TransA;
+  w->type = GSLSP_TYPE(A);
+  w->nzA = A->nz;
+
+  w->ptr = malloc((N + 1) * sizeof(size_t));
+  w->diag = malloc(GSL_MAX(N, 1) * sizeof(size_t));
+  w->level_ptr = malloc((N + 1) * sizeof(size_t));
+  w->level_rows = malloc(GSL_MAX(N, 1) * sizeof(size_t));
+  if (!w->ptr || !w->diag || !w->level_ptr || !w->level_rows)
+    {
+      gsl_spblas_trsv_free(w);
+      GSL_ERROR_NULL("failed to allocate space for trsv workspace",
+                     GSL_ENOMEM);
+    }
+
+  /* count the off-diagonal elements of each row of the triangle */
+  for (i = 0; i < N; ++i)
+    {
+      w->ptr[i] = 0;
+      w->diag[i] = TRSV_NONE;
+    }
+
+  for (k = 0; k < N; ++k)
+    {
+      for (p = B.p[k]; p < B.p[k + 1]; ++p)
+        {
+          /* (i,j) = row and column of this element of op(A) */
+          const size_t i = GSLSP_ISCRS(&B) ? k : B.i[p];
+          const size_t j = GSLSP_ISCRS(&B) ? B.i[p] : k;
+
+          if (i == j)
+            w->diag[i] = p;
+          else if ((lower && j < i) || (!lower && j > i))
+            {
+              w->ptr[i]++;
+              ++nz;
+            }
+        }
+    }
+
+  gsl_spmatrix_cumsum(N, w->ptr);
+
+  w->nz = nz;
+  w->col = malloc(GSL_MAX(nz, 1) * sizeof(size_t));
+  w->pos = malloc(GSL_MAX(nz, 1) * sizeof(size_t));
+  level = malloc(GSL_MAX(N, 1) * sizeof(size_t));
+  if (!w->col || !w->pos || !level)
+    {
+      if (level)
+        free(level);
+
+      gsl_spblas_trsv_free(w);
+      GSL_ERROR_NULL("failed to allocate space for trsv workspace",
+                     GSL_ENOMEM);
+    }
+
+  /* fill the rows, using level[] as insertion pointers */
+  for (i = 0; i < N; ++i)
+    level[i] = w->ptr[i];
+
+  for (k = 0; k < N; ++k)
+    {
+      for (p = B.p[k]; p < B.p[k + 1]; ++p)
+        {
+          const size_t i = GSLSP_ISCRS(&B) ? k : B.i[p];
+          const size_t j = GSLSP_ISCRS(&B) ? B.i[p] : k;
+
+          if ((lower && j < i) || (!lower && j > i))
+            {
+              size_t q = level[i]++;
+              w->col[q] = j;
+              w->pos[q] = p;
+            }
+        }
+    }
+
+  /* compute levels, in the order in which the rows are solved */
+  w->nlevels = 0;
+  for (k = 0; k < N; ++k)
+    {
+      const size_t i = lower ? k : N - 1 - k;
+      size_t li = 0;
+
+      for (p = w->ptr[i]; p < w->ptr[i + 1]; ++p)
+        li = GSL_MAX(li, level[w->col[p]] + 1);
+
+      level[i] = li;
+      w->nlevels = GSL_MAX(w->nlevels, li + 1);
+    }
+
+  /* sort rows by level, keeping the solve order within each level */
+  for (k = 0; k < w->nlevels + 1; ++k)
+    w->level_ptr[k] = 0;
+
+  for (i = 0; i < N; ++i)
+    w->level_ptr[level[i]]++;
+
+  gsl_spmatrix_cumsum(w->nlevels, w->level_ptr);
+
+  for (k = 0; k < N; ++k)
+    {
+      const size_t i = lower ? k : N - 1 - k;
+      w->level_rows[w->level_ptr[level[i]]++] = i;
+    }
+
+  /* restore level pointers shifted by the previous loop */
+  for (k = w->nlevels; k > 0; --k)
+    w->level_ptr[k] = w->level_ptr[k - 1];
+
+  w->level_ptr[0] = 0;
+
+  free(level);
+
+  return w;
+} /* gsl_spblas_trsv_alloc() */
+
+void
+gsl_spblas_trsv_free(gsl_spblas_trsv_workspace *w)
+{
+  if (w->ptr)
+    free(w->ptr);
+
+  if (w->col)
+    free(w->col);
+
+  if (w->pos)
+    free(w->pos);
+
+  if (w->diag)
+    free(w->diag);
+
+  if (w->level_ptr)
+    free(w->level_ptr);
+
+  if (w->level_rows)
+    free(w->level_rows);
+
+  free(w);
+} /* gsl_spblas_trsv_free() */
+
+/*
+gsl_spblas_dtrsv_levels()
+  Solve op(A) x = b using the level sets computed by
+gsl_spblas_trsv_alloc()
+
+Inputs: Diag - CblasUnit or CblasNonUnit
+        A    - matrix with the sparsity pattern given to
+               gsl_spblas_trsv_alloc()
+        w    - workspace
+        x    - (input/output) on input, right hand side b; on output,
+               solution x
+
+Return: success or error
+
+Notes:
+1) The rows of each level are divided between the threads requested
+with gsl_spblas_set_num_threads(), with a barrier between levels; with
+one thread, the rows are simply solved in level order. Every x_i is
+computed by the same sequence of operations regardless of the number
+of threads, so the result does not depend on it
+
+2) Only the positions of the elements in A->data are stored in the
+workspace, so A is checked against them with trsv_pattern() before
+A->data is read
+*/
+
+int
+gsl_spblas_dtrsv_levels(const CBLAS_DIAG_t Diag, const gsl_spmatrix *A,
+                        const gsl_spblas_trsv_workspace *w, gsl_vector *x)
+{
+  const size_t N = w->n;
+
+  if (A->size1 != N || A->size2 != N || GSLSP_TYPE(A) != w->type ||
+      A->nz != w->nzA || !trsv_pattern(A, w))
+    {
+      GSL_ERROR("matrix does not match workspace", GSL_EBADLEN);
+    }
+  else if (x->size != N)
+    {
+      GSL_ERROR("invalid length", GSL_EBADLEN);
+    }
+  else
+    {
+      const int nonunit = (Diag == CblasNonUnit);
+      const size_t nthreads = gsl_spblas_get_num_threads();
+      const double *Ad = A->data;
+      size_t i;
+
+      if (nonunit)
+        {
+          for (i = 0; i < N; ++i)
+            {
+              if (w->diag[i] == TRSV_NONE || Ad[w->diag[i]] == 0.0)
+                {
+                  GSL_ERROR("matrix is singular", GSL_ESING);
+                }
+            }
+        }
+
+      if (nthreads > 1)
+        {
+#pragma omp parallel num_threads(nthreads)
+          {
+            size_t l;
+
+            for (l = 0; l < w->nlevels; ++l)
+              {
+                long k;
+
+#pragma omp for schedule(static)
+                for (k = (long) w->level_ptr[l];
+                     k < (long) w->level_ptr[l + 1]; ++k)
+                  trsv_row(nonunit, Ad, w, w->level_rows[k], x);
+              }
+          }
+        }
+      else
+        {
+          for (i = 0; i < N; ++i)
+            trsv_row(nonunit, Ad, w, w->level_rows[i], x);
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_spblas_dtrsv_levels() */
+
+/*
+trsv_row()
+  Compute x_r from the known elements of x, using row r of op(A)
+stored in the workspace
+*/
+
+static void
+trsv_row(const int nonunit, const double *Ad,
+         const gsl_spblas_trsv_workspace *w, const size_t r, gsl_vector *x)
+{
+  double *X = x->data;
+  const size_t incX = x->stride;
+  double sum = X[r * incX];
+  size_t p;
+
+  for (p = w->ptr[r]; p < w->ptr[r + 1]; ++p)
+    sum -= Ad[w->pos[p]] * X[w->col[p] * incX];
+
+  if (nonunit)
+    sum /= Ad[w->diag[r]];
+
+  X[r * incX] = sum;
+} /* trsv_row() */
+
+/*
+trsv_pattern()
+  Check that the pattern of A is consistent with the workspace: each
+recorded position must lie within the first nzA elements of A, in the
+outer index (row or column of op(A)) it was recorded for, with the
+recorded inner index
+
+Inputs: A - compressed matrix with nz = w->nzA
+        w - workspace
+
+Return: 1 if A matches the workspace, 0 otherwise
+*/
+
+static int
+trsv_pattern(const gsl_spmatrix *A, const gsl_spblas_trsv_workspace *w)
+{
+  const size_t N = w->n;
+  gsl_spmatrix B;
+  int lower;
+  size_t r, q;
+
+  if (trsv_op(w->Uplo, w->TransA, A, &B, &lower) || B.p[N] > A->nz)
+    return 0;
+
+  for (r = 0; r < N; ++r)
+    {
+      const size_t d = w->diag[r];
+
+      if (d != TRSV_NONE &&
+          (d < B.p[r] || d >= B.p[r + 1] || B.i[d] != r))
+        return 0;
+
+      for (q = w->ptr[r]; q < w->ptr[r + 1]; ++q)
+        {
+          /* element (r, col[q]) of op(A) is in row r (CRS) or column col[q] */
+          const size_t outer = GSLSP_ISCRS(&B) ? r : w->col[q];
+          const size_t inner = GSLSP_ISCRS(&B) ? w->col[q] : r;
+          const size_t p = w->pos[q];
+
+          if (outer >= N || p < B.p[outer] || p >= B.p[outer + 1] ||
+              B.i[p] != inner)
+            return 0;
+        }
+    }
+
+  return 1;
+} /* trsv_pattern() */
+
+/*
+trsv_op()
+  Describe op(A) as a compressed matrix without copying A
+
+Inputs: Uplo   - triangle of A
+        TransA - CblasNoTrans or CblasTrans
+        A      - compressed matrix
+        B      - (output) shallow copy of A describing op(A)
+        lower  - (output) 1 if op(A) is lower triangular, 0 if upper
+
+Return: 0 on success, -1 if A is not compressed or Uplo/TransA are
+invalid
+
+Notes:
+1) A matrix with symmetric storage (GSL_SPMATRIX_SYMMETRIC) stores only
+its lower triangle L; its upper triangle is L^T, so for Uplo =
+CblasUpper the arrays are viewed as those of L^T before applying TransA
+*/
+
+static int
+trsv_op(const CBLAS_UPLO_t Uplo, const CBLAS_TRANSPOSE_t TransA,
+        const gsl_spmatrix *A, gsl_spmatrix *B, int *lower)
+{
+  if (!GSLSP_ISCCS(A) && !GSLSP_ISCRS(A))
+    return -1;
+
+  if (Uplo != CblasLower && Uplo != CblasUpper)
+    return -1;
+
+  *B = *A;
+  *lower = (Uplo == CblasLower);
+
+  if (GSLSP_ISSYMMETRIC(A) && Uplo == CblasUpper)
+    B->flags ^= GSL_SPMATRIX_CCS | GSL_SPMATRIX_CRS;
+
+  if (TransA == CblasTrans || TransA == CblasConjTrans)
+    {
+      B->flags ^= GSL_SPMATRIX_CCS | GSL_SPMATRIX_CRS;
+      *lower = !*lower;
+    }
+  else if (TransA != CblasNoTrans)
+    {
+      return -1;
+    }
+
+  return 0;
+} /* trsv_op() */
@@ -0,0 +1,144 @@
+/* spfloat.c
+ *
+ * Copyright (C) 2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "spthread.h"
+
+#define SPBASE_FLOAT
+#include "sptemplates_on.h"
+#include "spcompressed_source.c"
+#include "spgemv_source.c"
+#include "sptemplates_off.h"
+#undef SPBASE_FLOAT
+
+/*
+gsl_spmatrix_float_alloc_nzmax()
+  Allocate a compressed matrix with single precision values
+
+Inputs: n1    - number of rows
+        n2    - number of columns
+        nzmax - maximum number of matrix elements
+        flags - GSL_SPMATRIX_CCS or GSL_SPMATRIX_CRS
+
+Return: pointer to new matrix, or NULL on error
+*/
+
+gsl_spmatrix_float *
+gsl_spmatrix_float_alloc_nzmax(const size_t n1, const size_t n2,
+                               const size_t nzmax, const size_t flags)
+{
+  const size_t type = flags & GSL_SPMATRIX_TYPEMASK;
+  gsl_spmatrix_float *m;
+
+  if (n1 == 0 || n2 == 0)
+    {
+      GSL_ERROR_NULL("matrix dimensions must be positive integers",
+                     GSL_EINVAL);
+    }
+  else if (type != GSL_SPMATRIX_CCS && type != GSL_SPMATRIX_CRS)
+    {
+      GSL_ERROR_NULL("matrix must be in compressed format", GSL_EINVAL);
+    }
+
+  m = calloc(1, sizeof(gsl_spmatrix_float));
+  if (!m)
+    {
+      GSL_ERROR_NULL("failed to allocate space for spmatrix struct",
+                     GSL_ENOMEM);
+    }
+
+  m->size1 = n1;
+  m->size2 = n2;
+  m->nz = 0;
+  m->nzmax = GSL_MAX(nzmax, 1);
+  m->flags = type;
+
+  m->i = malloc(m->nzmax * sizeof(size_t));
+  m->data = malloc(m->nzmax * sizeof(float));
+  m->p = malloc(((type == GSL_SPMATRIX_CCS) ? n2 + 1 : n1 + 1) *
+                sizeof(size_t));
+  if (!m->i || !m->data || !m->p)
+    {
+      gsl_spmatrix_float_free(m);
+      GSL_ERROR_NULL("failed to allocate space for matrix arrays",
+                     GSL_ENOMEM);
+    }
+
+  return m;
+} /* gsl_spmatrix_float_alloc_nzmax() */
+
+/*
+gsl_spmatrix_float_free()
+  Free a matrix with single precision values
+*/
+
+void
+gsl_spmatrix_float_free(gsl_spmatrix_float *m)
+{
+  if (m->i)
+    free(m->i);
+
+  if (m->data)
+    free(m->data);
+
+  if (m->p)
+    free(m->p);
+
+  free(m);
+} /* gsl_spmatrix_float_free() */
+
+/*
+gsl_spblas_dsgemv()
+  Mixed precision product of a single precision sparse matrix and a
+double precision vector
+
+Inputs: TransA - CblasNoTrans or CblasTrans
+        alpha  - scalar factor
+        A      - sparse matrix with single precision values
+        x      - dense vector
+        beta   - scalar factor
+        y      - (input/output) dense vector
+
+Return: y = alpha*op(A)*x + beta*y, where op(A) = A or A^T
+
+Notes:
+1) Each element of A is converted to double as it is loaded, and all
+arithmetic is done in double precision, so the result is that of
+gsl_spblas_dgemv() applied to the rounded matrix; only the memory
+traffic for the values is halved
+
+2) The kernels of spgemv_source.c are shared with gsl_spblas_dgemv(),
+so the same serial and multithreaded algorithms are used
+*/
+
+int
+gsl_spblas_dsgemv(const CBLAS_TRANSPOSE_t TransA, const double alpha,
+                  const gsl_spmatrix_float *A, const gsl_vector *x,
+                  const double beta, gsl_vector *y)
+{
+  return spblas_float_gemv_op(TransA, alpha, A, x, beta, y);
+} /* gsl_spblas_dsgemv() */
@@ -0,0 +1,339 @@
+/* spgemv_source.c
+ *
+ * Copyright (C) 2012-2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Matrix-vector product kernels, included by spdgemv.c, spi32.c and
+ * spfloat.c between sptemplates_on.h and sptemplates_off.h. The
+ * elements of A are converted to double as they are loaded, so all
+ * arithmetic is done in double precision for every ATOMIC type.
+ */
+
+static int FUNCTION(spblas, gemv)(const double alpha,
+                                  const TYPE(gsl_spmatrix) *A,
+                                  const gsl_vector *x, const double beta,
+                                  gsl_vector *y);
+static int FUNCTION(spblas, gemv_parallel)(const double alpha,
+                                           const TYPE(gsl_spmatrix) *A,
+                                           const gsl_vector *x,
+                                           const double beta, gsl_vector *y,
+                                           const size_t nthreads);
+
+/*
+spblas_gemv_op()
+  Compute y = alpha*op(A)*x + beta*y for a compressed matrix
+
+Inputs: TransA - CblasNoTrans or CblasTrans
+        alpha  - scalar factor
+        A      - sparse matrix in CCS or CRS format
+        x      - dense vector
+        beta   - scalar factor
+        y      - (input/output) dense vector
+
+Return: success or error
+
+Notes:
+1) For op(A) = A^T, the matrix is not copied: the arrays of a CCS
+matrix are the arrays of a CRS matrix storing A^T (and vice versa).
+A^T is therefore described by a shallow copy of the matrix struct, as
+in gsl_spmatrix_transpose(), and passed to spblas_gemv(). In
+particular, A^T*x for a CCS matrix is computed as one dot product per
+column of A.
+*/
+
+static int
+FUNCTION(spblas, gemv_op)(const CBLAS_TRANSPOSE_t TransA, const double alpha,
+                          const TYPE(gsl_spmatrix) *A, const gsl_vector *x,
+                          const double beta, gsl_vector *y)
+{
+  if (TransA == CblasNoTrans)
+    {
+      return FUNCTION(spblas, gemv)(alpha, A, x, beta, y);
+    }
+  else if (TransA == CblasTrans || TransA == CblasConjTrans)
+    {
+      TYPE(gsl_spmatrix) AT = *A;
+
+      AT.size1 = A->size2;
+      AT.size2 = A->size1;
+      AT.flags ^= GSL_SPMATRIX_CCS | GSL_SPMATRIX_CRS;
+
+      return FUNCTION(spblas, gemv)(alpha, &AT, x, beta, y);
+    }
+  else
+    {
+      GSL_ERROR("invalid TransA", GSL_EINVAL);
+    }
+} /* spblas_gemv_op() */
+
+/*
+spblas_gemv()
+  Compute y = alpha*A*x + beta*y
+
+Notes:
+1) If more than one thread has been requested with
+gsl_spblas_set_num_threads(), the product is computed by
+spblas_gemv_parallel(); otherwise the serial code below is used. For
+CCS and triplet matrices, the number of threads is limited by
+spthread_nprivate(), since each thread needs a private vector of
+length M
+
+2) Triplet matrices only occur with SPBASE_DOUBLE
+*/
+
+static int
+FUNCTION(spblas, gemv)(const double alpha, const TYPE(gsl_spmatrix) *A,
+                       const gsl_vector *x, const double beta, gsl_vector *y)
+{
+  const size_t M = A->size1;
+  const size_t N = A->size2;
+  const size_t nthreads = GSLSP_ISCRS(A) ? gsl_spblas_get_num_threads() :
+    spthread_nprivate(gsl_spblas_get_num_threads(), A->nz, M);
+
+  if (N != x->size)
+    {
+      GSL_ERROR("invalid length of x vector", GSL_EBADLEN);
+    }
+  else if (M != y->size)
+    {
+      GSL_ERROR("invalid length of y vector", GSL_EBADLEN);
+    }
+  else if (!GSLSP_ISCCS(A) && !GSLSP_ISCRS(A) && !GSLSP_ISTRIPLET(A))
+    {
+      GSL_ERROR("unsupported matrix type", GSL_EINVAL);
+    }
+  else if (nthreads > 1 && alpha != 0.0)
+    {
+      return FUNCTION(spblas, gemv_parallel)(alpha, A, x, beta, y, nthreads);
+    }
+  else
+    {
+      const size_t *Ap = A->p;
+      const INDEX *Ai = A->i;
+      const ATOMIC *Ad = A->data;
+      const double *X = x->data;
+      const size_t incX = x->stride;
+      double *Y = y->data;
+      const size_t incY = y->stride;
+      size_t i, j, p;
+
+      /* form y := beta*y */
+      if (beta == 0.0)
+        {
+          for (i = 0; i < M; ++i)
+            Y[i * incY] = 0.0;
+        }
+      else if (beta != 1.0)
+        {
+          for (i = 0; i < M; ++i)
+            Y[i * incY] *= beta;
+        }
+
+      if (alpha == 0.0)
+        return GSL_SUCCESS;
+
+      /* form y := alpha*A*x + y */
+      if (GSLSP_ISCCS(A))
+        {
+          for (j = 0; j < N; ++j)
+            {
+              for (p = Ap[j]; p < Ap[j + 1]; ++p)
+                Y[Ai[p] * incY] += alpha * (double) Ad[p] * X[j * incX];
+            }
+        }
+      else if (GSLSP_ISCRS(A))
+        {
+          /* gather-and-dot: each y_i is read and written only once */
+          for (i = 0; i < M; ++i)
+            {
+              double temp = 0.0;
+
+              for (p = Ap[i]; p < Ap[i + 1]; ++p)
+                temp += (double) Ad[p] * X[Ai[p] * incX];
+
+              Y[i * incY] += alpha * temp;
+            }
+        }
+      else
+        {
+          /* triplet: A->p holds the column indices */
+          for (p = 0; p < A->nz; ++p)
+            Y[Ai[p] * incY] += alpha * (double) Ad[p] * X[Ap[p] * incX];
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* spblas_gemv() */
+
+/*
+spblas_gemv_parallel()
+  Multithreaded version of spblas_gemv()
+
+Inputs: alpha    - scalar factor
+        A        - sparse matrix
+        x        - dense vector
+        beta     - scalar factor
+        y        - (input/output) dense vector
+        nthreads - number of threads
+
+Return: y = alpha*A*x + beta*y
+
+Notes:
+1) For CRS, the rows are split into blocks with approximately equal
+numbers of non-zeros and each thread computes its block of y directly.
+The result is identical to the serial computation.
+
+2) For CCS and triplet, the columns (or the triplets) are split into
+blocks with approximately equal numbers of non-zeros. Each thread
+accumulates its contribution to A*x in a private vector, and the
+private vectors are summed afterwards, so no atomic updates of y are
+needed. Rounding errors may differ from the serial computation since
+the order of summation changes. The nthreads*M private elements are
+allocated on every call; spblas_gemv() limits nthreads so that this
+does not exceed the number of non-zeros of A.
+*/
+
+static int
+FUNCTION(spblas, gemv_parallel)(const double alpha,
+                                const TYPE(gsl_spmatrix) *A,
+                                const gsl_vector *x, const double beta,
+                                gsl_vector *y, const size_t nthreads)
+{
+  const size_t M = A->size1;
+  const size_t N = A->size2;
+  const size_t *Ap = A->p;
+  const INDEX *Ai = A->i;
+  const ATOMIC *Ad = A->data;
+  const double *X = x->data;
+  const size_t incX = x->stride;
+  double *Y = y->data;
+  const size_t incY = y->stride;
+  size_t *part;
+  long t;
+
+  part = malloc((nthreads + 1) * sizeof(size_t));
+  if (!part)
+    {
+      GSL_ERROR("failed to allocate space for partition", GSL_ENOMEM);
+    }
+
+  if (GSLSP_ISCRS(A))
+    {
+      spthread_partition(Ap, M, nthreads, part);
+
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+      for (t = 0; t < (long) nthreads; ++t)
+        {
+          size_t i, p;
+
+          for (i = part[t]; i < part[t + 1]; ++i)
+            {
+              double temp = 0.0;
+
+              for (p = Ap[i]; p < Ap[i + 1]; ++p)
+                temp += (double) Ad[p] * X[Ai[p] * incX];
+
+              /* same sequence of operations as the serial code */
+              if (beta == 0.0)
+                Y[i * incY] = 0.0;
+              else if (beta != 1.0)
+                Y[i * incY] *= beta;
+
+              Y[i * incY] += alpha * temp;
+            }
+        }
+    }
+  else
+    {
+      double *work = malloc(nthreads * M * sizeof(double));
+
+      if (!work)
+        {
+          free(part);
+          GSL_ERROR("failed to allocate space for thread workspace",
+                    GSL_ENOMEM);
+        }
+
+      if (GSLSP_ISCCS(A))
+        {
+          spthread_partition(Ap, N, nthreads, part);
+        }
+      else
+        {
+          size_t k;
+
+          /* triplets are already balanced by splitting [0,nz) evenly */
+          for (k = 0; k <= nthreads; ++k)
+            part[k] = spthread_block(A->nz, nthreads, k);
+        }
+
+#pragma omp parallel num_threads(nthreads)
+      {
+        long i;
+
+        /* each thread computes its partial product w_t = A_t*x */
+#pragma omp for schedule(static, 1)
+        for (t = 0; t < (long) nthreads; ++t)
+          {
+            double *w = work + t * M;
+            size_t j, p;
+
+            for (j = 0; j < M; ++j)
+              w[j] = 0.0;
+
+            if (GSLSP_ISCCS(A))
+              {
+                for (j = part[t]; j < part[t + 1]; ++j)
+                  {
+                    const double xj = X[j * incX];
+
+                    for (p = Ap[j]; p < Ap[j + 1]; ++p)
+                      w[Ai[p]] += (double) Ad[p] * xj;
+                  }
+              }
+            else
+              {
+                for (p = part[t]; p < part[t + 1]; ++p)
+                  w[Ai[p]] += (double) Ad[p] * X[Ap[p] * incX];
+              }
+          }
+
+        /* y := beta*y + alpha*sum_t w_t */
+#pragma omp for schedule(static)
+        for (i = 0; i < (long) M; ++i)
+          {
+            double sum = 0.0;
+            size_t k;
+
+            for (k = 0; k < nthreads; ++k)
+              sum += work[k * M + i];
+
+            if (beta == 0.0)
+              Y[i * incY] = alpha * sum;
+            else
+              Y[i * incY] = beta * Y[i * incY] + alpha * sum;
+          }
+      }
+
+      free(work);
+    }
+
+  free(part);
+
+  return GSL_SUCCESS;
+} /* spblas_gemv_parallel() */
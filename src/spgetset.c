@@ -26,6 +26,12 @@
 
 #include "gsl_spmatrix.h"
 
+static size_t *hash_find(const gsl_spmatrix *m, const size_t i,
+                         const size_t j);
+static int tri_insert(gsl_spmatrix *m, const size_t i, const size_t j,
+                      const double x);
+static int hash_build(gsl_spmatrix *m);
+
 double
 gsl_spmatrix_get(const gsl_spmatrix *m, const size_t i, const size_t j)
 {
@@ -37,12 +43,25 @@ gsl_spmatrix_get(const gsl_spmatrix *m, const size_t i, const size_t j)
     {
       GSL_ERROR_VAL("second index out of range", GSL_EINVAL, 0.0);
     }
+  else if (GSLSP_ISSYMMETRIC(m) && i < j)
+    {
+      /* only the lower triangle is stored */
+      return gsl_spmatrix_get(m, j, i);
+    }
   else
     {
       const size_t *mi = m->i;
       const size_t *mp = m->p;
 
-      if (GSLSP_ISTRIPLET(m))
+      if (GSLSP_ISTRIPLET(m) && m->hash)
+        {
+          /* expected O(1) lookup using the hash table */
+          size_t *slot = hash_find(m, i, j);
+
+          if (*slot)
+            return m->data[*slot - 1];
+        }
+      else if (GSLSP_ISTRIPLET(m))
         {
           size_t n;
           for (n = 0; n < m->nz; ++n)
@@ -51,15 +70,39 @@ gsl_spmatrix_get(const gsl_spmatrix *m, const size_t i, const size_t j)
                 return m->data[n];
             }
         }
-      else if (GSLSP_ISCCS(m))
+      else if (GSLSP_ISCCS(m) || GSLSP_ISCRS(m))
         {
-          size_t p;
+          /* search column j (CCS) or row i (CRS) for the inner index */
+          const size_t outer = GSLSP_ISCCS(m) ? j : i;
+          const size_t inner = GSLSP_ISCCS(m) ? i : j;
+          size_t lo = mp[outer];
+          size_t hi = mp[outer + 1];
 
-          /* loop over column j and search for row index i */
-          for (p = mp[j]; p < mp[j + 1]; ++p)
+          if (GSLSP_ISSORTED(m))
             {
-              if (mi[p] == i)
-                return m->data[p];
+              /* binary search */
+              while (lo < hi)
+                {
+                  size_t mid = lo + (hi - lo) / 2;
+
+                  if (mi[mid] < inner)
+                    lo = mid + 1;
+                  else
+                    hi = mid;
+                }
+
+              if (lo < mp[outer + 1] && mi[lo] == inner)
+                return m->data[lo];
+            }
+          else
+            {
+              size_t p;
+
+              for (p = lo; p < hi; ++p)
+                {
+                  if (mi[p] == inner)
+                    return m->data[p];
+                }
             }
         }
       else
@@ -74,12 +117,18 @@ gsl_spmatrix_get(const gsl_spmatrix *m, const size_t i, const size_t j)
 
 /*
 gsl_spmatrix_set()
-  Add an element to a matrix in triplet form
+  Set an element of a matrix in triplet form
 
 Inputs: m - spmatrix
         i - row index
         j - column index
         x - matrix value
+
+Notes:
+1) If the hash table is active (see gsl_spmatrix_hash_init()) and
+element (i,j) already exists, it is overwritten, so the triplet matrix
+never contains duplicate entries. Otherwise the element is appended
+without searching the existing ones
 */
 
 int
@@ -90,30 +139,276 @@ gsl_spmatrix_set(gsl_spmatrix *m, const size_t i, const size_t j,
     {
       GSL_ERROR("matrix not in triplet representation", GSL_EINVAL);
     }
-  else if (x == 0.0)
-    return GSL_SUCCESS;
   else
     {
-      int s = GSL_SUCCESS;
+      if (m->hash)
+        {
+          size_t *slot = hash_find(m, i, j);
+
+          if (*slot)
+            {
+              /* element already exists; overwrite it */
+              m->data[*slot - 1] = x;
+              return GSL_SUCCESS;
+            }
+        }
 
-      if (m->nz >= m->nzmax)
+      if (x == 0.0)
+        return GSL_SUCCESS;
+      else
+        return tri_insert(m, i, j, x);
+    }
+} /* gsl_spmatrix_set() */
+
+/*
+gsl_spmatrix_accumulate()
+  Add a value to an element of a matrix in triplet form,
+
+  m(i,j) += x
+
+Inputs: m - spmatrix
+        i - row index
+        j - column index
+        x - value to add to m(i,j)
+
+Notes:
+1) This is the typical operation for finite element assembly, where
+contributions to the same (i,j) entry are summed
+
+2) If the hash table is active, x is added to an existing element
+(i,j). Otherwise x is appended as a new triplet; the duplicates are
+summed by gsl_spmatrix_compress_sorted()
+*/
+
+int
+gsl_spmatrix_accumulate(gsl_spmatrix *m, const size_t i, const size_t j,
+                        const double x)
+{
+  if (!(m->flags & GSL_SPMATRIX_TRIPLET))
+    {
+      GSL_ERROR("matrix not in triplet representation", GSL_EINVAL);
+    }
+  else
+    {
+      if (m->hash)
         {
-          s = gsl_spmatrix_realloc(2 * m->nzmax, m);
-          if (s)
-            return s;
+          size_t *slot = hash_find(m, i, j);
+
+          if (*slot)
+            {
+              m->data[*slot - 1] += x;
+              return GSL_SUCCESS;
+            }
         }
 
-      /* store the triplet (i, j, x) */
-      m->i[m->nz] = i;
-      m->p[m->nz] = j;
-      m->data[m->nz] = x;
+      if (x == 0.0)
+        return GSL_SUCCESS;
+      else
+        return tri_insert(m, i, j, x);
+    }
+} /* gsl_spmatrix_accumulate() */
+
+/*
+gsl_spmatrix_hash_init()
+  Activate the hash table of a triplet matrix, so that
+gsl_spmatrix_get(), gsl_spmatrix_set() and gsl_spmatrix_accumulate()
+locate element (i,j) in constant expected time
 
-      /* increase matrix dimensions if needed */
-      m->size1 = GSL_MAX(m->size1, i + 1);
-      m->size2 = GSL_MAX(m->size2, j + 1);
+Inputs: m - spmatrix in triplet format
 
-      ++(m->nz);
+Return: success or error
 
-      return s;
+Notes:
+1) The table has at least 2*nzmax entries and is kept up to date by
+gsl_spmatrix_set(), gsl_spmatrix_accumulate(), gsl_spmatrix_realloc()
+and gsl_spmatrix_set_zero() until gsl_spmatrix_hash_free() is called
+
+2) If the triplet arrays already contain duplicate (i,j) entries,
+lookups will find the first of them
+*/
+
+int
+gsl_spmatrix_hash_init(gsl_spmatrix *m)
+{
+  if (!GSLSP_ISTRIPLET(m))
+    {
+      GSL_ERROR("matrix not in triplet representation", GSL_EINVAL);
     }
-} /* gsl_spmatrix_set() */
+  else
+    {
+      return hash_build(m);
+    }
+} /* gsl_spmatrix_hash_init() */
+
+/*
+gsl_spmatrix_hash_rebuild()
+  Rebuild the hash table of a triplet matrix from its index arrays.
+The table is resized to match m->nzmax.
+
+Inputs: m - spmatrix in triplet format
+
+Return: success or error
+
+Notes:
+1) This must be called if the arrays m->i, m->p are modified directly
+while the hash table is active
+
+2) If the hash table is not active, nothing is done
+*/
+
+int
+gsl_spmatrix_hash_rebuild(gsl_spmatrix *m)
+{
+  if (!GSLSP_ISTRIPLET(m))
+    {
+      GSL_ERROR("matrix not in triplet representation", GSL_EINVAL);
+    }
+  else if (!m->hash)
+    {
+      return GSL_SUCCESS;
+    }
+  else
+    {
+      return hash_build(m);
+    }
+} /* gsl_spmatrix_hash_rebuild() */
+
+/*
+gsl_spmatrix_hash_free()
+  Release the hash table of a triplet matrix; subsequent calls to
+gsl_spmatrix_set() append elements and gsl_spmatrix_get() scans the
+triplets
+*/
+
+void
+gsl_spmatrix_hash_free(gsl_spmatrix *m)
+{
+  if (m->hash)
+    free(m->hash);
+
+  m->hash = NULL;
+  m->hashsize = 0;
+} /* gsl_spmatrix_hash_free() */
+
+/*
+hash_build()
+  Size the hash table of a triplet matrix to at least 2*nzmax entries
+and insert the first occurrence of each (i,j)
+*/
+
+static int
+hash_build(gsl_spmatrix *m)
+{
+  size_t hashsize = 16;
+  size_t n;
+
+  while (hashsize < 2 * m->nzmax)
+    hashsize *= 2;
+
+  if (hashsize != m->hashsize)
+    {
+      void *ptr = realloc(m->hash, hashsize * sizeof(size_t));
+
+      if (!ptr)
+        {
+          GSL_ERROR("failed to allocate space for hash table", GSL_ENOMEM);
+        }
+
+      m->hash = (size_t *) ptr;
+      m->hashsize = hashsize;
+    }
+
+  for (n = 0; n < hashsize; ++n)
+    m->hash[n] = 0;
+
+  for (n = 0; n < m->nz; ++n)
+    {
+      size_t *slot = hash_find(m, m->i[n], m->p[n]);
+
+      if (*slot == 0)
+        *slot = n + 1;
+    }
+
+  return GSL_SUCCESS;
+} /* hash_build() */
+
+/*
+hash_find()
+  Find the hash table slot for element (i,j) of a triplet matrix
+
+Inputs: m - spmatrix in triplet format
+        i - row index
+        j - column index
+
+Return: pointer to the slot containing n + 1 if data[n] = m(i,j),
+        otherwise pointer to the empty slot where (i,j) would be
+        inserted
+
+Notes:
+1) The table is kept at most half full, so the linear probing
+sequence is short and always terminates at an empty slot
+*/
+
+static size_t *
+hash_find(const gsl_spmatrix *m, const size_t i, const size_t j)
+{
+  const size_t mask = m->hashsize - 1;
+  unsigned long long h;
+  size_t k;
+
+  /* mix the two indices into a single hash value */
+  h = (unsigned long long) i * 0x9E3779B97F4A7C15ULL ^ (unsigned long long) j;
+  h ^= h >> 29;
+  h *= 0xBF58476D1CE4E5B9ULL;
+  h ^= h >> 32;
+
+  k = (size_t) h & mask;
+
+  while (m->hash[k])
+    {
+      size_t n = m->hash[k] - 1;
+
+      if (m->i[n] == i && m->p[n] == j)
+        break;
+
+      k = (k + 1) & mask;
+    }
+
+  return &(m->hash[k]);
+} /* hash_find() */
+
+/*
+tri_insert()
+  Append a new element (i,j,x) to a triplet matrix; if the hash table
+is active, (i,j) must not already be present
+*/
+
+static int
+tri_insert(gsl_spmatrix *m, const size_t i, const size_t j, const double x)
+{
+  int s = GSL_SUCCESS;
+
+  if (m->nz >= m->nzmax)
+    {
+      /* this also rebuilds an active hash table */
+      s = gsl_spmatrix_realloc(2 * m->nzmax, m);
+      if (s)
+        return s;
+    }
+
+  /* store the triplet (i, j, x) */
+  m->i[m->nz] = i;
+  m->p[m->nz] = j;
+  m->data[m->nz] = x;
+
+  if (m->hash)
+    *hash_find(m, i, j) = m->nz + 1;
+
+  /* increase matrix dimensions if needed */
+  m->size1 = GSL_MAX(m->size1, i + 1);
+  m->size2 = GSL_MAX(m->size2, j + 1);
+
+  ++(m->nz);
+
+  return s;
+} /* tri_insert() */
@@ -0,0 +1,400 @@
+/* spgmres.c
+ *
+ * Copyright (C) 2012-2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "gsl_splinalg.h"
+
+/*
+ * The code in this module performs the restarted GMRES(m) method
+ * with right preconditioning, for general square matrices A
+ *
+ * References:
+ *
+ * [1] Saad, Y., Iterative Methods for Sparse Linear Systems, 2nd ed,
+ *     SIAM, 2003, Algorithms 6.9 and 9.5
+ *
+ * [2] Giraud, L., Langou, J. and Rozloznik, M., The loss of
+ *     orthogonality in the Gram-Schmidt orthogonalization process,
+ *     Comput. Math. Appl., 50, 2005
+ */
+
+typedef struct
+{
+  size_t n;        /* size of linear system */
+  size_t m;        /* dimension of Krylov subspace */
+
+  /*
+   * Krylov basis, (m+1)-by-n; basis vector v_j is stored in row j
+   * so that the first k vectors form the contiguous matrix V_k
+   * and the projections V_k w, V_k^T h are single calls to dgemv
+   */
+  gsl_matrix *V;
+
+  gsl_matrix *H;   /* Hessenberg matrix, (m+1)-by-m, reduced to upper triangular */
+  gsl_vector *c;   /* Givens rotations cosines, size m */
+  gsl_vector *s;   /* Givens rotations sines, size m */
+  gsl_vector *g;   /* rotated right hand side beta*e_1, size m+1 */
+  gsl_vector *h;   /* projection coefficients, size m+1 */
+  gsl_vector *h2;  /* reorthogonalization coefficients, size m+1 */
+  gsl_vector *w;   /* work vector, size n */
+  gsl_vector *z;   /* preconditioned vector, size n */
+
+  double normr;    /* residual norm || b - A x || */
+} gmres_state_t;
+
+static void *gmres_alloc(const size_t n, const size_t m);
+static int gmres_iterate(const gsl_spmatrix *A, const gsl_vector *b,
+                         const double tol, const gsl_splinalg_precond *P,
+                         gsl_vector *x, size_t *niter, void *vstate);
+static double gmres_normr(const void *vstate);
+static void gmres_free(void *vstate);
+static void gmres_givens(const double a, const double b, double *c,
+                         double *s);
+
+/*
+gmres_alloc()
+  Allocate GMRES workspace
+
+Inputs: n - size of linear system
+        m - dimension of Krylov subspace (number of iterations between
+            restarts); if 0, GSL_MIN(n, 10) is used
+
+Return: pointer to workspace
+*/
+
+static void *
+gmres_alloc(const size_t n, const size_t m)
+{
+  gmres_state_t *state;
+
+  if (n == 0)
+    {
+      GSL_ERROR_NULL("matrix dimension n must be a positive integer",
+                     GSL_EINVAL);
+    }
+
+  state = calloc(1, sizeof(gmres_state_t));
+  if (!state)
+    {
+      GSL_ERROR_NULL("failed to allocate gmres state", GSL_ENOMEM);
+    }
+
+  state->n = n;
+  state->m = (m > 0) ? GSL_MIN(n, m) : GSL_MIN(n, 10);
+
+  state->V = gsl_matrix_alloc(state->m + 1, n);
+  state->H = gsl_matrix_alloc(state->m + 1, state->m);
+  state->c = gsl_vector_alloc(state->m);
+  state->s = gsl_vector_alloc(state->m);
+  state->g = gsl_vector_alloc(state->m + 1);
+  state->h = gsl_vector_alloc(state->m + 1);
+  state->h2 = gsl_vector_alloc(state->m + 1);
+  state->w = gsl_vector_alloc(n);
+  state->z = gsl_vector_alloc(n);
+  if (!state->V || !state->H || !state->c || !state->s || !state->g ||
+      !state->h || !state->h2 || !state->w || !state->z)
+    {
+      gmres_free(state);
+      GSL_ERROR_NULL("failed to allocate gmres workspace", GSL_ENOMEM);
+    }
+
+  state->normr = 0.0;
+
+  return state;
+} /* gmres_alloc() */
+
+/*
+gmres_iterate()
+  Perform one restart cycle of GMRES(m)
+
+Inputs: A      - square sparse matrix
+        b      - right hand side vector
+        tol    - relative tolerance
+        P      - preconditioner or NULL
+        x      - (input/output) on input, initial guess; on output,
+                 updated solution
+        niter  - (output) number of iterations performed
+        vstate - workspace
+
+Return: GSL_SUCCESS if || b - A x || <= tol * || b ||, GSL_CONTINUE if
+the cycle ended without converging, or an error code
+
+Notes:
+1) With right preconditioning, the solver works with A M^{-1} and
+u = M x, so the residual minimized is the true residual b - A x
+
+2) Each new vector is orthogonalized against the whole basis with
+classical Gram-Schmidt, applied twice (CGS2). Each pass is two dgemv
+calls on the contiguous basis matrix instead of j separate dot
+products and axpys, and the second pass restores the orthogonality
+lost by a single classical pass
+*/
+
+static int
+gmres_iterate(const gsl_spmatrix *A, const gsl_vector *b, const double tol,
+              const gsl_splinalg_precond *P, gsl_vector *x, size_t *niter,
+              void *vstate)
+{
+  gmres_state_t *state = (gmres_state_t *) vstate;
+  const size_t n = state->n;
+  const size_t m = state->m;
+  gsl_matrix *V = state->V;
+  gsl_matrix *H = state->H;
+  gsl_vector *w = state->w;
+  gsl_vector *z = state->z;
+  const double normb = gsl_blas_dnrm2(b);
+  gsl_vector_view v0 = gsl_matrix_row(V, 0);
+  double beta;
+  size_t j, k = 0;
+  int status;
+
+  *niter = 0;
+
+  if (n != w->size)
+    {
+      GSL_ERROR("matrix does not match workspace", GSL_EBADLEN);
+    }
+
+  if (normb == 0.0)
+    {
+      gsl_vector_set_zero(x);
+      state->normr = 0.0;
+      return GSL_SUCCESS;
+    }
+
+  /* v_0 = r = b - A x */
+  gsl_vector_memcpy(&v0.vector, b);
+  gsl_spblas_dgemv(CblasNoTrans, -1.0, A, x, 1.0, &v0.vector);
+
+  beta = gsl_blas_dnrm2(&v0.vector);
+  state->normr = beta;
+  if (beta <= tol * normb)
+    return GSL_SUCCESS;
+
+  gsl_blas_dscal(1.0 / beta, &v0.vector);
+
+  gsl_vector_set_zero(state->g);
+  gsl_vector_set(state->g, 0, beta);
+
+  for (j = 0; j < m; ++j)
+    {
+      gsl_vector_view vj = gsl_matrix_row(V, j);
+      gsl_matrix_view Vj = gsl_matrix_submatrix(V, 0, 0, j + 1, n);
+      gsl_vector_view hj = gsl_vector_subvector(state->h, 0, j + 1);
+      gsl_vector_view h2j = gsl_vector_subvector(state->h2, 0, j + 1);
+      double hjj, hj1, cj, sj, gj;
+      size_t i;
+
+      /* w = A M^{-1} v_j */
+      if (P)
+        {
+          status = P->solve(&vj.vector, z, P->params);
+          if (status)
+            return status;
+
+          gsl_spblas_dgemv(CblasNoTrans, 1.0, A, z, 0.0, w);
+        }
+      else
+        {
+          gsl_spblas_dgemv(CblasNoTrans, 1.0, A, &vj.vector, 0.0, w);
+        }
+
+      /* CGS2: h = V_j w, w = w - V_j^T h, twice */
+      gsl_blas_dgemv(CblasNoTrans, 1.0, &Vj.matrix, w, 0.0, &hj.vector);
+      gsl_blas_dgemv(CblasTrans, -1.0, &Vj.matrix, &hj.vector, 1.0, w);
+      gsl_blas_dgemv(CblasNoTrans, 1.0, &Vj.matrix, w, 0.0, &h2j.vector);
+      gsl_blas_dgemv(CblasTrans, -1.0, &Vj.matrix, &h2j.vector, 1.0, w);
+
+      for (i = 0; i <= j; ++i)
+        {
+          gsl_matrix_set(H, i, j, gsl_vector_get(state->h, i) +
+                                  gsl_vector_get(state->h2, i));
+        }
+
+      hj1 = gsl_blas_dnrm2(w);
+
+      /* apply previous Givens rotations to column j of H */
+      for (i = 0; i < j; ++i)
+        {
+          double ci = gsl_vector_get(state->c, i);
+          double si = gsl_vector_get(state->s, i);
+          double hi = gsl_matrix_get(H, i, j);
+          double hi1 = gsl_matrix_get(H, i + 1, j);
+
+          gsl_matrix_set(H, i, j, ci * hi + si * hi1);
+          gsl_matrix_set(H, i + 1, j, -si * hi + ci * hi1);
+        }
+
+      /* new rotation to annihilate H(j+1,j) */
+      hjj = gsl_matrix_get(H, j, j);
+      gmres_givens(hjj, hj1, &cj, &sj);
+      gsl_vector_set(state->c, j, cj);
+      gsl_vector_set(state->s, j, sj);
+      gsl_matrix_set(H, j, j, cj * hjj + sj * hj1);
+      gsl_matrix_set(H, j + 1, j, 0.0);
+
+      gj = gsl_vector_get(state->g, j);
+      gsl_vector_set(state->g, j, cj * gj);
+      gsl_vector_set(state->g, j + 1, -sj * gj);
+
+      ++(*niter);
+      k = j + 1;
+
+      state->normr = fabs(gsl_vector_get(state->g, j + 1));
+
+      /* stop on convergence or if the Krylov space is invariant */
+      if (state->normr <= tol * normb || hj1 == 0.0)
+        break;
+
+      if (j + 1 < m)
+        {
+          gsl_vector_view vj1 = gsl_matrix_row(V, j + 1);
+
+          gsl_vector_memcpy(&vj1.vector, w);
+          gsl_blas_dscal(1.0 / hj1, &vj1.vector);
+        }
+    }
+
+  /* solve the triangular system H(0:k-1,0:k-1) y = g(0:k-1) */
+  {
+    gsl_matrix_view Hk = gsl_matrix_submatrix(H, 0, 0, k, k);
+    gsl_vector_view y = gsl_vector_subvector(state->g, 0, k);
+    gsl_matrix_view Vk = gsl_matrix_submatrix(V, 0, 0, k, n);
+
+    if (gsl_matrix_get(H, k - 1, k - 1) == 0.0)
+      {
+        GSL_ERROR("GMRES breakdown: singular Hessenberg matrix", GSL_ESING);
+      }
+
+    gsl_blas_dtrsv(CblasUpper, CblasNoTrans, CblasNonUnit, &Hk.matrix,
+                   &y.vector);
+
+    /* x = x + M^{-1} V_k^T y */
+    gsl_blas_dgemv(CblasTrans, 1.0, &Vk.matrix, &y.vector, 0.0, w);
+
+    if (P)
+      {
+        status = P->solve(w, z, P->params);
+        if (status)
+          return status;
+
+        gsl_blas_daxpy(1.0, z, x);
+      }
+    else
+      {
+        gsl_blas_daxpy(1.0, w, x);
+      }
+  }
+
+  if (state->normr <= tol * normb)
+    return GSL_SUCCESS;
+  else
+    return GSL_CONTINUE;
+} /* gmres_iterate() */
+
+/*
+gmres_givens()
+  Compute a Givens rotation [c s; -s c] such that
+[c s; -s c] [a; b] = [r; 0]
+*/
+
+static void
+gmres_givens(const double a, const double b, double *c, double *s)
+{
+  if (b == 0.0)
+    {
+      *c = 1.0;
+      *s = 0.0;
+    }
+  else if (fabs(b) > fabs(a))
+    {
+      double t = a / b;
+      *s = 1.0 / sqrt(1.0 + t * t);
+      *c = *s * t;
+    }
+  else
+    {
+      double t = b / a;
+      *c = 1.0 / sqrt(1.0 + t * t);
+      *s = *c * t;
+    }
+} /* gmres_givens() */
+
+static double
+gmres_normr(const void *vstate)
+{
+  const gmres_state_t *state = (const gmres_state_t *) vstate;
+  return state->normr;
+} /* gmres_normr() */
+
+static void
+gmres_free(void *vstate)
+{
+  gmres_state_t *state = (gmres_state_t *) vstate;
+
+  if (state->V)
+    gsl_matrix_free(state->V);
+
+  if (state->H)
+    gsl_matrix_free(state->H);
+
+  if (state->c)
+    gsl_vector_free(state->c);
+
+  if (state->s)
+    gsl_vector_free(state->s);
+
+  if (state->g)
+    gsl_vector_free(state->g);
+
+  if (state->h)
+    gsl_vector_free(state->h);
+
+  if (state->h2)
+    gsl_vector_free(state->h2);
+
+  if (state->w)
+    gsl_vector_free(state->w);
+
+  if (state->z)
+    gsl_vector_free(state->z);
+
+  free(state);
+} /* gmres_free() */
+
+static const gsl_splinalg_itersolve_type gmres_type =
+{
+  "gmres",
+  &gmres_alloc,
+  &gmres_iterate,
+  &gmres_normr,
+  &gmres_free
+};
+
+const gsl_splinalg_itersolve_type * gsl_splinalg_itersolve_gmres = &gmres_type;
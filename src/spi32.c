@@ -0,0 +1,509 @@
+/* spi32.c
+ *
+ * Copyright (C) 2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_blas.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "spthread.h"
+
+/* largest dimension whose indices fit in uint32_t */
+#define I32_MAXDIM          ((uint64_t) UINT32_MAX + 1)
+
+#define SPBASE_I32
+#include "sptemplates_on.h"
+#include "spcompressed_source.c"
+#include "spgemv_source.c"
+#include "spdgemm_source.c"
+#include "sptemplates_off.h"
+#undef SPBASE_I32
+
+static int i32_dgemm_operands(const gsl_spmatrix_i32 *A,
+                              const gsl_spmatrix_i32 *B,
+                              const gsl_spmatrix_i32 **L,
+                              const gsl_spmatrix_i32 **R, size_t *M,
+                              size_t *N);
+
+/*
+gsl_spmatrix_i32_alloc_nzmax()
+  Allocate a compressed matrix with 32 bit indices
+
+Inputs: n1    - number of rows, at most 2^32
+        n2    - number of columns, at most 2^32
+        nzmax - maximum number of matrix elements
+        flags - GSL_SPMATRIX_CCS or GSL_SPMATRIX_CRS
+
+Return: pointer to new matrix, or NULL on error
+*/
+
+gsl_spmatrix_i32 *
+gsl_spmatrix_i32_alloc_nzmax(const size_t n1, const size_t n2,
+                             const size_t nzmax, const size_t flags)
+{
+  const size_t type = flags & GSL_SPMATRIX_TYPEMASK;
+  gsl_spmatrix_i32 *m;
+
+  if (n1 == 0 || n2 == 0)
+    {
+      GSL_ERROR_NULL("matrix dimensions must be positive integers",
+                     GSL_EINVAL);
+    }
+  else if ((uint64_t) n1 > I32_MAXDIM || (uint64_t) n2 > I32_MAXDIM)
+    {
+      GSL_ERROR_NULL("matrix dimensions must be at most 2^32", GSL_EINVAL);
+    }
+  else if (type != GSL_SPMATRIX_CCS && type != GSL_SPMATRIX_CRS)
+    {
+      GSL_ERROR_NULL("matrix must be in compressed format", GSL_EINVAL);
+    }
+
+  m = calloc(1, sizeof(gsl_spmatrix_i32));
+  if (!m)
+    {
+      GSL_ERROR_NULL("failed to allocate space for spmatrix struct",
+                     GSL_ENOMEM);
+    }
+
+  m->size1 = n1;
+  m->size2 = n2;
+  m->nz = 0;
+  m->nzmax = GSL_MAX(nzmax, 1);
+  m->flags = type;
+
+  m->i = malloc(m->nzmax * sizeof(uint32_t));
+  m->data = malloc(m->nzmax * sizeof(double));
+  m->p = malloc(((type == GSL_SPMATRIX_CCS) ? n2 + 1 : n1 + 1) *
+                sizeof(size_t));
+  m->work = malloc(GSL_MAX(n1, n2) * sizeof(size_t));
+  if (!m->i || !m->data || !m->p || !m->work)
+    {
+      gsl_spmatrix_i32_free(m);
+      GSL_ERROR_NULL("failed to allocate space for matrix arrays",
+                     GSL_ENOMEM);
+    }
+
+  return m;
+} /* gsl_spmatrix_i32_alloc_nzmax() */
+
+/*
+gsl_spmatrix_i32_free()
+  Free a matrix with 32 bit indices
+*/
+
+void
+gsl_spmatrix_i32_free(gsl_spmatrix_i32 *m)
+{
+  if (m->i)
+    free(m->i);
+
+  if (m->data)
+    free(m->data);
+
+  if (m->p)
+    free(m->p);
+
+  if (m->work)
+    free(m->work);
+
+  free(m);
+} /* gsl_spmatrix_i32_free() */
+
+/*
+gsl_spmatrix_i32_transpose_memcpy()
+  Compute the transpose of a matrix with 32 bit indices, storing the
+result in a newly allocated matrix of the same storage format
+
+Inputs: src - sparse matrix
+
+Return: pointer to src^T (should be freed when finished with it)
+
+Notes:
+1) The same counting sort as gsl_spmatrix_transpose_memcpy(), so the
+indices of the result are sorted
+*/
+
+gsl_spmatrix_i32 *
+gsl_spmatrix_i32_transpose_memcpy(const gsl_spmatrix_i32 *src)
+{
+  const size_t M = src->size1;
+  const size_t N = src->size2;
+  const size_t nz = src->nz;
+  const size_t nouter = GSLSP_ISCCS(src) ? N : M;
+  const size_t ninner = GSLSP_ISCCS(src) ? M : N;
+  gsl_spmatrix_i32 *dest;
+  const uint32_t *Ai = src->i;
+  const size_t *Ap = src->p;
+  const double *Ad = src->data;
+  size_t *w;
+  size_t p, j;
+
+  dest = gsl_spmatrix_i32_alloc_nzmax(N, M, nz, src->flags);
+  if (!dest)
+    return NULL;
+
+  w = dest->work;
+
+  for (p = 0; p < ninner + 1; ++p)
+    dest->p[p] = 0;
+
+  for (p = 0; p < nz; ++p)
+    dest->p[Ai[p]]++;
+
+  gsl_spmatrix_cumsum(ninner, dest->p);
+
+  for (j = 0; j < ninner; ++j)
+    w[j] = dest->p[j];
+
+  for (j = 0; j < nouter; ++j)
+    {
+      for (p = Ap[j]; p < Ap[j + 1]; ++p)
+        {
+          size_t k = w[Ai[p]]++;
+          dest->i[k] = (uint32_t) j;
+          dest->data[k] = Ad[p];
+        }
+    }
+
+  dest->nz = nz;
+  dest->flags |= GSL_SPMATRIX_SORTED | (src->flags & GSL_SPMATRIX_NODUPS);
+
+  return dest;
+} /* gsl_spmatrix_i32_transpose_memcpy() */
+
+/*
+gsl_spmatrix_i32_transpose()
+  Transpose a matrix with 32 bit indices in place, by reinterpreting it
+in the opposite compressed format
+*/
+
+int
+gsl_spmatrix_i32_transpose(gsl_spmatrix_i32 *m)
+{
+  size_t tmp;
+
+  m->flags ^= GSL_SPMATRIX_CCS | GSL_SPMATRIX_CRS;
+
+  tmp = m->size1;
+  m->size1 = m->size2;
+  m->size2 = tmp;
+
+  return GSL_SUCCESS;
+} /* gsl_spmatrix_i32_transpose() */
+
+/*
+gsl_spblas_i32_dgemv()
+  Multiply a matrix with 32 bit indices and a vector
+
+Inputs: TransA - CblasNoTrans or CblasTrans
+        alpha  - scalar factor
+        A      - sparse matrix
+        x      - dense vector
+        beta   - scalar factor
+        y      - (input/output) dense vector
+
+Return: y = alpha*op(A)*x + beta*y, where op(A) = A or A^T
+
+Notes:
+1) The kernels of spgemv_source.c are shared with gsl_spblas_dgemv(),
+so the same serial and multithreaded algorithms are used
+*/
+
+int
+gsl_spblas_i32_dgemv(const CBLAS_TRANSPOSE_t TransA, const double alpha,
+                     const gsl_spmatrix_i32 *A, const gsl_vector *x,
+                     const double beta, gsl_vector *y)
+{
+  return spblas_i32_gemv_op(TransA, alpha, A, x, beta, y);
+} /* gsl_spblas_i32_dgemv() */
+
+/*
+gsl_spblas_i32_dgemm()
+  Multiply two matrices with 32 bit indices
+
+Inputs: alpha - scalar factor
+        A     - sparse matrix
+        B     - sparse matrix, in the same format as A
+
+Return: pointer to C = alpha*A*B in the format of A, or NULL on error
+
+Notes:
+1) As gsl_spblas_dgemm(), the pattern of C is computed first by
+gsl_spblas_i32_dgemm_symbolic(), so that C is allocated exactly, and
+the values are then computed by gsl_spblas_i32_dgemm_numeric(). Both
+phases use the column block kernels of spdgemm_source.c and the
+threads requested with gsl_spblas_set_num_threads()
+
+2) The indices within each column (row) of C are in order of first
+occurrence, so C is not marked sorted
+*/
+
+gsl_spmatrix_i32 *
+gsl_spblas_i32_dgemm(const double alpha, const gsl_spmatrix_i32 *A,
+                     const gsl_spmatrix_i32 *B)
+{
+  gsl_spmatrix_i32 *C;
+  int s;
+
+  C = gsl_spblas_i32_dgemm_symbolic(A, B);
+  if (!C)
+    return NULL;
+
+  s = gsl_spblas_i32_dgemm_numeric(alpha, A, B, C);
+  if (s)
+    {
+      gsl_spmatrix_i32_free(C);
+      return NULL;
+    }
+
+  return C;
+} /* gsl_spblas_i32_dgemm() */
+
+/*
+gsl_spblas_i32_dgemm_symbolic()
+  Compute the sparsity pattern of the product of two matrices with 32
+bit indices; see gsl_spblas_dgemm_symbolic()
+
+Inputs: A - sparse matrix
+        B - sparse matrix, in the same format as A
+
+Return: matrix C with the sparsity pattern of A*B; C->i and C->p are
+        filled in but C->data is not initialized
+*/
+
+gsl_spmatrix_i32 *
+gsl_spblas_i32_dgemm_symbolic(const gsl_spmatrix_i32 *A,
+                              const gsl_spmatrix_i32 *B)
+{
+  const gsl_spmatrix_i32 *L, *R;
+  size_t M, N;
+
+  if (i32_dgemm_operands(A, B, &L, &R, &M, &N))
+    return NULL;
+  else
+    {
+      const size_t nthreads = gsl_spblas_get_num_threads();
+      size_t *part = NULL;
+      size_t *w;
+      gsl_spmatrix_i32 *C;
+      void *ptr;
+      size_t nz;
+      long t;
+
+      /* allocate C without storage for elements until nnz(C) is known */
+      C = gsl_spmatrix_i32_alloc_nzmax(A->size1, B->size2, 1, A->flags);
+      if (!C)
+        return NULL;
+
+      w = malloc(GSL_MAX(nthreads * M, 1) * sizeof(size_t));
+      if (nthreads > 1)
+        part = spblas_i32_dgemm_partition(L, R, N, nthreads);
+
+      if (!w || (nthreads > 1 && !part))
+        {
+          free(w);
+          free(part);
+          gsl_spmatrix_i32_free(C);
+          GSL_ERROR_NULL("failed to allocate space for workspace", GSL_ENOMEM);
+        }
+
+      /* pass 1: count the number of non-zeros in each column of C */
+      if (nthreads == 1)
+        {
+          spblas_i32_dgemm_count(L, R, M, 0, N, w, C->p);
+        }
+      else
+        {
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+          for (t = 0; t < (long) nthreads; ++t)
+            spblas_i32_dgemm_count(L, R, M, part[t], part[t + 1], w + t * M,
+                                   C->p);
+        }
+
+      spthread_cumsum(N, C->p, nthreads);
+
+      nz = GSL_MAX(C->p[N], 1);
+
+      ptr = realloc(C->i, nz * sizeof(uint32_t));
+      if (ptr)
+        {
+          C->i = (uint32_t *) ptr;
+          ptr = realloc(C->data, nz * sizeof(double));
+        }
+
+      if (!ptr)
+        {
+          free(w);
+          free(part);
+          gsl_spmatrix_i32_free(C);
+          GSL_ERROR_NULL("unable to allocate matrix C", GSL_ENOMEM);
+        }
+
+      C->data = (double *) ptr;
+      C->nzmax = nz;
+
+      /* pass 2: store the row indices of each column of C */
+      if (nthreads == 1)
+        {
+          spblas_i32_dgemm_pattern(L, R, M, 0, N, w, C);
+        }
+      else
+        {
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+          for (t = 0; t < (long) nthreads; ++t)
+            spblas_i32_dgemm_pattern(L, R, M, part[t], part[t + 1], w + t * M,
+                                     C);
+        }
+
+      C->nz = C->p[N];
+      C->flags = GSLSP_TYPE(A) | GSL_SPMATRIX_NODUPS;
+
+      free(w);
+      free(part);
+
+      return C;
+    }
+} /* gsl_spblas_i32_dgemm_symbolic() */
+
+/*
+gsl_spblas_i32_dgemm_numeric()
+  Compute the values of the product of two matrices with 32 bit
+indices, whose sparsity pattern has been computed by
+gsl_spblas_i32_dgemm_symbolic(); see gsl_spblas_dgemm_numeric()
+
+Inputs: alpha - scalar factor
+        A     - sparse matrix
+        B     - sparse matrix, in the same format as A
+        C     - (input/output) on input, sparsity pattern of A*B;
+                on output, C = alpha*A*B
+
+Return: success or error
+*/
+
+int
+gsl_spblas_i32_dgemm_numeric(const double alpha, const gsl_spmatrix_i32 *A,
+                             const gsl_spmatrix_i32 *B, gsl_spmatrix_i32 *C)
+{
+  const gsl_spmatrix_i32 *L, *R;
+  size_t M, N;
+  int s;
+
+  s = i32_dgemm_operands(A, B, &L, &R, &M, &N);
+  if (s)
+    return s;
+  else if (C->size1 != A->size1 || C->size2 != B->size2)
+    {
+      GSL_ERROR("matrix C has wrong dimensions", GSL_EBADLEN);
+    }
+  else if (GSLSP_TYPE(C) != GSLSP_TYPE(A))
+    {
+      GSL_ERROR("matrix C must have same sparse storage format as A and B",
+                GSL_EINVAL);
+    }
+  else
+    {
+      const size_t nthreads = gsl_spblas_get_num_threads();
+      double *x;
+      long t;
+
+      x = malloc(GSL_MAX(nthreads * M, 1) * sizeof(double));
+      if (!x)
+        {
+          GSL_ERROR("failed to allocate space for workspace", GSL_ENOMEM);
+        }
+
+      if (nthreads == 1)
+        {
+          spblas_i32_dgemm_values(alpha, L, R, 0, N, x, C);
+        }
+      else
+        {
+          size_t *part = spblas_i32_dgemm_partition(L, R, N, nthreads);
+
+          if (!part)
+            {
+              free(x);
+              GSL_ERROR("failed to allocate space for partition", GSL_ENOMEM);
+            }
+
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+          for (t = 0; t < (long) nthreads; ++t)
+            spblas_i32_dgemm_values(alpha, L, R, part[t], part[t + 1],
+                                    x + t * M, C);
+
+          free(part);
+        }
+
+      free(x);
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_spblas_i32_dgemm_numeric() */
+
+/*
+i32_dgemm_operands()
+  Check the inputs to the i32 dgemm routines and determine the operands
+of the compressed column product; see dgemm_operands() in spdgemm.c
+
+Inputs: A - sparse matrix
+        B - sparse matrix
+        L - (output) left operand
+        R - (output) right operand
+        M - (output) number of rows of L
+        N - (output) number of columns of R
+
+Return: success or error
+*/
+
+static int
+i32_dgemm_operands(const gsl_spmatrix_i32 *A, const gsl_spmatrix_i32 *B,
+                   const gsl_spmatrix_i32 **L, const gsl_spmatrix_i32 **R,
+                   size_t *M, size_t *N)
+{
+  if (A->size2 != B->size1)
+    {
+      GSL_ERROR("matrix dimensions do not match", GSL_EBADLEN);
+    }
+  else if (GSLSP_TYPE(A) != GSLSP_TYPE(B))
+    {
+      GSL_ERROR("matrices must have same sparse storage format", GSL_EINVAL);
+    }
+  else if (GSLSP_ISCCS(A))
+    {
+      *L = A;
+      *R = B;
+      *M = A->size1;
+      *N = B->size2;
+    }
+  else
+    {
+      /* CRS: C^T = B^T A^T, as in dgemm_operands() */
+      *L = B;
+      *R = A;
+      *M = B->size2;
+      *N = A->size1;
+    }
+
+  return GSL_SUCCESS;
+} /* i32_dgemm_operands() */
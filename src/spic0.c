@@ -0,0 +1,348 @@
+/* spic0.c
+ *
+ * Copyright (C) 2012-2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "gsl_splinalg.h"
+
+/*
+ * The code in this module computes the incomplete Cholesky
+ * factorization with zero fill-in, IC(0), of a symmetric positive
+ * definite matrix A in sorted compressed column format: A ~ L L^T
+ * where L has the sparsity pattern of the lower triangle of A
+ *
+ * References:
+ *
+ * [1] Saad, Y., Iterative Methods for Sparse Linear Systems, 2nd ed,
+ *     SIAM, 2003, Section 10.3.5
+ */
+
+/* marker for rows not in the pattern of the current column */
+#define IC0_NONE      ((size_t) -1)
+
+static int ic0_pattern(const gsl_spmatrix *A,
+                       const gsl_splinalg_ic0_workspace *w);
+
+/*
+gsl_splinalg_ic0_alloc()
+  Allocate an IC(0) workspace for the sparsity pattern of the lower
+triangle of A
+
+Inputs: A - symmetric square matrix in compressed column format with
+            sorted row indices, no duplicates, and all diagonal elements
+            stored. Only the lower triangle is used
+
+Return: pointer to workspace
+*/
+
+gsl_splinalg_ic0_workspace *
+gsl_splinalg_ic0_alloc(const gsl_spmatrix *A)
+{
+  gsl_splinalg_ic0_workspace *w;
+  size_t j, p, nz = 0;
+
+  if (A->size1 != A->size2 || !GSLSP_ISCCS(A) || !GSLSP_ISSORTED(A) ||
+      !(A->flags & GSL_SPMATRIX_NODUPS))
+    {
+      GSL_ERROR_NULL("matrix must be square, sorted, compressed column",
+                     GSL_EINVAL);
+    }
+
+  w = calloc(1, sizeof(gsl_splinalg_ic0_workspace));
+  if (!w)
+    {
+      GSL_ERROR_NULL("failed to allocate space for ic0 struct",
+                     GSL_ENOMEM);
+    }
+
+  w->n = A->size1;
+  w->nz = A->nz;
+
+  w->adiag = malloc(GSL_MAX(w->n, 1) * sizeof(size_t));
+  w->map = malloc(GSL_MAX(w->n, 1) * sizeof(size_t));
+  if (!w->adiag || !w->map)
+    {
+      gsl_splinalg_ic0_free(w);
+      GSL_ERROR_NULL("failed to allocate space for ic0 workspace",
+                     GSL_ENOMEM);
+    }
+
+  /* locate the diagonal of each column; the lower triangle follows it */
+  for (j = 0; j < w->n; ++j)
+    {
+      w->map[j] = IC0_NONE;
+      w->adiag[j] = IC0_NONE;
+
+      for (p = A->p[j]; p < A->p[j + 1]; ++p)
+        {
+          if (A->i[p] == j)
+            {
+              w->adiag[j] = p;
+              break;
+            }
+        }
+
+      if (w->adiag[j] == IC0_NONE)
+        {
+          gsl_splinalg_ic0_free(w);
+          GSL_ERROR_NULL("matrix has a structurally zero diagonal element",
+                         GSL_EINVAL);
+        }
+
+      nz += A->p[j + 1] - w->adiag[j];
+    }
+
+  w->L = gsl_spmatrix_alloc_nzmax(w->n, w->n, nz, GSL_SPMATRIX_CCS);
+  if (!w->L)
+    {
+      gsl_splinalg_ic0_free(w);
+      GSL_ERROR_NULL("failed to allocate space for ic0 factor", GSL_ENOMEM);
+    }
+
+  /* copy the pattern of the lower triangle */
+  nz = 0;
+  for (j = 0; j < w->n; ++j)
+    {
+      w->L->p[j] = nz;
+
+      for (p = w->adiag[j]; p < A->p[j + 1]; ++p)
+        w->L->i[nz++] = A->i[p];
+    }
+
+  w->L->p[w->n] = nz;
+  w->L->nz = nz;
+  w->L->flags |= GSL_SPMATRIX_SORTED | GSL_SPMATRIX_NODUPS;
+
+  return w;
+} /* gsl_splinalg_ic0_alloc() */
+
+void
+gsl_splinalg_ic0_free(gsl_splinalg_ic0_workspace *w)
+{
+  if (w->L)
+    gsl_spmatrix_free(w->L);
+
+  if (w->adiag)
+    free(w->adiag);
+
+  if (w->map)
+    free(w->map);
+
+  free(w);
+} /* gsl_splinalg_ic0_free() */
+
+/*
+gsl_splinalg_ic0_decomp()
+  Compute the IC(0) factorization of A
+
+Inputs: A - matrix with the same sparsity pattern as the matrix given
+            to gsl_splinalg_ic0_alloc()
+        w - workspace
+
+Return: success or error
+
+Notes:
+1) The factorization is right-looking: once column k of L is
+computed, it updates the columns j > k with l_jk != 0, dropping any
+fill-in outside the pattern of L. The diagonal element is the first
+element of each column of L since the row indices are sorted
+
+2) IC(0) may fail for some symmetric positive definite matrices,
+in which case GSL_EDOM is returned
+
+3) The positions of the diagonal elements of A were recorded by
+gsl_splinalg_ic0_alloc(), so the column pointers of A are checked
+against them with ic0_pattern() before A->data is read
+*/
+
+int
+gsl_splinalg_ic0_decomp(const gsl_spmatrix *A, gsl_splinalg_ic0_workspace *w)
+{
+  if (A->size1 != w->n || A->size2 != w->n || A->nz != w->nz ||
+      !GSLSP_ISCCS(A) || !ic0_pattern(A, w))
+    {
+      GSL_ERROR("matrix does not match workspace", GSL_EBADLEN);
+    }
+  else
+    {
+      const size_t n = w->n;
+      const size_t *Lp = w->L->p;
+      const size_t *Li = w->L->i;
+      double *Ld = w->L->data;
+      size_t *map = w->map;
+      size_t j, k, p, q;
+
+      /* copy the lower triangle of A */
+      for (j = 0; j < n; ++j)
+        {
+          for (p = w->adiag[j], q = Lp[j]; q < Lp[j + 1]; ++p, ++q)
+            Ld[q] = A->data[p];
+        }
+
+      for (k = 0; k < n; ++k)
+        {
+          double lkk = Ld[Lp[k]];
+
+          if (lkk <= 0.0)
+            {
+              GSL_ERROR("matrix is not positive definite for IC(0)",
+                        GSL_EDOM);
+            }
+
+          lkk = sqrt(lkk);
+          Ld[Lp[k]] = lkk;
+
+          for (p = Lp[k] + 1; p < Lp[k + 1]; ++p)
+            Ld[p] /= lkk;
+
+          /* update columns j > k: L(i,j) -= l_ik l_jk for i >= j */
+          for (p = Lp[k] + 1; p < Lp[k + 1]; ++p)
+            {
+              const size_t jj = Li[p];
+              const double ljk = Ld[p];
+
+              for (q = Lp[jj]; q < Lp[jj + 1]; ++q)
+                map[Li[q]] = q;
+
+              for (q = p; q < Lp[k + 1]; ++q)
+                {
+                  size_t idx = map[Li[q]];
+
+                  if (idx != IC0_NONE)
+                    Ld[idx] -= Ld[q] * ljk;
+                }
+
+              for (q = Lp[jj]; q < Lp[jj + 1]; ++q)
+                map[Li[q]] = IC0_NONE;
+            }
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_splinalg_ic0_decomp() */
+
+/*
+gsl_splinalg_ic0_solve()
+  Solve L L^T x = b using the IC(0) factor
+
+Inputs: w - workspace containing factor
+        b - right hand side
+        x - (output) solution; may be the same vector as b
+
+Return: success or error
+*/
+
+int
+gsl_splinalg_ic0_solve(const gsl_splinalg_ic0_workspace *w,
+                       const gsl_vector *b, gsl_vector *x)
+{
+  const size_t n = w->n;
+
+  if (b->size != n || x->size != n)
+    {
+      GSL_ERROR("vector length does not match workspace", GSL_EBADLEN);
+    }
+  else
+    {
+      const size_t *Lp = w->L->p;
+      const size_t *Li = w->L->i;
+      const double *Ld = w->L->data;
+      double *X = x->data;
+      const size_t incX = x->stride;
+      size_t j, p;
+
+      if (x != b)
+        gsl_vector_memcpy(x, b);
+
+      /* forward substitution L y = b, by columns */
+      for (j = 0; j < n; ++j)
+        {
+          const double xj = X[j * incX] / Ld[Lp[j]];
+
+          X[j * incX] = xj;
+
+          for (p = Lp[j] + 1; p < Lp[j + 1]; ++p)
+            X[Li[p] * incX] -= Ld[p] * xj;
+        }
+
+      /* back substitution L^T x = y; column j of L is row j of L^T */
+      for (j = n; j-- > 0; )
+        {
+          double sum = X[j * incX];
+
+          for (p = Lp[j] + 1; p < Lp[j + 1]; ++p)
+            sum -= Ld[p] * X[Li[p] * incX];
+
+          X[j * incX] = sum / Ld[Lp[j]];
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_splinalg_ic0_solve() */
+
+/*
+gsl_splinalg_ic0_precond()
+  Preconditioner function for gsl_splinalg_precond, with params
+pointing to a gsl_splinalg_ic0_workspace containing the factor
+*/
+
+int
+gsl_splinalg_ic0_precond(const gsl_vector *r, gsl_vector *z, void *params)
+{
+  return gsl_splinalg_ic0_solve((const gsl_splinalg_ic0_workspace *) params,
+                                r, z);
+} /* gsl_splinalg_ic0_precond() */
+
+/*
+ic0_pattern()
+  Check that the pattern of A is consistent with the workspace: each
+column j of A must contain the recorded diagonal position adiag[j],
+with as many elements below it as column j of L, all within the
+first nz elements of A
+
+Inputs: A - matrix in compressed column format with nz = w->nz
+        w - workspace
+
+Return: 1 if A matches the workspace, 0 otherwise
+*/
+
+static int
+ic0_pattern(const gsl_spmatrix *A, const gsl_splinalg_ic0_workspace *w)
+{
+  const size_t *Lp = w->L->p;
+  size_t j;
+
+  for (j = 0; j < w->n; ++j)
+    {
+      const size_t p = w->adiag[j];
+
+      if (p < A->p[j] || p >= A->p[j + 1] || A->p[j + 1] > A->nz ||
+          A->p[j + 1] - p != Lp[j + 1] - Lp[j] || A->i[p] != j)
+        return 0;
+    }
+
+  return 1;
+} /* ic0_pattern() */
@@ -0,0 +1,344 @@
+/* spilu0.c
+ *
+ * Copyright (C) 2012-2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "gsl_splinalg.h"
+
+/*
+ * The code in this module computes the incomplete LU factorization
+ * with zero fill-in, ILU(0), of a square matrix A in sorted compressed
+ * column format: A ~ L U where L is unit lower triangular, U is upper
+ * triangular, and L + U has the same sparsity pattern as A
+ *
+ * References:
+ *
+ * [1] Saad, Y., Iterative Methods for Sparse Linear Systems, 2nd ed,
+ *     SIAM, 2003, Section 10.3.2
+ */
+
+/* marker for rows not in the pattern of the current column */
+#define ILU0_NONE     ((size_t) -1)
+
+static int ilu0_check(const gsl_spmatrix *A);
+static int ilu0_pattern(const gsl_spmatrix *A, const gsl_spmatrix *LU);
+
+/*
+gsl_splinalg_ilu0_alloc()
+  Allocate an ILU(0) workspace for the sparsity pattern of A
+
+Inputs: A - square matrix in compressed column format with sorted
+            row indices, no duplicates, and all diagonal elements
+            stored (for example from gsl_spmatrix_compress_sorted())
+
+Return: pointer to workspace
+
+Notes:
+1) The factors are stored in a copy of A, so this is the only
+allocation; gsl_splinalg_ilu0_decomp() may then be called any number
+of times for matrices with the same pattern
+*/
+
+gsl_splinalg_ilu0_workspace *
+gsl_splinalg_ilu0_alloc(const gsl_spmatrix *A)
+{
+  gsl_splinalg_ilu0_workspace *w;
+  size_t j;
+
+  if (ilu0_check(A))
+    {
+      GSL_ERROR_NULL("matrix must be square, sorted, compressed column",
+                     GSL_EINVAL);
+    }
+
+  w = calloc(1, sizeof(gsl_splinalg_ilu0_workspace));
+  if (!w)
+    {
+      GSL_ERROR_NULL("failed to allocate space for ilu0 struct",
+                     GSL_ENOMEM);
+    }
+
+  w->n = A->size1;
+
+  w->LU = gsl_spmatrix_memcpy(A);
+  w->diag = malloc(GSL_MAX(w->n, 1) * sizeof(size_t));
+  w->map = malloc(GSL_MAX(w->n, 1) * sizeof(size_t));
+  if (!w->LU || !w->diag || !w->map)
+    {
+      gsl_splinalg_ilu0_free(w);
+      GSL_ERROR_NULL("failed to allocate space for ilu0 factors",
+                     GSL_ENOMEM);
+    }
+
+  /* locate diagonal elements */
+  for (j = 0; j < w->n; ++j)
+    {
+      size_t p;
+
+      w->diag[j] = ILU0_NONE;
+      w->map[j] = ILU0_NONE;
+
+      for (p = A->p[j]; p < A->p[j + 1]; ++p)
+        {
+          if (A->i[p] == j)
+            w->diag[j] = p;
+        }
+
+      if (w->diag[j] == ILU0_NONE)
+        {
+          gsl_splinalg_ilu0_free(w);
+          GSL_ERROR_NULL("matrix has a structurally zero diagonal element",
+                         GSL_EINVAL);
+        }
+    }
+
+  return w;
+} /* gsl_splinalg_ilu0_alloc() */
+
+void
+gsl_splinalg_ilu0_free(gsl_splinalg_ilu0_workspace *w)
+{
+  if (w->LU)
+    gsl_spmatrix_free(w->LU);
+
+  if (w->diag)
+    free(w->diag);
+
+  if (w->map)
+    free(w->map);
+
+  free(w);
+} /* gsl_splinalg_ilu0_free() */
+
+/*
+gsl_splinalg_ilu0_decomp()
+  Compute the ILU(0) factorization of A
+
+Inputs: A - matrix with the same sparsity pattern as the matrix given
+            to gsl_splinalg_ilu0_alloc()
+        w - workspace
+
+Return: success or error
+
+Notes:
+1) The factorization is computed column by column (left-looking):
+column j of A is updated by the previous columns k < j for which
+u_kj != 0, in increasing order of k, ignoring any fill-in outside the
+pattern of column j. A marker array maps the row indices of column j
+to their positions, so each update costs O(1) per element
+
+2) The factors overwrite a copy of the pattern of A, so the pattern of
+A is compared with it by ilu0_pattern() before A->data is read
+*/
+
+int
+gsl_splinalg_ilu0_decomp(const gsl_spmatrix *A,
+                         gsl_splinalg_ilu0_workspace *w)
+{
+  gsl_spmatrix *LU = w->LU;
+
+  if (A->size1 != w->n || A->size2 != w->n || A->nz != LU->nz ||
+      !GSLSP_ISCCS(A) || GSLSP_ISSYMMETRIC(A) || !ilu0_pattern(A, LU))
+    {
+      GSL_ERROR("matrix does not match workspace", GSL_EBADLEN);
+    }
+  else
+    {
+      const size_t n = w->n;
+      const size_t *Lp = LU->p;
+      const size_t *Li = LU->i;
+      double *Ld = LU->data;
+      size_t *map = w->map;
+      size_t j, p, q;
+
+      for (p = 0; p < LU->nz; ++p)
+        Ld[p] = A->data[p];
+
+      for (j = 0; j < n; ++j)
+        {
+          double ujj;
+
+          for (p = Lp[j]; p < Lp[j + 1]; ++p)
+            map[Li[p]] = p;
+
+          /* rows k < j of column j are the U part, sorted increasingly */
+          for (p = Lp[j]; p < w->diag[j]; ++p)
+            {
+              const size_t k = Li[p];
+              const double ukj = Ld[p];
+
+              /* column j -= u_kj * (L part of column k) */
+              for (q = w->diag[k] + 1; q < Lp[k + 1]; ++q)
+                {
+                  size_t idx = map[Li[q]];
+
+                  if (idx != ILU0_NONE)
+                    Ld[idx] -= Ld[q] * ukj;
+                }
+            }
+
+          ujj = Ld[w->diag[j]];
+          if (ujj == 0.0)
+            {
+              for (p = Lp[j]; p < Lp[j + 1]; ++p)
+                map[Li[p]] = ILU0_NONE;
+
+              GSL_ERROR("zero pivot in ILU(0) factorization", GSL_ESING);
+            }
+
+          for (p = w->diag[j] + 1; p < Lp[j + 1]; ++p)
+            Ld[p] /= ujj;
+
+          for (p = Lp[j]; p < Lp[j + 1]; ++p)
+            map[Li[p]] = ILU0_NONE;
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_splinalg_ilu0_decomp() */
+
+/*
+gsl_splinalg_ilu0_solve()
+  Solve L U x = b using the ILU(0) factors
+
+Inputs: w - workspace containing factors
+        b - right hand side
+        x - (output) solution; may be the same vector as b
+
+Return: success or error
+*/
+
+int
+gsl_splinalg_ilu0_solve(const gsl_splinalg_ilu0_workspace *w,
+                        const gsl_vector *b, gsl_vector *x)
+{
+  const size_t n = w->n;
+
+  if (b->size != n || x->size != n)
+    {
+      GSL_ERROR("vector length does not match workspace", GSL_EBADLEN);
+    }
+  else
+    {
+      const size_t *Lp = w->LU->p;
+      const size_t *Li = w->LU->i;
+      const double *Ld = w->LU->data;
+      double *X = x->data;
+      const size_t incX = x->stride;
+      size_t j, p;
+
+      if (x != b)
+        gsl_vector_memcpy(x, b);
+
+      /* forward substitution with unit lower triangular L */
+      for (j = 0; j < n; ++j)
+        {
+          const double xj = X[j * incX];
+
+          for (p = w->diag[j] + 1; p < Lp[j + 1]; ++p)
+            X[Li[p] * incX] -= Ld[p] * xj;
+        }
+
+      /* back substitution with upper triangular U */
+      for (j = n; j-- > 0; )
+        {
+          double xj = X[j * incX] / Ld[w->diag[j]];
+
+          X[j * incX] = xj;
+
+          for (p = Lp[j]; p < w->diag[j]; ++p)
+            X[Li[p] * incX] -= Ld[p] * xj;
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_splinalg_ilu0_solve() */
+
+/*
+gsl_splinalg_ilu0_precond()
+  Preconditioner function for gsl_splinalg_precond, with params
+pointing to a gsl_splinalg_ilu0_workspace containing the factors
+
+Inputs: r      - vector
+        z      - (output) z = (L U)^{-1} r
+        params - gsl_splinalg_ilu0_workspace
+
+Return: success or error
+*/
+
+int
+gsl_splinalg_ilu0_precond(const gsl_vector *r, gsl_vector *z, void *params)
+{
+  return gsl_splinalg_ilu0_solve((const gsl_splinalg_ilu0_workspace *) params,
+                                 r, z);
+} /* gsl_splinalg_ilu0_precond() */
+
+/*
+ilu0_check()
+  Return 0 if A is a square, sorted CCS matrix without duplicates,
+storing both triangles (not GSL_SPMATRIX_SYMMETRIC)
+*/
+
+static int
+ilu0_check(const gsl_spmatrix *A)
+{
+  if (A->size1 != A->size2 || !GSLSP_ISCCS(A) || !GSLSP_ISSORTED(A) ||
+      !(A->flags & GSL_SPMATRIX_NODUPS) || GSLSP_ISSYMMETRIC(A))
+    return -1;
+
+  return 0;
+} /* ilu0_check() */
+
+/*
+ilu0_pattern()
+  Check that A has the column pointers and row indices of LU, which
+was copied from the matrix given to gsl_splinalg_ilu0_alloc()
+
+Inputs: A  - matrix in compressed column format with nz = LU->nz
+        LU - factors
+
+Return: 1 if A matches the pattern of LU, 0 otherwise
+*/
+
+static int
+ilu0_pattern(const gsl_spmatrix *A, const gsl_spmatrix *LU)
+{
+  size_t j, p;
+
+  for (j = 0; j <= LU->size2; ++j)
+    {
+      if (A->p[j] != LU->p[j])
+        return 0;
+    }
+
+  for (p = 0; p < LU->nz; ++p)
+    {
+      if (A->i[p] != LU->i[p])
+        return 0;
+    }
+
+  return 1;
+} /* ilu0_pattern() */
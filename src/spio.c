@@ -0,0 +1,1220 @@
+/* spio.c
+ *
+ * Copyright (C) 2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+#define SPIO_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "spthread.h"
+#include "spio.h"
+
+/* size of the blocks read from the stream by gsl_spmatrix_fread_mm() */
+#define MM_CHUNK            (1 << 20)
+
+/* maximum length of a Matrix Market header or comment line */
+#define MM_LINE             1024
+
+/* binary format: magic string, version and byte order marker */
+#define SPBIN_MAGIC         "GSLSPMAT"
+#define SPBIN_VERSION       1
+#define SPBIN_ENDIAN        0x01020304
+
+/* alignment of the arrays in a binary file */
+#define SPBIN_ALIGN         64
+
+/*
+ * header of a binary file; it is followed by the arrays p, i and data,
+ * each starting at a multiple of SPBIN_ALIGN bytes from the start of
+ * the file
+ */
+typedef struct
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t endian;      /* SPBIN_ENDIAN in the byte order of the writer */
+  uint32_t index_width; /* sizeof(size_t) of the writer */
+  uint32_t value_width; /* sizeof(double) of the writer */
+  uint64_t size1;
+  uint64_t size2;
+  uint64_t nz;
+  uint64_t flags;       /* storage format and SORTED/NODUPS/SYMMETRIC */
+  uint64_t reserved;
+} spbin_header;
+
+/* offsets of the arrays in a binary file */
+typedef struct
+{
+  size_t np;            /* length of p */
+  size_t off_p;
+  size_t off_i;
+  size_t off_data;
+  size_t size;          /* total file size */
+} spbin_layout;
+
+/* header fields of a Matrix Market coordinate file */
+typedef struct
+{
+  size_t size1;
+  size_t size2;
+  size_t nnz;       /* number of entries in the file */
+  int pattern;      /* no values are stored; entries are 1 */
+  int symmetric;    /* 0 = general, 1 = symmetric, -1 = skew-symmetric */
+} mm_header;
+
+static int mm_write(FILE *stream, const gsl_spmatrix *m, const size_t flags,
+                    const char *format);
+static void mm_index(const gsl_spmatrix *m, const size_t n, size_t *outer,
+                     size_t *i, size_t *j);
+static int mm_read_header(FILE *stream, mm_header *h);
+static int mm_parse_chunk(const char *buf, const size_t len,
+                          const mm_header *h, const size_t nthreads,
+                          size_t *part, size_t *count, size_t *nent,
+                          int *status, gsl_spmatrix *T, size_t *nread);
+static int mm_parse(const char *s, const char *end, const mm_header *h,
+                    size_t *Ti, size_t *Tj, double *Td, const size_t cap,
+                    size_t *nout, size_t *nent);
+static size_t mm_count_lines(const char *s, const char *end);
+static void spbin_layout_init(const size_t type, const size_t size1,
+                              const size_t size2, const size_t nz,
+                              spbin_layout *l);
+static int spbin_check(const spbin_header *h, spbin_layout *l);
+static int spbin_arrays(const gsl_spmatrix *m, const size_t np);
+static int spbin_pad(FILE *stream, const size_t n);
+static int spbin_skip(FILE *stream, const size_t n);
+
+/*
+gsl_spmatrix_fprintf()
+  Write a sparse matrix to a stream in Matrix Market coordinate
+format, using a printf-style format for the values
+
+Inputs: stream - output stream
+        m      - sparse matrix in any storage format
+        format - format for the matrix elements, e.g. "%g"
+
+Return: success or error
+
+Notes:
+1) Row and column indices are written 1-based, one entry per line,
+in the order the elements are stored
+*/
+
+int
+gsl_spmatrix_fprintf(FILE *stream, const gsl_spmatrix *m,
+                     const char *format)
+{
+  return mm_write(stream, m, 0, format);
+} /* gsl_spmatrix_fprintf() */
+
+/*
+gsl_spmatrix_fwrite_mm()
+  Write a sparse matrix to a stream in Matrix Market coordinate format
+
+Inputs: stream - output stream
+        m      - sparse matrix in any storage format
+        flags  - 0 for a general real matrix, or a combination of
+                 GSL_SPMATRIX_MM_PATTERN    - write indices only
+                 GSL_SPMATRIX_MM_SYMMETRIC  - write the lower triangle
+                                              of a symmetric matrix
+
+Return: success or error
+
+Notes:
+1) Values are written with 17 significant digits so that
+gsl_spmatrix_fread_mm() recovers them exactly
+
+2) With GSL_SPMATRIX_MM_SYMMETRIC, elements above the diagonal are
+skipped; the matrix is assumed to be symmetric and this is not checked
+*/
+
+int
+gsl_spmatrix_fwrite_mm(FILE *stream, const gsl_spmatrix *m,
+                       const size_t flags)
+{
+  return mm_write(stream, m, flags, "%.17g");
+} /* gsl_spmatrix_fwrite_mm() */
+
+/*
+gsl_spmatrix_fread_mm()
+  Read a sparse matrix in Matrix Market coordinate format from a
+stream
+
+Inputs: stream - input stream, positioned at the banner line
+
+Return: pointer to new matrix in triplet format (must be freed by
+caller), or NULL on error
+
+Notes:
+1) real, integer and pattern fields are supported, with general,
+symmetric or skew-symmetric structure; pattern entries are set to 1
+
+2) The triplet arrays are allocated once, sized from the number of
+entries in the size line (twice that for symmetric files, whose
+off-diagonal entries are stored in both triangles). The body is read
+in blocks of MM_CHUNK bytes; each block is cut at line boundaries into
+one piece per thread (gsl_spblas_set_num_threads()), and the pieces are
+parsed in parallel directly into the triplet arrays
+
+3) The entries are stored in the order of the file regardless of the
+number of threads. Duplicate entries are kept as separate triplets,
+and gsl_spmatrix_get() returns the first of them
+
+4) The matrix is returned without a hash table, so no memory beyond
+the triplet arrays is allocated; call gsl_spmatrix_hash_init() if
+elements are to be overwritten afterwards
+*/
+
+gsl_spmatrix *
+gsl_spmatrix_fread_mm(FILE *stream)
+{
+  mm_header h;
+  int status = mm_read_header(stream, &h);
+
+  if (status)
+    {
+      return NULL;
+    }
+  else
+    {
+      const size_t nthreads = gsl_spblas_get_num_threads();
+      const size_t nzmax = h.symmetric ? 2 * h.nnz : h.nnz;
+      gsl_spmatrix *T;
+      char *buf;
+      size_t *part, *count, *nent;
+      int *tstatus;
+      size_t carry = 0;
+      size_t nread = 0;
+      int eof = 0;
+
+      T = gsl_spmatrix_alloc_nzmax(h.size1, h.size2, nzmax,
+                                   GSL_SPMATRIX_TRIPLET);
+      if (!T)
+        return NULL;
+
+      buf = malloc(2 * MM_CHUNK + 1);
+      part = malloc((nthreads + 1) * sizeof(size_t));
+      count = malloc(2 * nthreads * sizeof(size_t));
+      nent = malloc(nthreads * sizeof(size_t));
+      tstatus = malloc(nthreads * sizeof(int));
+      if (!buf || !part || !count || !nent || !tstatus)
+        {
+          free(buf);
+          free(part);
+          free(count);
+          free(nent);
+          free(tstatus);
+          gsl_spmatrix_free(T);
+          GSL_ERROR_NULL("failed to allocate space for read buffer",
+                         GSL_ENOMEM);
+        }
+
+      while (!eof && status == GSL_SUCCESS)
+        {
+          size_t n = fread(buf + carry, 1, MM_CHUNK, stream);
+          size_t len = carry + n;
+          size_t end = len;
+          char c;
+
+          if (n < MM_CHUNK)
+            {
+              if (ferror(stream))
+                {
+                  status = GSL_EFAILED;
+                  break;
+                }
+
+              eof = 1;
+            }
+          else
+            {
+              /* parse complete lines only; the rest is carried over */
+              while (end > 0 && buf[end - 1] != '\n')
+                --end;
+
+              if (end == 0)
+                {
+                  status = GSL_EFAILED;
+                  break;
+                }
+            }
+
+          c = buf[end];
+          buf[end] = '\0';
+
+          status = mm_parse_chunk(buf, end, &h, nthreads, part, count, nent,
+                                  tstatus, T, &nread);
+
+          buf[end] = c;
+          carry = len - end;
+          memmove(buf, buf + end, carry);
+        }
+
+      free(buf);
+      free(part);
+      free(count);
+      free(nent);
+      free(tstatus);
+
+      if (status == GSL_SUCCESS && nread != h.nnz)
+        status = GSL_EBADLEN;
+
+      if (status)
+        {
+          gsl_spmatrix_free(T);
+
+          if (status == GSL_EDOM)
+            {
+              GSL_ERROR_NULL("Matrix Market index out of range", GSL_EDOM);
+            }
+          else if (status == GSL_EBADLEN)
+            {
+              GSL_ERROR_NULL("number of Matrix Market entries does not match header",
+                             GSL_EBADLEN);
+            }
+          else
+            {
+              GSL_ERROR_NULL("malformed Matrix Market entry", GSL_EFAILED);
+            }
+        }
+
+      return T;
+    }
+} /* gsl_spmatrix_fread_mm() */
+
+/*
+gsl_spmatrix_fwrite()
+  Write a compressed matrix to a stream in binary format
+
+Inputs: stream - output stream
+        m      - sparse matrix in CCS or CRS format
+
+Return: success or error
+
+Notes:
+1) The file consists of a 64 byte header (spbin_header) giving the
+format version, byte order, index and value widths, dimensions, nz
+and flags, followed by the arrays p, i and data in native byte order,
+each aligned to SPBIN_ALIGN bytes, so that the file can be mapped
+directly with gsl_spmatrix_mmap()
+*/
+
+int
+gsl_spmatrix_fwrite(FILE *stream, const gsl_spmatrix *m)
+{
+  if (GSLSP_ISTRIPLET(m))
+    {
+      GSL_ERROR("matrix must be in compressed format", GSL_EINVAL);
+    }
+  else
+    {
+      spbin_header h;
+      spbin_layout l;
+      size_t n;
+
+      memset(&h, 0, sizeof(h));
+      memcpy(h.magic, SPBIN_MAGIC, sizeof(h.magic));
+      h.version = SPBIN_VERSION;
+      h.endian = SPBIN_ENDIAN;
+      h.index_width = sizeof(size_t);
+      h.value_width = sizeof(double);
+      h.size1 = m->size1;
+      h.size2 = m->size2;
+      h.nz = m->nz;
+      h.flags = m->flags & (GSL_SPMATRIX_TYPEMASK | GSL_SPMATRIX_SORTED |
+                            GSL_SPMATRIX_NODUPS | GSL_SPMATRIX_SYMMETRIC);
+
+      spbin_layout_init(GSLSP_TYPE(m), m->size1, m->size2, m->nz, &l);
+
+      n = fwrite(&h, sizeof(h), 1, stream);
+      if (n != 1)
+        {
+          GSL_ERROR("fwrite failed", GSL_EFAILED);
+        }
+
+      if (spbin_pad(stream, l.off_p - sizeof(h)) ||
+          fwrite(m->p, sizeof(size_t), l.np, stream) != l.np ||
+          spbin_pad(stream, l.off_i - l.off_p - l.np * sizeof(size_t)) ||
+          fwrite(m->i, sizeof(size_t), m->nz, stream) != m->nz ||
+          spbin_pad(stream, l.off_data - l.off_i - m->nz * sizeof(size_t)) ||
+          fwrite(m->data, sizeof(double), m->nz, stream) != m->nz)
+        {
+          GSL_ERROR("fwrite failed", GSL_EFAILED);
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_spmatrix_fwrite() */
+
+/*
+gsl_spmatrix_fread()
+  Read a compressed matrix in binary format from a stream
+
+Inputs: stream - input stream, positioned at the header
+
+Return: pointer to new matrix (must be freed by caller), or NULL on
+error
+
+Notes:
+1) The file must have been written by gsl_spmatrix_fwrite() on a
+machine with the same byte order and index width
+
+2) The stream is read sequentially, so it need not be seekable
+
+3) The arrays are validated with spbin_arrays() in O(nz) operations,
+so a corrupt file cannot produce a matrix whose indices are out of
+range
+*/
+
+gsl_spmatrix *
+gsl_spmatrix_fread(FILE *stream)
+{
+  spbin_header h;
+  spbin_layout l;
+  gsl_spmatrix *m;
+
+  if (fread(&h, sizeof(h), 1, stream) != 1)
+    {
+      GSL_ERROR_NULL("fread failed", GSL_EFAILED);
+    }
+
+  if (spbin_check(&h, &l))
+    return NULL;
+
+  m = gsl_spmatrix_alloc_nzmax(h.size1, h.size2, h.nz, h.flags);
+  if (!m)
+    return NULL;
+
+  if (spbin_skip(stream, l.off_p - sizeof(h)) ||
+      fread(m->p, sizeof(size_t), l.np, stream) != l.np ||
+      spbin_skip(stream, l.off_i - l.off_p - l.np * sizeof(size_t)) ||
+      fread(m->i, sizeof(size_t), h.nz, stream) != h.nz ||
+      spbin_skip(stream, l.off_data - l.off_i - h.nz * sizeof(size_t)) ||
+      fread(m->data, sizeof(double), h.nz, stream) != h.nz)
+    {
+      gsl_spmatrix_free(m);
+      GSL_ERROR_NULL("fread failed", GSL_EFAILED);
+    }
+
+  m->nz = h.nz;
+  m->flags = h.flags;
+
+  if (spbin_arrays(m, l.np))
+    {
+      gsl_spmatrix_free(m);
+      GSL_ERROR_NULL("corrupt index arrays in sparse matrix file",
+                     GSL_EFAILED);
+    }
+
+  return m;
+} /* gsl_spmatrix_fread() */
+
+/*
+gsl_spmatrix_mmap()
+  Map a compressed matrix file written by gsl_spmatrix_fwrite() into
+memory
+
+Inputs: filename - name of file
+
+Return: pointer to new read-only matrix (must be freed by caller), or
+NULL on error
+
+Notes:
+1) The arrays p, i and data of the returned matrix point into a
+read-only shared mapping of the file, so no data is read until it is
+accessed and processes mapping the same file share the page cache.
+Only the matrix structure and its work array are allocated.
+
+2) The matrix has the GSL_SPMATRIX_READONLY flag set, and routines
+which would modify its arrays return an error. gsl_spmatrix_free()
+unmaps the file. gsl_spmatrix_memcpy() gives a modifiable copy.
+
+3) Only the header is validated, so that the file is not read when
+it is mapped; unlike gsl_spmatrix_fread(), the arrays are trusted
+
+4) If memory mapping is not available, the file is read with
+gsl_spmatrix_fread() and an ordinary matrix is returned
+*/
+
+gsl_spmatrix *
+gsl_spmatrix_mmap(const char *filename)
+{
+#ifdef SPIO_HAVE_MMAP
+  const spbin_header *h;
+  spbin_layout l;
+  struct stat st;
+  gsl_spmatrix *m;
+  void *map;
+  size_t mapsize;
+  int fd;
+
+  fd = open(filename, O_RDONLY);
+  if (fd < 0)
+    {
+      GSL_ERROR_NULL("unable to open sparse matrix file", GSL_EFAILED);
+    }
+
+  if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(spbin_header))
+    {
+      close(fd);
+      GSL_ERROR_NULL("sparse matrix file is too short", GSL_EFAILED);
+    }
+
+  mapsize = (size_t) st.st_size;
+  map = mmap(NULL, mapsize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (map == MAP_FAILED)
+    {
+      GSL_ERROR_NULL("unable to map sparse matrix file", GSL_EFAILED);
+    }
+
+  h = (const spbin_header *) map;
+
+  if (spbin_check(h, &l))
+    {
+      munmap(map, mapsize);
+      return NULL;
+    }
+  else if (mapsize < l.size)
+    {
+      munmap(map, mapsize);
+      GSL_ERROR_NULL("sparse matrix file is too short", GSL_EFAILED);
+    }
+
+  m = calloc(1, sizeof(gsl_spmatrix));
+  if (!m)
+    {
+      munmap(map, mapsize);
+      GSL_ERROR_NULL("failed to allocate space for spmatrix struct",
+                     GSL_ENOMEM);
+    }
+
+  m->size1 = h->size1;
+  m->size2 = h->size2;
+  m->nz = h->nz;
+  m->nzmax = h->nz;
+  m->flags = h->flags | GSL_SPMATRIX_READONLY;
+  m->map = map;
+  m->mapsize = mapsize;
+  m->p = (size_t *) ((char *) map + l.off_p);
+  m->i = (size_t *) ((char *) map + l.off_i);
+  m->data = (double *) ((char *) map + l.off_data);
+
+  if (m->p[0] != 0 || m->p[l.np - 1] != m->nz)
+    {
+      gsl_spmatrix_free(m);
+      GSL_ERROR_NULL("corrupt pointer array in sparse matrix file",
+                     GSL_EFAILED);
+    }
+
+  m->work = malloc(GSL_MAX(m->size1, m->size2) * sizeof(size_t));
+  if (!m->work)
+    {
+      gsl_spmatrix_free(m);
+      GSL_ERROR_NULL("failed to allocate space for work array", GSL_ENOMEM);
+    }
+
+  return m;
+#else
+  FILE *stream = fopen(filename, "rb");
+  gsl_spmatrix *m;
+
+  if (!stream)
+    {
+      GSL_ERROR_NULL("unable to open sparse matrix file", GSL_EFAILED);
+    }
+
+  m = gsl_spmatrix_fread(stream);
+  fclose(stream);
+
+  return m;
+#endif
+} /* gsl_spmatrix_mmap() */
+
+/*
+spio_unmap()
+  Release the file mapping of a matrix returned by gsl_spmatrix_mmap()
+*/
+
+void
+spio_unmap(gsl_spmatrix *m)
+{
+#ifdef SPIO_HAVE_MMAP
+  munmap(m->map, m->mapsize);
+#endif
+
+  m->map = NULL;
+  m->mapsize = 0;
+} /* spio_unmap() */
+
+/*
+mm_write()
+  Write a sparse matrix in Matrix Market coordinate format
+
+Inputs: stream - output stream
+        m      - sparse matrix
+        flags  - GSL_SPMATRIX_MM_xxx flags
+        format - format for the matrix elements
+
+Return: success or error
+
+Notes:
+1) A matrix with symmetric storage (GSL_SPMATRIX_SYMMETRIC) is always
+written with a symmetric header, since only its lower triangle is stored
+*/
+
+static int
+mm_write(FILE *stream, const gsl_spmatrix *m, const size_t flags,
+         const char *format)
+{
+  const int pattern = (flags & GSL_SPMATRIX_MM_PATTERN) != 0;
+  const int symmetric = (flags & GSL_SPMATRIX_MM_SYMMETRIC) != 0 ||
+                        GSLSP_ISSYMMETRIC(m);
+
+  if (symmetric && m->size1 != m->size2)
+    {
+      GSL_ERROR("symmetric matrix must be square", GSL_ENOTSQR);
+    }
+  else
+    {
+      size_t nz = m->nz;
+      size_t outer = 0;
+      size_t n, i, j;
+      int status;
+
+      if (symmetric)
+        {
+          /* count the elements on and below the diagonal */
+          nz = 0;
+          for (n = 0; n < m->nz; ++n)
+            {
+              mm_index(m, n, &outer, &i, &j);
+              if (i >= j)
+                ++nz;
+            }
+
+          outer = 0;
+        }
+
+      status = fprintf(stream, "%%%%MatrixMarket matrix coordinate %s %s\n",
+                       pattern ? "pattern" : "real",
+                       symmetric ? "symmetric" : "general");
+      if (status < 0)
+        {
+          GSL_ERROR("fprintf failed", GSL_EFAILED);
+        }
+
+      status = fprintf(stream, "%lu %lu %lu\n", (unsigned long) m->size1,
+                       (unsigned long) m->size2, (unsigned long) nz);
+      if (status < 0)
+        {
+          GSL_ERROR("fprintf failed", GSL_EFAILED);
+        }
+
+      for (n = 0; n < m->nz; ++n)
+        {
+          mm_index(m, n, &outer, &i, &j);
+
+          if (symmetric && i < j)
+            continue;
+
+          status = fprintf(stream, "%lu %lu", (unsigned long) (i + 1),
+                           (unsigned long) (j + 1));
+
+          if (status >= 0 && !pattern)
+            {
+              status = putc(' ', stream);
+              if (status != EOF)
+                status = fprintf(stream, format, m->data[n]);
+            }
+
+          if (status >= 0)
+            status = putc('\n', stream);
+
+          if (status < 0)
+            {
+              GSL_ERROR("fprintf failed", GSL_EFAILED);
+            }
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* mm_write() */
+
+/*
+mm_index()
+  Find the row and column of element n of a sparse matrix. Elements
+must be visited in increasing order of n, starting with *outer = 0.
+*/
+
+static void
+mm_index(const gsl_spmatrix *m, const size_t n, size_t *outer,
+         size_t *i, size_t *j)
+{
+  if (GSLSP_ISTRIPLET(m))
+    {
+      *i = m->i[n];
+      *j = m->p[n];
+    }
+  else
+    {
+      while (m->p[*outer + 1] <= n)
+        ++(*outer);
+
+      if (GSLSP_ISCCS(m))
+        {
+          *i = m->i[n];
+          *j = *outer;
+        }
+      else
+        {
+          *i = *outer;
+          *j = m->i[n];
+        }
+    }
+} /* mm_index() */
+
+/*
+mm_read_header()
+  Read the banner, comment lines and size line of a Matrix Market
+coordinate file
+
+Inputs: stream - input stream
+        h      - (output) header fields
+
+Return: success or error
+*/
+
+static int
+mm_read_header(FILE *stream, mm_header *h)
+{
+  char line[MM_LINE];
+  char object[MM_LINE], format[MM_LINE], field[MM_LINE], symm[MM_LINE];
+  unsigned long size1, size2, nnz;
+  char *s;
+
+  if (fgets(line, MM_LINE, stream) == NULL)
+    {
+      GSL_ERROR("failed to read Matrix Market banner", GSL_EFAILED);
+    }
+
+  for (s = line; *s; ++s)
+    *s = tolower((unsigned char) *s);
+
+  if (sscanf(line, "%%%%matrixmarket %s %s %s %s",
+             object, format, field, symm) != 4)
+    {
+      GSL_ERROR("invalid Matrix Market banner", GSL_EFAILED);
+    }
+
+  if (strcmp(object, "matrix") != 0 || strcmp(format, "coordinate") != 0)
+    {
+      GSL_ERROR("only coordinate Matrix Market matrices are supported",
+                GSL_EUNSUP);
+    }
+
+  if (strcmp(field, "pattern") == 0)
+    h->pattern = 1;
+  else if (strcmp(field, "real") == 0 || strcmp(field, "double") == 0 ||
+           strcmp(field, "integer") == 0)
+    h->pattern = 0;
+  else
+    {
+      GSL_ERROR("unsupported Matrix Market field", GSL_EUNSUP);
+    }
+
+  if (strcmp(symm, "general") == 0)
+    h->symmetric = 0;
+  else if (strcmp(symm, "symmetric") == 0)
+    h->symmetric = 1;
+  else if (strcmp(symm, "skew-symmetric") == 0 && !h->pattern)
+    h->symmetric = -1;
+  else
+    {
+      GSL_ERROR("unsupported Matrix Market symmetry", GSL_EUNSUP);
+    }
+
+  /* skip comment and blank lines up to the size line */
+  do
+    {
+      if (fgets(line, MM_LINE, stream) == NULL)
+        {
+          GSL_ERROR("failed to read Matrix Market size line", GSL_EFAILED);
+        }
+
+      for (s = line; *s == ' ' || *s == '\t' || *s == '\r'; ++s)
+        ;
+    }
+  while (*s == '%' || *s == '\n' || *s == '\0');
+
+  if (sscanf(s, "%lu %lu %lu", &size1, &size2, &nnz) != 3)
+    {
+      GSL_ERROR("invalid Matrix Market size line", GSL_EFAILED);
+    }
+
+  if (h->symmetric && size1 != size2)
+    {
+      GSL_ERROR("symmetric matrix must be square", GSL_ENOTSQR);
+    }
+
+  h->size1 = size1;
+  h->size2 = size2;
+  h->nnz = nnz;
+
+  return GSL_SUCCESS;
+} /* mm_read_header() */
+
+/*
+mm_parse_chunk()
+  Parse a block of complete lines into the triplet matrix T
+
+Inputs: buf      - block of lines, terminated by '\0'
+        len      - length of block
+        h        - header fields
+        nthreads - number of threads
+        part     - workspace, size nthreads + 1
+        count    - workspace, size 2 * nthreads
+        nent     - workspace, size nthreads
+        status   - workspace, size nthreads
+        T        - (input/output) triplet matrix; entries are appended
+                   at T->nz
+        nread    - (input/output) number of file entries read
+
+Return: success or error
+
+Notes:
+1) The block is cut into nthreads pieces at line boundaries. Piece t
+has at most count[t] lines, so it produces at most count[t] triplets
+(2*count[t] if symmetric); the pieces are parsed in parallel into
+disjoint regions of T of that size, which are then moved down to be
+contiguous
+
+2) If the regions would not fit in T, because blank lines are counted
+as lines, the block is parsed serially
+*/
+
+static int
+mm_parse_chunk(const char *buf, const size_t len, const mm_header *h,
+               const size_t nthreads, size_t *part, size_t *count,
+               size_t *nent, int *status, gsl_spmatrix *T, size_t *nread)
+{
+  const size_t mult = h->symmetric ? 2 : 1;
+  size_t *offset = count + nthreads;
+  size_t total = 0;
+  size_t t;
+  int s = GSL_SUCCESS;
+
+  if (nthreads > 1)
+    {
+      long k;
+
+      /* cut the block after the first newline past each split point */
+      part[0] = 0;
+      for (t = 1; t < nthreads; ++t)
+        {
+          size_t pos = GSL_MAX(spthread_block(len, nthreads, t), part[t - 1]);
+          const char *nl = pos < len ? memchr(buf + pos, '\n', len - pos) : NULL;
+
+          part[t] = nl ? (size_t) (nl - buf) + 1 : len;
+        }
+      part[nthreads] = len;
+
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+      for (k = 0; k < (long) nthreads; ++k)
+        count[k] = mm_count_lines(buf + part[k], buf + part[k + 1]);
+
+      for (t = 0; t < nthreads; ++t)
+        {
+          offset[t] = total;
+          total += mult * count[t];
+        }
+    }
+
+  if (nthreads > 1 && T->nz + total <= T->nzmax)
+    {
+      long k;
+      size_t dest = T->nz;
+
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+      for (k = 0; k < (long) nthreads; ++k)
+        {
+          const size_t start = T->nz + offset[k];
+
+          status[k] = mm_parse(buf + part[k], buf + part[k + 1], h,
+                               T->i + start, T->p + start, T->data + start,
+                               mult * count[k], &count[k], &nent[k]);
+        }
+
+      for (t = 0; t < nthreads; ++t)
+        {
+          const size_t start = T->nz + offset[t];
+
+          if (status[t] && !s)
+            s = status[t];
+
+          if (dest != start)
+            {
+              memmove(T->i + dest, T->i + start, count[t] * sizeof(size_t));
+              memmove(T->p + dest, T->p + start, count[t] * sizeof(size_t));
+              memmove(T->data + dest, T->data + start,
+                      count[t] * sizeof(double));
+            }
+
+          dest += count[t];
+          *nread += nent[t];
+        }
+
+      T->nz = dest;
+    }
+  else
+    {
+      size_t nout, nentries;
+
+      s = mm_parse(buf, buf + len, h, T->i + T->nz, T->p + T->nz,
+                   T->data + T->nz, T->nzmax - T->nz, &nout, &nentries);
+
+      T->nz += nout;
+      *nread += nentries;
+    }
+
+  if (s == GSL_SUCCESS && *nread > h->nnz)
+    s = GSL_EBADLEN;
+
+  return s;
+} /* mm_parse_chunk() */
+
+/*
+mm_parse()
+  Parse the entries in [s,end) into triplet arrays
+
+Inputs: s    - start of text, at the beginning of a line
+        end  - end of text
+        h    - header fields
+        Ti   - (output) 0-based row indices
+        Tj   - (output) 0-based column indices
+        Td   - (output) values
+        cap  - size of Ti, Tj, Td
+        nout - (output) number of triplets stored
+        nent - (output) number of entries parsed
+
+Return: GSL_SUCCESS, GSL_EFAILED for a malformed line, GSL_EDOM for
+an index out of range, or GSL_EBADLEN if the arrays are full
+
+Notes:
+1) [s,end) must consist of complete lines: every line ends with a
+newline, except possibly the last, which must then be followed by '\0'
+
+2) This routine runs inside parallel regions, so it returns a status
+rather than calling the error handler
+*/
+
+static int
+mm_parse(const char *s, const char *end, const mm_header *h,
+         size_t *Ti, size_t *Tj, double *Td, const size_t cap,
+         size_t *nout, size_t *nent)
+{
+  size_t n = 0;
+  size_t ne = 0;
+  int status = GSL_SUCCESS;
+
+  while (s < end)
+    {
+      size_t i = 0, j = 0;
+      double x = 1.0;
+
+      while (s < end && (*s == ' ' || *s == '\t' || *s == '\r'))
+        ++s;
+
+      if (s == end)
+        break;
+
+      if (*s == '\n' || *s == '%')
+        {
+          /* blank or comment line */
+          while (s < end && *s != '\n')
+            ++s;
+          ++s;
+          continue;
+        }
+
+      if (!isdigit((unsigned char) *s))
+        {
+          status = GSL_EFAILED;
+          break;
+        }
+
+      while (isdigit((unsigned char) *s))
+        i = 10 * i + (size_t) (*s++ - '0');
+
+      while (*s == ' ' || *s == '\t')
+        ++s;
+
+      if (!isdigit((unsigned char) *s))
+        {
+          status = GSL_EFAILED;
+          break;
+        }
+
+      while (isdigit((unsigned char) *s))
+        j = 10 * j + (size_t) (*s++ - '0');
+
+      if (!h->pattern)
+        {
+          char *e;
+
+          while (*s == ' ' || *s == '\t')
+            ++s;
+
+          /* strtod would skip a newline, so check for a value first */
+          if (*s == '\n' || *s == '\r' || *s == '\0')
+            {
+              status = GSL_EFAILED;
+              break;
+            }
+
+          x = strtod(s, &e);
+          if (e == s)
+            {
+              status = GSL_EFAILED;
+              break;
+            }
+
+          s = e;
+        }
+
+      /* skip the rest of the line */
+      while (s < end && *s != '\n')
+        ++s;
+      ++s;
+
+      if (i == 0 || i > h->size1 || j == 0 || j > h->size2)
+        {
+          status = GSL_EDOM;
+          break;
+        }
+
+      if (n >= cap || (h->symmetric && i != j && n + 1 >= cap))
+        {
+          status = GSL_EBADLEN;
+          break;
+        }
+
+      Ti[n] = i - 1;
+      Tj[n] = j - 1;
+      Td[n] = x;
+      ++n;
+
+      if (h->symmetric && i != j)
+        {
+          Ti[n] = j - 1;
+          Tj[n] = i - 1;
+          Td[n] = h->symmetric > 0 ? x : -x;
+          ++n;
+        }
+
+      ++ne;
+    }
+
+  *nout = n;
+  *nent = ne;
+
+  return status;
+} /* mm_parse() */
+
+/*
+mm_count_lines()
+  Count the lines in [s,end), including a final line without a
+newline
+*/
+
+static size_t
+mm_count_lines(const char *s, const char *end)
+{
+  size_t n = 0;
+
+  while (s < end)
+    {
+      const char *nl = memchr(s, '\n', (size_t) (end - s));
+
+      ++n;
+
+      if (!nl)
+        break;
+
+      s = nl + 1;
+    }
+
+  return n;
+} /* mm_count_lines() */
+
+/*
+spbin_layout_init()
+  Compute the array offsets of a binary file
+*/
+
+static void
+spbin_layout_init(const size_t type, const size_t size1, const size_t size2,
+                  const size_t nz, spbin_layout *l)
+{
+  l->np = (type == GSL_SPMATRIX_CCS) ? size2 + 1 : size1 + 1;
+  l->off_p = SPBIN_ALIGN;
+  l->off_i = l->off_p + l->np * sizeof(size_t);
+  l->off_i = (l->off_i + SPBIN_ALIGN - 1) / SPBIN_ALIGN * SPBIN_ALIGN;
+  l->off_data = l->off_i + nz * sizeof(size_t);
+  l->off_data = (l->off_data + SPBIN_ALIGN - 1) / SPBIN_ALIGN * SPBIN_ALIGN;
+  l->size = l->off_data + nz * sizeof(double);
+} /* spbin_layout_init() */
+
+/*
+spbin_check()
+  Validate the header of a binary file and compute its layout
+
+Inputs: h - header
+        l - (output) array offsets
+
+Return: success or error
+*/
+
+static int
+spbin_check(const spbin_header *h, spbin_layout *l)
+{
+  const size_t type = h->flags & GSL_SPMATRIX_TYPEMASK;
+
+  if (memcmp(h->magic, SPBIN_MAGIC, sizeof(h->magic)) != 0)
+    {
+      GSL_ERROR("not a sparse matrix file", GSL_EFAILED);
+    }
+  else if (h->version != SPBIN_VERSION)
+    {
+      GSL_ERROR("unsupported sparse matrix file version", GSL_EUNSUP);
+    }
+  else if (h->endian != SPBIN_ENDIAN)
+    {
+      GSL_ERROR("sparse matrix file has different byte order", GSL_EUNSUP);
+    }
+  else if (h->index_width != sizeof(size_t) ||
+           h->value_width != sizeof(double))
+    {
+      GSL_ERROR("sparse matrix file has different index width", GSL_EUNSUP);
+    }
+  else if ((type != GSL_SPMATRIX_CCS && type != GSL_SPMATRIX_CRS) ||
+           (h->flags & ~(uint64_t) (GSL_SPMATRIX_TYPEMASK |
+                                    GSL_SPMATRIX_SORTED |
+                                    GSL_SPMATRIX_NODUPS |
+                                    GSL_SPMATRIX_SYMMETRIC)))
+    {
+      GSL_ERROR("invalid flags in sparse matrix file", GSL_EFAILED);
+    }
+  else if ((h->flags & GSL_SPMATRIX_SYMMETRIC) &&
+           (type != GSL_SPMATRIX_CCS || h->size1 != h->size2))
+    {
+      GSL_ERROR("invalid symmetric matrix in sparse matrix file",
+                GSL_EFAILED);
+    }
+  else if (h->size1 == 0 || h->size2 == 0 ||
+           h->size1 >= SIZE_MAX / (2 * sizeof(double)) ||
+           h->size2 >= SIZE_MAX / (2 * sizeof(double)) ||
+           h->nz >= SIZE_MAX / (4 * sizeof(double)))
+    {
+      GSL_ERROR("invalid dimensions in sparse matrix file", GSL_EFAILED);
+    }
+
+  spbin_layout_init(type, h->size1, h->size2, h->nz, l);
+
+  return GSL_SUCCESS;
+} /* spbin_check() */
+
+/*
+spbin_arrays()
+  Validate the arrays of a compressed matrix read from a binary file:
+the np outer pointers must increase from 0 to nz, every inner index
+must be below the inner dimension, and a matrix with symmetric storage
+must hold only its lower triangle
+
+Inputs: m  - compressed matrix, with nz and flags set from the header
+        np - number of outer pointers
+
+Return: 0 if the arrays are valid, -1 otherwise
+*/
+
+static int
+spbin_arrays(const gsl_spmatrix *m, const size_t np)
+{
+  const size_t ninner = GSLSP_ISCCS(m) ? m->size1 : m->size2;
+  size_t j, p;
+
+  if (m->p[0] != 0 || m->p[np - 1] != m->nz)
+    return -1;
+
+  for (j = 0; j + 1 < np; ++j)
+    {
+      if (m->p[j] > m->p[j + 1] || m->p[j + 1] > m->nz)
+        return -1;
+
+      for (p = m->p[j]; p < m->p[j + 1]; ++p)
+        {
+          if (m->i[p] >= ninner || (GSLSP_ISSYMMETRIC(m) && m->i[p] < j))
+            return -1;
+        }
+    }
+
+  return 0;
+} /* spbin_arrays() */
+
+/*
+spbin_pad()
+  Write n zero bytes
+*/
+
+static int
+spbin_pad(FILE *stream, const size_t n)
+{
+  static const char zero[SPBIN_ALIGN] = { 0 };
+
+  return fwrite(zero, 1, n, stream) != n;
+} /* spbin_pad() */
+
+/*
+spbin_skip()
+  Read and discard n < SPBIN_ALIGN bytes
+*/
+
+static int
+spbin_skip(FILE *stream, const size_t n)
+{
+  char buf[SPBIN_ALIGN];
+
+  return fread(buf, 1, n, stream) != n;
+} /* spbin_skip() */
@@ -0,0 +1,176 @@
+/* spitersolve.c
+ *
+ * Copyright (C) 2012-2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "gsl_splinalg.h"
+
+/*
+gsl_splinalg_itersolve_alloc()
+  Allocate a workspace for an iterative linear solver
+
+Inputs: T - solver type
+        n - size of linear system
+        m - solver parameter; the maximum number of iterations
+            performed by each call to gsl_splinalg_itersolve_iterate()
+            for CG, or the dimension of the Krylov subspace for
+            restarted methods. If m = 0, a default value is used
+
+Return: pointer to new workspace
+*/
+
+gsl_splinalg_itersolve *
+gsl_splinalg_itersolve_alloc(const gsl_splinalg_itersolve_type *T,
+                             const size_t n, const size_t m)
+{
+  gsl_splinalg_itersolve *w;
+
+  w = calloc(1, sizeof(gsl_splinalg_itersolve));
+  if (w == NULL)
+    {
+      GSL_ERROR_NULL("failed to allocate space for itersolve struct",
+                     GSL_ENOMEM);
+    }
+
+  w->type = T;
+  w->precond = NULL;
+  w->normr = 0.0;
+  w->niter = 0;
+
+  w->state = w->type->alloc(n, m);
+  if (w->state == NULL)
+    {
+      gsl_splinalg_itersolve_free(w);
+      GSL_ERROR_NULL("failed to allocate space for itersolve state",
+                     GSL_ENOMEM);
+    }
+
+  return w;
+} /* gsl_splinalg_itersolve_alloc() */
+
+void
+gsl_splinalg_itersolve_free(gsl_splinalg_itersolve *w)
+{
+  if (w->state)
+    w->type->free(w->state);
+
+  free(w);
+} /* gsl_splinalg_itersolve_free() */
+
+const char *
+gsl_splinalg_itersolve_name(const gsl_splinalg_itersolve *w)
+{
+  return w->type->name;
+} /* gsl_splinalg_itersolve_name() */
+
+/*
+gsl_splinalg_itersolve_set_precond()
+  Set the preconditioner used by subsequent iterations
+
+Inputs: w - workspace
+        P - preconditioner, or NULL for no preconditioning. The
+            struct is not copied, and must remain valid while the
+            workspace is used
+
+Return: success
+*/
+
+int
+gsl_splinalg_itersolve_set_precond(gsl_splinalg_itersolve *w,
+                                   const gsl_splinalg_precond *P)
+{
+  w->precond = P;
+  return GSL_SUCCESS;
+} /* gsl_splinalg_itersolve_set_precond() */
+
+/*
+gsl_splinalg_itersolve_iterate()
+  Perform iterations to solve A x = b
+
+Inputs: A   - sparse matrix
+        b   - right hand side vector
+        tol - relative tolerance; the solver stops when
+              || b - A x || <= tol * || b ||
+        x   - (input/output) on input, initial guess; on output,
+              updated solution
+        w   - workspace
+
+Return: GSL_SUCCESS if converged, GSL_CONTINUE if more iterations
+are needed, or an error code
+*/
+
+int
+gsl_splinalg_itersolve_iterate(const gsl_spmatrix *A, const gsl_vector *b,
+                               const double tol, gsl_vector *x,
+                               gsl_splinalg_itersolve *w)
+{
+  if (A->size1 != A->size2)
+    {
+      GSL_ERROR("matrix must be square", GSL_ENOTSQR);
+    }
+  else if (A->size1 != b->size)
+    {
+      GSL_ERROR("matrix does not match right hand side", GSL_EBADLEN);
+    }
+  else if (A->size1 != x->size)
+    {
+      GSL_ERROR("matrix does not match solution vector", GSL_EBADLEN);
+    }
+  else
+    {
+      size_t niter = 0;
+      int status = w->type->iterate(A, b, tol, w->precond, x, &niter,
+                                    w->state);
+
+      w->normr = w->type->normr(w->state);
+      w->niter += niter;
+
+      return status;
+    }
+} /* gsl_splinalg_itersolve_iterate() */
+
+/*
+gsl_splinalg_itersolve_normr()
+  Return the residual norm || b - A x || after the last call to
+gsl_splinalg_itersolve_iterate()
+*/
+
+double
+gsl_splinalg_itersolve_normr(const gsl_splinalg_itersolve *w)
+{
+  return w->normr;
+} /* gsl_splinalg_itersolve_normr() */
+
+/*
+gsl_splinalg_itersolve_niter()
+  Return the total number of iterations performed with this workspace
+*/
+
+size_t
+gsl_splinalg_itersolve_niter(const gsl_splinalg_itersolve *w)
+{
+  return w->niter;
+} /* gsl_splinalg_itersolve_niter() */
@@ -25,6 +25,7 @@
 #include <gsl/gsl_errno.h>
 
 #include "gsl_spmatrix.h"
+#include "spio.h"
 
 /*
 gsl_spmatrix_alloc()
@@ -56,7 +57,8 @@ gsl_spmatrix_alloc_nzmax()
 Inputs: n1    - number of rows
         n2    - number of columns
         nzmax - maximum number of matrix elements
-        flags - type of matrix (triplet, compressed column)
+        flags - type of matrix (triplet, compressed column, compressed row);
+                property bits such as GSL_SPMATRIX_SORTED are ignored
 
 Notes: if (n1,n2) are not known at allocation time, they can each be
 set to 1, and they will be expanded as elements are added to the matrix
@@ -66,6 +68,7 @@ gsl_spmatrix *
 gsl_spmatrix_alloc_nzmax(const size_t n1, const size_t n2,
                          const size_t nzmax, const size_t flags)
 {
+  const size_t type = flags & GSL_SPMATRIX_TYPEMASK;
   gsl_spmatrix *m;
 
   if (n1 == 0)
@@ -90,7 +93,7 @@ gsl_spmatrix_alloc_nzmax(const size_t n1, const size_t n2,
   m->size2 = n2;
   m->nz = 0;
   m->nzmax = GSL_MAX(nzmax, 1);
-  m->flags = flags;
+  m->flags = type;
 
   m->i = malloc(m->nzmax * sizeof(size_t));
   if (!m->i)
@@ -100,7 +103,7 @@ gsl_spmatrix_alloc_nzmax(const size_t n1, const size_t n2,
                     GSL_ENOMEM, 0);
     }
 
-  if (flags == GSL_SPMATRIX_TRIPLET)
+  if (type == GSL_SPMATRIX_TRIPLET)
     {
       m->p = malloc(m->nzmax * sizeof(size_t));
       if (!m->p)
@@ -110,7 +113,7 @@ gsl_spmatrix_alloc_nzmax(const size_t n1, const size_t n2,
                         GSL_ENOMEM, 0);
         }
     }
-  else if (flags == GSL_SPMATRIX_CCS)
+  else if (type == GSL_SPMATRIX_CCS)
     {
       m->p = malloc((n2 + 1) * sizeof(size_t));
       m->work = malloc(GSL_MAX(n1, n2) * sizeof(size_t));
@@ -121,6 +124,17 @@ gsl_spmatrix_alloc_nzmax(const size_t n1, const size_t n2,
                         GSL_ENOMEM, 0);
         }
     }
+  else if (type == GSL_SPMATRIX_CRS)
+    {
+      m->p = malloc((n1 + 1) * sizeof(size_t));
+      m->work = malloc(GSL_MAX(n1, n2) * sizeof(size_t));
+      if (!m->p || !m->work)
+        {
+          gsl_spmatrix_free(m);
+          GSL_ERROR_VAL("failed to allocate space for row pointers",
+                        GSL_ENOMEM, 0);
+        }
+    }
 
   m->data = malloc(m->nzmax * sizeof(double));
   if (!m->data)
@@ -141,18 +155,30 @@ gsl_spmatrix_free()
 void
 gsl_spmatrix_free(gsl_spmatrix *m)
 {
-  if (m->i)
-    free(m->i);
+  if (GSLSP_ISREADONLY(m))
+    {
+      /* i, p and data belong to the file mapping */
+      if (m->map)
+        spio_unmap(m);
+    }
+  else
+    {
+      if (m->i)
+        free(m->i);
 
-  if (m->p)
-    free(m->p);
+      if (m->p)
+        free(m->p);
 
-  if (m->data)
-    free(m->data);
+      if (m->data)
+        free(m->data);
+    }
 
   if (m->work)
     free(m->work);
 
+  if (m->hash)
+    free(m->hash);
+
   free(m);
 } /* gsl_spmatrix_free() */
 
@@ -169,7 +195,11 @@ gsl_spmatrix_realloc(const size_t nzmax, gsl_spmatrix *m)
   int s = GSL_SUCCESS;
   void *ptr;
 
-  if (nzmax < m->nz)
+  if (GSLSP_ISREADONLY(m))
+    {
+      GSL_ERROR("matrix is read-only", GSL_EINVAL);
+    }
+  else if (nzmax < m->nz)
     {
       GSL_ERROR("new nzmax is less than current nz", GSL_EINVAL);
     }
@@ -203,6 +233,12 @@ gsl_spmatrix_realloc(const size_t nzmax, gsl_spmatrix *m)
 
   m->nzmax = nzmax;
 
+  if (GSLSP_ISTRIPLET(m))
+    {
+      /* grow an active hash table to match the new nzmax */
+      s = gsl_spmatrix_hash_rebuild(m);
+    }
+
   return s;
 } /* gsl_spmatrix_realloc() */
 
@@ -211,10 +247,18 @@ gsl_spmatrix_set_zero(gsl_spmatrix *m)
 {
   int s = GSL_SUCCESS;
 
+  if (GSLSP_ISREADONLY(m))
+    {
+      GSL_ERROR("matrix is read-only", GSL_EINVAL);
+    }
+
   m->nz = 0;
   m->size1 = 1;
   m->size2 = 1;
 
+  if (GSLSP_ISTRIPLET(m))
+    s = gsl_spmatrix_hash_rebuild(m);
+
   return s;
 } /* gsl_spmatrix_set_zero() */
 
@@ -224,11 +268,51 @@ gsl_spmatrix_nnz(const gsl_spmatrix *m)
   return m->nz;
 } /* gsl_spmatrix_nnz() */
 
-int
-gsl_spmatrix_fprintf(FILE *stream, const gsl_spmatrix *m,
-                     const char *format)
+/*
+gsl_spmatrix_workspace_alloc()
+  Allocate a workspace for the _w variants of the dgemm, add,
+transpose and compress routines
+
+Inputs: n - maximum dimension of the matrices the workspace will
+            be used with
+
+Return: pointer to new workspace (should be freed with
+        gsl_spmatrix_workspace_free)
+*/
+
+gsl_spmatrix_workspace *
+gsl_spmatrix_workspace_alloc(const size_t n)
 {
-  int s = 0;
+  gsl_spmatrix_workspace *work;
 
-  return s;
-} /* gsl_spmatrix_fprintf() */
+  work = calloc(1, sizeof(gsl_spmatrix_workspace));
+  if (!work)
+    {
+      GSL_ERROR_NULL("failed to allocate space for workspace struct",
+                     GSL_ENOMEM);
+    }
+
+  work->iwork = malloc(GSL_MAX(n, 1) * sizeof(size_t));
+  work->dwork = malloc(GSL_MAX(n, 1) * sizeof(double));
+  if (!work->iwork || !work->dwork)
+    {
+      gsl_spmatrix_workspace_free(work);
+      GSL_ERROR_NULL("failed to allocate space for workspace", GSL_ENOMEM);
+    }
+
+  work->n = n;
+
+  return work;
+} /* gsl_spmatrix_workspace_alloc() */
+
+void
+gsl_spmatrix_workspace_free(gsl_spmatrix_workspace *work)
+{
+  if (work->iwork)
+    free(work->iwork);
+
+  if (work->dwork)
+    free(work->dwork);
+
+  free(work);
+} /* gsl_spmatrix_workspace_free() */
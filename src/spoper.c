@@ -30,12 +30,19 @@
 int
 gsl_spmatrix_scale(gsl_spmatrix *m, const double x)
 {
-  size_t i;
+  if (GSLSP_ISREADONLY(m))
+    {
+      GSL_ERROR("matrix is read-only", GSL_EINVAL);
+    }
+  else
+    {
+      size_t i;
 
-  for (i = 0; i < m->nz; ++i)
-    m->data[i] *= x;
+      for (i = 0; i < m->nz; ++i)
+        m->data[i] *= x;
 
-  return GSL_SUCCESS;
+      return GSL_SUCCESS;
+    }
 } /* gsl_spmatrix_scale() */
 
 int
@@ -75,13 +82,55 @@ gsl_spmatrix_add()
 
 Inputs: a - (input) sparse matrix
         b - (input) sparse matrix
-        c - (output) a + b
 
-Return: success or error
+Return: a + b (should be freed when finished with it)
+
+Notes:
+1) A temporary workspace is allocated for the call; use
+gsl_spmatrix_add_w() to supply one instead
 */
 
 gsl_spmatrix *
 gsl_spmatrix_add(const gsl_spmatrix *a, const gsl_spmatrix *b)
+{
+  gsl_spmatrix_workspace *work;
+  gsl_spmatrix *c;
+
+  work = gsl_spmatrix_workspace_alloc(GSL_MAX(a->size1, a->size2));
+  if (!work)
+    return NULL;
+
+  c = gsl_spmatrix_add_w(a, b, work);
+
+  gsl_spmatrix_workspace_free(work);
+
+  return c;
+} /* gsl_spmatrix_add() */
+
+/*
+gsl_spmatrix_add_w()
+  Add two sparse matrices using a caller-supplied workspace
+
+Inputs: a    - (input) sparse matrix
+        b    - (input) sparse matrix
+        work - workspace of size at least MAX(size1, size2)
+
+Return: a + b (should be freed when finished with it)
+
+Notes:
+1) The inputs are not modified in any way, so several threads may
+add the same matrices concurrently with separate workspaces. The only
+memory allocated is the result
+
+2) If a and b both have symmetric storage (GSL_SPMATRIX_SYMMETRIC), the
+sum of their lower triangles is the lower triangle of a + b, which is
+returned with symmetric storage. A symmetric matrix cannot be added to
+a general one, since only half of its elements are stored
+*/
+
+gsl_spmatrix *
+gsl_spmatrix_add_w(const gsl_spmatrix *a, const gsl_spmatrix *b,
+                   gsl_spmatrix_workspace *work)
 {
   const size_t M = a->size1;
   const size_t N = a->size2;
@@ -90,19 +139,34 @@ gsl_spmatrix_add(const gsl_spmatrix *a, const gsl_spmatrix *b)
     {
       GSL_ERROR_NULL("matrices must have same dimensions", GSL_EBADLEN);
     }
-  else if (a->flags != b->flags)
+  else if (GSLSP_TYPE(a) != GSLSP_TYPE(b))
     {
       GSL_ERROR_NULL("matrices must have same sparse storage format", GSL_EINVAL);
     }
+  else if (GSLSP_ISSYMMETRIC(a) != GSLSP_ISSYMMETRIC(b))
+    {
+      GSL_ERROR_NULL("matrices must both have symmetric storage or neither",
+                     GSL_EINVAL);
+    }
   else if (GSLSP_ISTRIPLET(a))
     {
       GSL_ERROR_NULL("triplet format not yet supported", GSL_EINVAL);
     }
+  else if (work->n < GSL_MAX(M, N))
+    {
+      GSL_ERROR_NULL("workspace is too small", GSL_EBADLEN);
+    }
   else
     {
+      /*
+       * for compressed row storage the same algorithm is applied
+       * to the rows instead of the columns
+       */
+      const size_t nouter = GSLSP_ISCRS(a) ? M : N;
+      const size_t ninner = GSLSP_ISCRS(a) ? N : M;
       gsl_spmatrix *c;
-      size_t *w = a->work;
-      double *x = malloc(M * sizeof(double));
+      size_t *w = work->iwork;
+      double *x = work->dwork;
       size_t *Cp, *Ci;
       double *Cd;
       size_t j, p;
@@ -114,15 +178,18 @@ gsl_spmatrix_add(const gsl_spmatrix *a, const gsl_spmatrix *b)
           GSL_ERROR_NULL("failed to allocate space for c matrix", GSL_ENOMEM);
         }
 
+      /* the sum of two symmetric matrices is stored by its lower triangle */
+      c->flags |= a->flags & b->flags & GSL_SPMATRIX_SYMMETRIC;
+
       /* initialize w = 0 */
-      for (j = 0; j < M; ++j)
+      for (j = 0; j < ninner; ++j)
         w[j] = 0;
 
       Ci = c->i;
       Cp = c->p;
       Cd = c->data;
 
-      for (j = 0; j < N; ++j)
+      for (j = 0; j < nouter; ++j)
         {
           Cp[j] = nz;
 
@@ -137,14 +204,12 @@ gsl_spmatrix_add(const gsl_spmatrix *a, const gsl_spmatrix *b)
         }
 
       /* finalize last column of c */
-      Cp[N] = nz;
+      Cp[nouter] = nz;
       c->nz = nz;
 
-      free(x);
-
       return c;
     }
-} /* gsl_spmatrix_add() */
+} /* gsl_spmatrix_add_w() */
 
 /*
 gsl_spmatrix_d2sp()
@@ -0,0 +1,696 @@
+/* sporder.c
+ *
+ * Copyright (C) 2012-2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_permutation.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+
+/*
+ * The code in this module computes symmetric orderings of a square
+ * sparse matrix from the graph of A + A^T: reverse Cuthill-McKee, which
+ * reduces the bandwidth, and approximate minimum degree, which reduces
+ * the fill-in of a Cholesky or LU factorization. The result is a
+ * permutation p for gsl_spmatrix_permute(A, p, p)
+ *
+ * References:
+ *
+ * [1] George, A. and Liu, J. W. H., Computer Solution of Large Sparse
+ *     Positive Definite Systems, Prentice-Hall, 1981
+ *
+ * [2] Amestoy, P. R., Davis, T. A. and Duff, I. S., An approximate
+ *     minimum degree ordering algorithm, SIAM J. Matrix Anal. Appl.,
+ *     17, 1996
+ */
+
+/* marker for empty lists */
+#define ORDER_NONE    ((size_t) -1)
+
+/* status of a node during minimum degree ordering */
+#define AMD_VARIABLE  0
+#define AMD_ELEMENT   1
+#define AMD_DEAD      2
+
+static int order_graph(const gsl_spmatrix *A, size_t **gp, size_t **gi);
+static size_t rcm_levels(const size_t *gp, const size_t *gi,
+                         const size_t root, size_t *mark, const size_t stamp,
+                         size_t *queue, size_t *nvisit, size_t *last);
+
+/*
+gsl_spmatrix_rcm()
+  Compute the reverse Cuthill-McKee ordering of a square matrix
+
+Inputs: A - square sparse matrix in compressed format (CCS or CRS)
+        p - (output) permutation of length A->size1
+
+Return: success or error
+
+Notes:
+1) Each connected component of the graph of A + A^T is ordered by a
+breadth first search, visiting the neighbours of each node by increasing
+degree, started from a pseudo-peripheral node: the search is restarted
+from a node of minimum degree in the last level as long as the number of
+levels increases [1, Sec. 4.3]. The complete ordering is then reversed
+*/
+
+int
+gsl_spmatrix_rcm(const gsl_spmatrix *A, gsl_permutation *p)
+{
+  const size_t n = A->size1;
+
+  if (n != A->size2)
+    {
+      GSL_ERROR("matrix must be square", GSL_ENOTSQR);
+    }
+  else if (p->size != n)
+    {
+      GSL_ERROR("permutation length does not match matrix", GSL_EBADLEN);
+    }
+  else if (!GSLSP_ISCCS(A) && !GSLSP_ISCRS(A))
+    {
+      GSL_ERROR("matrix must be in compressed format", GSL_EINVAL);
+    }
+  else
+    {
+      size_t *gp, *gi, *mark, *perm = p->data;
+      size_t stamp = 0, start = 0, k = 0;
+      int status;
+
+      status = order_graph(A, &gp, &gi);
+      if (status)
+        {
+          GSL_ERROR("failed to allocate space for graph", status);
+        }
+
+      mark = calloc(GSL_MAX(n, 1), sizeof(size_t));
+      if (!mark)
+        {
+          free(gp);
+          free(gi);
+          GSL_ERROR("failed to allocate space for rcm", GSL_ENOMEM);
+        }
+
+      /*
+       * perm[k..] is used as the search queue; mark[i] == stamp
+       * marks nodes reached by the current search, and mark[i] ==
+       * ORDER_NONE nodes already in the ordering
+       */
+      while (k < n)
+        {
+          size_t root, last, nlev, ncomp, i, q;
+
+          while (mark[start] == ORDER_NONE)
+            ++start;
+
+          /* node of minimum degree in the component of start */
+          rcm_levels(gp, gi, start, mark, ++stamp, perm + k, &ncomp, &last);
+          for (i = 0, root = start; i < ncomp; ++i)
+            {
+              const size_t v = perm[k + i];
+
+              if (gp[v + 1] - gp[v] < gp[root + 1] - gp[root])
+                root = v;
+            }
+
+          /* pseudo-peripheral node */
+          nlev = rcm_levels(gp, gi, root, mark, ++stamp, perm + k, &ncomp,
+                            &last);
+          for (;;)
+            {
+              size_t x = perm[k + last], nlev2;
+
+              for (i = last; i < ncomp; ++i)
+                {
+                  const size_t v = perm[k + i];
+
+                  if (gp[v + 1] - gp[v] < gp[x + 1] - gp[x])
+                    x = v;
+                }
+
+              nlev2 = rcm_levels(gp, gi, x, mark, ++stamp, perm + k, &ncomp,
+                                 &last);
+              if (nlev2 <= nlev)
+                break;
+
+              root = x;
+              nlev = nlev2;
+            }
+
+          /* Cuthill-McKee search from root */
+          perm[k] = root;
+          mark[root] = ORDER_NONE;
+          for (q = k, i = k + 1; q < i; ++q)
+            {
+              const size_t v = perm[q];
+              const size_t first = i;
+              size_t r;
+
+              for (r = gp[v]; r < gp[v + 1]; ++r)
+                {
+                  if (mark[gi[r]] != ORDER_NONE)
+                    {
+                      mark[gi[r]] = ORDER_NONE;
+                      perm[i++] = gi[r];
+                    }
+                }
+
+              /* sort the new nodes by increasing degree */
+              for (r = first + 1; r < i; ++r)
+                {
+                  const size_t u = perm[r];
+                  const size_t du = gp[u + 1] - gp[u];
+                  size_t t = r;
+
+                  while (t > first && gp[perm[t - 1] + 1] - gp[perm[t - 1]] > du)
+                    {
+                      perm[t] = perm[t - 1];
+                      --t;
+                    }
+
+                  perm[t] = u;
+                }
+            }
+
+          k += ncomp;
+        }
+
+      /* reverse */
+      for (k = 0; k < n / 2; ++k)
+        {
+          size_t tmp = perm[k];
+          perm[k] = perm[n - 1 - k];
+          perm[n - 1 - k] = tmp;
+        }
+
+      free(gp);
+      free(gi);
+      free(mark);
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_spmatrix_rcm() */
+
+/*
+gsl_spmatrix_amd()
+  Compute an approximate minimum degree ordering of a square matrix
+
+Inputs: A - square sparse matrix in compressed format (CCS or CRS)
+        p - (output) permutation of length A->size1
+
+Return: success or error
+
+Notes:
+1) The elimination is simulated on the quotient graph: when a node p
+is eliminated, it becomes an element whose list L_p holds the uneliminated
+nodes adjacent to p directly or through the elements adjacent to p, and
+those elements are absorbed into p. The graph therefore never needs more
+storage than A + A^T plus the current element lists
+
+2) The degree of each node i in L_p is not computed exactly, but bounded
+as in [2] by
+
+d_i = min(n - k, d_i + |L_p \ i|, |A_i| + |L_p \ i| + sum_e |L_e \ L_p|)
+
+where the sum is over the other elements e adjacent to i, and the sizes
+|L_e \ L_p| are computed for all e at once by scanning the element lists
+of the nodes in L_p. Elements with |L_e \ L_p| = 0 are absorbed into p
+
+3) Nodes are kept in lists by degree, and the next pivot is taken from
+the list of smallest degree. Indistinguishable nodes are not merged into
+supervariables, so each node is eliminated separately
+*/
+
+int
+gsl_spmatrix_amd(const gsl_spmatrix *A, gsl_permutation *p)
+{
+  const size_t n = A->size1;
+
+  if (n != A->size2)
+    {
+      GSL_ERROR("matrix must be square", GSL_ENOTSQR);
+    }
+  else if (p->size != n)
+    {
+      GSL_ERROR("permutation length does not match matrix", GSL_EBADLEN);
+    }
+  else if (!GSLSP_ISCCS(A) && !GSLSP_ISCRS(A))
+    {
+      GSL_ERROR("matrix must be in compressed format", GSL_EINVAL);
+    }
+  else
+    {
+      size_t *gp, *gi;
+      size_t *alen, *deg, *head, *next, *prev, *status, *mark, *wmark;
+      size_t *elen, *ecap, *lelen, *w, *tmp;
+      size_t **elist, **le;
+      size_t mindeg = 0, stamp = 0, k, i;
+      int s;
+
+      s = order_graph(A, &gp, &gi);
+      if (s)
+        {
+          GSL_ERROR("failed to allocate space for graph", s);
+        }
+
+      alen = malloc(GSL_MAX(n, 1) * sizeof(size_t));
+      deg = malloc(GSL_MAX(n, 1) * sizeof(size_t));
+      head = malloc((n + 1) * sizeof(size_t));
+      next = malloc(GSL_MAX(n, 1) * sizeof(size_t));
+      prev = malloc(GSL_MAX(n, 1) * sizeof(size_t));
+      status = calloc(GSL_MAX(n, 1), sizeof(size_t));
+      mark = calloc(GSL_MAX(n, 1), sizeof(size_t));
+      wmark = calloc(GSL_MAX(n, 1), sizeof(size_t));
+      elen = calloc(GSL_MAX(n, 1), sizeof(size_t));
+      ecap = calloc(GSL_MAX(n, 1), sizeof(size_t));
+      lelen = calloc(GSL_MAX(n, 1), sizeof(size_t));
+      w = malloc(GSL_MAX(n, 1) * sizeof(size_t));
+      tmp = malloc(GSL_MAX(n, 1) * sizeof(size_t));
+      elist = calloc(GSL_MAX(n, 1), sizeof(size_t *));
+      le = calloc(GSL_MAX(n, 1), sizeof(size_t *));
+      if (!alen || !deg || !head || !next || !prev || !status || !mark ||
+          !wmark || !elen || !ecap || !lelen || !w || !tmp || !elist || !le)
+        s = GSL_ENOMEM;
+
+      if (!s)
+        {
+          for (i = 0; i <= n; ++i)
+            head[i] = ORDER_NONE;
+
+          /* insert in reverse order so ties are broken by lowest index */
+          for (i = n; i-- > 0; )
+            {
+              alen[i] = gp[i + 1] - gp[i];
+              deg[i] = alen[i];
+              prev[i] = ORDER_NONE;
+              next[i] = head[deg[i]];
+              if (next[i] != ORDER_NONE)
+                prev[next[i]] = i;
+              head[deg[i]] = i;
+              mindeg = GSL_MIN(mindeg, deg[i]);
+            }
+        }
+
+      for (k = 0; k < n && !s; ++k)
+        {
+          size_t piv, nlp = 0, r, e, t;
+
+          /* remove the node of minimum degree from its list */
+          while (head[mindeg] == ORDER_NONE)
+            ++mindeg;
+
+          piv = head[mindeg];
+          head[mindeg] = next[piv];
+          if (next[piv] != ORDER_NONE)
+            prev[next[piv]] = ORDER_NONE;
+
+          p->data[k] = piv;
+
+          /* L_p = (A_p u L_e for e in E_p) \ p, absorbing the elements */
+          mark[piv] = ++stamp;
+          for (r = gp[piv]; r < gp[piv] + alen[piv]; ++r)
+            {
+              const size_t j = gi[r];
+
+              if (status[j] == AMD_VARIABLE && mark[j] != stamp)
+                {
+                  mark[j] = stamp;
+                  tmp[nlp++] = j;
+                }
+            }
+
+          for (r = 0; r < elen[piv]; ++r)
+            {
+              e = elist[piv][r];
+              if (status[e] != AMD_ELEMENT)
+                continue;
+
+              for (t = 0; t < lelen[e]; ++t)
+                {
+                  const size_t j = le[e][t];
+
+                  if (j != piv && mark[j] != stamp)
+                    {
+                      mark[j] = stamp;
+                      tmp[nlp++] = j;
+                    }
+                }
+
+              status[e] = AMD_DEAD;
+              free(le[e]);
+              le[e] = NULL;
+            }
+
+          free(elist[piv]);
+          elist[piv] = NULL;
+          elen[piv] = ecap[piv] = 0;
+          alen[piv] = 0;
+          status[piv] = AMD_DEAD;
+
+          if (nlp == 0)
+            continue;
+
+          le[piv] = malloc(nlp * sizeof(size_t));
+          if (!le[piv])
+            {
+              s = GSL_ENOMEM;
+              break;
+            }
+
+          for (r = 0; r < nlp; ++r)
+            le[piv][r] = tmp[r];
+
+          lelen[piv] = nlp;
+          status[piv] = AMD_ELEMENT;
+
+          /* update the adjacency of each i in L_p */
+          for (r = 0; r < nlp && !s; ++r)
+            {
+              const size_t v = tmp[r];
+              size_t q, m;
+
+              /* remove from degree list */
+              if (prev[v] != ORDER_NONE)
+                next[prev[v]] = next[v];
+              else
+                head[deg[v]] = next[v];
+              if (next[v] != ORDER_NONE)
+                prev[next[v]] = prev[v];
+
+              /* E_i = (E_i \ absorbed elements) u p */
+              for (q = 0, m = 0; q < elen[v]; ++q)
+                {
+                  if (status[elist[v][q]] == AMD_ELEMENT)
+                    elist[v][m++] = elist[v][q];
+                }
+
+              elen[v] = m;
+              if (elen[v] == ecap[v])
+                {
+                  size_t newcap = 2 * ecap[v] + 4;
+                  size_t *ptr = realloc(elist[v], newcap * sizeof(size_t));
+
+                  if (!ptr)
+                    {
+                      s = GSL_ENOMEM;
+                      break;
+                    }
+
+                  elist[v] = ptr;
+                  ecap[v] = newcap;
+                }
+
+              elist[v][elen[v]++] = piv;
+
+              /* A_i = A_i \ (L_p u p), now connected through element p */
+              for (q = gp[v], m = gp[v]; q < gp[v] + alen[v]; ++q)
+                {
+                  const size_t j = gi[q];
+
+                  if (status[j] == AMD_VARIABLE && mark[j] != stamp)
+                    gi[m++] = j;
+                }
+
+              alen[v] = m - gp[v];
+            }
+
+          if (s)
+            break;
+
+          /* w(e) = |L_e \ L_p| for the elements e adjacent to L_p */
+          for (r = 0; r < nlp; ++r)
+            {
+              const size_t v = tmp[r];
+              size_t q;
+
+              for (q = 0; q < elen[v]; ++q)
+                {
+                  e = elist[v][q];
+                  if (e == piv || status[e] != AMD_ELEMENT)
+                    continue;
+
+                  if (wmark[e] != stamp)
+                    {
+                      wmark[e] = stamp;
+                      w[e] = lelen[e];
+                    }
+
+                  w[e]--;
+                }
+            }
+
+          /* approximate degrees */
+          for (r = 0; r < nlp; ++r)
+            {
+              const size_t v = tmp[r];
+              size_t d = alen[v] + nlp - 1, q, m;
+
+              for (q = 0, m = 0; q < elen[v]; ++q)
+                {
+                  e = elist[v][q];
+                  if (status[e] != AMD_ELEMENT)
+                    continue;
+
+                  if (e != piv && w[e] == 0)
+                    {
+                      /* L_e is a subset of L_p: absorb e into p */
+                      status[e] = AMD_DEAD;
+                      free(le[e]);
+                      le[e] = NULL;
+                      continue;
+                    }
+
+                  if (e != piv)
+                    d += w[e];
+
+                  elist[v][m++] = e;
+                }
+
+              elen[v] = m;
+
+              d = GSL_MIN(d, deg[v] + nlp - 1);
+              d = GSL_MIN(d, n - k - 2);
+              deg[v] = d;
+
+              prev[v] = ORDER_NONE;
+              next[v] = head[d];
+              if (next[v] != ORDER_NONE)
+                prev[next[v]] = v;
+              head[d] = v;
+              mindeg = GSL_MIN(mindeg, d);
+            }
+        }
+
+      if (elist && le)
+        {
+          for (i = 0; i < n; ++i)
+            {
+              free(elist[i]);
+              free(le[i]);
+            }
+        }
+
+      free(gp);
+      free(gi);
+      free(alen);
+      free(deg);
+      free(head);
+      free(next);
+      free(prev);
+      free(status);
+      free(mark);
+      free(wmark);
+      free(elen);
+      free(ecap);
+      free(lelen);
+      free(w);
+      free(tmp);
+      free(elist);
+      free(le);
+
+      if (s)
+        {
+          GSL_ERROR("failed to allocate space for amd", s);
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_spmatrix_amd() */
+
+/*
+order_graph()
+  Build the adjacency structure of the graph of A + A^T, without the
+diagonal and without duplicate edges
+
+Inputs: A  - square compressed matrix
+        gp - (output) pointers, size n + 1
+        gi - (output) adjacent nodes of node i in gi[gp[i]..gp[i+1]-1]
+
+Return: success or GSL_ENOMEM
+
+Notes:
+1) The graph is the same whether the arrays of A are read as CCS or
+CRS, so both formats are handled identically
+*/
+
+static int
+order_graph(const gsl_spmatrix *A, size_t **gp, size_t **gi)
+{
+  const size_t n = A->size1;
+  size_t *Gp, *Gi, *mark;
+  size_t j, r, nz, start;
+
+  Gp = malloc((n + 1) * sizeof(size_t));
+  Gi = malloc(GSL_MAX(2 * A->nz, 1) * sizeof(size_t));
+  mark = malloc((n + 1) * sizeof(size_t));
+  if (!Gp || !Gi || !mark)
+    {
+      free(Gp);
+      free(Gi);
+      free(mark);
+      return GSL_ENOMEM;
+    }
+
+  for (j = 0; j < n; ++j)
+    Gp[j] = 0;
+
+  for (j = 0; j < n; ++j)
+    {
+      for (r = A->p[j]; r < A->p[j + 1]; ++r)
+        {
+          if (A->i[r] != j)
+            {
+              Gp[A->i[r]]++;
+              Gp[j]++;
+            }
+        }
+    }
+
+  gsl_spmatrix_cumsum(n, Gp);
+
+  for (j = 0; j < n; ++j)
+    mark[j] = Gp[j];
+
+  for (j = 0; j < n; ++j)
+    {
+      for (r = A->p[j]; r < A->p[j + 1]; ++r)
+        {
+          const size_t i = A->i[r];
+
+          if (i != j)
+            {
+              Gi[mark[i]++] = j;
+              Gi[mark[j]++] = i;
+            }
+        }
+    }
+
+  /* remove duplicate edges, compacting the lists in place */
+  for (j = 0; j < n; ++j)
+    mark[j] = ORDER_NONE;
+
+  for (j = 0, nz = 0, start = 0; j < n; ++j)
+    {
+      const size_t end = Gp[j + 1];
+
+      Gp[j] = nz;
+
+      for (r = start; r < end; ++r)
+        {
+          if (mark[Gi[r]] != j)
+            {
+              mark[Gi[r]] = j;
+              Gi[nz++] = Gi[r];
+            }
+        }
+
+      start = end;
+    }
+
+  Gp[n] = nz;
+
+  free(mark);
+
+  *gp = Gp;
+  *gi = Gi;
+
+  return GSL_SUCCESS;
+} /* order_graph() */
+
+/*
+rcm_levels()
+  Breadth first search from root, storing the visited nodes in queue
+
+Inputs: gp    - graph pointers
+        gi    - graph adjacency
+        root  - starting node
+        mark  - node markers; nodes with mark[i] == stamp or ORDER_NONE
+                are not visited
+        stamp - marker for this search
+        queue - (output) visited nodes in order
+        nvisit - (output) number of visited nodes
+        last  - (output) position in queue of the first node of the
+                last level
+
+Return: number of levels
+*/
+
+static size_t
+rcm_levels(const size_t *gp, const size_t *gi, const size_t root,
+           size_t *mark, const size_t stamp, size_t *queue, size_t *nvisit,
+           size_t *last)
+{
+  size_t head = 0, tail = 1, nlev = 0;
+
+  queue[0] = root;
+  mark[root] = stamp;
+
+  while (head < tail)
+    {
+      const size_t end = tail;
+
+      *last = head;
+      ++nlev;
+
+      for (; head < end; ++head)
+        {
+          const size_t v = queue[head];
+          size_t r;
+
+          for (r = gp[v]; r < gp[v + 1]; ++r)
+            {
+              const size_t u = gi[r];
+
+              if (mark[u] != stamp && mark[u] != ORDER_NONE)
+                {
+                  mark[u] = stamp;
+                  queue[tail++] = u;
+                }
+            }
+        }
+    }
+
+  *nvisit = tail;
+
+  return nlev;
+} /* rcm_levels() */
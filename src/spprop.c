@@ -37,10 +37,14 @@ gsl_spmatrix_equal(const gsl_spmatrix *a, const gsl_spmatrix *b)
     {
       GSL_ERROR_VAL("matrices must have same dimensions", GSL_EBADLEN, 0);
     }
-  else if (a->flags != b->flags)
+  else if (GSLSP_TYPE(a) != GSLSP_TYPE(b))
     {
       GSL_ERROR_VAL("trying to compare different sparse matrix types", GSL_EINVAL, 0);
     }
+  else if (GSLSP_ISSYMMETRIC(a) != GSLSP_ISSYMMETRIC(b))
+    {
+      GSL_ERROR_VAL("trying to compare symmetric and general storage", GSL_EINVAL, 0);
+    }
   else
     {
       const size_t nz = a->nz;
@@ -63,25 +67,50 @@ gsl_spmatrix_equal(const gsl_spmatrix *a, const gsl_spmatrix *b)
                 return 0;
             }
         }
-      else if (GSLSP_ISCCS(a))
+      else if (GSLSP_ISCCS(a) || GSLSP_ISCRS(a))
         {
-          /*
-           * for compressed column, both matrices should have everything
-           * in the same order
-           */
+          /* number of column pointers (CCS) or row pointers (CRS) */
+          const size_t nouter = GSLSP_ISCCS(a) ? N : M;
 
-          /* check row indices and data */
-          for (n = 0; n < nz; ++n)
+          /* check column (or row) pointers */
+          for (n = 0; n < nouter + 1; ++n)
             {
-              if ((a->i[n] != b->i[n]) || (a->data[n] != b->data[n]))
+              if (a->p[n] != b->p[n])
                 return 0;
             }
 
-          /* check column pointers */
-          for (n = 0; n < a->size2 + 1; ++n)
+          if (GSLSP_ISSORTED(a) && GSLSP_ISSORTED(b))
             {
-              if (a->p[n] != b->p[n])
-                return 0;
+              /*
+               * both matrices have their indices in the same order,
+               * so the arrays can be compared directly
+               */
+              for (n = 0; n < nz; ++n)
+                {
+                  if ((a->i[n] != b->i[n]) || (a->data[n] != b->data[n]))
+                    return 0;
+                }
+            }
+          else
+            {
+              /*
+               * the indices within a column (row) may be stored in
+               * a different order, so look up each aij in b
+               */
+              size_t j;
+
+              for (j = 0; j < nouter; ++j)
+                {
+                  for (n = a->p[j]; n < a->p[j + 1]; ++n)
+                    {
+                      double bij = GSLSP_ISCCS(a) ?
+                                   gsl_spmatrix_get(b, a->i[n], j) :
+                                   gsl_spmatrix_get(b, j, a->i[n]);
+
+                      if (a->data[n] != bij)
+                        return 0;
+                    }
+                }
             }
         }
       else
@@ -0,0 +1,600 @@
+/* spsell.c
+ *
+ * Copyright (C) 2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+
+/*
+ * The SIMD kernels are compiled with function target attributes and
+ * selected at run time, so the library itself needs no special
+ * compiler flags
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SELL_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+/* largest supported chunk height */
+#define SELL_MAXC           64
+
+/* sort key of a row */
+typedef struct
+{
+  size_t len;
+  size_t row;
+} sell_row;
+
+/* computes the C sums of chunk c into t */
+typedef void sell_kernel(const gsl_spmatrix_sell *A, const size_t c,
+                         const double *x, const size_t incX, double *t);
+
+/* instruction set selected with gsl_spblas_sell_set_simd(), or -1 */
+static int sell_simd = -1;
+
+static size_t sell_detect(void);
+static int sell_compare(const void *a, const void *b);
+static void sell_chunk(const gsl_spmatrix_sell *A, const size_t c,
+                       const double *x, const size_t incX, double *t);
+#ifdef SELL_HAVE_X86
+static void sell_chunk_avx2(const gsl_spmatrix_sell *A, const size_t c,
+                            const double *x, const size_t incX, double *t);
+static void sell_chunk_avx512(const gsl_spmatrix_sell *A, const size_t c,
+                              const double *x, const size_t incX, double *t);
+#endif
+static void sell_update(const gsl_spmatrix_sell *A, const size_t c,
+                        const double alpha, const double *t,
+                        const double beta, double *Y, const size_t incY);
+
+/*
+gsl_spmatrix_sell_alloc()
+  Create a SELL-C-sigma matrix from a sparse matrix
+
+Inputs: A     - sparse matrix in triplet, CCS or CRS format, without
+                symmetric storage
+        C     - chunk height, 1 <= C <= 64; a multiple of 8 allows the
+                AVX-512 kernel and a multiple of 4 the AVX2 kernel
+        sigma - sorting window, >= 1; rows are sorted by decreasing
+                length within consecutive windows of sigma rows.
+                sigma = 1 keeps the original order, sigma >= size1
+                sorts all rows
+
+Return: pointer to new matrix, or NULL on error
+
+Notes:
+1) The rows are obtained in CRS order: a CRS matrix is used directly,
+a CCS matrix is transposed with gsl_spmatrix_transpose_memcpy(), whose
+arrays are the CRS arrays of A, and a triplet matrix is compressed
+with gsl_spmatrix_crs()
+
+2) Padding elements have value 0 and column index 0. The length of
+each stored row is kept in len, and the kernels skip the padding of a
+row, so x is only read at the columns of stored elements and
+non-finite elements of x propagate exactly as in gsl_spblas_dgemv()
+
+3) Column and row lengths are stored as int32_t for the SIMD gathers,
+so size2 must be less than 2^31
+*/
+
+gsl_spmatrix_sell *
+gsl_spmatrix_sell_alloc(const gsl_spmatrix *A, const size_t C,
+                        const size_t sigma)
+{
+  const size_t M = A->size1;
+  const size_t N = A->size2;
+
+  if (C == 0 || C > SELL_MAXC)
+    {
+      GSL_ERROR_NULL("chunk height C must be between 1 and 64", GSL_EINVAL);
+    }
+  else if (sigma == 0)
+    {
+      GSL_ERROR_NULL("sigma must be positive", GSL_EINVAL);
+    }
+  else if ((uint64_t) N > INT32_MAX)
+    {
+      GSL_ERROR_NULL("number of columns must be less than 2^31", GSL_EINVAL);
+    }
+  else if (GSLSP_ISSYMMETRIC(A))
+    {
+      GSL_ERROR_NULL("symmetric storage is not supported", GSL_EINVAL);
+    }
+  else
+    {
+      gsl_spmatrix *B = NULL;
+      const size_t *Rp, *Ri;
+      const double *Rd;
+      gsl_spmatrix_sell *m;
+      sell_row *rows;
+      size_t c, k, r, w;
+
+      if (GSLSP_ISCRS(A))
+        {
+          Rp = A->p;
+          Ri = A->i;
+          Rd = A->data;
+        }
+      else
+        {
+          B = GSLSP_ISCCS(A) ? gsl_spmatrix_transpose_memcpy(A) :
+                               gsl_spmatrix_crs(A);
+          if (!B)
+            return NULL;
+
+          Rp = B->p;
+          Ri = B->i;
+          Rd = B->data;
+        }
+
+      m = calloc(1, sizeof(gsl_spmatrix_sell));
+      rows = malloc(M * sizeof(sell_row));
+      if (!m || !rows)
+        {
+          free(m);
+          free(rows);
+          if (B)
+            gsl_spmatrix_free(B);
+          GSL_ERROR_NULL("failed to allocate space for SELL matrix",
+                         GSL_ENOMEM);
+        }
+
+      m->size1 = M;
+      m->size2 = N;
+      m->C = C;
+      m->sigma = sigma;
+      m->nchunks = (M + C - 1) / C;
+      m->nz = Rp[M];
+
+      /* sort the rows of each window by decreasing length */
+      for (r = 0; r < M; ++r)
+        {
+          rows[r].len = Rp[r + 1] - Rp[r];
+          rows[r].row = r;
+        }
+
+      if (sigma > 1)
+        {
+          for (w = 0; w < M; w += sigma)
+            qsort(rows + w, GSL_MIN(sigma, M - w), sizeof(sell_row),
+                  sell_compare);
+        }
+
+      m->cptr = malloc((m->nchunks + 1) * sizeof(size_t));
+      m->perm = malloc(m->nchunks * C * sizeof(size_t));
+      m->len = malloc(m->nchunks * C * sizeof(int32_t));
+      if (!m->cptr || !m->perm || !m->len)
+        {
+          free(rows);
+          if (B)
+            gsl_spmatrix_free(B);
+          gsl_spmatrix_sell_free(m);
+          GSL_ERROR_NULL("failed to allocate space for SELL matrix",
+                         GSL_ENOMEM);
+        }
+
+      /* chunk widths are the lengths of their longest rows */
+      m->cptr[0] = 0;
+      for (c = 0; c < m->nchunks; ++c)
+        {
+          size_t width = 0;
+
+          for (r = c * C; r < GSL_MIN((c + 1) * C, M); ++r)
+            width = GSL_MAX(width, rows[r].len);
+
+          m->cptr[c + 1] = m->cptr[c] + width * C;
+        }
+
+      for (r = 0; r < m->nchunks * C; ++r)
+        {
+          m->perm[r] = (r < M) ? rows[r].row : M;
+          m->len[r] = (r < M) ? (int32_t) rows[r].len : 0;
+        }
+
+      free(rows);
+
+      m->col = malloc(GSL_MAX(m->cptr[m->nchunks], 1) * sizeof(int32_t));
+      m->val = malloc(GSL_MAX(m->cptr[m->nchunks], 1) * sizeof(double));
+      if (!m->col || !m->val)
+        {
+          if (B)
+            gsl_spmatrix_free(B);
+          gsl_spmatrix_sell_free(m);
+          GSL_ERROR_NULL("failed to allocate space for SELL matrix",
+                         GSL_ENOMEM);
+        }
+
+      for (c = 0; c < m->nchunks; ++c)
+        {
+          const size_t width = (m->cptr[c + 1] - m->cptr[c]) / C;
+
+          for (r = 0; r < C; ++r)
+            {
+              const size_t row = m->perm[c * C + r];
+              const size_t len = (size_t) m->len[c * C + r];
+
+              for (k = 0; k < width; ++k)
+                {
+                  const size_t idx = m->cptr[c] + k * C + r;
+
+                  if (k < len)
+                    {
+                      m->col[idx] = (int32_t) Ri[Rp[row] + k];
+                      m->val[idx] = Rd[Rp[row] + k];
+                    }
+                  else
+                    {
+                      m->col[idx] = 0;
+                      m->val[idx] = 0.0;
+                    }
+                }
+            }
+        }
+
+      if (B)
+        gsl_spmatrix_free(B);
+
+      return m;
+    }
+} /* gsl_spmatrix_sell_alloc() */
+
+/*
+gsl_spmatrix_sell_free()
+  Free a SELL-C-sigma matrix
+*/
+
+void
+gsl_spmatrix_sell_free(gsl_spmatrix_sell *m)
+{
+  if (m->cptr)
+    free(m->cptr);
+
+  if (m->perm)
+    free(m->perm);
+
+  if (m->len)
+    free(m->len);
+
+  if (m->col)
+    free(m->col);
+
+  if (m->val)
+    free(m->val);
+
+  free(m);
+} /* gsl_spmatrix_sell_free() */
+
+/*
+gsl_spblas_sell_dgemv()
+  Multiply a SELL-C-sigma matrix and a vector
+
+Inputs: alpha - scalar factor
+        A     - SELL-C-sigma matrix
+        x     - dense vector
+        beta  - scalar factor
+        y     - (input/output) dense vector
+
+Return: y = alpha*A*x + beta*y
+
+Notes:
+1) Each chunk is computed independently into C sums, which are then
+scattered to y through perm, so the chunks are divided between the
+threads (gsl_spblas_set_num_threads()) without any reduction, and the
+result does not depend on the number of threads
+
+2) The chunk kernel is the widest of the instruction sets selected
+with gsl_spblas_sell_set_simd() which divides C; the SIMD kernels
+gather x with 32 bit indices, so they require x to have unit stride.
+Otherwise the scalar kernel is used. The AVX2 and AVX-512 kernels use
+fused multiply-add, so their rounding errors may differ slightly from
+the scalar kernel, whose sums are accumulated in the same order as
+gsl_spblas_dgemv() for a CRS matrix
+*/
+
+int
+gsl_spblas_sell_dgemv(const double alpha, const gsl_spmatrix_sell *A,
+                      const gsl_vector *x, const double beta, gsl_vector *y)
+{
+  if (A->size2 != x->size)
+    {
+      GSL_ERROR("invalid length of x vector", GSL_EBADLEN);
+    }
+  else if (A->size1 != y->size)
+    {
+      GSL_ERROR("invalid length of y vector", GSL_EBADLEN);
+    }
+  else
+    {
+      const size_t simd = gsl_spblas_sell_get_simd();
+      const size_t nthreads = gsl_spblas_get_num_threads();
+      const double *X = x->data;
+      const size_t incX = x->stride;
+      double *Y = y->data;
+      const size_t incY = y->stride;
+      sell_kernel *kernel = sell_chunk;
+      long c;
+
+      if (alpha == 0.0)
+        {
+          size_t i;
+
+          for (i = 0; i < A->size1; ++i)
+            Y[i * incY] = (beta == 0.0) ? 0.0 : beta * Y[i * incY];
+
+          return GSL_SUCCESS;
+        }
+
+#ifdef SELL_HAVE_X86
+      if (incX == 1 && simd >= GSL_SPBLAS_SIMD_AVX512 && A->C % 8 == 0)
+        kernel = sell_chunk_avx512;
+      else if (incX == 1 && simd >= GSL_SPBLAS_SIMD_AVX2 && A->C % 4 == 0)
+        kernel = sell_chunk_avx2;
+#endif
+
+      if (nthreads > 1)
+        {
+#pragma omp parallel for num_threads(nthreads) schedule(static)
+          for (c = 0; c < (long) A->nchunks; ++c)
+            {
+              double t[SELL_MAXC];
+
+              kernel(A, (size_t) c, X, incX, t);
+              sell_update(A, (size_t) c, alpha, t, beta, Y, incY);
+            }
+        }
+      else
+        {
+          double t[SELL_MAXC];
+
+          for (c = 0; c < (long) A->nchunks; ++c)
+            {
+              kernel(A, (size_t) c, X, incX, t);
+              sell_update(A, (size_t) c, alpha, t, beta, Y, incY);
+            }
+        }
+
+      return GSL_SUCCESS;
+    }
+} /* gsl_spblas_sell_dgemv() */
+
+/*
+gsl_spblas_sell_set_simd()
+  Select the widest instruction set used by gsl_spblas_sell_dgemv()
+
+Inputs: simd - GSL_SPBLAS_SIMD_SCALAR, GSL_SPBLAS_SIMD_AVX2 or
+               GSL_SPBLAS_SIMD_AVX512
+
+Return: success, or GSL_EUNSUP if the processor does not support simd
+
+Notes:
+1) By default the widest instruction set supported by the processor
+is used; lower settings are mainly useful for testing and comparison
+*/
+
+int
+gsl_spblas_sell_set_simd(const size_t simd)
+{
+  if (simd > sell_detect())
+    {
+      GSL_ERROR("instruction set not supported by processor", GSL_EUNSUP);
+    }
+
+  sell_simd = (int) simd;
+
+  return GSL_SUCCESS;
+} /* gsl_spblas_sell_set_simd() */
+
+/*
+gsl_spblas_sell_get_simd()
+  Return the widest instruction set used by gsl_spblas_sell_dgemv()
+*/
+
+size_t
+gsl_spblas_sell_get_simd(void)
+{
+  if (sell_simd < 0)
+    sell_simd = (int) sell_detect();
+
+  return (size_t) sell_simd;
+} /* gsl_spblas_sell_get_simd() */
+
+/*
+sell_detect()
+  Return the widest instruction set supported by the processor
+*/
+
+static size_t
+sell_detect(void)
+{
+#ifdef SELL_HAVE_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f"))
+    return GSL_SPBLAS_SIMD_AVX512;
+  else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return GSL_SPBLAS_SIMD_AVX2;
+#endif
+
+  return GSL_SPBLAS_SIMD_SCALAR;
+} /* sell_detect() */
+
+/*
+sell_compare()
+  Order rows by decreasing length, keeping the original order of rows
+of equal length
+*/
+
+static int
+sell_compare(const void *a, const void *b)
+{
+  const sell_row *ra = (const sell_row *) a;
+  const sell_row *rb = (const sell_row *) b;
+
+  if (ra->len != rb->len)
+    return (ra->len > rb->len) ? -1 : 1;
+  else
+    return (ra->row > rb->row) - (ra->row < rb->row);
+} /* sell_compare() */
+
+/*
+sell_chunk()
+  Scalar kernel: t[r] = sum_k val[k*C + r] * x[col[k*C + r]] for the
+C rows of chunk c, over the len[r] elements of each row
+*/
+
+static void
+sell_chunk(const gsl_spmatrix_sell *A, const size_t c, const double *x,
+           const size_t incX, double *t)
+{
+  const size_t C = A->C;
+  const double *val = A->val + A->cptr[c];
+  const int32_t *col = A->col + A->cptr[c];
+  const int32_t *len = A->len + c * C;
+  size_t k, r;
+
+  for (r = 0; r < C; ++r)
+    {
+      double sum = 0.0;
+
+      for (k = 0; k < (size_t) len[r]; ++k)
+        sum += val[k * C + r] * x[(size_t) col[k * C + r] * incX];
+
+      t[r] = sum;
+    }
+} /* sell_chunk() */
+
+#ifdef SELL_HAVE_X86
+
+/*
+sell_chunk_avx2()
+  AVX2 kernel for C a multiple of 4: each group of 4 rows is
+accumulated in one register, gathering 4 elements of x at a time.
+The gather is masked by k < len[r], so padded lanes load 0 instead
+of reading x
+*/
+
+__attribute__((target("avx2,fma")))
+static void
+sell_chunk_avx2(const gsl_spmatrix_sell *A, const size_t c, const double *x,
+                const size_t incX, double *t)
+{
+  const size_t C = A->C;
+  const double *val = A->val + A->cptr[c];
+  const int32_t *col = A->col + A->cptr[c];
+  const int32_t *len = A->len + c * C;
+  const size_t width = (A->cptr[c + 1] - A->cptr[c]) / C;
+  size_t k, r;
+
+  (void) incX;
+
+  for (r = 0; r < C; r += 4)
+    {
+      const __m128i lenv = _mm_loadu_si128((const __m128i *) (len + r));
+      __m256d sum = _mm256_setzero_pd();
+
+      for (k = 0; k < width; ++k)
+        {
+          __m128i idx = _mm_loadu_si128((const __m128i *) (col + k * C + r));
+          __m128i live = _mm_cmpgt_epi32(lenv, _mm_set1_epi32((int) k));
+          __m256d mask = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(live));
+          __m256d xv = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), x, idx,
+                                                mask, 8);
+          __m256d av = _mm256_loadu_pd(val + k * C + r);
+
+          sum = _mm256_fmadd_pd(av, xv, sum);
+        }
+
+      _mm256_storeu_pd(t + r, sum);
+    }
+} /* sell_chunk_avx2() */
+
+/*
+sell_chunk_avx512()
+  AVX-512 kernel for C a multiple of 8, with the gather masked as in
+sell_chunk_avx2()
+*/
+
+__attribute__((target("avx512f")))
+static void
+sell_chunk_avx512(const gsl_spmatrix_sell *A, const size_t c,
+                  const double *x, const size_t incX, double *t)
+{
+  const size_t C = A->C;
+  const double *val = A->val + A->cptr[c];
+  const int32_t *col = A->col + A->cptr[c];
+  const int32_t *len = A->len + c * C;
+  const size_t width = (A->cptr[c + 1] - A->cptr[c]) / C;
+  size_t k, r;
+
+  (void) incX;
+
+  for (r = 0; r < C; r += 8)
+    {
+      const __m512i lenv =
+        _mm512_cvtepi32_epi64(_mm256_loadu_si256((const __m256i *) (len + r)));
+      __m512d sum = _mm512_setzero_pd();
+
+      for (k = 0; k < width; ++k)
+        {
+          __m256i idx = _mm256_loadu_si256((const __m256i *) (col + k * C + r));
+          __mmask8 live = _mm512_cmpgt_epi64_mask(lenv,
+                                                  _mm512_set1_epi64((long long) k));
+          __m512d xv = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), live, idx,
+                                                x, 8);
+          __m512d av = _mm512_loadu_pd(val + k * C + r);
+
+          sum = _mm512_fmadd_pd(av, xv, sum);
+        }
+
+      _mm512_storeu_pd(t + r, sum);
+    }
+} /* sell_chunk_avx512() */
+
+#endif /* SELL_HAVE_X86 */
+
+/*
+sell_update()
+  Store y := alpha*t + beta*y for the rows of chunk c
+*/
+
+static void
+sell_update(const gsl_spmatrix_sell *A, const size_t c, const double alpha,
+            const double *t, const double beta, double *Y, const size_t incY)
+{
+  const size_t *perm = A->perm + c * A->C;
+  size_t r;
+
+  for (r = 0; r < A->C; ++r)
+    {
+      const size_t i = perm[r];
+
+      if (i >= A->size1)
+        continue;
+
+      if (beta == 0.0)
+        Y[i * incY] = alpha * t[r];
+      else
+        Y[i * incY] = alpha * t[r] + beta * Y[i * incY];
+    }
+} /* sell_update() */
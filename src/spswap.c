@@ -19,13 +19,36 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_matrix.h>
+#include <gsl/gsl_permutation.h>
 #include <gsl/gsl_errno.h>
 
 #include "gsl_spmatrix.h"
+#include "spthread.h"
+
+static gsl_spmatrix *permute_symmetric(const gsl_spmatrix *A,
+                                       const gsl_permutation *p,
+                                       const gsl_permutation *q);
+static void transpose_compressed(const gsl_spmatrix *src, size_t *w,
+                                 const size_t nthreads, gsl_spmatrix *dest);
+
+/*
+gsl_spmatrix_transpose_memcpy()
+  Compute the transpose of a sparse matrix, storing the result
+in a newly allocated matrix of the same storage format
+
+Inputs: src - sparse matrix (triplet, CCS or CRS)
+
+Return: pointer to src^T (should be freed when finished with it)
+
+Notes:
+1) A symmetric matrix (GSL_SPMATRIX_SYMMETRIC) is its own transpose,
+so it is copied unchanged to keep its lower triangle storage
+*/
 
 gsl_spmatrix *
 gsl_spmatrix_transpose_memcpy(const gsl_spmatrix *src)
@@ -35,8 +58,13 @@ gsl_spmatrix_transpose_memcpy(const gsl_spmatrix *src)
   const size_t nz = src->nz;
   gsl_spmatrix *dest;
 
+  if (GSLSP_ISSYMMETRIC(src))
+    return gsl_spmatrix_memcpy(src);
+
   /* allocate space for transposed matrix */
   dest = gsl_spmatrix_alloc_nzmax(N, M, nz, src->flags);
+  if (!dest)
+    return NULL;
 
   if (GSLSP_ISTRIPLET(src))
     {
@@ -48,50 +76,462 @@ gsl_spmatrix_transpose_memcpy(const gsl_spmatrix *src)
           dest->p[n] = src->i[n];
           dest->data[n] = src->data[n];
         }
+
+      dest->nz = nz;
+
+      if (src->hash && gsl_spmatrix_hash_init(dest))
+        {
+          gsl_spmatrix_free(dest);
+          return NULL;
+        }
+    }
+  else if (GSLSP_ISCCS(src) || GSLSP_ISCRS(src))
+    {
+      transpose_compressed(src, dest->work, gsl_spblas_get_num_threads(),
+                           dest);
+    }
+  else
+    {
+      gsl_spmatrix_free(dest);
+      GSL_ERROR_NULL("unknown sparse matrix type", GSL_EINVAL);
+    }
+
+  dest->nz = nz;
+
+  return dest;
+} /* gsl_spmatrix_transpose_memcpy() */
+
+/*
+gsl_spmatrix_transpose_memcpy_w()
+  Compute the transpose of a compressed matrix into an existing
+matrix, using a caller-supplied workspace
+
+Inputs: dest - (output) src^T; must have the storage format of src,
+               dimensions size2(src)-by-size1(src) and nzmax >= nz(src)
+        src  - sparse matrix (CCS or CRS)
+        work - workspace of size at least MAX(size1, size2)
+
+Return: success or error
+
+Notes:
+1) No memory is allocated and src is not modified, so several threads
+may transpose the same matrix concurrently with separate workspaces
+
+2) A symmetric matrix is copied unchanged, as in
+gsl_spmatrix_transpose_memcpy()
+*/
+
+int
+gsl_spmatrix_transpose_memcpy_w(gsl_spmatrix *dest, const gsl_spmatrix *src,
+                                gsl_spmatrix_workspace *work)
+{
+  if (!GSLSP_ISCCS(src) && !GSLSP_ISCRS(src))
+    {
+      GSL_ERROR("matrix must be in compressed format", GSL_EINVAL);
+    }
+  else if (GSLSP_TYPE(dest) != GSLSP_TYPE(src))
+    {
+      GSL_ERROR("matrices must have same sparse storage format", GSL_EINVAL);
+    }
+  else if (dest->size1 != src->size2 || dest->size2 != src->size1)
+    {
+      GSL_ERROR("dest matrix has wrong dimensions", GSL_EBADLEN);
+    }
+  else if (dest->nzmax < src->nz)
+    {
+      GSL_ERROR("dest matrix is too small", GSL_EBADLEN);
+    }
+  else if (GSLSP_ISREADONLY(dest))
+    {
+      GSL_ERROR("dest matrix is read-only", GSL_EINVAL);
+    }
+  else if (work->n < GSL_MAX(src->size1, src->size2))
+    {
+      GSL_ERROR("workspace is too small", GSL_EBADLEN);
+    }
+  else if (GSLSP_ISSYMMETRIC(src))
+    {
+      const size_t nouter = GSLSP_ISCCS(src) ? src->size2 : src->size1;
+
+      memcpy(dest->p, src->p, (nouter + 1) * sizeof(size_t));
+      memcpy(dest->i, src->i, src->nz * sizeof(size_t));
+      memcpy(dest->data, src->data, src->nz * sizeof(double));
+      dest->nz = src->nz;
+      dest->flags = src->flags & ~GSL_SPMATRIX_READONLY;
+
+      return GSL_SUCCESS;
+    }
+  else
+    {
+      transpose_compressed(src, work->iwork, 1, dest);
+      return GSL_SUCCESS;
+    }
+} /* gsl_spmatrix_transpose_memcpy_w() */
+
+/*
+gsl_spmatrix_transpose()
+  Transpose a sparse matrix in place
+
+Inputs: m - (input/output) sparse matrix
+
+Notes:
+1) No data is moved: a triplet matrix has its row and column index
+arrays swapped (and an active hash table rebuilt), and a compressed matrix is reinterpreted in the
+opposite compressed format, since the CCS arrays of A are exactly
+the CRS arrays of A^T (and vice versa)
+
+2) A symmetric matrix (GSL_SPMATRIX_SYMMETRIC) is left unchanged
+*/
+
+int
+gsl_spmatrix_transpose(gsl_spmatrix *m)
+{
+  size_t tmp;
+
+  if (GSLSP_ISSYMMETRIC(m))
+    return GSL_SUCCESS;
+
+  if (GSLSP_ISTRIPLET(m))
+    {
+      size_t *ptr = m->i;
+      m->i = m->p;
+      m->p = ptr;
+
+      /* (i,j) keys of an active hash table have changed */
+      gsl_spmatrix_hash_rebuild(m);
+    }
+  else if (GSLSP_ISCCS(m))
+    {
+      /* sorted/no duplicates properties carry over */
+      m->flags ^= GSL_SPMATRIX_CCS | GSL_SPMATRIX_CRS;
     }
-  else if (GSLSP_ISCCS(src))
+  else if (GSLSP_ISCRS(m))
     {
-      size_t *Ai = src->i;
-      size_t *Ap = src->p;
-      double *Ad = src->data;
-      size_t *ATi = dest->i;
-      size_t *ATp = dest->p;
-      double *ATd = dest->data;
-      size_t *w = dest->work;
-      size_t p, j;
+      m->flags ^= GSL_SPMATRIX_CCS | GSL_SPMATRIX_CRS;
+    }
+  else
+    {
+      GSL_ERROR("unknown sparse matrix type", GSL_EINVAL);
+    }
+
+  tmp = m->size1;
+  m->size1 = m->size2;
+  m->size2 = tmp;
+
+  return GSL_SUCCESS;
+} /* gsl_spmatrix_transpose() */
+
+/*
+gsl_spmatrix_permute()
+  Permute the rows and columns of a sparse matrix, C = A(p,q), so that
+C_ij = A_{p_i,q_j}
+
+Inputs: A - sparse matrix (triplet, CCS or CRS)
+        p - row permutation of length A->size1, or NULL for the identity
+        q - column permutation of length A->size2, or NULL for the
+            identity. A symmetric permutation P A P^T is obtained with
+            q = p
+
+Return: pointer to C in the storage format of A (should be freed when
+finished with it)
 
-      /* initialize to 0 */
-      for (p = 0; p < M + 1; ++p)
-        ATp[p] = 0;
+Notes:
+1) For compressed formats, the matrix is not converted to triplet
+format. Column j of C (CCS) is column q_j of A with its row indices
+renumbered, which would leave them unsorted; instead the renumbered
+columns are scattered by row into a temporary compressed row matrix,
+which is then scattered back by column. Both passes visit the indices in
+increasing order, so C has sorted indices, at a cost of O(nnz + n)
 
-      /* compute row counts of A (= column counts for A^T) */
-      for (p = 0; p < nz; ++p)
-        ATp[Ai[p]]++;
+2) A matrix with symmetric storage (GSL_SPMATRIX_SYMMETRIC) only allows
+symmetric permutations, q = p; see permute_symmetric()
+*/
 
-      /* compute row pointers for A (= column pointers for A^T) */
-      gsl_spmatrix_cumsum(M, ATp);
+gsl_spmatrix *
+gsl_spmatrix_permute(const gsl_spmatrix *A, const gsl_permutation *p,
+                     const gsl_permutation *q)
+{
+  const size_t M = A->size1;
+  const size_t N = A->size2;
+  const size_t nz = A->nz;
+  gsl_spmatrix *C;
+  size_t *pinv, *qinv;
+  size_t k;
+
+  if ((p && p->size != M) || (q && q->size != N))
+    {
+      GSL_ERROR_NULL("permutation length does not match matrix", GSL_EBADLEN);
+    }
+  else if (GSLSP_ISSYMMETRIC(A))
+    {
+      return permute_symmetric(A, p, q);
+    }
+
+  C = gsl_spmatrix_alloc_nzmax(M, N, nz, GSLSP_TYPE(A));
+  if (!C)
+    return NULL;
 
-      /* make copy of row pointers */
-      for (j = 0; j < M; ++j)
-        w[j] = ATp[j];
+  pinv = malloc(GSL_MAX(M, 1) * sizeof(size_t));
+  qinv = malloc(GSL_MAX(N, 1) * sizeof(size_t));
+  if (!pinv || !qinv)
+    {
+      free(pinv);
+      free(qinv);
+      gsl_spmatrix_free(C);
+      GSL_ERROR_NULL("failed to allocate space for inverse permutations",
+                     GSL_ENOMEM);
+    }
 
-      for (j = 0; j < N; ++j)
+  for (k = 0; k < M; ++k)
+    pinv[p ? p->data[k] : k] = k;
+
+  for (k = 0; k < N; ++k)
+    qinv[q ? q->data[k] : k] = k;
+
+  if (GSLSP_ISTRIPLET(A))
+    {
+      for (k = 0; k < nz; ++k)
+        {
+          C->i[k] = pinv[A->i[k]];
+          C->p[k] = qinv[A->p[k]];
+          C->data[k] = A->data[k];
+        }
+
+      C->nz = nz;
+
+      if (A->hash && gsl_spmatrix_hash_init(C))
+        {
+          free(pinv);
+          free(qinv);
+          gsl_spmatrix_free(C);
+          return NULL;
+        }
+    }
+  else if (GSLSP_ISCCS(A) || GSLSP_ISCRS(A))
+    {
+      /* as in gsl_spmatrix_transpose_memcpy(), CRS swaps the roles */
+      const size_t nouter = GSLSP_ISCCS(A) ? N : M;
+      const size_t ninner = GSLSP_ISCCS(A) ? M : N;
+      const size_t *po = GSLSP_ISCCS(A) ? (q ? q->data : NULL) :
+                                          (p ? p->data : NULL);
+      const size_t *iinv = GSLSP_ISCCS(A) ? pinv : qinv;
+      size_t *tp = malloc((ninner + 1) * sizeof(size_t));
+      size_t *ti = malloc(GSL_MAX(nz, 1) * sizeof(size_t));
+      double *td = malloc(GSL_MAX(nz, 1) * sizeof(double));
+      size_t *w = malloc(GSL_MAX(GSL_MAX(ninner, nouter), 1) * sizeof(size_t));
+      size_t i, j, r;
+
+      if (!tp || !ti || !td || !w)
+        {
+          free(tp);
+          free(ti);
+          free(td);
+          free(w);
+          free(pinv);
+          free(qinv);
+          gsl_spmatrix_free(C);
+          GSL_ERROR_NULL("failed to allocate space for permutation workspace",
+                         GSL_ENOMEM);
+        }
+
+      /* first pass: new outer vectors, scattered by new inner index */
+      for (i = 0; i < ninner; ++i)
+        tp[i] = 0;
+
+      for (r = 0; r < nz; ++r)
+        tp[iinv[A->i[r]]]++;
+
+      gsl_spmatrix_cumsum(ninner, tp);
+
+      for (i = 0; i < ninner; ++i)
+        w[i] = tp[i];
+
+      for (j = 0; j < nouter; ++j)
+        {
+          const size_t jold = po ? po[j] : j;
+
+          for (r = A->p[jold]; r < A->p[jold + 1]; ++r)
+            {
+              size_t t = w[iinv[A->i[r]]]++;
+              ti[t] = j;
+              td[t] = A->data[r];
+            }
+        }
+
+      /* second pass: scatter back by new outer index */
+      for (j = 0; j < nouter; ++j)
+        {
+          const size_t jold = po ? po[j] : j;
+          C->p[j] = A->p[jold + 1] - A->p[jold];
+        }
+
+      gsl_spmatrix_cumsum(nouter, C->p);
+
+      for (j = 0; j < nouter; ++j)
+        w[j] = C->p[j];
+
+      for (i = 0; i < ninner; ++i)
         {
-          for (p = Ap[j]; p < Ap[j + 1]; ++p)
+          for (r = tp[i]; r < tp[i + 1]; ++r)
             {
-              size_t k = w[Ai[p]]++;
-              ATi[k] = j;
-              ATd[k] = Ad[p];
+              size_t t = w[ti[r]]++;
+              C->i[t] = i;
+              C->data[t] = td[r];
             }
         }
+
+      C->nz = nz;
+      C->flags |= GSL_SPMATRIX_SORTED | (A->flags & GSL_SPMATRIX_NODUPS);
+
+      free(tp);
+      free(ti);
+      free(td);
+      free(w);
     }
   else
     {
-      gsl_spmatrix_free(dest);
+      free(pinv);
+      free(qinv);
+      gsl_spmatrix_free(C);
       GSL_ERROR_NULL("unknown sparse matrix type", GSL_EINVAL);
     }
 
-  dest->nz = nz;
+  free(pinv);
+  free(qinv);
 
-  return dest;
-} /* gsl_spmatrix_transpose_memcpy() */
+  return C;
+} /* gsl_spmatrix_permute() */
+
+/*
+permute_symmetric()
+  Compute C = P A P^T for a matrix with symmetric storage
+
+Inputs: A - sparse matrix with symmetric storage
+        p - permutation of length A->size1, or NULL for the identity
+        q - must be the same permutation as p
+
+Return: pointer to C with symmetric storage (should be freed when
+finished with it)
+
+Notes:
+1) A stored element (i,j), i >= j, moves to (pinv_i, pinv_j), which may
+lie above the diagonal; it is then stored as its transpose. The moved
+elements are collected in a triplet matrix and compressed with
+gsl_spmatrix_symmetric(), which sorts them
+*/
+
+static gsl_spmatrix *
+permute_symmetric(const gsl_spmatrix *A, const gsl_permutation *p,
+                  const gsl_permutation *q)
+{
+  const size_t N = A->size1;
+  gsl_spmatrix *T, *C;
+  size_t *pinv;
+  size_t j, k;
+
+  for (k = 0; k < N; ++k)
+    {
+      if ((p ? p->data[k] : k) != (q ? q->data[k] : k))
+        {
+          GSL_ERROR_NULL("symmetric storage requires q = p", GSL_EINVAL);
+        }
+    }
+
+  T = gsl_spmatrix_alloc_nzmax(N, N, GSL_MAX(A->nz, 1), GSL_SPMATRIX_TRIPLET);
+  if (!T)
+    return NULL;
+
+  pinv = malloc(GSL_MAX(N, 1) * sizeof(size_t));
+  if (!pinv)
+    {
+      gsl_spmatrix_free(T);
+      GSL_ERROR_NULL("failed to allocate space for inverse permutation",
+                     GSL_ENOMEM);
+    }
+
+  for (k = 0; k < N; ++k)
+    pinv[p ? p->data[k] : k] = k;
+
+  for (j = 0; j < N; ++j)
+    {
+      for (k = A->p[j]; k < A->p[j + 1]; ++k)
+        {
+          const size_t inew = pinv[A->i[k]];
+          const size_t jnew = pinv[j];
+
+          T->i[k] = GSL_MAX(inew, jnew);
+          T->p[k] = GSL_MIN(inew, jnew);
+          T->data[k] = A->data[k];
+        }
+    }
+
+  T->nz = A->nz;
+
+  C = gsl_spmatrix_symmetric(T);
+
+  gsl_spmatrix_free(T);
+  free(pinv);
+
+  return C;
+} /* permute_symmetric() */
+
+/*
+transpose_compressed()
+  Store the transpose of a compressed matrix
+
+Inputs: src      - sparse matrix (CCS or CRS)
+        w        - workspace of size MAX(size1, size2)
+        nthreads - number of threads for the cumulative sum
+        dest     - (output) src^T in the same format, with room for
+                   src->nz elements
+
+Notes:
+1) The algorithm is the same for both formats; for CRS the roles of
+rows and columns are simply interchanged
+*/
+
+static void
+transpose_compressed(const gsl_spmatrix *src, size_t *w,
+                     const size_t nthreads, gsl_spmatrix *dest)
+{
+  const size_t nz = src->nz;
+  const size_t nouter = GSLSP_ISCCS(src) ? src->size2 : src->size1;
+  const size_t ninner = GSLSP_ISCCS(src) ? src->size1 : src->size2;
+  const size_t *Ai = src->i;
+  const size_t *Ap = src->p;
+  const double *Ad = src->data;
+  size_t *ATi = dest->i;
+  size_t *ATp = dest->p;
+  double *ATd = dest->data;
+  size_t p, j;
+
+  /* initialize to 0 */
+  for (p = 0; p < ninner + 1; ++p)
+    ATp[p] = 0;
+
+  /* compute row counts of A (= column counts for A^T) */
+  for (p = 0; p < nz; ++p)
+    ATp[Ai[p]]++;
+
+  /* compute row pointers for A (= column pointers for A^T) */
+  spthread_cumsum(ninner, ATp, nthreads);
+
+  /* make copy of row pointers */
+  for (j = 0; j < ninner; ++j)
+    w[j] = ATp[j];
+
+  for (j = 0; j < nouter; ++j)
+    {
+      for (p = Ap[j]; p < Ap[j + 1]; ++p)
+        {
+          size_t k = w[Ai[p]]++;
+          ATi[k] = j;
+          ATd[k] = Ad[p];
+        }
+    }
+
+  /* scanning A in order leaves the indices of A^T sorted */
+  dest->flags = GSLSP_TYPE(src) | GSL_SPMATRIX_SORTED |
+                (src->flags & GSL_SPMATRIX_NODUPS);
+  dest->nz = nz;
+} /* transpose_compressed() */
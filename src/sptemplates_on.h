@@ -0,0 +1,68 @@
+/* sptemplates_on.h
+ *
+ * Copyright (C) 2014 Patrick Alken
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Template macros for the compressed matrix variants, in the style of
+ * the GSL templates_on.h. Define one of
+ *
+ *   SPBASE_DOUBLE  gsl_spmatrix      size_t indices,   double values
+ *   SPBASE_FLOAT   gsl_spmatrix_float size_t indices,  float values
+ *   SPBASE_I32     gsl_spmatrix_i32  uint32_t indices, double values
+ *
+ * before including this header and a *_source.c file, and include
+ * sptemplates_off.h afterwards. The source file then uses
+ *
+ *   ATOMIC             type of the stored values
+ *   INDEX              type of the inner (row or column) indices
+ *   TYPE(dir)          gsl_spmatrix -> gsl_spmatrix_SHORT
+ *   FUNCTION(dir,name) dir_name -> dir_SHORT_name
+ *
+ * This header is not installed.
+ */
+
+#if defined(SPBASE_DOUBLE)
+#define ATOMIC double
+#define INDEX size_t
+
+#elif defined(SPBASE_FLOAT)
+#define ATOMIC float
+#define INDEX size_t
+#define SHORT float
+
+#elif defined(SPBASE_I32)
+#define ATOMIC double
+#define INDEX uint32_t
+#define SHORT i32
+
+#else
+#error unknown SPBASE_ directive in sptemplates_on.h
+#endif
+
+#define CONCAT2x(a,b) a ## _ ## b
+#define CONCAT2(a,b) CONCAT2x(a,b)
+#define CONCAT3x(a,b,c) a ## _ ## b ## _ ## c
+#define CONCAT3(a,b,c) CONCAT3x(a,b,c)
+
+#if defined(SPBASE_DOUBLE)
+#define FUNCTION(dir,name) CONCAT2(dir,name)
+#define TYPE(dir) dir
+#else
+#define FUNCTION(dir,name) CONCAT3(dir,SHORT,name)
+#define TYPE(dir) CONCAT2(dir,SHORT)
+#endif
@@ -0,0 +1,161 @@
+/* spthread.c
+ * 
+ * Copyright (C) 2014 Patrick Alken
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_errno.h>
+
+#include "gsl_spmatrix.h"
+#include "spthread.h"
+
+/* number of threads used by the parallel kernels; 1 = serial */
+static size_t spblas_nthreads = 1;
+
+/*
+gsl_spblas_set_num_threads()
+  Set the number of threads used by the sparse BLAS routines
+
+Inputs: nthreads - number of threads; 1 selects the serial code paths
+
+Return: success or error
+
+Notes:
+1) If the library was built without OpenMP support, this setting
+is stored but has no effect
+*/
+
+int
+gsl_spblas_set_num_threads(const size_t nthreads)
+{
+  if (nthreads == 0)
+    {
+      GSL_ERROR("number of threads must be positive", GSL_EINVAL);
+    }
+
+  spblas_nthreads = nthreads;
+
+  return GSL_SUCCESS;
+} /* gsl_spblas_set_num_threads() */
+
+/*
+gsl_spblas_get_num_threads()
+  Return the number of threads which will be used by the sparse
+BLAS routines. This is always 1 if the library was built without
+OpenMP support
+*/
+
+size_t
+gsl_spblas_get_num_threads(void)
+{
+#ifdef _OPENMP
+  return spblas_nthreads;
+#else
+  return 1;
+#endif
+} /* gsl_spblas_get_num_threads() */
+
+/*
+spthread_partition()
+  Split the outer dimension of a compressed matrix into contiguous
+blocks containing approximately equal numbers of non-zero elements,
+so that matrices with a skewed distribution of non-zeros per row
+(or column) are still balanced across threads
+
+Inputs: p      - column (or row) pointers of size n + 1
+        n      - number of columns (or rows)
+        nparts - number of blocks
+        part   - (output) array of size nparts + 1; block k
+                 consists of columns part[k] <= j < part[k+1]
+*/
+
+void
+spthread_partition(const size_t *p, const size_t n, const size_t nparts,
+                   size_t *part)
+{
+  const size_t nz = p[n];
+  size_t k;
+
+  part[0] = 0;
+
+  for (k = 1; k < nparts; ++k)
+    {
+      /* find smallest j with p[j] >= k*nz/nparts by bisection */
+      const size_t target = (size_t) ((double) nz * k / nparts);
+      size_t lo = part[k - 1];
+      size_t hi = n;
+
+      while (lo < hi)
+        {
+          size_t mid = lo + (hi - lo) / 2;
+
+          if (p[mid] < target)
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+
+      part[k] = lo;
+    }
+
+  part[nparts] = n;
+} /* spthread_partition() */
+
+/*
+spthread_block()
+  Split the range [0,n) into nparts contiguous blocks whose sizes
+differ by at most one, and return the start of block k. Block k is
+[spthread_block(n,nparts,k), spthread_block(n,nparts,k+1))
+
+Inputs: n      - size of range
+        nparts - number of blocks
+        k      - block index, 0 <= k <= nparts
+*/
+
+size_t
+spthread_block(const size_t n, const size_t nparts, const size_t k)
+{
+  return (n / nparts) * k + GSL_MIN(k, n % nparts);
+} /* spthread_block() */
+
+/*
+spthread_nprivate()
+  Return the number of threads for a product in which each thread
+accumulates its contribution in a private vector of length n
+
+Inputs: nthreads - number of threads requested
+        nz       - number of non-zero elements of the matrix
+        n        - length of each private vector
+
+Return: number of threads, at most nz / n
+
+Notes:
+1) The private vectors are allocated, cleared and summed on every
+call, at a cost of O(nthreads * n). Limiting the number of threads to
+nz / n keeps this cost, and the memory allocated, below that of the
+product itself; a matrix with fewer than 2 elements per private vector
+entry is multiplied serially
+*/
+
+size_t
+spthread_nprivate(const size_t nthreads, const size_t nz, const size_t n)
+{
+  return GSL_MIN(nthreads, nz / GSL_MAX(n, 1));
+} /* spthread_nprivate() */
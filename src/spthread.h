@@ -0,0 +1,35 @@
+/* spthread.h
+ * 
+ * Copyright (C) 2014 Patrick Alken
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __SPTHREAD_H__
+#define __SPTHREAD_H__
+
+/*
+ * Internal helpers for the multithreaded sparse kernels. This header
+ * is not installed.
+ */
+
+void spthread_partition(const size_t *p, const size_t n, const size_t nparts,
+                        size_t *part);
+size_t spthread_block(const size_t n, const size_t nparts, const size_t k);
+size_t spthread_nprivate(const size_t nthreads, const size_t nz,
+                         const size_t n);
+void spthread_cumsum(const size_t n, size_t *c, const size_t nthreads);
+
+#endif /* __SPTHREAD_H__ */
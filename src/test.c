@@ -30,8 +30,10 @@
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_test.h>
 #include <gsl/gsl_blas.h>
+#include <gsl/gsl_permutation.h>
 
 #include "gsl_spmatrix.h"
+#include "gsl_splinalg.h"
 
 /*
 create_random_sparse()
@@ -59,6 +61,9 @@ create_random_sparse(const size_t M, const size_t N, const double density,
   size_t nnzwanted = (size_t) round(M * N * GSL_MIN(density, 1.0));
   size_t n = 0;
 
+  /* use the hash table for the _get lookups below */
+  gsl_spmatrix_hash_init(m);
+
   while (n <= nnzwanted)
     {
       /* generate a random row and column */
@@ -79,6 +84,8 @@ create_random_sparse(const size_t M, const size_t N, const double density,
       ++n;
     }
 
+  gsl_spmatrix_hash_free(m);
+
   return m;
 } /* create_random_sparse() */
 
@@ -145,10 +152,112 @@ test_getset(const size_t M, const size_t N, const gsl_rng *r)
     gsl_spmatrix_free(m);
   }
 
+  /* test that _set overwrites and _accumulate sums repeated entries */
+  {
+    gsl_spmatrix *m = gsl_spmatrix_alloc_nzmax(M, N, 1, GSL_SPMATRIX_TRIPLET);
+
+    gsl_spmatrix_hash_init(m);
+
+    status = 0;
+    for (i = 0; i < M; ++i)
+      {
+        for (j = 0; j < N; ++j)
+          {
+            double x = (double) (i + 1);
+
+            gsl_spmatrix_set(m, i, j, -1.0);
+            gsl_spmatrix_set(m, i, j, 2.0);
+            gsl_spmatrix_accumulate(m, i, j, x);
+            gsl_spmatrix_accumulate(m, i, j, x);
+          }
+      }
+
+    if (m->nz != M * N)
+      status = 1;
+
+    for (i = 0; i < M; ++i)
+      {
+        for (j = 0; j < N; ++j)
+          {
+            double x = (double) (i + 1);
+
+            if (gsl_spmatrix_get(m, i, j) != 2.0 + 2.0 * x)
+              status = 1;
+          }
+      }
+
+    /* setting an existing element to zero must not leave the old value */
+    gsl_spmatrix_set(m, 0, 0, 0.0);
+    if (gsl_spmatrix_get(m, 0, 0) != 0.0)
+      status = 1;
+
+    gsl_test(status, "test_getset: M=%zu N=%zu _accumulate", M, N);
+
+    /* transposing a triplet matrix must keep (i,j) lookups valid */
+    gsl_spmatrix_transpose(m);
+
+    status = 0;
+    for (i = 1; i < M; ++i)
+      {
+        for (j = 0; j < N; ++j)
+          {
+            double x = (double) (i + 1);
+
+            if (gsl_spmatrix_get(m, j, i) != 2.0 + 2.0 * x)
+              status = 1;
+          }
+      }
+
+    gsl_test(status, "test_getset: M=%zu N=%zu triplet _transpose", M, N);
+
+    gsl_spmatrix_free(m);
+  }
+
+  /* without the hash table, _set and _accumulate append duplicates */
+  {
+    gsl_spmatrix *m = gsl_spmatrix_alloc_nzmax(M, N, 1, GSL_SPMATRIX_TRIPLET);
+    gsl_spmatrix *C;
+
+    status = 0;
+    for (i = 0; i < M; ++i)
+      {
+        for (j = 0; j < N; ++j)
+          {
+            double x = (double) (i + 1);
+
+            gsl_spmatrix_set(m, i, j, 2.0);
+            gsl_spmatrix_accumulate(m, i, j, x);
+          }
+      }
+
+    if (m->hash != NULL || m->nz != 2 * M * N)
+      status = 1;
+
+    C = gsl_spmatrix_compress_sorted(m, GSL_SPMATRIX_CCS);
+
+    for (i = 0; i < M; ++i)
+      {
+        for (j = 0; j < N; ++j)
+          {
+            double x = (double) (i + 1);
+
+            if (gsl_spmatrix_get(m, i, j) != 2.0 ||
+                gsl_spmatrix_get(C, i, j) != 2.0 + x)
+              status = 1;
+          }
+      }
+
+    gsl_test(status, "test_getset: M=%zu N=%zu triplet without hash", M, N);
+
+    gsl_spmatrix_free(m);
+    gsl_spmatrix_free(C);
+  }
+
   /* test compressed version of gsl_spmatrix_get() */
   {
     gsl_spmatrix *T = create_random_sparse(M, N, 0.3, r);
     gsl_spmatrix *C = gsl_spmatrix_compress(T);
+    gsl_spmatrix *R = gsl_spmatrix_crs(T);
 
     status = 0;
     for (i = 0; i < M; ++i)
@@ -157,8 +266,9 @@ test_getset(const size_t M, const size_t N, const gsl_rng *r)
           {
             double Tij = gsl_spmatrix_get(T, i, j);
             double Cij = gsl_spmatrix_get(C, i, j);
+            double Rij = gsl_spmatrix_get(R, i, j);
 
-            if (Tij != Cij)
+            if (Tij != Cij || Tij != Rij)
               status = 1;
           }
       }
@@ -167,6 +277,7 @@ test_getset(const size_t M, const size_t N, const gsl_rng *r)
 
     gsl_spmatrix_free(T);
     gsl_spmatrix_free(C);
+    gsl_spmatrix_free(R);
   }
 } /* test_getset() */
 
@@ -178,7 +289,8 @@ test_memcpy(const size_t M, const size_t N, const gsl_rng *r)
   {
     gsl_spmatrix *at = create_random_sparse(M, N, 0.2, r);
     gsl_spmatrix *ac = gsl_spmatrix_compress(at);
-    gsl_spmatrix *bt, *bc;
+    gsl_spmatrix *ar = gsl_spmatrix_crs(at);
+    gsl_spmatrix *bt, *bc, *br;
   
     bt = gsl_spmatrix_memcpy(at);
 
@@ -190,10 +302,17 @@ test_memcpy(const size_t M, const size_t N, const gsl_rng *r)
     status = gsl_spmatrix_equal(ac, bc) != 1;
     gsl_test(status, "test_memcpy: _memcpy M=%zu N=%zu compressed column format", M, N);
 
+    br = gsl_spmatrix_memcpy(ar);
+
+    status = gsl_spmatrix_equal(ar, br) != 1;
+    gsl_test(status, "test_memcpy: _memcpy M=%zu N=%zu compressed row format", M, N);
+
     gsl_spmatrix_free(at);
     gsl_spmatrix_free(ac);
+    gsl_spmatrix_free(ar);
     gsl_spmatrix_free(bt);
     gsl_spmatrix_free(bc);
+    gsl_spmatrix_free(br);
   }
 
   /* test transpose_memcpy */
@@ -202,6 +321,8 @@ test_memcpy(const size_t M, const size_t N, const gsl_rng *r)
     gsl_spmatrix *AT = gsl_spmatrix_transpose_memcpy(A);
     gsl_spmatrix *B = gsl_spmatrix_compress(A);
     gsl_spmatrix *BT = gsl_spmatrix_transpose_memcpy(B);
+    gsl_spmatrix *C = gsl_spmatrix_crs(A);
+    gsl_spmatrix *CT = gsl_spmatrix_transpose_memcpy(C);
     size_t i, j;
 
     status = 0;
@@ -213,21 +334,202 @@ test_memcpy(const size_t M, const size_t N, const gsl_rng *r)
             double ATji = gsl_spmatrix_get(AT, j, i);
             double Bij = gsl_spmatrix_get(B, i, j);
             double BTji = gsl_spmatrix_get(BT, j, i);
+            double Cij = gsl_spmatrix_get(C, i, j);
+            double CTji = gsl_spmatrix_get(CT, j, i);
+
+            if ((Aij != ATji) || (Bij != BTji) || (Aij != Bij) ||
+                (Cij != CTji) || (Aij != Cij))
+              status = 1;
+          }
+      }
 
-            if ((Aij != ATji) || (Bij != BTji) || (Aij != Bij))
+    gsl_test(status, "test_memcpy: _transpose_memcpy M=%zu N=%zu", M, N);
+
+    /* in-place transpose of CCS should give exactly the CRS of A^T */
+    gsl_spmatrix_transpose(B);
+    status = !GSLSP_ISCRS(B) || B->size1 != N || B->size2 != M;
+    for (i = 0; i < M && !status; ++i)
+      {
+        for (j = 0; j < N; ++j)
+          {
+            if (gsl_spmatrix_get(A, i, j) != gsl_spmatrix_get(B, j, i))
               status = 1;
           }
       }
 
-    gsl_test(status, "test_memcpy: _transpose_memcpy M=%zu N=%zu triplet format", M, N);
+    gsl_test(status, "test_memcpy: _transpose M=%zu N=%zu compressed format", M, N);
 
     gsl_spmatrix_free(A);
     gsl_spmatrix_free(AT);
     gsl_spmatrix_free(B);
     gsl_spmatrix_free(BT);
+    gsl_spmatrix_free(C);
+    gsl_spmatrix_free(CT);
   }
 } /* test_memcpy() */
 
+/*
+test_compress()
+  Test gsl_spmatrix_compress_sorted() on a triplet matrix containing
+duplicate entries
+*/
+
+static void
+test_compress(const size_t M, const size_t N, const gsl_rng *r)
+{
+  gsl_spmatrix *T = create_random_sparse(M, N, 0.2, r);
+  gsl_spmatrix *D = gsl_spmatrix_alloc_nzmax(M, N, 2 * T->nz, GSL_SPMATRIX_TRIPLET);
+  const size_t types[2] = { GSL_SPMATRIX_CCS, GSL_SPMATRIX_CRS };
+  size_t i, j, k, n;
+  int status;
+
+  /*
+   * store each element of T twice in D, as T(i,j) and 1, in reverse
+   * order, writing the triplet arrays directly
+   */
+  for (n = 0; n < T->nz; ++n)
+    {
+      size_t idx = T->nz - 1 - n;
+
+      D->i[n] = T->i[idx];
+      D->p[n] = T->p[idx];
+      D->data[n] = T->data[idx];
+
+      D->i[T->nz + n] = T->i[idx];
+      D->p[T->nz + n] = T->p[idx];
+      D->data[T->nz + n] = 1.0;
+    }
+
+  D->nz = 2 * T->nz;
+
+  for (k = 0; k < 2; ++k)
+    {
+      gsl_spmatrix *C = gsl_spmatrix_compress_sorted(D, types[k]);
+      gsl_spmatrix *U = (types[k] == GSL_SPMATRIX_CCS) ?
+                        gsl_spmatrix_compress(T) : gsl_spmatrix_crs(T);
+      gsl_spmatrix *S = gsl_spmatrix_compress_sorted(T, types[k]);
+      const size_t nouter = (types[k] == GSL_SPMATRIX_CCS) ? N : M;
+
+      /* duplicates summed and flags set */
+      status = (C->nz != T->nz) || !GSLSP_ISSORTED(C) ||
+               !(C->flags & GSL_SPMATRIX_NODUPS) || (GSLSP_TYPE(C) != types[k]);
+
+      /* indices strictly increasing in each column (row) */
+      for (j = 0; j < nouter; ++j)
+        {
+          for (n = C->p[j] + 1; n < C->p[j + 1]; ++n)
+            {
+              if (C->i[n - 1] >= C->i[n])
+                status = 1;
+            }
+        }
+
+      for (i = 0; i < M; ++i)
+        {
+          for (j = 0; j < N; ++j)
+            {
+              double Tij = gsl_spmatrix_get(T, i, j);
+              double Cij = gsl_spmatrix_get(C, i, j);
+
+              if ((Tij == 0.0 && Cij != 0.0) ||
+                  (Tij != 0.0 && Cij != Tij + 1.0))
+                status = 1;
+            }
+        }
+
+      gsl_test(status, "test_compress: _compress_sorted M=%zu N=%zu type=%zu",
+               M, N, types[k]);
+
+      /* sorted and unsorted compressions of T are equal */
+      status = gsl_spmatrix_equal(U, S) != 1 || gsl_spmatrix_equal(S, U) != 1;
+      gsl_test(status, "test_compress: _equal sorted/unsorted M=%zu N=%zu type=%zu",
+               M, N, types[k]);
+
+      gsl_spmatrix_free(C);
+      gsl_spmatrix_free(U);
+      gsl_spmatrix_free(S);
+    }
+
+  gsl_spmatrix_free(T);
+  gsl_spmatrix_free(D);
+} /* test_compress() */
+
+/*
+test_compress_plan()
+  Test gsl_spmatrix_compress_plan() and gsl_spmatrix_compress_update()
+on a triplet matrix with duplicate entries
+*/
+
+static void
+test_compress_plan(const size_t M, const size_t N, const gsl_rng *r)
+{
+  gsl_spmatrix *T = create_random_sparse(M, N, 0.2, r);
+  const size_t nz = T->nz;
+  gsl_spmatrix *D = gsl_spmatrix_alloc_nzmax(M, N, 2 * nz, GSL_SPMATRIX_TRIPLET);
+  gsl_spmatrix_plan *plan = gsl_spmatrix_plan_alloc(2 * nz);
+  const size_t types[2] = { GSL_SPMATRIX_CCS, GSL_SPMATRIX_CRS };
+  size_t k, n;
+  int status;
+
+  /* every element of T appears twice in D */
+  for (n = 0; n < nz; ++n)
+    {
+      D->i[n] = D->i[nz + n] = T->i[nz - 1 - n];
+      D->p[n] = D->p[nz + n] = T->p[nz - 1 - n];
+      D->data[n] = T->data[nz - 1 - n];
+      D->data[nz + n] = 0.5;
+    }
+
+  D->nz = 2 * nz;
+
+  for (k = 0; k < 2; ++k)
+    {
+      gsl_spmatrix *C = gsl_spmatrix_compress_plan(D, types[k], plan);
+      gsl_spmatrix *S = gsl_spmatrix_compress_sorted(D, types[k]);
+
+      status = gsl_spmatrix_equal(C, S) != 1 || !GSLSP_ISSORTED(C);
+      gsl_test(status, "test_compress_plan: _compress_plan M=%zu N=%zu type=%zu",
+               M, N, types[k]);
+
+      /* new values with the same pattern */
+      for (n = 0; n < D->nz; ++n)
+        D->data[n] = gsl_rng_uniform(r) - 0.5;
+
+      gsl_spmatrix_free(S);
+      S = gsl_spmatrix_compress_sorted(D, types[k]);
+
+      status = gsl_spmatrix_compress_update(D->data, plan, C);
+      for (n = 0; n < C->nz; ++n)
+        {
+          if (C->i[n] != S->i[n] || C->data[n] != S->data[n])
+            status = 1;
+        }
+
+      gsl_test(status, "test_compress_plan: _compress_update M=%zu N=%zu type=%zu",
+               M, N, types[k]);
+
+      /* a matrix in the other format with the same nz must be rejected */
+      {
+        gsl_error_handler_t *handler = gsl_set_error_handler_off();
+        gsl_spmatrix *O = gsl_spmatrix_compress_sorted(D, types[1 - k]);
+
+        status = gsl_spmatrix_compress_update(D->data, plan, O) != GSL_EINVAL;
+        gsl_test(status, "test_compress_plan: _compress_update M=%zu N=%zu type=%zu wrong format",
+                 M, N, types[k]);
+
+        gsl_spmatrix_free(O);
+        gsl_set_error_handler(handler);
+      }
+
+      gsl_spmatrix_free(C);
+      gsl_spmatrix_free(S);
+    }
+
+  gsl_spmatrix_plan_free(plan);
+  gsl_spmatrix_free(T);
+  gsl_spmatrix_free(D);
+} /* test_compress_plan() */
+
 void
 test_ops(const size_t M, const size_t N, const gsl_rng *r)
 {
@@ -257,6 +559,31 @@ test_ops(const size_t M, const size_t N, const gsl_rng *r)
 
     gsl_test(status, "test_ops: _add M=%zu N=%zu compressed format", M, N);
 
+    gsl_spmatrix_free(a);
+    gsl_spmatrix_free(b);
+    gsl_spmatrix_free(c);
+
+    /* repeat for compressed row format */
+    a = gsl_spmatrix_crs(Ta);
+    b = gsl_spmatrix_crs(Tb);
+    c = gsl_spmatrix_add(a, b);
+
+    status = 0;
+    for (i = 0; i < M; ++i)
+      {
+        for (j = 0; j < N; ++j)
+          {
+            double aij = gsl_spmatrix_get(a, i, j);
+            double bij = gsl_spmatrix_get(b, i, j);
+            double cij = gsl_spmatrix_get(c, i, j);
+
+            if (aij + bij != cij)
+              status = 1;
+          }
+      }
+
+    gsl_test(status, "test_ops: _add M=%zu N=%zu compressed row format", M, N);
+
     gsl_spmatrix_free(Ta);
     gsl_spmatrix_free(Tb);
     gsl_spmatrix_free(a);
@@ -274,6 +601,8 @@ test_dgemv(const double alpha, const double beta, const gsl_rng *r)
   gsl_vector *y0 = gsl_vector_alloc(N_max);
   gsl_vector *y1 = gsl_vector_alloc(N_max);
   gsl_vector *y2 = gsl_vector_alloc(N_max);
+  gsl_vector *z1 = gsl_vector_alloc(N_max);
+  gsl_vector *z2 = gsl_vector_alloc(N_max);
   size_t N, M;
 
   for (M = 1; M <= N_max; ++M)
@@ -287,7 +616,7 @@ test_dgemv(const double alpha, const double beta, const gsl_rng *r)
           gsl_matrix_view Av = gsl_matrix_submatrix(A, 0, 0, M, N);
           gsl_vector_view xv = gsl_vector_subvector(x, 0, N);
           gsl_spmatrix *mt = create_random_sparse(M, N, 0.2, r);
-          gsl_spmatrix *mc;
+          gsl_spmatrix *mc, *mr;
 
           /* create random dense vectors */
           create_random_vector(&xv.vector, r);
@@ -303,18 +632,55 @@ test_dgemv(const double alpha, const double beta, const gsl_rng *r)
           gsl_blas_dgemv(CblasNoTrans, alpha, &Av.matrix, &xv.vector, beta, &y_gsl.vector);
 
           /* compute y = alpha*A*x + beta*y0 with spblas/triplet */
-          gsl_spblas_dgemv(alpha, mt, &xv.vector, beta, &y_sp.vector);
+          gsl_spblas_dgemv(CblasNoTrans, alpha, mt, &xv.vector, beta, &y_sp.vector);
           test_vectors(&y_sp.vector, &y_gsl.vector, 1.0e-10,
                        "test_dgemv: triplet format");
 
           /* compute y = alpha*A*x + beta*y0 with spblas/compcol */
           mc = gsl_spmatrix_compress(mt);
           gsl_vector_memcpy(&y_sp.vector, &y.vector);
-          gsl_spblas_dgemv(alpha, mc, &xv.vector, beta, &y_sp.vector);
+          gsl_spblas_dgemv(CblasNoTrans, alpha, mc, &xv.vector, beta, &y_sp.vector);
           test_vectors(&y_sp.vector, &y_gsl.vector, 1.0e-10,
                        "test_dgemv: compressed column format");
 
+          /* compute y = alpha*A*x + beta*y0 with spblas/comprow */
+          mr = gsl_spmatrix_crs(mt);
+          gsl_vector_memcpy(&y_sp.vector, &y.vector);
+          gsl_spblas_dgemv(CblasNoTrans, alpha, mr, &xv.vector, beta, &y_sp.vector);
+          test_vectors(&y_sp.vector, &y_gsl.vector, 1.0e-10,
+                       "test_dgemv: compressed row format");
+
+          /*
+           * compute z = alpha*A^T*y + beta*x, using y as the input
+           * vector and x as the initial output vector
+           */
+          {
+            gsl_vector_view z_gsl = gsl_vector_subvector(z1, 0, N);
+            gsl_vector_view z_sp = gsl_vector_subvector(z2, 0, N);
+            gsl_spmatrix *mats[3];
+            const char *desc[3] = { "triplet", "compressed column",
+                                    "compressed row" };
+            size_t k;
+
+            mats[0] = mt;
+            mats[1] = mc;
+            mats[2] = mr;
+
+            gsl_vector_memcpy(&z_gsl.vector, &xv.vector);
+            gsl_blas_dgemv(CblasTrans, alpha, &Av.matrix, &y.vector, beta,
+                           &z_gsl.vector);
+
+            for (k = 0; k < 3; ++k)
+              {
+                gsl_vector_memcpy(&z_sp.vector, &xv.vector);
+                gsl_spblas_dgemv(CblasTrans, alpha, mats[k], &y.vector,
+                                 beta, &z_sp.vector);
+                test_vectors(&z_sp.vector, &z_gsl.vector, 1.0e-10, desc[k]);
+              }
+          }
+
           gsl_spmatrix_free(mc);
+          gsl_spmatrix_free(mr);
           gsl_spmatrix_free(mt);
         }
     }
@@ -324,8 +690,251 @@ test_dgemv(const double alpha, const double beta, const gsl_rng *r)
   gsl_vector_free(y0);
   gsl_vector_free(y1);
   gsl_vector_free(y2);
+  gsl_vector_free(z1);
+  gsl_vector_free(z2);
 } /* test_dgemv() */
 
+/*
+test_dgemm_dense()
+  Test gsl_spblas_dgemm_dense() against gsl_blas_dgemm() for all
+storage formats, using submatrix views of X and Y so that the row
+strides differ from the number of columns, and check that the
+multithreaded result is identical to the serial one
+*/
+
+static void
+test_dgemm_dense(const double alpha, const double beta, const size_t M,
+                 const size_t N, const size_t K, const gsl_rng *r)
+{
+  gsl_spmatrix *T = create_random_sparse(M, N, 0.2, r);
+  gsl_spmatrix *A[3];
+  gsl_matrix *Ad = gsl_matrix_alloc(M, N);
+  gsl_matrix *Xbig = gsl_matrix_alloc(N, K + 3);
+  gsl_matrix *Y0 = gsl_matrix_alloc(M, K);
+  gsl_matrix *Y_gsl = gsl_matrix_alloc(M, K);
+  gsl_matrix *Y_serial = gsl_matrix_alloc(M, K);
+  gsl_matrix *Ybig = gsl_matrix_alloc(M, K + 5);
+  gsl_matrix_view X = gsl_matrix_submatrix(Xbig, 0, 1, N, K);
+  gsl_matrix_view Y = gsl_matrix_submatrix(Ybig, 0, 2, M, K);
+  const char *names[3] = { "triplet", "CCS", "CRS" };
+  size_t i, j, k;
+
+  A[0] = T;
+  A[1] = gsl_spmatrix_compress(T);
+  A[2] = gsl_spmatrix_crs(T);
+
+  for (i = 0; i < N; ++i)
+    for (j = 0; j < K + 3; ++j)
+      gsl_matrix_set(Xbig, i, j, gsl_rng_uniform(r) - 0.5);
+
+  for (i = 0; i < M; ++i)
+    for (j = 0; j < K; ++j)
+      gsl_matrix_set(Y0, i, j, gsl_rng_uniform(r) - 0.5);
+
+  gsl_spmatrix_sp2d(Ad, T);
+  gsl_matrix_memcpy(Y_gsl, Y0);
+  gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, alpha, Ad, &X.matrix,
+                 beta, Y_gsl);
+
+  for (k = 0; k < 3; ++k)
+    {
+      int status = 0;
+
+      gsl_spblas_set_num_threads(1);
+      gsl_matrix_memcpy(&Y.matrix, Y0);
+      gsl_spblas_dgemm_dense(alpha, A[k], &X.matrix, beta, &Y.matrix);
+
+      for (i = 0; i < M; ++i)
+        {
+          for (j = 0; j < K; ++j)
+            {
+              double yij = gsl_matrix_get(&Y.matrix, i, j);
+              double eij = gsl_matrix_get(Y_gsl, i, j);
+
+              if (fabs(yij - eij) > 1.0e-10 * GSL_MAX(1.0, fabs(eij)))
+                status = 1;
+            }
+        }
+
+      gsl_test(status, "test_dgemm_dense: %s alpha=%g beta=%g M=%zu N=%zu K=%zu",
+               names[k], alpha, beta, M, N, K);
+
+      gsl_matrix_memcpy(Y_serial, &Y.matrix);
+
+      gsl_spblas_set_num_threads(3);
+      gsl_matrix_memcpy(&Y.matrix, Y0);
+      gsl_spblas_dgemm_dense(alpha, A[k], &X.matrix, beta, &Y.matrix);
+      gsl_spblas_set_num_threads(1);
+
+      status = 0;
+      for (i = 0; i < M; ++i)
+        {
+          for (j = 0; j < K; ++j)
+            {
+              if (gsl_matrix_get(&Y.matrix, i, j) !=
+                  gsl_matrix_get(Y_serial, i, j))
+                status = 1;
+            }
+        }
+
+      gsl_test(status, "test_dgemm_dense: %s threads M=%zu N=%zu K=%zu",
+               names[k], M, N, K);
+    }
+
+  for (k = 0; k < 3; ++k)
+    gsl_spmatrix_free(A[k]);
+
+  gsl_matrix_free(Ad);
+  gsl_matrix_free(Xbig);
+  gsl_matrix_free(Y0);
+  gsl_matrix_free(Y_gsl);
+  gsl_matrix_free(Y_serial);
+  gsl_matrix_free(Ybig);
+} /* test_dgemm_dense() */
+
+/*
+test_dgemv_threads()
+  Compare the multithreaded gsl_spblas_dgemv() against the serial
+version on a matrix with a skewed number of non-zeros per row
+*/
+
+void
+test_dgemv_threads(const size_t M, const size_t N, const size_t nthreads,
+                   const gsl_rng *r)
+{
+  gsl_spmatrix *T = create_random_sparse(M, N, 0.05, r);
+  gsl_spmatrix *C, *R;
+  gsl_vector *x = gsl_vector_alloc(N);
+  gsl_vector *y0 = gsl_vector_alloc(M);
+  gsl_vector *y_serial = gsl_vector_alloc(M);
+  gsl_vector *y_par = gsl_vector_alloc(M);
+  const double alpha = 1.3, beta = -0.7;
+  gsl_spmatrix *mats[3];
+  size_t i, k;
+  int status;
+
+  /* make the first few rows dense so the partition has to balance them */
+  for (i = 0; i < GSL_MIN(M, 3); ++i)
+    {
+      size_t j;
+
+      for (j = 0; j < N; ++j)
+        gsl_spmatrix_set(T, i, j, 1.0 + (double) j);
+    }
+
+  C = gsl_spmatrix_compress(T);
+  R = gsl_spmatrix_crs(T);
+  mats[0] = T;
+  mats[1] = C;
+  mats[2] = R;
+
+  create_random_vector(x, r);
+  create_random_vector(y0, r);
+
+  for (k = 0; k < 3; ++k)
+    {
+      gsl_spblas_set_num_threads(1);
+      gsl_vector_memcpy(y_serial, y0);
+      gsl_spblas_dgemv(CblasNoTrans, alpha, mats[k], x, beta, y_serial);
+
+      gsl_spblas_set_num_threads(nthreads);
+      gsl_vector_memcpy(y_par, y0);
+      gsl_spblas_dgemv(CblasNoTrans, alpha, mats[k], x, beta, y_par);
+
+      test_vectors(y_par, y_serial, 1.0e-12, "test_dgemv_threads");
+
+      if (k == 2)
+        {
+          /* row-partitioned CRS product is identical to the serial one */
+          status = 0;
+          for (i = 0; i < M; ++i)
+            {
+              if (gsl_vector_get(y_par, i) != gsl_vector_get(y_serial, i))
+                status = 1;
+            }
+
+          gsl_test(status, "test_dgemv_threads: M=%zu N=%zu nthreads=%zu compressed row bitwise",
+                   M, N, nthreads);
+        }
+    }
+
+  /* A^T*x with CCS is a row-partitioned gather, also identical */
+  {
+    gsl_vector *z0 = gsl_vector_alloc(N);
+    gsl_vector *z_serial = gsl_vector_alloc(N);
+    gsl_vector *z_par = gsl_vector_alloc(N);
+
+    create_random_vector(z0, r);
+
+    gsl_spblas_set_num_threads(1);
+    gsl_vector_memcpy(z_serial, z0);
+    gsl_spblas_dgemv(CblasTrans, alpha, C, y0, beta, z_serial);
+
+    gsl_spblas_set_num_threads(nthreads);
+    gsl_vector_memcpy(z_par, z0);
+    gsl_spblas_dgemv(CblasTrans, alpha, C, y0, beta, z_par);
+
+    status = 0;
+    for (i = 0; i < N; ++i)
+      {
+        if (gsl_vector_get(z_par, i) != gsl_vector_get(z_serial, i))
+          status = 1;
+      }
+
+    gsl_test(status, "test_dgemv_threads: M=%zu N=%zu nthreads=%zu transposed compressed column bitwise",
+             M, N, nthreads);
+
+    gsl_vector_free(z0);
+    gsl_vector_free(z_serial);
+    gsl_vector_free(z_par);
+  }
+
+  /*
+   * with fewer than 2 non-zeros per row the private vectors of a CCS
+   * product would cost more than the product, so it is computed serially
+   */
+  {
+    gsl_spmatrix *D = gsl_spmatrix_alloc(M, N);
+    gsl_spmatrix *DC;
+
+    for (i = 0; i < GSL_MIN(M, N); ++i)
+      gsl_spmatrix_set(D, i, i, 1.0 + (double) i);
+
+    DC = gsl_spmatrix_compress(D);
+
+    gsl_spblas_set_num_threads(1);
+    gsl_vector_memcpy(y_serial, y0);
+    gsl_spblas_dgemv(CblasNoTrans, alpha, DC, x, beta, y_serial);
+
+    gsl_spblas_set_num_threads(nthreads);
+    gsl_vector_memcpy(y_par, y0);
+    gsl_spblas_dgemv(CblasNoTrans, alpha, DC, x, beta, y_par);
+
+    status = 0;
+    for (i = 0; i < M; ++i)
+      {
+        if (gsl_vector_get(y_par, i) != gsl_vector_get(y_serial, i))
+          status = 1;
+      }
+
+    gsl_test(status, "test_dgemv_threads: M=%zu N=%zu nthreads=%zu diagonal compressed column bitwise",
+             M, N, nthreads);
+
+    gsl_spmatrix_free(D);
+    gsl_spmatrix_free(DC);
+  }
+
+  gsl_spblas_set_num_threads(1);
+
+  gsl_spmatrix_free(T);
+  gsl_spmatrix_free(C);
+  gsl_spmatrix_free(R);
+  gsl_vector_free(x);
+  gsl_vector_free(y0);
+  gsl_vector_free(y_serial);
+  gsl_vector_free(y_par);
+} /* test_dgemv_threads() */
+
 void
 test_dgemm(const double alpha, const size_t M, const size_t N, const gsl_rng *r)
 {
@@ -344,6 +953,10 @@ test_dgemm(const double alpha, const size_t M, const size_t N, const gsl_rng *r)
       gsl_spmatrix *A = gsl_spmatrix_compress(TA);
       gsl_spmatrix *B = gsl_spmatrix_compress(TB);
       gsl_spmatrix *C = gsl_spblas_dgemm(alpha, A, B);
+      gsl_spmatrix *AR = gsl_spmatrix_crs(TA);
+      gsl_spmatrix *BR = gsl_spmatrix_crs(TB);
+      gsl_spmatrix *CR = gsl_spblas_dgemm(alpha, AR, BR);
+      int status;
 
       /* make dense matrices and use standard dgemm to multiply them */
       gsl_spmatrix_sp2d(&Ag.matrix, TA);
@@ -357,23 +970,2805 @@ test_dgemm(const double alpha, const size_t M, const size_t N, const gsl_rng *r)
           for (j = 0; j < N; ++j)
             {
               double Cij = gsl_spmatrix_get(C, i, j);
+              double CRij = gsl_spmatrix_get(CR, i, j);
               double Dij = gsl_matrix_get(C_gsl, i, j);
 
               gsl_test_rel(Cij, Dij, 1.0e-12, "test_dgemm: _dgemm");
+              gsl_test_rel(CRij, Dij, 1.0e-12, "test_dgemm: _dgemm compressed row");
             }
         }
 
-      gsl_spmatrix_free(TA);
-      gsl_spmatrix_free(TB);
+      /* C should be allocated with exactly nnz(A*B) elements */
+      status = C->nz > 0 && C->nzmax != C->nz;
+      gsl_test(status, "test_dgemm: M=%zu N=%zu k=%zu nzmax=%zu nz=%zu",
+               M, N, k, C->nzmax, C->nz);
+
+      /* change the values of A and B and reuse the pattern of C */
+      gsl_spmatrix_scale(A, -2.0);
+      gsl_spmatrix_scale(B, 0.5);
+      gsl_spmatrix_scale(TA, -2.0);
+      gsl_spmatrix_scale(TB, 0.5);
+      gsl_spblas_dgemm_numeric(alpha, A, B, C);
+
+      gsl_spmatrix_sp2d(&Ag.matrix, TA);
+      gsl_spmatrix_sp2d(&Bg.matrix, TB);
+      gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, alpha, &Ag.matrix, &Bg.matrix,
+                     0.0, C_gsl);
+
+      for (i = 0; i < M; ++i)
+        {
+          for (j = 0; j < N; ++j)
+            {
+              double Cij = gsl_spmatrix_get(C, i, j);
+              double Dij = gsl_matrix_get(C_gsl, i, j);
+
+              gsl_test_rel(Cij, Dij, 1.0e-12, "test_dgemm: _dgemm_numeric");
+            }
+        }
+
+      gsl_spmatrix_free(TA);
+      gsl_spmatrix_free(TB);
+      gsl_spmatrix_free(A);
+      gsl_spmatrix_free(B);
+      gsl_spmatrix_free(C);
+      gsl_spmatrix_free(AR);
+      gsl_spmatrix_free(BR);
+      gsl_spmatrix_free(CR);
+    }
+
+  gsl_matrix_free(A_gsl);
+  gsl_matrix_free(B_gsl);
+  gsl_matrix_free(C_gsl);
+} /* test_dgemm() */
+
+/*
+test_dgemm_threads()
+  Check that the multithreaded gsl_spblas_dgemm() gives exactly the
+same result as the serial version
+*/
+
+void
+test_dgemm_threads(const size_t M, const size_t K, const size_t N,
+                   const size_t nthreads, const gsl_rng *r)
+{
+  gsl_spmatrix *TA = create_random_sparse(M, K, 0.05, r);
+  gsl_spmatrix *TB = create_random_sparse(K, N, 0.05, r);
+  gsl_spmatrix *A = gsl_spmatrix_compress(TA);
+  gsl_spmatrix *B = gsl_spmatrix_compress(TB);
+  gsl_spmatrix *C_serial, *C_par;
+  int status;
+
+  gsl_spblas_set_num_threads(1);
+  C_serial = gsl_spblas_dgemm(1.7, A, B);
+
+  gsl_spblas_set_num_threads(nthreads);
+  C_par = gsl_spblas_dgemm(1.7, A, B);
+
+  status = gsl_spmatrix_equal(C_serial, C_par) != 1;
+  gsl_test(status, "test_dgemm_threads: M=%zu K=%zu N=%zu nthreads=%zu",
+           M, K, N, nthreads);
+
+  gsl_spblas_set_num_threads(1);
+
+  gsl_spmatrix_free(TA);
+  gsl_spmatrix_free(TB);
+  gsl_spmatrix_free(A);
+  gsl_spmatrix_free(B);
+  gsl_spmatrix_free(C_serial);
+  gsl_spmatrix_free(C_par);
+} /* test_dgemm_threads() */
+
+/*
+test_compress_threads()
+  Check that multithreaded compression and gsl_spmatrix_cumsum()
+give exactly the same arrays as the serial versions
+*/
+
+void
+test_compress_threads(const size_t M, const size_t N,
+                      const size_t nthreads, const gsl_rng *r)
+{
+  gsl_spmatrix *T = create_random_sparse(M, N, 0.1, r);
+  const size_t n = 50000;
+  size_t *c_serial = malloc((n + 1) * sizeof(size_t));
+  size_t *c_par = malloc((n + 1) * sizeof(size_t));
+  size_t k, type;
+  int status;
+
+  for (type = 0; type < 2; ++type)
+    {
+      const size_t nouter = (type == 0) ? N : M;
+      gsl_spmatrix *C_serial, *C_par;
+
+      gsl_spblas_set_num_threads(1);
+      C_serial = (type == 0) ? gsl_spmatrix_compress(T) : gsl_spmatrix_crs(T);
+
+      gsl_spblas_set_num_threads(nthreads);
+      C_par = (type == 0) ? gsl_spmatrix_compress(T) : gsl_spmatrix_crs(T);
+
+      status = (C_serial->nz != C_par->nz) ||
+               (GSLSP_TYPE(C_serial) != GSLSP_TYPE(C_par));
+
+      for (k = 0; k < nouter + 1; ++k)
+        {
+          if (C_serial->p[k] != C_par->p[k])
+            status = 1;
+        }
+
+      for (k = 0; k < C_serial->nz && !status; ++k)
+        {
+          if (C_serial->i[k] != C_par->i[k] ||
+              C_serial->data[k] != C_par->data[k])
+            status = 1;
+        }
+
+      gsl_test(status, "test_compress_threads: M=%zu N=%zu type=%zu nthreads=%zu",
+               M, N, type, nthreads);
+
+      gsl_spmatrix_free(C_serial);
+      gsl_spmatrix_free(C_par);
+    }
+
+  for (k = 0; k < n; ++k)
+    c_serial[k] = c_par[k] = (size_t) (10.0 * gsl_rng_uniform(r));
+
+  gsl_spblas_set_num_threads(1);
+  gsl_spmatrix_cumsum(n, c_serial);
+
+  gsl_spblas_set_num_threads(nthreads);
+  gsl_spmatrix_cumsum(n, c_par);
+
+  status = 0;
+  for (k = 0; k < n + 1; ++k)
+    {
+      if (c_serial[k] != c_par[k])
+        status = 1;
+    }
+
+  gsl_test(status, "test_compress_threads: _cumsum n=%zu nthreads=%zu",
+           n, nthreads);
+
+  gsl_spblas_set_num_threads(1);
+
+  gsl_spmatrix_free(T);
+  free(c_serial);
+  free(c_par);
+} /* test_compress_threads() */
+
+/*
+create_poisson2d()
+  Create the symmetric positive definite matrix of the 5-point finite
+difference Laplacian on a k-by-k grid, plus diag(shift * i) so that the
+diagonal varies
+*/
+
+static gsl_spmatrix *
+create_poisson2d(const size_t k, const double shift)
+{
+  const size_t n = k * k;
+  gsl_spmatrix *T = gsl_spmatrix_alloc(n, n);
+  size_t i, j;
+
+  /* callers overwrite some elements with gsl_spmatrix_set() */
+  gsl_spmatrix_hash_init(T);
+
+  for (i = 0; i < k; ++i)
+    {
+      for (j = 0; j < k; ++j)
+        {
+          size_t idx = i * k + j;
+
+          gsl_spmatrix_set(T, idx, idx, 4.0 + shift * idx);
+
+          if (i > 0)
+            gsl_spmatrix_set(T, idx, idx - k, -1.0);
+          if (i + 1 < k)
+            gsl_spmatrix_set(T, idx, idx + k, -1.0);
+          if (j > 0)
+            gsl_spmatrix_set(T, idx, idx - 1, -1.0);
+          if (j + 1 < k)
+            gsl_spmatrix_set(T, idx, idx + 1, -1.0);
+        }
+    }
+
+  return T;
+} /* create_poisson2d() */
+
+/* Jacobi preconditioner: z = D^{-1} r, params is the diagonal of A */
+static int
+precond_jacobi(const gsl_vector *r, gsl_vector *z, void *params)
+{
+  const gsl_vector *d = (const gsl_vector *) params;
+  size_t i;
+
+  for (i = 0; i < r->size; ++i)
+    gsl_vector_set(z, i, gsl_vector_get(r, i) / gsl_vector_get(d, i));
+
+  return GSL_SUCCESS;
+} /* precond_jacobi() */
+
+/*
+test_itersolve_system()
+  Solve A x = b with an iterative solver, calling
+gsl_splinalg_itersolve_iterate() until convergence, and check the
+true residual
+
+Inputs: T     - solver type
+        A     - matrix
+        m     - solver parameter
+        P     - preconditioner or NULL
+        tol   - tolerance
+        r     - random number generator
+        desc  - test description
+*/
+
+static void
+test_itersolve_system(const gsl_splinalg_itersolve_type *T,
+                      const gsl_spmatrix *A, const size_t m,
+                      const gsl_splinalg_precond *P, const double tol,
+                      const gsl_rng *r, const char *desc)
+{
+  const size_t n = A->size1;
+  const size_t maxcall = 1000;
+  gsl_splinalg_itersolve *w = gsl_splinalg_itersolve_alloc(T, n, m);
+  gsl_vector *b = gsl_vector_alloc(n);
+  gsl_vector *x = gsl_vector_calloc(n);
+  gsl_vector *res = gsl_vector_alloc(n);
+  size_t ncall = 0;
+  double normr;
+  int status;
+
+  create_random_vector(b, r);
+  gsl_splinalg_itersolve_set_precond(w, P);
+
+  do
+    status = gsl_splinalg_itersolve_iterate(A, b, tol, x, w);
+  while (status == GSL_CONTINUE && ++ncall < maxcall);
+
+  gsl_test(status, "test_itersolve: %s %s n=%zu m=%zu status",
+           gsl_splinalg_itersolve_name(w), desc, n, m);
+
+  /* res = b - A x */
+  gsl_vector_memcpy(res, b);
+  gsl_spblas_dgemv(CblasNoTrans, -1.0, A, x, 1.0, res);
+  normr = gsl_blas_dnrm2(res);
+
+  gsl_test(normr > 10.0 * tol * gsl_blas_dnrm2(b),
+           "test_itersolve: %s %s n=%zu m=%zu residual %e niter=%zu",
+           gsl_splinalg_itersolve_name(w), desc, n, m, normr,
+           gsl_splinalg_itersolve_niter(w));
+
+  gsl_test(gsl_splinalg_itersolve_normr(w) > tol * gsl_blas_dnrm2(b),
+           "test_itersolve: %s %s n=%zu m=%zu normr",
+           gsl_splinalg_itersolve_name(w), desc, n, m);
+
+  gsl_splinalg_itersolve_free(w);
+  gsl_vector_free(b);
+  gsl_vector_free(x);
+  gsl_vector_free(res);
+} /* test_itersolve_system() */
+
+/*
+test_cg()
+  Test the CG solver on the 2D Poisson matrix in each storage format,
+with and without a Jacobi preconditioner
+*/
+
+static void
+test_cg(const size_t k, const double shift, const gsl_rng *r)
+{
+  gsl_spmatrix *T = create_poisson2d(k, shift);
+  gsl_spmatrix *C = gsl_spmatrix_compress(T);
+  gsl_spmatrix *R = gsl_spmatrix_crs(T);
+  gsl_vector *d = gsl_vector_alloc(k * k);
+  gsl_splinalg_precond P;
+  size_t i;
+
+  for (i = 0; i < k * k; ++i)
+    gsl_vector_set(d, i, gsl_spmatrix_get(T, i, i));
+
+  P.solve = precond_jacobi;
+  P.params = d;
+
+  test_itersolve_system(gsl_splinalg_itersolve_cg, T, 0, NULL, 1.0e-10, r,
+                        "triplet");
+  test_itersolve_system(gsl_splinalg_itersolve_cg, C, 0, NULL, 1.0e-10, r,
+                        "CCS");
+  test_itersolve_system(gsl_splinalg_itersolve_cg, R, 0, NULL, 1.0e-10, r,
+                        "CRS");
+  test_itersolve_system(gsl_splinalg_itersolve_cg, R, 0, &P, 1.0e-10, r,
+                        "CRS jacobi");
+
+  /* restart every 5 iterations */
+  test_itersolve_system(gsl_splinalg_itersolve_cg, R, 5, &P, 1.0e-8, r,
+                        "CRS jacobi restarted");
+
+  gsl_spmatrix_free(T);
+  gsl_spmatrix_free(C);
+  gsl_spmatrix_free(R);
+  gsl_vector_free(d);
+} /* test_cg() */
+
+/*
+test_nonsymm()
+  Test the GMRES and BiCGStab solvers on a convection-diffusion
+matrix: the 2D Poisson matrix plus a centered first derivative term
+with coefficient c, which makes the matrix nonsymmetric
+*/
+
+static void
+test_nonsymm(const size_t k, const double c, const gsl_rng *r)
+{
+  const size_t n = k * k;
+  gsl_spmatrix *T = create_poisson2d(k, 0.1);
+  gsl_spmatrix *C, *R;
+  gsl_vector *d = gsl_vector_alloc(n);
+  gsl_splinalg_precond P;
+  size_t i;
+
+  for (i = 0; i < n; ++i)
+    {
+      if (i % k + 1 < k)
+        gsl_spmatrix_set(T, i, i + 1, -1.0 + c);
+      if (i % k > 0)
+        gsl_spmatrix_set(T, i, i - 1, -1.0 - c);
+
+      gsl_vector_set(d, i, gsl_spmatrix_get(T, i, i));
+    }
+
+  C = gsl_spmatrix_compress(T);
+  R = gsl_spmatrix_crs(T);
+
+  P.solve = precond_jacobi;
+  P.params = d;
+
+  test_itersolve_system(gsl_splinalg_itersolve_gmres, T, 0, NULL, 1.0e-10, r,
+                        "triplet");
+  test_itersolve_system(gsl_splinalg_itersolve_gmres, C, 20, NULL, 1.0e-10, r,
+                        "CCS");
+  test_itersolve_system(gsl_splinalg_itersolve_gmres, R, 50, &P, 1.0e-10, r,
+                        "CRS jacobi");
+  test_itersolve_system(gsl_splinalg_itersolve_gmres, R, n, NULL, 1.0e-10, r,
+                        "CRS full");
+
+  test_itersolve_system(gsl_splinalg_itersolve_bicgstab, T, 0, NULL, 1.0e-10, r,
+                        "triplet");
+  test_itersolve_system(gsl_splinalg_itersolve_bicgstab, C, 0, NULL, 1.0e-10, r,
+                        "CCS");
+  test_itersolve_system(gsl_splinalg_itersolve_bicgstab, R, 0, &P, 1.0e-10, r,
+                        "CRS jacobi");
+  test_itersolve_system(gsl_splinalg_itersolve_bicgstab, R, 7, &P, 1.0e-10, r,
+                        "CRS jacobi restarted");
+
+  gsl_spmatrix_free(T);
+  gsl_spmatrix_free(C);
+  gsl_spmatrix_free(R);
+  gsl_vector_free(d);
+} /* test_nonsymm() */
+
+/* convert a CCS matrix to dense */
+static void
+ccs_to_dense(const gsl_spmatrix *A, gsl_matrix *Ad)
+{
+  size_t j, p;
+
+  gsl_matrix_set_zero(Ad);
+
+  for (j = 0; j < A->size2; ++j)
+    {
+      for (p = A->p[j]; p < A->p[j + 1]; ++p)
+        gsl_matrix_set(Ad, A->i[p], j, A->data[p]);
+    }
+} /* ccs_to_dense() */
+
+/*
+test_ilu_ic()
+  Test ILU(0) and IC(0): the product of the factors must equal A on the
+sparsity pattern of A, the factorization can be recomputed for new
+values, and the factors used as preconditioners must reduce the number
+of iterations of GMRES and CG
+*/
+
+static void
+test_ilu_ic(const size_t k, const double c, const gsl_rng *r)
+{
+  const size_t n = k * k;
+  gsl_spmatrix *T = create_poisson2d(k, 0.1);
+  gsl_spmatrix *S, *N;
+  gsl_matrix *Ad = gsl_matrix_alloc(n, n);
+  gsl_matrix *L = gsl_matrix_alloc(n, n);
+  gsl_matrix *U = gsl_matrix_alloc(n, n);
+  gsl_matrix *LU = gsl_matrix_alloc(n, n);
+  gsl_splinalg_ilu0_workspace *ilu;
+  gsl_splinalg_ic0_workspace *ic;
+  size_t i, j, pass, p;
+  int status;
+
+  /* symmetric matrix S, nonsymmetric matrix N */
+  S = gsl_spmatrix_compress_sorted(T, GSL_SPMATRIX_CCS);
+
+  for (i = 0; i < n; ++i)
+    {
+      if (i % k + 1 < k)
+        gsl_spmatrix_set(T, i, i + 1, -1.0 + c);
+      if (i % k > 0)
+        gsl_spmatrix_set(T, i, i - 1, -1.0 - c);
+    }
+
+  N = gsl_spmatrix_compress_sorted(T, GSL_SPMATRIX_CCS);
+
+  ilu = gsl_splinalg_ilu0_alloc(N);
+  ic = gsl_splinalg_ic0_alloc(S);
+
+  for (pass = 0; pass < 2; ++pass)
+    {
+      /* second pass: same pattern, new values */
+      if (pass == 1)
+        {
+          for (j = 0; j < n; ++j)
+            {
+              for (p = N->p[j]; p < N->p[j + 1]; ++p)
+                {
+                  if (N->i[p] == j)
+                    N->data[p] += 1.0 + gsl_rng_uniform(r);
+                }
+            }
+
+          gsl_spmatrix_scale(S, 2.5);
+        }
+
+      /* ILU(0): (L U)_ij = A_ij on the pattern of A */
+      status = gsl_splinalg_ilu0_decomp(N, ilu);
+
+      gsl_matrix_set_zero(L);
+      gsl_matrix_set_zero(U);
+      for (j = 0; j < n; ++j)
+        {
+          gsl_matrix_set(L, j, j, 1.0);
+
+          for (p = ilu->LU->p[j]; p < ilu->LU->p[j + 1]; ++p)
+            {
+              i = ilu->LU->i[p];
+
+              if (i > j)
+                gsl_matrix_set(L, i, j, ilu->LU->data[p]);
+              else
+                gsl_matrix_set(U, i, j, ilu->LU->data[p]);
+            }
+        }
+
+      gsl_blas_dgemm(CblasNoTrans, CblasNoTrans, 1.0, L, U, 0.0, LU);
+      ccs_to_dense(N, Ad);
+
+      for (j = 0; j < n; ++j)
+        {
+          for (p = N->p[j]; p < N->p[j + 1]; ++p)
+            {
+              i = N->i[p];
+
+              if (fabs(gsl_matrix_get(LU, i, j) - gsl_matrix_get(Ad, i, j)) > 1.0e-12)
+                status = 1;
+            }
+        }
+
+      gsl_test(status, "test_ilu_ic: ILU(0) k=%zu pass=%zu", k, pass);
+
+      /* IC(0): (L L^T)_ij = A_ij on the pattern of A */
+      status = gsl_splinalg_ic0_decomp(S, ic);
+
+      ccs_to_dense(ic->L, L);
+      gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, L, L, 0.0, LU);
+      ccs_to_dense(S, Ad);
+
+      for (j = 0; j < n; ++j)
+        {
+          for (p = S->p[j]; p < S->p[j + 1]; ++p)
+            {
+              i = S->i[p];
+
+              if (fabs(gsl_matrix_get(LU, i, j) - gsl_matrix_get(Ad, i, j)) > 1.0e-12)
+                status = 1;
+            }
+        }
+
+      gsl_test(status, "test_ilu_ic: IC(0) k=%zu pass=%zu", k, pass);
+    }
+
+  /* preconditioned solves */
+  {
+    gsl_splinalg_itersolve *w0 =
+      gsl_splinalg_itersolve_alloc(gsl_splinalg_itersolve_cg, n, 0);
+    gsl_splinalg_itersolve *w1 =
+      gsl_splinalg_itersolve_alloc(gsl_splinalg_itersolve_cg, n, 0);
+    gsl_splinalg_itersolve *g0 =
+      gsl_splinalg_itersolve_alloc(gsl_splinalg_itersolve_gmres, n, 30);
+    gsl_splinalg_itersolve *g1 =
+      gsl_splinalg_itersolve_alloc(gsl_splinalg_itersolve_gmres, n, 30);
+    gsl_splinalg_precond Pic, Pilu;
+    gsl_vector *b = gsl_vector_alloc(n);
+    gsl_vector *x = gsl_vector_alloc(n);
+
+    Pic.solve = gsl_splinalg_ic0_precond;
+    Pic.params = ic;
+    Pilu.solve = gsl_splinalg_ilu0_precond;
+    Pilu.params = ilu;
+
+    gsl_splinalg_itersolve_set_precond(w1, &Pic);
+    gsl_splinalg_itersolve_set_precond(g1, &Pilu);
+
+    create_random_vector(b, r);
+
+    gsl_vector_set_zero(x);
+    while (gsl_splinalg_itersolve_iterate(S, b, 1.0e-10, x, w0) == GSL_CONTINUE)
+      ;
+    gsl_vector_set_zero(x);
+    while (gsl_splinalg_itersolve_iterate(S, b, 1.0e-10, x, w1) == GSL_CONTINUE)
+      ;
+
+    gsl_test(gsl_splinalg_itersolve_niter(w1) >= gsl_splinalg_itersolve_niter(w0),
+             "test_ilu_ic: IC(0) preconditioned CG k=%zu niter=%zu unpreconditioned=%zu",
+             k, gsl_splinalg_itersolve_niter(w1), gsl_splinalg_itersolve_niter(w0));
+
+    gsl_vector_set_zero(x);
+    while (gsl_splinalg_itersolve_iterate(N, b, 1.0e-10, x, g0) == GSL_CONTINUE)
+      ;
+    gsl_vector_set_zero(x);
+    while (gsl_splinalg_itersolve_iterate(N, b, 1.0e-10, x, g1) == GSL_CONTINUE)
+      ;
+
+    gsl_test(gsl_splinalg_itersolve_niter(g1) >= gsl_splinalg_itersolve_niter(g0),
+             "test_ilu_ic: ILU(0) preconditioned GMRES k=%zu niter=%zu unpreconditioned=%zu",
+             k, gsl_splinalg_itersolve_niter(g1), gsl_splinalg_itersolve_niter(g0));
+
+    gsl_splinalg_itersolve_free(w0);
+    gsl_splinalg_itersolve_free(w1);
+    gsl_splinalg_itersolve_free(g0);
+    gsl_splinalg_itersolve_free(g1);
+    gsl_vector_free(b);
+    gsl_vector_free(x);
+  }
+
+  /* IC(0) of a matrix whose pattern differs from the workspace */
+  {
+    gsl_error_handler_t *handler = gsl_set_error_handler_off();
+    gsl_spmatrix *D = gsl_spmatrix_alloc_nzmax(n, n, n, GSL_SPMATRIX_CCS);
+    gsl_spmatrix *P = gsl_spmatrix_memcpy(S);
+
+    for (j = 0; j < n; ++j)
+      {
+        D->p[j] = j;
+        D->i[j] = j;
+        D->data[j] = 1.0;
+      }
+
+    D->p[n] = n;
+    D->nz = n;
+
+    /* same nz, but the first column loses its last element */
+    P->p[1] -= 1;
+
+    status = gsl_splinalg_ic0_decomp(D, ic) != GSL_EBADLEN ||
+             gsl_splinalg_ic0_decomp(P, ic) != GSL_EBADLEN;
+    gsl_test(status, "test_ilu_ic: IC(0) k=%zu pattern mismatch", k);
+
+    gsl_spmatrix_free(D);
+    gsl_spmatrix_free(P);
+    gsl_set_error_handler(handler);
+  }
+
+  /* ILU(0) of a matrix whose pattern differs from the workspace */
+  {
+    gsl_error_handler_t *handler = gsl_set_error_handler_off();
+    gsl_spmatrix *P = gsl_spmatrix_memcpy(N);
+    gsl_spmatrix *Q = gsl_spmatrix_memcpy(N);
+
+    /* same nz, but the first column loses its last element */
+    P->p[1] -= 1;
+
+    /* same column pointers, but the last element moves to another row */
+    Q->i[Q->nz - 1] -= 1;
+
+    status = gsl_splinalg_ilu0_decomp(P, ilu) != GSL_EBADLEN ||
+             gsl_splinalg_ilu0_decomp(Q, ilu) != GSL_EBADLEN;
+    gsl_test(status, "test_ilu_ic: ILU(0) k=%zu pattern mismatch", k);
+
+    gsl_spmatrix_free(P);
+    gsl_spmatrix_free(Q);
+    gsl_set_error_handler(handler);
+  }
+
+  gsl_splinalg_ilu0_free(ilu);
+  gsl_splinalg_ic0_free(ic);
+  gsl_spmatrix_free(T);
+  gsl_spmatrix_free(S);
+  gsl_spmatrix_free(N);
+  gsl_matrix_free(Ad);
+  gsl_matrix_free(L);
+  gsl_matrix_free(U);
+  gsl_matrix_free(LU);
+} /* test_ilu_ic() */
+
+/*
+test_dtrsv()
+  Test gsl_spblas_dtrsv() and gsl_spblas_dtrsv_levels() against the
+dense gsl_blas_dtrsv() for all combinations of Uplo, TransA and Diag,
+for a matrix with elements in both triangles. The level scheduled solve
+must give identical results with 1 and nthreads threads
+*/
+
+static void
+test_dtrsv(const size_t N, const double density, const size_t nthreads,
+           const gsl_rng *r)
+{
+  const CBLAS_UPLO_t uplo[2] = { CblasLower, CblasUpper };
+  const CBLAS_TRANSPOSE_t trans[2] = { CblasNoTrans, CblasTrans };
+  const CBLAS_DIAG_t diag[2] = { CblasNonUnit, CblasUnit };
+  gsl_spmatrix *T = create_random_sparse(N, N, density, r);
+  gsl_spmatrix *mats[2];
+  gsl_matrix *Ad = gsl_matrix_alloc(N, N);
+  gsl_vector *b = gsl_vector_alloc(N);
+  gsl_vector *x_dense = gsl_vector_alloc(N);
+  gsl_vector *x = gsl_vector_alloc(N);
+  gsl_vector *x_par = gsl_vector_alloc(N);
+  size_t i, k, iu, it, id;
+  int status;
+
+  /* dominant diagonal keeps the triangular systems well conditioned */
+  gsl_spmatrix_hash_init(T);
+  for (i = 0; i < N; ++i)
+    gsl_spmatrix_set(T, i, i, 1.0 + 0.2 * (double) N * density);
+
+  mats[0] = gsl_spmatrix_compress(T);
+  mats[1] = gsl_spmatrix_crs(T);
+  ccs_to_dense(mats[0], Ad);
+
+  create_random_vector(b, r);
+
+  for (k = 0; k < 2; ++k)
+    {
+      const char *fmt = (k == 0) ? "compressed column" : "compressed row";
+
+      for (iu = 0; iu < 2; ++iu)
+        {
+          for (it = 0; it < 2; ++it)
+            {
+              gsl_spblas_trsv_workspace *w =
+                gsl_spblas_trsv_alloc(uplo[iu], trans[it], mats[k]);
+
+              for (id = 0; id < 2; ++id)
+                {
+                  gsl_vector_memcpy(x_dense, b);
+                  gsl_blas_dtrsv(uplo[iu], trans[it], diag[id], Ad, x_dense);
+
+                  gsl_vector_memcpy(x, b);
+                  status = gsl_spblas_dtrsv(uplo[iu], trans[it], diag[id],
+                                            mats[k], x);
+                  gsl_test(status, "test_dtrsv: N=%zu %s status", N, fmt);
+                  test_vectors(x, x_dense, 1.0e-10, "test_dtrsv: dtrsv");
+
+                  gsl_spblas_set_num_threads(1);
+                  gsl_vector_memcpy(x, b);
+                  status = gsl_spblas_dtrsv_levels(diag[id], mats[k], w, x);
+                  gsl_test(status, "test_dtrsv: N=%zu %s levels status",
+                           N, fmt);
+                  test_vectors(x, x_dense, 1.0e-10, "test_dtrsv: levels");
+
+                  gsl_spblas_set_num_threads(nthreads);
+                  gsl_vector_memcpy(x_par, b);
+                  gsl_spblas_dtrsv_levels(diag[id], mats[k], w, x_par);
+
+                  status = 0;
+                  for (i = 0; i < N; ++i)
+                    {
+                      if (gsl_vector_get(x_par, i) != gsl_vector_get(x, i))
+                        status = 1;
+                    }
+
+                  gsl_test(status, "test_dtrsv: N=%zu %s uplo=%zu trans=%zu diag=%zu nthreads=%zu levels bitwise",
+                           N, fmt, iu, it, id, nthreads);
+
+                  gsl_spblas_set_num_threads(1);
+                }
+
+              /* a chain of dependencies gives one level per row at most */
+              gsl_test(w->nlevels < 1 || w->nlevels > N,
+                       "test_dtrsv: N=%zu %s nlevels=%zu", N, fmt, w->nlevels);
+
+              gsl_spblas_trsv_free(w);
+            }
+        }
+    }
+
+  /* a zero diagonal element is reported */
+  {
+    gsl_spmatrix *Z;
+    gsl_error_handler_t *handler;
+    int status_levels;
+    gsl_spblas_trsv_workspace *w;
+
+    gsl_spmatrix_set(T, N / 2, N / 2, 0.0);
+    Z = gsl_spmatrix_compress(T);
+    w = gsl_spblas_trsv_alloc(CblasLower, CblasNoTrans, Z);
+
+    handler = gsl_set_error_handler_off();
+    gsl_vector_memcpy(x, b);
+    status = gsl_spblas_dtrsv(CblasLower, CblasNoTrans, CblasNonUnit, Z, x);
+    gsl_vector_memcpy(x, b);
+    status_levels = gsl_spblas_dtrsv_levels(CblasNonUnit, Z, w, x);
+    gsl_set_error_handler(handler);
+
+    gsl_test(status != GSL_ESING || status_levels != GSL_ESING,
+             "test_dtrsv: N=%zu singular", N);
+
+    gsl_spblas_trsv_free(w);
+    gsl_spmatrix_free(Z);
+  }
+
+  /* a matrix with another pattern is rejected by the levels solver */
+  {
+    gsl_spblas_trsv_workspace *w =
+      gsl_spblas_trsv_alloc(CblasLower, CblasNoTrans, mats[0]);
+    gsl_spmatrix *Y = gsl_spmatrix_memcpy(mats[0]);
+    gsl_spmatrix *D = gsl_spmatrix_alloc(N, N);
+    gsl_spmatrix *DC;
+    gsl_error_handler_t *handler;
+    int status_nz, status_pattern = GSL_EBADLEN;
+    size_t q = Y->nz;
+    size_t j, p;
+
+    for (i = 0; i < N; ++i)
+      gsl_spmatrix_set(D, i, i, 1.0);
+
+    DC = gsl_spmatrix_compress(D);
+
+    /* find an element of the strict lower triangle */
+    for (j = 0; j < N && q == Y->nz; ++j)
+      {
+        for (p = Y->p[j]; p < Y->p[j + 1]; ++p)
+          {
+            if (Y->i[p] > j)
+              {
+                q = p;
+                break;
+              }
+          }
+      }
+
+    handler = gsl_set_error_handler_off();
+
+    gsl_vector_memcpy(x, b);
+    status_nz = (DC->nz == mats[0]->nz) ? GSL_EBADLEN :
+                gsl_spblas_dtrsv_levels(CblasNonUnit, DC, w, x);
+
+    if (q < Y->nz)
+      {
+        /* same number of elements, one moved up by a row */
+        Y->i[q] = Y->i[q] - 1;
+        gsl_vector_memcpy(x, b);
+        status_pattern = gsl_spblas_dtrsv_levels(CblasNonUnit, Y, w, x);
+      }
+
+    gsl_set_error_handler(handler);
+
+    gsl_test(status_nz != GSL_EBADLEN || status_pattern != GSL_EBADLEN,
+             "test_dtrsv: N=%zu levels pattern mismatch", N);
+
+    gsl_spblas_trsv_free(w);
+    gsl_spmatrix_free(Y);
+    gsl_spmatrix_free(D);
+    gsl_spmatrix_free(DC);
+  }
+
+  gsl_spmatrix_free(T);
+  gsl_spmatrix_free(mats[0]);
+  gsl_spmatrix_free(mats[1]);
+  gsl_matrix_free(Ad);
+  gsl_vector_free(b);
+  gsl_vector_free(x_dense);
+  gsl_vector_free(x);
+  gsl_vector_free(x_par);
+} /* test_dtrsv() */
+
+/*
+cholesky_residual()
+  Solve A x = b with the Cholesky factor in w for a random b and return
+the relative residual || A x - b || / || b ||, where F is the full
+symmetric matrix
+*/
+
+static double
+cholesky_residual(const gsl_spmatrix *F,
+                  const gsl_splinalg_cholesky_workspace *w,
+                  const gsl_rng *r)
+{
+  const size_t n = F->size1;
+  gsl_vector *b = gsl_vector_alloc(n);
+  gsl_vector *x = gsl_vector_alloc(n);
+  double normb, normr;
+
+  create_random_vector(b, r);
+  gsl_splinalg_cholesky_solve(w, b, x);
+
+  normb = gsl_blas_dnrm2(b);
+  gsl_spblas_dgemv(CblasNoTrans, 1.0, F, x, -1.0, b);
+  normr = gsl_blas_dnrm2(b);
+
+  gsl_vector_free(b);
+  gsl_vector_free(x);
+
+  return normr / normb;
+} /* cholesky_residual() */
+
+/*
+test_cholesky()
+  Test the supernodal Cholesky factorization: L L^T must equal A, the
+factorization must be repeatable for new values with the same symbolic
+analysis, only the lower triangle of A may be given, and a matrix which
+is not positive definite must be detected
+*/
+
+static void
+test_cholesky(const size_t k, const double shift, const gsl_rng *r)
+{
+  const size_t n = k * k;
+  gsl_spmatrix *T = create_poisson2d(k, shift);
+  gsl_spmatrix *A = gsl_spmatrix_compress(T);
+  gsl_matrix *Ad = gsl_matrix_alloc(n, n);
+  gsl_matrix *L = gsl_matrix_alloc(n, n);
+  gsl_matrix *LLT = gsl_matrix_alloc(n, n);
+  gsl_splinalg_cholesky_workspace *w = gsl_splinalg_cholesky_alloc(A);
+  size_t i, j, s, c, p;
+  int status;
+
+  status = gsl_splinalg_cholesky_decomp(A, w);
+  gsl_test(status, "test_cholesky: k=%zu decomp status", k);
+
+  /* L L^T = A */
+  gsl_matrix_set_zero(L);
+  for (s = 0; s < w->nsuper; ++s)
+    {
+      const size_t nrows = w->rowptr[s + 1] - w->rowptr[s];
+
+      for (c = 0; c < w->super[s + 1] - w->super[s]; ++c)
+        {
+          for (i = c; i < nrows; ++i)
+            {
+              gsl_matrix_set(L, w->rowind[w->rowptr[s] + i], w->super[s] + c,
+                             w->blk[w->blkptr[s] + c * nrows + i]);
+            }
+        }
+    }
+
+  gsl_blas_dgemm(CblasNoTrans, CblasTrans, 1.0, L, L, 0.0, LLT);
+  ccs_to_dense(A, Ad);
+
+  status = 0;
+  for (i = 0; i < n; ++i)
+    {
+      for (j = 0; j < n; ++j)
+        {
+          if (fabs(gsl_matrix_get(LLT, i, j) - gsl_matrix_get(Ad, i, j)) > 1.0e-12)
+            status = 1;
+        }
+    }
+
+  gsl_test(status, "test_cholesky: k=%zu L L^T = A", k);
+  gsl_test(w->nsuper > n || (n > 1 && w->nsuper == n),
+           "test_cholesky: k=%zu nsuper=%zu", k, w->nsuper);
+  gsl_test(cholesky_residual(A, w, r) > 1.0e-12,
+           "test_cholesky: k=%zu residual", k);
+
+  /* new values, same pattern */
+  gsl_spmatrix_scale(A, 3.0);
+  for (j = 0; j < n; ++j)
+    {
+      for (p = A->p[j]; p < A->p[j + 1]; ++p)
+        {
+          if (A->i[p] == j)
+            A->data[p] += gsl_rng_uniform(r);
+        }
+    }
+
+  status = gsl_splinalg_cholesky_decomp(A, w);
+  gsl_test(status, "test_cholesky: k=%zu refactor status", k);
+  gsl_test(cholesky_residual(A, w, r) > 1.0e-12,
+           "test_cholesky: k=%zu refactor residual", k);
+
+  /* not positive definite */
+  {
+    gsl_error_handler_t *handler;
+
+    for (p = A->p[n / 2]; p < A->p[n / 2 + 1]; ++p)
+      {
+        if (A->i[p] == n / 2)
+          A->data[p] = -1.0;
+      }
+
+    handler = gsl_set_error_handler_off();
+    status = gsl_splinalg_cholesky_decomp(A, w);
+    gsl_set_error_handler(handler);
+
+    gsl_test(status != GSL_EDOM, "test_cholesky: k=%zu not positive definite",
+             k);
+  }
+
+  gsl_splinalg_cholesky_free(w);
+
+  /* random symmetric matrix, with only the lower triangle given */
+  {
+    gsl_spmatrix *R = create_random_sparse(n, n, (n > 1) ? 3.0 / n : 0.0, r);
+    gsl_spmatrix *Tf = gsl_spmatrix_alloc(n, n);
+    gsl_spmatrix *Tl = gsl_spmatrix_alloc(n, n);
+    gsl_spmatrix *F, *Lo;
+
+    for (p = 0; p < R->nz; ++p)
+      {
+        i = GSL_MAX(R->i[p], R->p[p]);
+        j = GSL_MIN(R->i[p], R->p[p]);
+
+        if (i == j)
+          continue;
+
+        gsl_spmatrix_set(Tf, i, j, R->data[p]);
+        gsl_spmatrix_set(Tf, j, i, R->data[p]);
+        gsl_spmatrix_set(Tl, i, j, R->data[p]);
+      }
+
+    for (i = 0; i < n; ++i)
+      {
+        gsl_spmatrix_set(Tf, i, i, 2.0 + (double) n * 0.1);
+        gsl_spmatrix_set(Tl, i, i, 2.0 + (double) n * 0.1);
+      }
+
+    F = gsl_spmatrix_compress(Tf);
+    Lo = gsl_spmatrix_compress(Tl);
+
+    w = gsl_splinalg_cholesky_alloc(Lo);
+    status = gsl_splinalg_cholesky_decomp(Lo, w);
+    gsl_test(status, "test_cholesky: n=%zu random lower status", n);
+    gsl_test(cholesky_residual(F, w, r) > 1.0e-12,
+             "test_cholesky: n=%zu random lower residual", n);
+
+    gsl_splinalg_cholesky_free(w);
+    gsl_spmatrix_free(R);
+    gsl_spmatrix_free(Tf);
+    gsl_spmatrix_free(Tl);
+    gsl_spmatrix_free(F);
+    gsl_spmatrix_free(Lo);
+  }
+
+  gsl_spmatrix_free(T);
+  gsl_spmatrix_free(A);
+  gsl_matrix_free(Ad);
+  gsl_matrix_free(L);
+  gsl_matrix_free(LLT);
+} /* test_cholesky() */
+
+/* random permutation by Fisher-Yates shuffle */
+static void
+create_random_permutation(gsl_permutation *p, const gsl_rng *r)
+{
+  size_t i;
+
+  gsl_permutation_init(p);
+
+  for (i = p->size; i > 1; --i)
+    {
+      size_t j = (size_t) (gsl_rng_uniform(r) * i);
+      size_t tmp = p->data[i - 1];
+
+      p->data[i - 1] = p->data[j];
+      p->data[j] = tmp;
+    }
+} /* create_random_permutation() */
+
+/* bandwidth max |i - j| of a compressed matrix */
+static size_t
+spmatrix_bandwidth(const gsl_spmatrix *A)
+{
+  const size_t nouter = GSLSP_ISCCS(A) ? A->size2 : A->size1;
+  size_t j, p, bw = 0;
+
+  for (j = 0; j < nouter; ++j)
+    {
+      for (p = A->p[j]; p < A->p[j + 1]; ++p)
+        {
+          size_t i = A->i[p];
+          bw = GSL_MAX(bw, (i > j) ? i - j : j - i);
+        }
+    }
+
+  return bw;
+} /* spmatrix_bandwidth() */
+
+/*
+test_permute()
+  Test gsl_spmatrix_permute() in all storage formats against
+C_ij = A_{p_i,q_j}
+*/
+
+static void
+test_permute(const size_t M, const size_t N, const gsl_rng *r)
+{
+  gsl_spmatrix *T = create_random_sparse(M, N, 0.2, r);
+  gsl_permutation *p = gsl_permutation_alloc(M);
+  gsl_permutation *q = gsl_permutation_alloc(N);
+  gsl_spmatrix *mats[3];
+  size_t i, j, k;
+  int status;
+
+  mats[0] = T;
+  mats[1] = gsl_spmatrix_compress(T);
+  mats[2] = gsl_spmatrix_crs(T);
+
+  create_random_permutation(p, r);
+  create_random_permutation(q, r);
+
+  for (k = 0; k < 3; ++k)
+    {
+      gsl_spmatrix *C = gsl_spmatrix_permute(mats[k], p, q);
+      gsl_spmatrix *D = gsl_spmatrix_permute(mats[k], NULL, q);
+
+      status = (GSLSP_TYPE(C) != GSLSP_TYPE(mats[k])) || C->nz != T->nz;
+      for (i = 0; i < M; ++i)
+        {
+          for (j = 0; j < N; ++j)
+            {
+              double aij = gsl_spmatrix_get(T, p->data[i], q->data[j]);
+
+              if (gsl_spmatrix_get(C, i, j) != aij)
+                status = 1;
+
+              if (gsl_spmatrix_get(D, i, j) != gsl_spmatrix_get(T, i, q->data[j]))
+                status = 1;
+            }
+        }
+
+      gsl_test(status, "test_permute: M=%zu N=%zu type=%zu", M, N, k);
+
+      if (k > 0)
+        {
+          const size_t nouter = (k == 1) ? N : M;
+
+          status = !GSLSP_ISSORTED(C);
+          for (j = 0; j < nouter; ++j)
+            {
+              size_t s;
+
+              for (s = C->p[j] + 1; s < C->p[j + 1]; ++s)
+                {
+                  if (C->i[s - 1] >= C->i[s])
+                    status = 1;
+                }
+            }
+
+          gsl_test(status, "test_permute: M=%zu N=%zu type=%zu sorted",
+                   M, N, k);
+        }
+
+      gsl_spmatrix_free(C);
+      gsl_spmatrix_free(D);
+    }
+
+  gsl_spmatrix_free(mats[0]);
+  gsl_spmatrix_free(mats[1]);
+  gsl_spmatrix_free(mats[2]);
+  gsl_permutation_free(p);
+  gsl_permutation_free(q);
+} /* test_permute() */
+
+/*
+mm_roundtrip()
+  Write A with gsl_spmatrix_fwrite_mm() and read it back with
+nthreads threads
+*/
+
+static gsl_spmatrix *
+mm_roundtrip(const gsl_spmatrix *A, const size_t flags, const size_t nthreads)
+{
+  FILE *f = tmpfile();
+  gsl_spmatrix *B;
+
+  gsl_spmatrix_fwrite_mm(f, A, flags);
+  rewind(f);
+
+  gsl_spblas_set_num_threads(nthreads);
+  B = gsl_spmatrix_fread_mm(f);
+  gsl_spblas_set_num_threads(1);
+
+  fclose(f);
+
+  return B;
+} /* mm_roundtrip() */
+
+/*
+mm_identical()
+  Return 1 if the triplet arrays of a and b are identical
+*/
+
+static int
+mm_identical(const gsl_spmatrix *a, const gsl_spmatrix *b)
+{
+  size_t n;
+
+  if (a->size1 != b->size1 || a->size2 != b->size2 || a->nz != b->nz)
+    return 0;
+
+  for (n = 0; n < a->nz; ++n)
+    {
+      if (a->i[n] != b->i[n] || a->p[n] != b->p[n] ||
+          a->data[n] != b->data[n])
+        return 0;
+    }
+
+  return 1;
+} /* mm_identical() */
+
+/*
+test_mm()
+  Test Matrix Market output and input: general, pattern and symmetric
+files written from each storage format must read back exactly, and
+the parallel reader must give the same triplets as the serial one
+*/
+
+static void
+test_mm(const size_t M, const size_t N, const double density,
+        const size_t nthreads, const gsl_rng *r)
+{
+  gsl_spmatrix *T = create_random_sparse(M, N, density, r);
+  gsl_spmatrix *mats[3];
+  gsl_spmatrix *B, *C;
+  size_t k, n;
+  int status;
+
+  mats[0] = T;
+  mats[1] = gsl_spmatrix_compress(T);
+  mats[2] = gsl_spmatrix_crs(T);
+
+  for (k = 0; k < 3; ++k)
+    {
+      B = mm_roundtrip(mats[k], 0, 1);
+      C = mm_roundtrip(mats[k], 0, nthreads);
+
+      status = !GSLSP_ISTRIPLET(B) || B->hash != NULL ||
+               !gsl_spmatrix_equal(T, B);
+      gsl_test(status, "test_mm: M=%zu N=%zu type=%zu general", M, N, k);
+
+      status = !mm_identical(B, C);
+      gsl_test(status, "test_mm: M=%zu N=%zu type=%zu threads=%zu",
+               M, N, k, nthreads);
+
+      gsl_spmatrix_free(B);
+      gsl_spmatrix_free(C);
+    }
+
+  /* pattern */
+  B = mm_roundtrip(mats[1], GSL_SPMATRIX_MM_PATTERN, nthreads);
+  status = B->nz != T->nz;
+  for (n = 0; n < B->nz; ++n)
+    {
+      if (B->data[n] != 1.0 || gsl_spmatrix_get(T, B->i[n], B->p[n]) == 0.0)
+        status = 1;
+    }
+  gsl_test(status, "test_mm: M=%zu N=%zu pattern", M, N);
+  gsl_spmatrix_free(B);
+
+  /* fprintf with a lossless format */
+  {
+    FILE *f = tmpfile();
+
+    gsl_spmatrix_fprintf(f, mats[2], "%.17g");
+    rewind(f);
+    B = gsl_spmatrix_fread_mm(f);
+    fclose(f);
+
+    status = !gsl_spmatrix_equal(T, B);
+    gsl_test(status, "test_mm: M=%zu N=%zu fprintf", M, N);
+    gsl_spmatrix_free(B);
+  }
+
+  if (M == N)
+    {
+      gsl_spmatrix *S = gsl_spmatrix_alloc(N, N);
+
+      gsl_spmatrix_hash_init(S);
+      for (n = 0; n < T->nz; ++n)
+        {
+          gsl_spmatrix_set(S, T->i[n], T->p[n], T->data[n]);
+          gsl_spmatrix_set(S, T->p[n], T->i[n], T->data[n]);
+        }
+
+      B = mm_roundtrip(S, GSL_SPMATRIX_MM_SYMMETRIC, 1);
+      C = mm_roundtrip(S, GSL_SPMATRIX_MM_SYMMETRIC, nthreads);
+
+      status = !gsl_spmatrix_equal(S, B) || !mm_identical(B, C);
+      gsl_test(status, "test_mm: N=%zu symmetric", N);
+
+      gsl_spmatrix_free(B);
+      gsl_spmatrix_free(C);
+      gsl_spmatrix_free(S);
+    }
+
+  gsl_spmatrix_free(mats[0]);
+  gsl_spmatrix_free(mats[1]);
+  gsl_spmatrix_free(mats[2]);
+} /* test_mm() */
+
+/*
+test_mm_errors()
+  Test that gsl_spmatrix_fread_mm() rejects malformed files
+*/
+
+static void
+test_mm_errors(void)
+{
+  const char *files[] = {
+    "%%MatrixMarket matrix array real general\n2 2\n1\n2\n3\n4\n",
+    "%%MatrixMarket matrix coordinate complex general\n2 2 1\n1 1 1 0\n",
+    "%%MatrixMarket matrix coordinate real general\n2 2 2\n1 1 1.0\n",
+    "%%MatrixMarket matrix coordinate real general\n2 2 1\n1 1 1.0\n2 2 1.0\n",
+    "%%MatrixMarket matrix coordinate real general\n2 2 1\n3 1 1.0\n",
+    "%%MatrixMarket matrix coordinate real general\n2 2 2\n1 1\n2 2 1.0\n",
+    "%%MatrixMarket matrix coordinate real symmetric\n2 3 1\n1 1 1.0\n",
+    "not a matrix market file\n"
+  };
+  const size_t nfiles = sizeof(files) / sizeof(files[0]);
+  gsl_error_handler_t *handler = gsl_set_error_handler_off();
+  size_t k;
+
+  for (k = 0; k < nfiles; ++k)
+    {
+      FILE *f = tmpfile();
+      gsl_spmatrix *B;
+
+      fputs(files[k], f);
+      rewind(f);
+      B = gsl_spmatrix_fread_mm(f);
+      fclose(f);
+
+      gsl_test(B != NULL, "test_mm_errors: file %zu", k);
+
+      if (B)
+        gsl_spmatrix_free(B);
+    }
+
+  /* comments, blank lines and upper case banner are accepted */
+  {
+    FILE *f = tmpfile();
+    gsl_spmatrix *B;
+
+    fputs("%%MatrixMarket MATRIX Coordinate Integer Skew-Symmetric\n"
+          "% comment\n\n3 3 2\n2 1 4\n\n3 2 -1", f);
+    rewind(f);
+    B = gsl_spmatrix_fread_mm(f);
+    fclose(f);
+
+    gsl_test(B == NULL || B->nz != 4 ||
+             gsl_spmatrix_get(B, 1, 0) != 4.0 ||
+             gsl_spmatrix_get(B, 0, 1) != -4.0 ||
+             gsl_spmatrix_get(B, 1, 2) != 1.0,
+             "test_mm_errors: skew-symmetric");
+
+    if (B)
+      gsl_spmatrix_free(B);
+  }
+
+  gsl_set_error_handler(handler);
+} /* test_mm_errors() */
+
+/*
+test_binary()
+  Test the binary format: compressed matrices written with
+gsl_spmatrix_fwrite() must be recovered exactly by gsl_spmatrix_fread()
+and gsl_spmatrix_mmap(), and a mapped matrix must be usable but
+read-only
+*/
+
+static void
+test_binary(const size_t M, const size_t N, const double density,
+            const gsl_rng *r)
+{
+  const char *filename = "test_spmatrix.bin";
+  gsl_spmatrix *T = create_random_sparse(M, N, density, r);
+  gsl_vector *x = gsl_vector_alloc(N);
+  gsl_vector *y1 = gsl_vector_alloc(M);
+  gsl_vector *y2 = gsl_vector_alloc(M);
+  gsl_spmatrix *mats[2];
+  gsl_error_handler_t *handler;
+  size_t k, i;
+  int status;
+
+  mats[0] = gsl_spmatrix_compress(T);
+  mats[1] = gsl_spmatrix_crs(T);
+
+  for (i = 0; i < N; ++i)
+    gsl_vector_set(x, i, gsl_rng_uniform(r));
+
+  for (k = 0; k < 2; ++k)
+    {
+      gsl_spmatrix *A = mats[k];
+      gsl_spmatrix *B, *C;
+      FILE *f = tmpfile();
+
+      gsl_spmatrix_fwrite(f, A);
+      rewind(f);
+      B = gsl_spmatrix_fread(f);
+      fclose(f);
+
+      status = B == NULL || !gsl_spmatrix_equal(A, B) ||
+               B->flags != A->flags;
+      gsl_test(status, "test_binary: M=%zu N=%zu type=%zu fread", M, N, k);
+      gsl_spmatrix_free(B);
+
+      f = fopen(filename, "wb");
+      gsl_spmatrix_fwrite(f, A);
+      fclose(f);
+
+      B = gsl_spmatrix_mmap(filename);
+      status = B == NULL || !gsl_spmatrix_equal(A, B);
+      gsl_test(status, "test_binary: M=%zu N=%zu type=%zu mmap", M, N, k);
+
+      gsl_spblas_dgemv(CblasNoTrans, 1.0, A, x, 0.0, y1);
+      gsl_spblas_dgemv(CblasNoTrans, 1.0, B, x, 0.0, y2);
+      status = 0;
+      for (i = 0; i < M; ++i)
+        {
+          if (gsl_vector_get(y1, i) != gsl_vector_get(y2, i))
+            status = 1;
+        }
+      gsl_test(status, "test_binary: M=%zu N=%zu type=%zu mmap dgemv",
+               M, N, k);
+
+      handler = gsl_set_error_handler_off();
+      status = gsl_spmatrix_scale(B, 2.0) != GSL_EINVAL ||
+               gsl_spmatrix_realloc(2 * B->nz + 1, B) != GSL_EINVAL;
+      gsl_set_error_handler(handler);
+      gsl_test(status, "test_binary: M=%zu N=%zu type=%zu read-only",
+               M, N, k);
+
+      C = gsl_spmatrix_memcpy(B);
+      status = GSLSP_ISREADONLY(C) || gsl_spmatrix_scale(C, 2.0) ||
+               !gsl_spmatrix_equal(A, B);
+      gsl_test(status, "test_binary: M=%zu N=%zu type=%zu memcpy", M, N, k);
+
+      gsl_spmatrix_free(C);
+      gsl_spmatrix_free(B);
+      remove(filename);
+    }
+
+  /* the symmetric storage keeps its flag */
+  {
+    gsl_spmatrix *Q = create_random_sparse(N, N, density, r);
+    gsl_spmatrix *S = gsl_spmatrix_symmetric(Q);
+    gsl_spmatrix *B, *C;
+    FILE *f = tmpfile();
+
+    gsl_spmatrix_fwrite(f, S);
+    rewind(f);
+    B = gsl_spmatrix_fread(f);
+    fclose(f);
+
+    f = fopen(filename, "wb");
+    gsl_spmatrix_fwrite(f, S);
+    fclose(f);
+    C = gsl_spmatrix_mmap(filename);
+
+    status = B == NULL || C == NULL || !gsl_spmatrix_equal(S, B) ||
+             !gsl_spmatrix_equal(S, C) || B->flags != S->flags ||
+             !GSLSP_ISSYMMETRIC(C);
+    for (i = 0; status == 0 && i < N; ++i)
+      {
+        for (k = 0; k < N; ++k)
+          {
+            if (gsl_spmatrix_get(B, k, i) != gsl_spmatrix_get(S, i, k) ||
+                gsl_spmatrix_get(C, k, i) != gsl_spmatrix_get(S, i, k))
+              status = 1;
+          }
+      }
+
+    gsl_test(status, "test_binary: N=%zu symmetric", N);
+
+    if (B)
+      gsl_spmatrix_free(B);
+    if (C)
+      gsl_spmatrix_free(C);
+    gsl_spmatrix_free(Q);
+    gsl_spmatrix_free(S);
+    remove(filename);
+  }
+
+  /* files which are not sparse matrix files are rejected */
+  {
+    FILE *f = tmpfile();
+    gsl_spmatrix *B;
+
+    gsl_spmatrix_fwrite_mm(f, mats[0], 0);
+    rewind(f);
+
+    handler = gsl_set_error_handler_off();
+    B = gsl_spmatrix_fread(f);
+    status = (B != NULL) || gsl_spmatrix_fwrite(f, T) != GSL_EINVAL;
+    gsl_set_error_handler(handler);
+
+    gsl_test(status, "test_binary: M=%zu N=%zu invalid", M, N);
+    fclose(f);
+  }
+
+  /* files with corrupt index arrays are rejected by gsl_spmatrix_fread() */
+  for (k = 0; k < 3; ++k)
+    {
+      gsl_spmatrix *Y = gsl_spmatrix_memcpy(mats[0]);
+      gsl_spmatrix *B;
+      FILE *f = tmpfile();
+
+      if (k == 0 && Y->nz > 0)
+        Y->i[Y->nz - 1] = M;            /* row index out of range */
+      else if (k == 1 && N > 1)
+        Y->p[1] = Y->nz + 1;            /* pointers not increasing */
+      else
+        Y->p[N] = Y->nz + 1;            /* last pointer != nz */
+
+      gsl_spmatrix_fwrite(f, Y);
+      rewind(f);
+
+      handler = gsl_set_error_handler_off();
+      B = gsl_spmatrix_fread(f);
+      gsl_set_error_handler(handler);
+
+      gsl_test(B != NULL, "test_binary: M=%zu N=%zu corrupt %zu", M, N, k);
+
+      if (B)
+        gsl_spmatrix_free(B);
+      gsl_spmatrix_free(Y);
+      fclose(f);
+    }
+
+  gsl_spmatrix_free(T);
+  gsl_spmatrix_free(mats[0]);
+  gsl_spmatrix_free(mats[1]);
+  gsl_vector_free(x);
+  gsl_vector_free(y1);
+  gsl_vector_free(y2);
+} /* test_binary() */
+
+/*
+test_i32()
+  Test the matrices with 32 bit indices against gsl_spmatrix:
+compression, element access, matrix-vector products (with nthreads
+threads), transposes and sparse products
+*/
+
+static void
+test_i32(const size_t M, const size_t N, const size_t K, const size_t nthreads,
+         const gsl_rng *r)
+{
+  const size_t types[2] = { GSL_SPMATRIX_CCS, GSL_SPMATRIX_CRS };
+  gsl_spmatrix *TA = create_random_sparse(M, N, 0.2, r);
+  gsl_spmatrix *TB = create_random_sparse(N, K, 0.2, r);
+  gsl_vector *x = gsl_vector_alloc(N);
+  gsl_vector *xt = gsl_vector_alloc(M);
+  gsl_vector *y1 = gsl_vector_alloc(M);
+  gsl_vector *y2 = gsl_vector_alloc(M);
+  gsl_vector *yt1 = gsl_vector_alloc(N);
+  gsl_vector *yt2 = gsl_vector_alloc(N);
+  size_t i, j, k, t;
+  int status;
+
+  for (j = 0; j < N; ++j)
+    gsl_vector_set(x, j, gsl_rng_uniform(r) - 0.5);
+
+  for (i = 0; i < M; ++i)
+    {
+      gsl_vector_set(xt, i, gsl_rng_uniform(r) - 0.5);
+      gsl_vector_set(y1, i, gsl_rng_uniform(r));
+    }
+
+  for (k = 0; k < 2; ++k)
+    {
+      gsl_spmatrix *A = gsl_spmatrix_compress_sorted(TA, types[k]);
+      gsl_spmatrix *B = gsl_spmatrix_compress_sorted(TB, types[k]);
+      gsl_spmatrix *C = gsl_spblas_dgemm(1.5, A, B);
+      gsl_spmatrix_i32 *A32 = gsl_spmatrix_i32_compress(TA, types[k]);
+      gsl_spmatrix_i32 *B32 = gsl_spmatrix_i32_compress(B, types[k]);
+      gsl_spmatrix_i32 *C32 = gsl_spblas_i32_dgemm(1.5, A32, B32);
+      gsl_spmatrix_i32 *AT32 = gsl_spmatrix_i32_transpose_memcpy(A32);
+
+      status = A32->nz != A->nz || GSLSP_TYPE(A32) != types[k] ||
+               !GSLSP_ISSORTED(A32);
+      for (i = 0; i < M; ++i)
+        {
+          for (j = 0; j < N; ++j)
+            {
+              double aij = gsl_spmatrix_get(A, i, j);
+
+              if (gsl_spmatrix_i32_get(A32, i, j) != aij ||
+                  gsl_spmatrix_i32_get(AT32, j, i) != aij)
+                status = 1;
+            }
+        }
+      gsl_test(status, "test_i32: M=%zu N=%zu type=%zu compress/transpose",
+               M, N, k);
+
+      /* the products use the same algorithms as gsl_spblas_dgemv */
+      for (t = 1; t <= nthreads; t += nthreads - 1)
+        {
+          gsl_vector_memcpy(y2, y1);
+          gsl_vector_memcpy(yt2, x);
+          gsl_vector_memcpy(yt1, x);
+
+          gsl_spblas_set_num_threads(t);
+          gsl_spblas_i32_dgemv(CblasNoTrans, 0.7, A32, x, 0.3, y2);
+          gsl_spblas_dgemv(CblasNoTrans, 0.7, A, x, 0.3, y1);
+          gsl_spblas_i32_dgemv(CblasTrans, -1.1, A32, xt, 0.0, yt2);
+          gsl_spblas_dgemv(CblasTrans, -1.1, A, xt, 0.0, yt1);
+          gsl_spblas_set_num_threads(1);
+
+          status = 0;
+          for (i = 0; i < M; ++i)
+            {
+              if (gsl_vector_get(y1, i) != gsl_vector_get(y2, i))
+                status = 1;
+            }
+
+          for (j = 0; j < N; ++j)
+            {
+              if (gsl_vector_get(yt1, j) != gsl_vector_get(yt2, j))
+                status = 1;
+            }
+
+          gsl_test(status, "test_i32: M=%zu N=%zu type=%zu dgemv threads=%zu",
+                   M, N, k, t);
+
+          if (nthreads == 1)
+            break;
+        }
+
+      status = C32->nz != C->nz || C32->size1 != M || C32->size2 != K;
+      for (i = 0; i < M; ++i)
+        {
+          for (j = 0; j < K; ++j)
+            {
+              double cij = gsl_spmatrix_get(C, i, j);
+
+              if (fabs(gsl_spmatrix_i32_get(C32, i, j) - cij) >
+                  1.0e-12 * GSL_MAX(fabs(cij), 1.0))
+                status = 1;
+            }
+        }
+      gsl_test(status, "test_i32: M=%zu N=%zu K=%zu type=%zu dgemm",
+               M, N, K, k);
+
+      /* symbolic and numeric phases with nthreads threads, new alpha */
+      {
+        gsl_spmatrix_i32 *D32;
+        const size_t np = (types[k] == GSL_SPMATRIX_CCS) ? K + 1 : M + 1;
+        size_t p;
+
+        gsl_spblas_set_num_threads(nthreads);
+        D32 = gsl_spblas_i32_dgemm_symbolic(A32, B32);
+        gsl_spblas_i32_dgemm_numeric(3.0, A32, B32, D32);
+        gsl_spblas_set_num_threads(1);
+
+        status = D32->nz != C32->nz;
+        for (p = 0; p < np && !status; ++p)
+          {
+            if (D32->p[p] != C32->p[p])
+              status = 1;
+          }
+
+        for (p = 0; p < D32->nz && !status; ++p)
+          {
+            if (D32->i[p] != C32->i[p] || D32->data[p] != 2.0 * C32->data[p])
+              status = 1;
+          }
+
+        gsl_test(status, "test_i32: M=%zu N=%zu K=%zu type=%zu dgemm threads=%zu",
+                 M, N, K, k, nthreads);
+
+        gsl_spmatrix_i32_free(D32);
+      }
+
+      gsl_spmatrix_i32_transpose(AT32);
+      status = AT32->size1 != M || AT32->size2 != N ||
+               GSLSP_TYPE(AT32) == types[k];
+      for (i = 0; i < M; ++i)
+        {
+          for (j = 0; j < N; ++j)
+            {
+              if (gsl_spmatrix_i32_get(AT32, i, j) != gsl_spmatrix_get(A, i, j))
+                status = 1;
+            }
+        }
+      gsl_test(status, "test_i32: M=%zu N=%zu type=%zu transpose", M, N, k);
+
+      gsl_spmatrix_free(A);
+      gsl_spmatrix_free(B);
+      gsl_spmatrix_free(C);
+      gsl_spmatrix_i32_free(A32);
+      gsl_spmatrix_i32_free(B32);
+      gsl_spmatrix_i32_free(C32);
+      gsl_spmatrix_i32_free(AT32);
+    }
+
+  gsl_spmatrix_free(TA);
+  gsl_spmatrix_free(TB);
+  gsl_vector_free(x);
+  gsl_vector_free(xt);
+  gsl_vector_free(y1);
+  gsl_vector_free(y2);
+  gsl_vector_free(yt1);
+  gsl_vector_free(yt2);
+} /* test_i32() */
+
+/*
+test_float()
+  Test the single precision matrices: the mixed precision product
+gsl_spblas_dsgemv() must equal gsl_spblas_dgemv() applied to the
+matrix rounded to single precision, with 1 and nthreads threads
+*/
+
+static void
+test_float(const size_t M, const size_t N, const size_t nthreads,
+           const gsl_rng *r)
+{
+  const size_t types[2] = { GSL_SPMATRIX_CCS, GSL_SPMATRIX_CRS };
+  gsl_spmatrix *T = create_random_sparse(M, N, 0.2, r);
+  gsl_vector *x = gsl_vector_alloc(N);
+  gsl_vector *xt = gsl_vector_alloc(M);
+  gsl_vector *y = gsl_vector_alloc(M);
+  gsl_vector *y1 = gsl_vector_alloc(M);
+  gsl_vector *y2 = gsl_vector_alloc(M);
+  gsl_vector *yt1 = gsl_vector_alloc(N);
+  gsl_vector *yt2 = gsl_vector_alloc(N);
+  size_t i, j, k, n, t;
+  int status;
+
+  for (j = 0; j < N; ++j)
+    gsl_vector_set(x, j, gsl_rng_uniform(r) - 0.5);
+
+  for (i = 0; i < M; ++i)
+    {
+      gsl_vector_set(xt, i, gsl_rng_uniform(r) - 0.5);
+      gsl_vector_set(y, i, gsl_rng_uniform(r));
+    }
+
+  for (k = 0; k < 2; ++k)
+    {
+      gsl_spmatrix *A = gsl_spmatrix_compress_sorted(T, types[k]);
+      gsl_spmatrix_float *Af = gsl_spmatrix_float_compress(T, types[k]);
+
+      /* A rounded to single precision */
+      for (n = 0; n < A->nz; ++n)
+        A->data[n] = (float) A->data[n];
+
+      status = Af->nz != A->nz || GSLSP_TYPE(Af) != types[k];
+      for (i = 0; i < M; ++i)
+        {
+          for (j = 0; j < N; ++j)
+            {
+              if (gsl_spmatrix_float_get(Af, i, j) != gsl_spmatrix_get(A, i, j))
+                status = 1;
+            }
+        }
+      gsl_test(status, "test_float: M=%zu N=%zu type=%zu compress", M, N, k);
+
+      for (t = 1; t <= nthreads; t += GSL_MAX(nthreads - 1, 1))
+        {
+          gsl_vector_memcpy(y1, y);
+          gsl_vector_memcpy(y2, y);
+
+          gsl_spblas_set_num_threads(t);
+          gsl_spblas_dgemv(CblasNoTrans, 0.7, A, x, 0.3, y1);
+          gsl_spblas_dsgemv(CblasNoTrans, 0.7, Af, x, 0.3, y2);
+          gsl_spblas_dgemv(CblasTrans, -1.1, A, xt, 0.0, yt1);
+          gsl_spblas_dsgemv(CblasTrans, -1.1, Af, xt, 0.0, yt2);
+          gsl_spblas_set_num_threads(1);
+
+          status = 0;
+          for (i = 0; i < M; ++i)
+            {
+              if (gsl_vector_get(y1, i) != gsl_vector_get(y2, i))
+                status = 1;
+            }
+
+          for (j = 0; j < N; ++j)
+            {
+              if (gsl_vector_get(yt1, j) != gsl_vector_get(yt2, j))
+                status = 1;
+            }
+
+          gsl_test(status, "test_float: M=%zu N=%zu type=%zu dsgemv threads=%zu",
+                   M, N, k, t);
+        }
+
+      gsl_spmatrix_free(A);
+      gsl_spmatrix_float_free(Af);
+    }
+
+  gsl_spmatrix_free(T);
+  gsl_vector_free(x);
+  gsl_vector_free(xt);
+  gsl_vector_free(y);
+  gsl_vector_free(y1);
+  gsl_vector_free(y2);
+  gsl_vector_free(yt1);
+  gsl_vector_free(yt2);
+} /* test_float() */
+
+/*
+test_sell()
+  Test the SELL-C-sigma matrices against gsl_spblas_dgemv() on the CRS
+matrix, built from triplet, CCS and CRS input, with a dense row to make
+the row lengths irregular. The scalar kernel must agree exactly; the
+SIMD kernels use fused multiply-add and must agree to rounding error.
+For each kernel the result must not depend on the number of threads
+*/
+
+static void
+test_sell(const size_t M, const size_t N, const size_t C, const size_t sigma,
+          const size_t nthreads, const gsl_rng *r)
+{
+  const size_t types[3] = { GSL_SPMATRIX_TRIPLET, GSL_SPMATRIX_CCS,
+                            GSL_SPMATRIX_CRS };
+  const size_t maxsimd = gsl_spblas_sell_get_simd();
+  gsl_spmatrix *T = create_random_sparse(M, N, 0.2, r);
+  gsl_spmatrix *A, *As;
+  gsl_vector *x2 = gsl_vector_alloc(2 * N);
+  gsl_vector *y = gsl_vector_alloc(M);
+  gsl_vector *y0 = gsl_vector_alloc(M);
+  gsl_vector *y1 = gsl_vector_alloc(M);
+  gsl_vector *y2 = gsl_vector_alloc(M);
+  gsl_vector_view xs = gsl_vector_subvector_with_stride(x2, 0, 2, N);
+  gsl_vector *x = gsl_vector_alloc(N);
+  size_t i, j, k, s, t;
+  int status;
+
+  /* dense row */
+  for (j = 0; j < N; ++j)
+    gsl_spmatrix_set(T, M / 2, j, gsl_rng_uniform(r) + 1.0);
+
+  /* CRS matrices with the row orders used by gsl_spmatrix_sell_alloc() */
+  A = gsl_spmatrix_crs(T);
+  As = gsl_spmatrix_compress_sorted(T, GSL_SPMATRIX_CRS);
+
+  for (j = 0; j < 2 * N; ++j)
+    gsl_vector_set(x2, j, gsl_rng_uniform(r) - 0.5);
+
+  gsl_vector_memcpy(x, &xs.vector);
+
+  for (i = 0; i < M; ++i)
+    gsl_vector_set(y, i, gsl_rng_uniform(r));
+
+  for (k = 0; k < 3; ++k)
+    {
+      gsl_spmatrix *B = (types[k] == GSL_SPMATRIX_TRIPLET) ?
+                        gsl_spmatrix_memcpy(T) :
+                        gsl_spmatrix_compress_sorted(T, types[k]);
+      gsl_spmatrix_sell *S = gsl_spmatrix_sell_alloc(B, C, sigma);
+
+      gsl_vector_memcpy(y0, y);
+      gsl_spblas_dgemv(CblasNoTrans, 0.7, (k == 0) ? A : As, x, 0.3, y0);
+
+      status = S->nz != B->nz || S->nchunks != (M + C - 1) / C;
+      gsl_test(status, "test_sell: M=%zu N=%zu C=%zu sigma=%zu type=%zu alloc",
+               M, N, C, sigma, k);
+
+      for (s = GSL_SPBLAS_SIMD_SCALAR; s <= maxsimd; ++s)
+        {
+          gsl_spblas_sell_set_simd(s);
+
+          /* unit stride x, with 1 and nthreads threads */
+          status = 0;
+          for (t = 1; t <= nthreads; t += GSL_MAX(nthreads - 1, 1))
+            {
+              gsl_vector_memcpy(y1, y);
+
+              gsl_spblas_set_num_threads(t);
+              gsl_spblas_sell_dgemv(0.7, S, x, 0.3, y1);
+              gsl_spblas_set_num_threads(1);
+
+              if (t == 1)
+                gsl_vector_memcpy(y2, y1);
+
+              for (i = 0; i < M; ++i)
+                {
+                  double yi = gsl_vector_get(y1, i);
+                  double ei = gsl_vector_get(y0, i);
+
+                  if (yi != gsl_vector_get(y2, i))
+                    status = 1;
+                  else if (s == GSL_SPBLAS_SIMD_SCALAR && yi != ei)
+                    status = 1;
+                  else if (fabs(yi - ei) > 1.0e-13 * GSL_MAX(fabs(ei), 1.0))
+                    status = 1;
+                }
+            }
+
+          gsl_test(status, "test_sell: M=%zu N=%zu C=%zu sigma=%zu type=%zu simd=%zu",
+                   M, N, C, sigma, k, s);
+
+          /* strided x falls back to the scalar kernel */
+          gsl_vector_memcpy(y1, y);
+          gsl_spblas_sell_dgemv(0.7, S, &xs.vector, 0.3, y1);
+
+          status = 0;
+          for (i = 0; i < M; ++i)
+            {
+              if (gsl_vector_get(y1, i) != gsl_vector_get(y0, i))
+                status = 1;
+            }
+
+          gsl_test(status, "test_sell: M=%zu N=%zu C=%zu sigma=%zu type=%zu simd=%zu stride",
+                   M, N, C, sigma, k, s);
+        }
+
+      /*
+       * non-finite x: the padding of rows which do not reference
+       * column 0 must not turn x_0 = Inf into NaN
+       */
+      {
+        gsl_vector *xi = gsl_vector_alloc(N);
+
+        gsl_vector_memcpy(xi, x);
+        gsl_vector_set(xi, 0, GSL_POSINF);
+
+        gsl_vector_memcpy(y0, y);
+        gsl_spblas_dgemv(CblasNoTrans, 0.7, (k == 0) ? A : As, xi, 0.3, y0);
+
+        status = 0;
+        for (s = GSL_SPBLAS_SIMD_SCALAR; s <= maxsimd; ++s)
+          {
+            gsl_spblas_sell_set_simd(s);
+            gsl_vector_memcpy(y1, y);
+            gsl_spblas_sell_dgemv(0.7, S, xi, 0.3, y1);
+
+            for (i = 0; i < M; ++i)
+              {
+                double yi = gsl_vector_get(y1, i);
+                double ei = gsl_vector_get(y0, i);
+
+                if (gsl_finite(ei) != gsl_finite(yi) || gsl_isnan(ei) != gsl_isnan(yi))
+                  status = 1;
+              }
+          }
+
+        gsl_test(status, "test_sell: M=%zu N=%zu C=%zu sigma=%zu type=%zu non-finite x",
+                 M, N, C, sigma, k);
+
+        gsl_vector_free(xi);
+      }
+
+      gsl_spblas_sell_set_simd(maxsimd);
+
+      gsl_spmatrix_sell_free(S);
+      gsl_spmatrix_free(B);
+    }
+
+  /* invalid parameters */
+  {
+    gsl_error_handler_t *handler = gsl_set_error_handler_off();
+
+    status = gsl_spmatrix_sell_alloc(A, 0, sigma) != NULL ||
+             gsl_spmatrix_sell_alloc(A, 65, sigma) != NULL ||
+             gsl_spmatrix_sell_alloc(A, C, 0) != NULL;
+    gsl_set_error_handler(handler);
+
+    gsl_test(status, "test_sell: M=%zu N=%zu invalid parameters", M, N);
+  }
+
+  gsl_spmatrix_free(T);
+  gsl_spmatrix_free(A);
+  gsl_spmatrix_free(As);
+  gsl_vector_free(x);
+  gsl_vector_free(x2);
+  gsl_vector_free(y);
+  gsl_vector_free(y0);
+  gsl_vector_free(y1);
+  gsl_vector_free(y2);
+} /* test_sell() */
+
+/*
+test_bsr()
+  Test the BSR matrices built from triplet, CCS and CRS input, for a
+matrix of dense b-by-b blocks (whose block size must be detected) and
+a random matrix with partially filled blocks. The products must agree
+with gsl_spblas_dgemv() and gsl_spblas_dgemm_dense() to rounding
+error, and must not depend on the number of threads
+*/
+
+static void
+test_bsr(const size_t mb, const size_t nb, const size_t b,
+         const size_t nthreads, const gsl_rng *r)
+{
+  const size_t M = mb * b;
+  const size_t N = nb * b;
+  const size_t K = 5;
+  const size_t types[3] = { GSL_SPMATRIX_TRIPLET, GSL_SPMATRIX_CCS,
+                            GSL_SPMATRIX_CRS };
+  gsl_spmatrix *T[2];
+  gsl_vector *x = gsl_vector_alloc(N);
+  gsl_vector *y = gsl_vector_alloc(M);
+  gsl_vector *y0 = gsl_vector_alloc(M);
+  gsl_vector *y1 = gsl_vector_alloc(M);
+  gsl_vector *y2 = gsl_vector_alloc(M);
+  gsl_matrix *X = gsl_matrix_alloc(N, K);
+  gsl_matrix *Y = gsl_matrix_alloc(M, K);
+  gsl_matrix *Y0 = gsl_matrix_alloc(M, K);
+  gsl_matrix *Y1 = gsl_matrix_alloc(M, K);
+  gsl_matrix *Y2 = gsl_matrix_alloc(M, K);
+  size_t i, j, k, l, n, t, I, J;
+  int status;
+
+  /* dense blocks in a random block pattern */
+  T[0] = gsl_spmatrix_alloc(M, N);
+  for (I = 0; I < mb; ++I)
+    {
+      for (J = 0; J < nb; ++J)
+        {
+          if (I != J && gsl_rng_uniform(r) > 0.3)
+            continue;
+
+          for (i = 0; i < b; ++i)
+            {
+              for (j = 0; j < b; ++j)
+                gsl_spmatrix_set(T[0], I * b + i, J * b + j,
+                                 gsl_rng_uniform(r) + 0.1);
+            }
+        }
+    }
+
+  T[1] = create_random_sparse(M, N, 0.1, r);
+
+  status = gsl_spmatrix_bsr_blocksize(T[0], 1.0) != b;
+  gsl_test(status, "test_bsr: mb=%zu nb=%zu b=%zu blocksize", mb, nb, b);
+
+  for (j = 0; j < N; ++j)
+    {
+      gsl_vector_set(x, j, gsl_rng_uniform(r) - 0.5);
+      for (l = 0; l < K; ++l)
+        gsl_matrix_set(X, j, l, gsl_rng_uniform(r) - 0.5);
+    }
+
+  for (i = 0; i < M; ++i)
+    {
+      gsl_vector_set(y, i, gsl_rng_uniform(r));
+      for (l = 0; l < K; ++l)
+        gsl_matrix_set(Y, i, l, gsl_rng_uniform(r));
+    }
+
+  for (n = 0; n < 2; ++n)
+    {
+      gsl_spmatrix *A = gsl_spmatrix_crs(T[n]);
+
+      gsl_vector_memcpy(y0, y);
+      gsl_spblas_dgemv(CblasNoTrans, 0.7, A, x, 0.3, y0);
+      gsl_matrix_memcpy(Y0, Y);
+      gsl_spblas_dgemm_dense(-1.2, A, X, 0.4, Y0);
+
+      for (k = 0; k < 3; ++k)
+        {
+          gsl_spmatrix *B = (types[k] == GSL_SPMATRIX_TRIPLET) ?
+                            gsl_spmatrix_memcpy(T[n]) :
+                            gsl_spmatrix_compress_sorted(T[n], types[k]);
+          gsl_spmatrix_bsr *S = gsl_spmatrix_bsr_alloc(B, b);
+
+          status = S->mb != mb || S->nb != nb;
+          for (i = 0; i < M; ++i)
+            {
+              for (j = 0; j < N; ++j)
+                {
+                  if (gsl_spmatrix_bsr_get(S, i, j) != gsl_spmatrix_get(A, i, j))
+                    status = 1;
+                }
+            }
+
+          gsl_test(status, "test_bsr: mb=%zu nb=%zu b=%zu n=%zu type=%zu alloc",
+                   mb, nb, b, n, k);
+
+          status = 0;
+          for (t = 1; t <= nthreads; t += GSL_MAX(nthreads - 1, 1))
+            {
+              gsl_vector_memcpy(y1, y);
+              gsl_matrix_memcpy(Y1, Y);
+
+              gsl_spblas_set_num_threads(t);
+              gsl_spblas_bsr_dgemv(0.7, S, x, 0.3, y1);
+              gsl_spblas_bsr_dgemm_dense(-1.2, S, X, 0.4, Y1);
+              gsl_spblas_set_num_threads(1);
+
+              if (t == 1)
+                {
+                  gsl_vector_memcpy(y2, y1);
+                  gsl_matrix_memcpy(Y2, Y1);
+                }
+
+              for (i = 0; i < M; ++i)
+                {
+                  double yi = gsl_vector_get(y1, i);
+                  double ei = gsl_vector_get(y0, i);
+
+                  if (yi != gsl_vector_get(y2, i) ||
+                      fabs(yi - ei) > 1.0e-13 * GSL_MAX(fabs(ei), 1.0))
+                    status = 1;
+
+                  for (l = 0; l < K; ++l)
+                    {
+                      yi = gsl_matrix_get(Y1, i, l);
+                      ei = gsl_matrix_get(Y0, i, l);
+
+                      if (yi != gsl_matrix_get(Y2, i, l) ||
+                          fabs(yi - ei) > 1.0e-13 * GSL_MAX(fabs(ei), 1.0))
+                        status = 1;
+                    }
+                }
+            }
+
+          gsl_test(status, "test_bsr: mb=%zu nb=%zu b=%zu n=%zu type=%zu products",
+                   mb, nb, b, n, k);
+
+          gsl_spmatrix_bsr_free(S);
+          gsl_spmatrix_free(B);
+        }
+
+      gsl_spmatrix_free(A);
+    }
+
+  gsl_spmatrix_free(T[0]);
+  gsl_spmatrix_free(T[1]);
+  gsl_vector_free(x);
+  gsl_vector_free(y);
+  gsl_vector_free(y0);
+  gsl_vector_free(y1);
+  gsl_vector_free(y2);
+  gsl_matrix_free(X);
+  gsl_matrix_free(Y);
+  gsl_matrix_free(Y0);
+  gsl_matrix_free(Y1);
+  gsl_matrix_free(Y2);
+} /* test_bsr() */
+
+/*
+test_dia()
+  Test the DIA matrices on the tridiagonal and 5-point Laplacians of
+an n-by-n grid and on a random rectangular matrix, built from triplet,
+CCS and CRS input. The number of diagonals must be detected, and
+gsl_spblas_dia_dgemv() must agree with gsl_spblas_dgemv() to rounding
+error, for unit and non-unit strides, and must not depend on the
+number of threads
+*/
+
+static void
+test_dia(const size_t n, const size_t nthreads, const gsl_rng *r)
+{
+  const size_t types[3] = { GSL_SPMATRIX_TRIPLET, GSL_SPMATRIX_CCS,
+                            GSL_SPMATRIX_CRS };
+  const size_t nn = n * n;
+  const size_t ndiag[3] = { GSL_MIN(nn, 3), n > 1 ? 5 : 1, 0 };
+  gsl_spmatrix *T[3];
+  size_t i, j, k, l, s, t;
+  int status;
+
+  T[0] = gsl_spmatrix_alloc(nn, nn);
+  T[1] = gsl_spmatrix_alloc(nn, nn);
+  T[2] = create_random_sparse(n + 2, n, 0.2, r);
+
+  for (i = 0; i < nn; ++i)
+    {
+      gsl_spmatrix_set(T[0], i, i, 2.0);
+      gsl_spmatrix_set(T[1], i, i, 4.0);
+
+      if (i > 0)
+        gsl_spmatrix_set(T[0], i, i - 1, -1.0);
+      if (i + 1 < nn)
+        gsl_spmatrix_set(T[0], i, i + 1, -1.0);
+
+      if (i % n > 0)
+        gsl_spmatrix_set(T[1], i, i - 1, -1.0);
+      if (i % n + 1 < n)
+        gsl_spmatrix_set(T[1], i, i + 1, -1.0);
+      if (i >= n)
+        gsl_spmatrix_set(T[1], i, i - n, -1.0);
+      if (i + n < nn)
+        gsl_spmatrix_set(T[1], i, i + n, -1.0);
+    }
+
+  for (l = 0; l < 3; ++l)
+    {
+      const size_t M = T[l]->size1;
+      const size_t N = T[l]->size2;
+      gsl_spmatrix *A = gsl_spmatrix_crs(T[l]);
+      gsl_vector *x = gsl_vector_alloc(2 * N);
+      gsl_vector *y = gsl_vector_alloc(2 * M);
+      gsl_vector *y0 = gsl_vector_alloc(2 * M);
+      gsl_vector *y1 = gsl_vector_alloc(2 * M);
+      gsl_vector *y2 = gsl_vector_alloc(2 * M);
+
+      if (l < 2)
+        {
+          status = gsl_spmatrix_dia_ndiag(T[l]) != ndiag[l];
+          gsl_test(status, "test_dia: n=%zu l=%zu ndiag", n, l);
+        }
+
+      for (j = 0; j < 2 * N; ++j)
+        gsl_vector_set(x, j, gsl_rng_uniform(r) - 0.5);
+
+      for (i = 0; i < 2 * M; ++i)
+        gsl_vector_set(y, i, gsl_rng_uniform(r));
+
+      for (k = 0; k < 3; ++k)
+        {
+          gsl_spmatrix *B = (types[k] == GSL_SPMATRIX_TRIPLET) ?
+                            gsl_spmatrix_memcpy(T[l]) :
+                            gsl_spmatrix_compress_sorted(T[l], types[k]);
+          gsl_spmatrix_dia *D = gsl_spmatrix_dia_alloc(B);
+
+          status = D->ndiag != gsl_spmatrix_dia_ndiag(B);
+          if (M * N <= 40000)
+            {
+              for (i = 0; i < M; ++i)
+                {
+                  for (j = 0; j < N; ++j)
+                    {
+                      if (gsl_spmatrix_dia_get(D, i, j) != gsl_spmatrix_get(A, i, j))
+                        status = 1;
+                    }
+                }
+            }
+
+          gsl_test(status, "test_dia: n=%zu l=%zu type=%zu alloc", n, l, k);
+
+          /* s = 1: unit stride, s = 2: stride 2 */
+          for (s = 1; s <= 2; ++s)
+            {
+              gsl_vector_view xs = gsl_vector_subvector_with_stride(x, 0, s, N);
+              gsl_vector_view ys0 = gsl_vector_subvector_with_stride(y0, 0, s, M);
+              gsl_vector_view ys1 = gsl_vector_subvector_with_stride(y1, 0, s, M);
+
+              gsl_vector_memcpy(y0, y);
+              gsl_spblas_dgemv(CblasNoTrans, 0.7, A, &xs.vector, 0.3, &ys0.vector);
+
+              status = 0;
+              for (t = 1; t <= nthreads; t += GSL_MAX(nthreads - 1, 1))
+                {
+                  gsl_vector_memcpy(y1, y);
+
+                  gsl_spblas_set_num_threads(t);
+                  gsl_spblas_dia_dgemv(0.7, D, &xs.vector, 0.3, &ys1.vector);
+                  gsl_spblas_set_num_threads(1);
+
+                  if (t == 1)
+                    gsl_vector_memcpy(y2, y1);
+
+                  for (i = 0; i < 2 * M; ++i)
+                    {
+                      const double yi = gsl_vector_get(y1, i);
+                      const double ei = gsl_vector_get(y0, i);
+
+                      if (yi != gsl_vector_get(y2, i) ||
+                          fabs(yi - ei) > 1.0e-13 * GSL_MAX(fabs(ei), 1.0))
+                        status = 1;
+                    }
+                }
+
+              gsl_test(status, "test_dia: n=%zu l=%zu type=%zu stride=%zu dgemv",
+                       n, l, k, s);
+            }
+
+          gsl_spmatrix_dia_free(D);
+          gsl_spmatrix_free(B);
+        }
+
       gsl_spmatrix_free(A);
+      gsl_vector_free(x);
+      gsl_vector_free(y);
+      gsl_vector_free(y0);
+      gsl_vector_free(y1);
+      gsl_vector_free(y2);
+    }
+
+  for (l = 0; l < 3; ++l)
+    gsl_spmatrix_free(T[l]);
+} /* test_dia() */
+
+/*
+test_symmetric()
+  Test the symmetric storage built from triplet, CCS and CRS matrices
+storing both triangles, and gsl_spblas_dsymv() against
+gsl_spblas_dgemv() on the full matrix, with 1 and nthreads threads and
+with unit and non-unit strides
+*/
+
+static void
+test_symmetric(const size_t N, const size_t nthreads, const gsl_rng *r)
+{
+  const size_t types[3] = { GSL_SPMATRIX_TRIPLET, GSL_SPMATRIX_CCS,
+                            GSL_SPMATRIX_CRS };
+  gsl_spmatrix *T = create_random_sparse(N, N, 0.1, r);
+  gsl_spmatrix *F = gsl_spmatrix_alloc(N, N);
+  gsl_spmatrix *A;
+  gsl_vector *x = gsl_vector_alloc(2 * N);
+  gsl_vector *y = gsl_vector_alloc(2 * N);
+  gsl_vector *y0 = gsl_vector_alloc(2 * N);
+  gsl_vector *y1 = gsl_vector_alloc(2 * N);
+  gsl_error_handler_t *handler;
+  size_t i, j, k, n, s, t, nzlower = 0;
+  int status;
+
+  /* F = symmetric matrix with the pattern of T + T^T */
+  gsl_spmatrix_hash_init(F);
+  for (n = 0; n < T->nz; ++n)
+    {
+      gsl_spmatrix_set(F, T->i[n], T->p[n], T->data[n]);
+      gsl_spmatrix_set(F, T->p[n], T->i[n], T->data[n]);
+    }
+
+  A = gsl_spmatrix_crs(F);
+  for (n = 0; n < F->nz; ++n)
+    nzlower += (F->i[n] >= F->p[n]);
+
+  for (i = 0; i < 2 * N; ++i)
+    {
+      gsl_vector_set(x, i, gsl_rng_uniform(r) - 0.5);
+      gsl_vector_set(y, i, gsl_rng_uniform(r));
+    }
+
+  for (k = 0; k < 3; ++k)
+    {
+      gsl_spmatrix *B = (types[k] == GSL_SPMATRIX_TRIPLET) ?
+                        gsl_spmatrix_memcpy(F) :
+                        gsl_spmatrix_compress_sorted(F, types[k]);
+      gsl_spmatrix *S = gsl_spmatrix_symmetric(B);
+      gsl_spmatrix *St = gsl_spmatrix_transpose_memcpy(S);
+
+      status = !GSLSP_ISSYMMETRIC(S) || !GSLSP_ISCCS(S) || S->nz != nzlower;
+      for (n = 0; n < S->nz; ++n)
+        {
+          if (St->i[n] != S->i[n] || St->data[n] != S->data[n])
+            status = 1;
+        }
+
+      for (i = 0; i < N; ++i)
+        {
+          for (j = 0; j < N; ++j)
+            {
+              if (gsl_spmatrix_get(S, i, j) != gsl_spmatrix_get(A, i, j))
+                status = 1;
+            }
+        }
+
+      gsl_test(status, "test_symmetric: N=%zu type=%zu storage", N, k);
+
+      /* s = 1: unit stride, s = 2: stride 2 */
+      for (s = 1; s <= 2; ++s)
+        {
+          gsl_vector_view xs = gsl_vector_subvector_with_stride(x, 0, s, N);
+          gsl_vector_view ys0 = gsl_vector_subvector_with_stride(y0, 0, s, N);
+          gsl_vector_view ys1 = gsl_vector_subvector_with_stride(y1, 0, s, N);
+
+          gsl_vector_memcpy(y0, y);
+          gsl_spblas_dgemv(CblasNoTrans, 0.7, A, &xs.vector, 0.3, &ys0.vector);
+
+          status = 0;
+          for (t = 1; t <= nthreads; t += GSL_MAX(nthreads - 1, 1))
+            {
+              gsl_vector_memcpy(y1, y);
+
+              gsl_spblas_set_num_threads(t);
+              gsl_spblas_dsymv(0.7, S, &xs.vector, 0.3, &ys1.vector);
+              gsl_spblas_set_num_threads(1);
+
+              for (i = 0; i < 2 * N; ++i)
+                {
+                  const double yi = gsl_vector_get(y1, i);
+                  const double ei = gsl_vector_get(y0, i);
+
+                  if (fabs(yi - ei) > 1.0e-13 * GSL_MAX(fabs(ei), 1.0))
+                    status = 1;
+                }
+            }
+
+          gsl_test(status, "test_symmetric: N=%zu type=%zu stride=%zu dsymv",
+                   N, k, s);
+        }
+
       gsl_spmatrix_free(B);
-      gsl_spmatrix_free(C);
+      gsl_spmatrix_free(S);
+      gsl_spmatrix_free(St);
     }
 
-  gsl_matrix_free(A_gsl);
-  gsl_matrix_free(B_gsl);
-  gsl_matrix_free(C_gsl);
-} /* test_dgemm() */
+  /* invalid inputs */
+  handler = gsl_set_error_handler_off();
+
+  {
+    gsl_spmatrix *R = gsl_spmatrix_alloc(N, N + 1);
+    gsl_vector_view xs = gsl_vector_subvector(x, 0, N);
+    gsl_vector_view ys = gsl_vector_subvector(y1, 0, N);
+
+    status = gsl_spmatrix_symmetric(R) != NULL ||
+             gsl_spblas_dsymv(1.0, A, &xs.vector, 0.0, &ys.vector) != GSL_EINVAL;
+    gsl_test(status, "test_symmetric: N=%zu invalid inputs", N);
+
+    gsl_spmatrix_free(R);
+  }
+
+  gsl_set_error_handler(handler);
+
+  gsl_spmatrix_free(T);
+  gsl_spmatrix_free(F);
+  gsl_spmatrix_free(A);
+  gsl_vector_free(x);
+  gsl_vector_free(y);
+  gsl_vector_free(y0);
+  gsl_vector_free(y1);
+} /* test_symmetric() */
+
+/*
+test_symmetric_ops()
+  Test the routines accepting a matrix with symmetric storage against
+the same routines applied to the full matrix, and check that the
+routines which do not support symmetric storage reject it
+*/
+
+static void
+test_symmetric_ops(const size_t N, const gsl_rng *r)
+{
+  const CBLAS_UPLO_t uplo[2] = { CblasLower, CblasUpper };
+  const CBLAS_TRANSPOSE_t trans[2] = { CblasNoTrans, CblasTrans };
+  gsl_spmatrix *T = create_random_sparse(N, N, 0.1, r);
+  gsl_spmatrix *F = gsl_spmatrix_alloc(N, N);
+  gsl_spmatrix *A, *S, *C;
+  gsl_permutation *p = gsl_permutation_alloc(N);
+  gsl_permutation *q = gsl_permutation_alloc(N);
+  gsl_matrix *X = gsl_matrix_alloc(N, 2);
+  gsl_matrix *Y = gsl_matrix_alloc(N, 2);
+  gsl_vector *x = gsl_vector_alloc(N);
+  gsl_vector *y0 = gsl_vector_alloc(N);
+  gsl_vector *y1 = gsl_vector_alloc(N);
+  gsl_error_handler_t *handler;
+  size_t i, j, k, l, n;
+  int status;
+
+  /* F = symmetric matrix with the pattern of T + T^T and a heavy diagonal */
+  gsl_spmatrix_hash_init(F);
+  for (n = 0; n < T->nz; ++n)
+    {
+      gsl_spmatrix_set(F, T->i[n], T->p[n], T->data[n]);
+      gsl_spmatrix_set(F, T->p[n], T->i[n], T->data[n]);
+    }
+
+  for (i = 0; i < N; ++i)
+    gsl_spmatrix_set(F, i, i, (double) N + 1.0);
+
+  A = gsl_spmatrix_compress_sorted(F, GSL_SPMATRIX_CCS);
+  S = gsl_spmatrix_symmetric(A);
+
+  for (i = 0; i < N; ++i)
+    gsl_vector_set(x, i, gsl_rng_uniform(r) - 0.5);
+
+  /* dgemv is dispatched to dsymv for both values of TransA */
+  status = 0;
+  for (k = 0; k < 2; ++k)
+    {
+      gsl_spblas_dgemv(trans[k], 1.0, A, x, 0.0, y0);
+      gsl_spblas_dgemv(trans[k], 1.0, S, x, 0.0, y1);
+
+      for (i = 0; i < N; ++i)
+        {
+          const double ei = gsl_vector_get(y0, i);
+
+          if (fabs(gsl_vector_get(y1, i) - ei) > 1.0e-13 * GSL_MAX(fabs(ei), 1.0))
+            status = 1;
+        }
+    }
+
+  gsl_test(status, "test_symmetric_ops: N=%zu dgemv", N);
+
+  /* the sum of two symmetric matrices keeps symmetric storage */
+  C = gsl_spmatrix_add(S, S);
+  status = !GSLSP_ISSYMMETRIC(C);
+  for (i = 0; i < N; ++i)
+    {
+      for (j = 0; j < N; ++j)
+        {
+          if (gsl_spmatrix_get(C, i, j) != 2.0 * gsl_spmatrix_get(A, i, j))
+            status = 1;
+        }
+    }
+
+  gsl_test(status, "test_symmetric_ops: N=%zu add", N);
+  gsl_spmatrix_free(C);
+
+  /* symmetric permutation P A P^T */
+  create_random_permutation(p, r);
+  gsl_permutation_memcpy(q, p);
+
+  C = gsl_spmatrix_permute(S, p, q);
+  status = !GSLSP_ISSYMMETRIC(C) || !GSLSP_ISCCS(C) || C->nz != S->nz;
+  for (i = 0; i < N; ++i)
+    {
+      for (j = 0; j < N; ++j)
+        {
+          double aij = gsl_spmatrix_get(A, p->data[i], p->data[j]);
+
+          if (gsl_spmatrix_get(C, i, j) != aij)
+            status = 1;
+        }
+
+      for (n = C->p[i]; n < C->p[i + 1]; ++n)
+        {
+          if (C->i[n] < i || (n > C->p[i] && C->i[n] <= C->i[n - 1]))
+            status = 1;
+        }
+    }
+
+  gsl_test(status, "test_symmetric_ops: N=%zu permute", N);
+  gsl_spmatrix_free(C);
+
+  /* triangular solves with either triangle, also through trsv_alloc */
+  status = 0;
+  for (k = 0; k < 2; ++k)
+    {
+      for (l = 0; l < 2; ++l)
+        {
+          gsl_spblas_trsv_workspace *w = gsl_spblas_trsv_alloc(uplo[k], trans[l], S);
+
+          gsl_vector_memcpy(y0, x);
+          gsl_vector_memcpy(y1, x);
+          gsl_spblas_dtrsv(uplo[k], trans[l], CblasNonUnit, A, y0);
+          gsl_spblas_dtrsv(uplo[k], trans[l], CblasNonUnit, S, y1);
+
+          for (i = 0; i < N; ++i)
+            {
+              const double ei = gsl_vector_get(y0, i);
+
+              if (fabs(gsl_vector_get(y1, i) - ei) > 1.0e-13 * GSL_MAX(fabs(ei), 1.0))
+                status = 1;
+            }
+
+          gsl_vector_memcpy(y1, x);
+          gsl_spblas_dtrsv_levels(CblasNonUnit, S, w, y1);
+
+          for (i = 0; i < N; ++i)
+            {
+              const double ei = gsl_vector_get(y0, i);
+
+              if (fabs(gsl_vector_get(y1, i) - ei) > 1.0e-13 * GSL_MAX(fabs(ei), 1.0))
+                status = 1;
+            }
+
+          gsl_spblas_trsv_free(w);
+        }
+    }
+
+  gsl_test(status, "test_symmetric_ops: N=%zu dtrsv", N);
+
+  /* the Cholesky factorizations only read the lower triangle */
+  {
+    gsl_splinalg_ic0_workspace *wa = gsl_splinalg_ic0_alloc(A);
+    gsl_splinalg_ic0_workspace *ws = gsl_splinalg_ic0_alloc(S);
+    gsl_splinalg_cholesky_workspace *ca = gsl_splinalg_cholesky_alloc(A);
+    gsl_splinalg_cholesky_workspace *cs = gsl_splinalg_cholesky_alloc(S);
+
+    status = gsl_splinalg_ic0_decomp(A, wa) || gsl_splinalg_ic0_decomp(S, ws) ||
+             gsl_splinalg_cholesky_decomp(A, ca) ||
+             gsl_splinalg_cholesky_decomp(S, cs);
+
+    gsl_splinalg_ic0_solve(wa, x, y0);
+    gsl_splinalg_ic0_solve(ws, x, y1);
+    for (i = 0; i < N; ++i)
+      {
+        if (gsl_vector_get(y0, i) != gsl_vector_get(y1, i))
+          status = 1;
+      }
+
+    gsl_splinalg_cholesky_solve(ca, x, y0);
+    gsl_splinalg_cholesky_solve(cs, x, y1);
+    for (i = 0; i < N; ++i)
+      {
+        if (gsl_vector_get(y0, i) != gsl_vector_get(y1, i))
+          status = 1;
+      }
+
+    gsl_test(status, "test_symmetric_ops: N=%zu ic0/cholesky", N);
+
+    gsl_splinalg_ic0_free(wa);
+    gsl_splinalg_ic0_free(ws);
+    gsl_splinalg_cholesky_free(ca);
+    gsl_splinalg_cholesky_free(cs);
+  }
+
+  /* Matrix Market output has a symmetric header and the full matrix is read back */
+  C = mm_roundtrip(S, 0, 1);
+  status = C == NULL;
+  for (i = 0; C && i < N; ++i)
+    {
+      for (j = 0; j < N; ++j)
+        {
+          if (gsl_spmatrix_get(C, i, j) != gsl_spmatrix_get(A, i, j))
+            status = 1;
+        }
+    }
+
+  gsl_test(status, "test_symmetric_ops: N=%zu Matrix Market", N);
+  if (C)
+    gsl_spmatrix_free(C);
+
+  /* unsupported operations */
+  handler = gsl_set_error_handler_off();
+
+  gsl_matrix_set_zero(X);
+
+  if (N > 1)
+    {
+      /* q = p with two elements exchanged */
+      q->data[0] = p->data[1];
+      q->data[1] = p->data[0];
+      status = gsl_spmatrix_permute(S, p, q) != NULL;
+    }
+  else
+    status = 0;
+
+  status |= gsl_spmatrix_add(S, A) != NULL ||
+            gsl_spmatrix_add(A, S) != NULL ||
+            gsl_spblas_dgemm(1.0, S, S) != NULL ||
+            gsl_spblas_dgemm(1.0, A, S) != NULL ||
+            gsl_spblas_dgemm_dense(1.0, S, X, 0.0, Y) != GSL_EINVAL ||
+            gsl_spmatrix_equal(S, A) != 0 ||
+            gsl_spmatrix_i32_compress(S, GSL_SPMATRIX_CCS) != NULL ||
+            gsl_spmatrix_float_compress(S, GSL_SPMATRIX_CCS) != NULL ||
+            gsl_spmatrix_sell_alloc(S, 4, 1) != NULL ||
+            gsl_spmatrix_bsr_alloc(S, 1) != NULL ||
+            gsl_spmatrix_bsr_blocksize(S, 1.0) != 0 ||
+            gsl_spmatrix_dia_alloc(S) != NULL ||
+            gsl_spmatrix_dia_ndiag(S) != 0 ||
+            gsl_splinalg_ilu0_alloc(S) != NULL;
+
+  gsl_test(status, "test_symmetric_ops: N=%zu unsupported", N);
+
+  gsl_set_error_handler(handler);
+
+  gsl_spmatrix_free(T);
+  gsl_spmatrix_free(F);
+  gsl_spmatrix_free(A);
+  gsl_spmatrix_free(S);
+  gsl_permutation_free(p);
+  gsl_permutation_free(q);
+  gsl_matrix_free(X);
+  gsl_matrix_free(Y);
+  gsl_vector_free(x);
+  gsl_vector_free(y0);
+  gsl_vector_free(y1);
+} /* test_symmetric_ops() */
+
+/*
+test_workspace()
+  Test the _w variants of the add, transpose, compress and dgemm
+routines against the allocating versions. The work arrays of the input
+matrices are hidden during the calls to check that they are not used,
+and nthreads products of the same matrices are computed concurrently,
+each with its own workspace
+*/
+
+static void
+test_workspace(const size_t M, const size_t N, const size_t nthreads,
+               const gsl_rng *r)
+{
+  const size_t types[2] = { GSL_SPMATRIX_CCS, GSL_SPMATRIX_CRS };
+  gsl_spmatrix *Ta = create_random_sparse(M, N, 0.2, r);
+  gsl_spmatrix *Tb = create_random_sparse(M, N, 0.2, r);
+  gsl_spmatrix *Tc = create_random_sparse(N, M, 0.2, r);
+  gsl_spmatrix_workspace *work = gsl_spmatrix_workspace_alloc(GSL_MAX(M, N));
+  gsl_spmatrix_workspace **tw = malloc(nthreads * sizeof(*tw));
+  gsl_spmatrix **tC = malloc(nthreads * sizeof(*tC));
+  gsl_error_handler_t *handler;
+  size_t k, t;
+  long l;
+  int status;
+
+  for (t = 0; t < nthreads; ++t)
+    tw[t] = gsl_spmatrix_workspace_alloc(GSL_MAX(M, N));
+
+  for (k = 0; k < 2; ++k)
+    {
+      gsl_spmatrix *a = gsl_spmatrix_compress_sorted(Ta, types[k]);
+      gsl_spmatrix *b = gsl_spmatrix_compress_sorted(Tb, types[k]);
+      gsl_spmatrix *c = gsl_spmatrix_compress_sorted(Tc, types[k]);
+      gsl_spmatrix *a0 = gsl_spmatrix_memcpy(a);
+      gsl_spmatrix *at = gsl_spmatrix_alloc_nzmax(N, M, GSL_MAX(a->nz, 1),
+                                                 types[k]);
+      size_t *awork = a->work, *bwork = b->work, *cwork = c->work;
+      size_t *atwork = at->work;
+      gsl_spmatrix *C0, *C1, *S0, *S1, *T0, *T1;
+
+      /* reference results */
+      C0 = gsl_spblas_dgemm(1.7, a, c);
+      S0 = gsl_spmatrix_add(a, b);
+      T0 = gsl_spmatrix_transpose_memcpy(a);
+      T1 = (types[k] == GSL_SPMATRIX_CCS) ? gsl_spmatrix_compress(Ta) :
+                                            gsl_spmatrix_crs(Ta);
+
+      a->work = b->work = c->work = at->work = NULL;
+
+      C1 = gsl_spblas_dgemm_w(1.7, a, c, work);
+      S1 = gsl_spmatrix_add_w(a, b, work);
+
+      status = gsl_spmatrix_equal(C0, C1) != 1 ||
+               gsl_spmatrix_equal(S0, S1) != 1;
+      gsl_test(status, "test_workspace: M=%zu N=%zu type=%zu dgemm/add",
+               M, N, k);
+
+      status = gsl_spmatrix_transpose_memcpy_w(at, a, work) != GSL_SUCCESS ||
+               gsl_spmatrix_equal(T0, at) != 1;
+      gsl_test(status, "test_workspace: M=%zu N=%zu type=%zu transpose",
+               M, N, k);
+
+      gsl_spmatrix_free(S1);
+      S1 = gsl_spmatrix_compress_w(Ta, types[k], work);
+      status = gsl_spmatrix_equal(T1, S1) != 1;
+      gsl_test(status, "test_workspace: M=%zu N=%zu type=%zu compress",
+               M, N, k);
+
+      /* numeric phase with a new scalar, reusing the pattern of C1 */
+      gsl_spblas_dgemm_numeric(-0.4, a0, c, C0);
+      status = gsl_spblas_dgemm_numeric_w(-0.4, a, c, C1, work) != GSL_SUCCESS ||
+               gsl_spmatrix_equal(C0, C1) != 1;
+      gsl_test(status, "test_workspace: M=%zu N=%zu type=%zu numeric",
+               M, N, k);
+
+      /* concurrent products of the same matrices */
+#pragma omp parallel for num_threads(nthreads) schedule(static, 1)
+      for (l = 0; l < (long) nthreads; ++l)
+        tC[l] = gsl_spblas_dgemm_w(-0.4, a, c, tw[l]);
+
+      status = 0;
+      for (t = 0; t < nthreads; ++t)
+        {
+          if (gsl_spmatrix_equal(C0, tC[t]) != 1)
+            status = 1;
+
+          gsl_spmatrix_free(tC[t]);
+        }
+
+      /* the inputs are unchanged */
+      if (gsl_spmatrix_equal(a0, a) != 1)
+        status = 1;
+
+      gsl_test(status, "test_workspace: M=%zu N=%zu type=%zu nthreads=%zu",
+               M, N, k, nthreads);
+
+      a->work = awork;
+      b->work = bwork;
+      c->work = cwork;
+      at->work = atwork;
+
+      gsl_spmatrix_free(a);
+      gsl_spmatrix_free(b);
+      gsl_spmatrix_free(c);
+      gsl_spmatrix_free(a0);
+      gsl_spmatrix_free(at);
+      gsl_spmatrix_free(C0);
+      gsl_spmatrix_free(C1);
+      gsl_spmatrix_free(S0);
+      gsl_spmatrix_free(S1);
+      gsl_spmatrix_free(T0);
+      gsl_spmatrix_free(T1);
+    }
+
+  /* invalid inputs */
+  handler = gsl_set_error_handler_off();
+
+  {
+    gsl_spmatrix_workspace *small =
+      gsl_spmatrix_workspace_alloc(GSL_MAX(M, N) - 1);
+    gsl_spmatrix *a = gsl_spmatrix_compress(Ta);
+    gsl_spmatrix *at = gsl_spmatrix_alloc_nzmax(N, M, GSL_MAX(a->nz, 1),
+                                                GSL_SPMATRIX_CCS);
+    gsl_spmatrix *b = gsl_spmatrix_alloc_nzmax(N + 1, M, GSL_MAX(a->nz, 1),
+                                               GSL_SPMATRIX_CCS);
+
+    status = gsl_spmatrix_transpose_memcpy_w(at, Ta, work) != GSL_EINVAL ||
+             gsl_spmatrix_transpose_memcpy_w(b, a, work) != GSL_EBADLEN ||
+             gsl_spmatrix_compress_w(Ta, 0, work) != NULL;
+
+    if (M == N)
+      {
+        status |= gsl_spmatrix_add_w(a, a, small) != NULL ||
+                  gsl_spmatrix_transpose_memcpy_w(at, a, small) != GSL_EBADLEN ||
+                  gsl_spmatrix_compress_w(Ta, GSL_SPMATRIX_CCS, small) != NULL ||
+                  gsl_spblas_dgemm_symbolic_w(a, a, small) != NULL;
+      }
+
+    gsl_test(status, "test_workspace: M=%zu N=%zu invalid inputs", M, N);
+
+    gsl_spmatrix_workspace_free(small);
+    gsl_spmatrix_free(a);
+    gsl_spmatrix_free(at);
+    gsl_spmatrix_free(b);
+  }
+
+  gsl_set_error_handler(handler);
+
+  for (t = 0; t < nthreads; ++t)
+    gsl_spmatrix_workspace_free(tw[t]);
+
+  free(tw);
+  free(tC);
+  gsl_spmatrix_workspace_free(work);
+  gsl_spmatrix_free(Ta);
+  gsl_spmatrix_free(Tb);
+  gsl_spmatrix_free(Tc);
+} /* test_workspace() */
+
+/*
+test_order()
+  Test the RCM and AMD orderings on a randomly renumbered 2D Laplacian:
+RCM must recover a bandwidth close to that of the natural ordering, and
+AMD must give less fill-in in the Cholesky factor than the natural
+ordering
+*/
+
+static void
+test_order(const size_t k, const gsl_rng *r)
+{
+  const size_t n = k * k;
+  gsl_spmatrix *T = create_poisson2d(k, 0.0);
+  gsl_spmatrix *A = gsl_spmatrix_compress(T);
+  gsl_permutation *p0 = gsl_permutation_alloc(n);
+  gsl_permutation *p = gsl_permutation_alloc(n);
+  gsl_spmatrix *B, *C, *R;
+  gsl_splinalg_cholesky_workspace *w;
+  size_t nnz_natural;
+  int status;
+
+  w = gsl_splinalg_cholesky_alloc(A);
+  nnz_natural = w->nnz;
+  gsl_splinalg_cholesky_free(w);
+
+  /* scramble the numbering of the grid */
+  create_random_permutation(p0, r);
+  B = gsl_spmatrix_permute(A, p0, p0);
+
+  /* reverse Cuthill-McKee, in both compressed formats */
+  status = gsl_spmatrix_rcm(B, p);
+  gsl_test(status || gsl_permutation_valid(p),
+           "test_order: k=%zu rcm valid", k);
+
+  C = gsl_spmatrix_permute(B, p, p);
+  gsl_test(spmatrix_bandwidth(C) > 2 * k,
+           "test_order: k=%zu rcm bandwidth %zu (scrambled %zu)",
+           k, spmatrix_bandwidth(C), spmatrix_bandwidth(B));
+
+  R = gsl_spmatrix_crs(T);
+  gsl_spmatrix_rcm(R, p);
+  gsl_test(gsl_permutation_valid(p), "test_order: k=%zu rcm crs valid", k);
+
+  gsl_spmatrix_free(C);
+
+  /* approximate minimum degree */
+  status = gsl_spmatrix_amd(B, p);
+  gsl_test(status || gsl_permutation_valid(p),
+           "test_order: k=%zu amd valid", k);
+
+  C = gsl_spmatrix_permute(B, p, p);
+  w = gsl_splinalg_cholesky_alloc(C);
+
+  gsl_test(k > 4 && w->nnz >= nnz_natural,
+           "test_order: k=%zu amd nnz(L)=%zu natural=%zu", k, w->nnz,
+           nnz_natural);
+
+  status = gsl_splinalg_cholesky_decomp(C, w);
+  gsl_test(status || cholesky_residual(C, w, r) > 1.0e-12,
+           "test_order: k=%zu amd cholesky residual", k);
+
+  gsl_splinalg_cholesky_free(w);
+  gsl_spmatrix_free(C);
+  gsl_spmatrix_free(B);
+  gsl_spmatrix_free(R);
+  gsl_spmatrix_free(A);
+  gsl_spmatrix_free(T);
+  gsl_permutation_free(p0);
+  gsl_permutation_free(p);
+} /* test_order() */
 
 int
 main()
@@ -390,6 +3785,17 @@ main()
   test_getset(30, 20, r);
   test_getset(15, 210, r);
 
+  test_compress(20, 20, r);
+  test_compress(30, 7, r);
+  test_compress(5, 90, r);
+
+  test_compress_plan(20, 20, r);
+  test_compress_plan(40, 9, r);
+  test_compress_plan(3, 70, r);
+
+  test_compress_threads(300, 200, 4, r);
+  test_compress_threads(17, 400, 3, r);
+
   test_ops(20, 20, r);
   test_ops(50, 20, r);
   test_ops(20, 50, r);
@@ -399,11 +3805,94 @@ main()
   test_dgemv(2.4, -0.5, r);
   test_dgemv(0.1, 10.0, r);
 
+  test_dgemv_threads(200, 150, 4, r);
+  test_dgemv_threads(33, 500, 3, r);
+  test_dgemv_threads(2, 7, 5, r);
+
+  test_cg(10, 0.0, r);
+  test_cg(25, 0.5, r);
+  test_cg(1, 0.0, r);
+
+  test_nonsymm(12, 0.5, r);
+  test_nonsymm(20, 0.9, r);
+  test_nonsymm(1, 0.0, r);
+
+  test_ilu_ic(8, 0.4, r);
+  test_ilu_ic(15, 0.8, r);
+
+  test_dtrsv(40, 0.1, 4, r);
+  test_dtrsv(200, 0.02, 3, r);
+  test_dtrsv(1, 0.0, 2, r);
+
+  test_cholesky(1, 0.0, r);
+  test_cholesky(6, 0.0, r);
+  test_cholesky(15, 0.3, r);
+
+  test_permute(20, 30, r);
+  test_permute(35, 8, r);
+  test_permute(1, 1, r);
+
+  test_mm(20, 30, 0.2, 3, r);
+  test_mm(40, 40, 0.1, 4, r);
+  test_mm(1000, 1000, 0.06, 3, r);
+  test_mm(1, 1, 0.0, 2, r);
+  test_mm_errors();
+
+  test_binary(20, 30, 0.2, r);
+  test_binary(300, 7, 0.3, r);
+  test_binary(1, 1, 0.0, r);
+
+  test_i32(30, 20, 25, 3, r);
+  test_i32(200, 150, 40, 4, r);
+  test_i32(1, 1, 1, 1, r);
+
+  test_float(40, 25, 3, r);
+  test_float(300, 200, 4, r);
+  test_float(1, 1, 1, r);
+
+  test_sell(100, 80, 8, 32, 3, r);
+  test_sell(257, 120, 4, 1, 4, r);
+  test_sell(50, 300, 3, 1000, 2, r);
+  test_sell(1, 1, 8, 1, 1, r);
+
+  test_bsr(7, 5, 3, 3, r);
+  test_bsr(5, 7, 4, 4, r);
+  test_bsr(13, 11, 2, 2, r);
+  test_bsr(3, 3, 5, 2, r);
+  test_bsr(1, 1, 1, 1, r);
+
+  test_dia(10, 3, r);
+  test_dia(40, 4, r);
+  test_dia(1, 2, r);
+
+  test_symmetric(50, 3, r);
+  test_symmetric(300, 4, r);
+  test_symmetric(1, 2, r);
+
+  test_symmetric_ops(40, r);
+  test_symmetric_ops(1, r);
+
+  test_workspace(30, 20, 3, r);
+  test_workspace(100, 100, 4, r);
+  test_workspace(1, 1, 2, r);
+
+  test_order(1, r);
+  test_order(10, r);
+  test_order(30, r);
+
+  test_dgemm_dense(1.0, 0.0, 30, 20, 8, r);
+  test_dgemm_dense(-0.7, 1.0, 17, 45, 13, r);
+  test_dgemm_dense(2.1, 0.3, 60, 9, 2, r);
+  test_dgemm_dense(0.0, -1.5, 5, 5, 4, r);
+
   test_dgemm(1.0, 10, 10, r);
   test_dgemm(2.3, 20, 15, r);
   test_dgemm(1.8, 12, 30, r);
   test_dgemm(0.4, 45, 35, r);
 
+  test_dgemm_threads(150, 100, 120, 4, r);
+  test_dgemm_threads(40, 300, 7, 3, r);
+
   gsl_rng_free(r);
 
   exit (gsl_test_summary());